@@ -0,0 +1,125 @@
+/** @brief  Measure the memory footprint of each cache in 'src/ttl'.
+ *
+ *  I count every byte that the caches allocate on the heap (including
+ *  the allocator's rounding) by replacing the global operator new and
+ *  delete. I fill each cache to capacity, evict for a while to reach a
+ *  steady state, then report the live heap bytes per cached object.
+ *
+ *  @note   I skip the Yang et al. caches because they wrap libCacheSim's
+ *          own (C) allocations, which this does not see.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <string>
+
+#include "cache/clock_cache.hpp"
+#include "cache/fifo_cache.hpp"
+#include "cache/lfu_cache.hpp"
+#include "cache/lru_cache.hpp"
+#include "cache/sieve_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_metadata/cache_metadata.hpp"
+#include "cache_metadata/packed_cache_metadata.hpp"
+#include "composed_cache/composed_cache.hpp"
+#include "ttl_cache/new_ttl_clock_cache.hpp"
+#include "ttl_cache/ttl_clock_cache.hpp"
+#include "ttl_cache/ttl_fifo_cache.hpp"
+#include "ttl_cache/ttl_lfu_cache.hpp"
+#include "ttl_cache/ttl_lru_cache.hpp"
+#include "ttl_cache/ttl_sieve_cache.hpp"
+
+static std::size_t live_bytes = 0;
+
+// NOTE I keep these out of line, otherwise GCC inlines them into the
+//      standard containers and then warns that we free() memory that
+//      came from operator new.
+__attribute__((noinline)) void *
+operator new(std::size_t const size)
+{
+    void *p = std::malloc(size != 0 ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    live_bytes += malloc_usable_size(p);
+    return p;
+}
+
+__attribute__((noinline)) void
+operator delete(void *const p) noexcept
+{
+    if (p != nullptr) {
+        live_bytes -= malloc_usable_size(p);
+    }
+    std::free(p);
+}
+
+void
+operator delete(void *const p, std::size_t const) noexcept
+{
+    operator delete(p);
+}
+
+std::size_t const CAPACITY = 1 << 20;
+
+template <class T>
+static void
+measure()
+{
+    std::size_t const before = live_bytes;
+    auto cache = std::make_unique<T>(CAPACITY);
+    // NOTE Every key is new, so the cache fills up and then evicts on
+    //      every access. Every other access carries a (long) TTL.
+    for (std::uint64_t i = 0; i < 2 * CAPACITY; ++i) {
+        cache->access_item(CacheAccess{
+            i,
+            i,
+            1,
+            i % 2 ? std::optional<std::uint64_t>(1 << 30) : std::nullopt});
+    }
+    std::size_t const after = live_bytes;
+    std::printf("%-40s %8.1f B/object\n",
+                std::string(T::name).c_str(),
+                (double)(after - before) / CAPACITY);
+}
+
+int
+main()
+{
+    std::printf("sizeof(CacheMetadata) = %zu B\n", sizeof(CacheMetadata));
+    std::printf("sizeof(PackedCacheMetadata) = %zu B\n",
+                sizeof(PackedCacheMetadata));
+    std::printf("sizeof(TTLCacheEntry) = %zu B\n", sizeof(TTLCacheEntry));
+    std::printf("Capacity = %zu objects\n", CAPACITY);
+
+    measure<FIFOCache>();
+    measure<LRUCache>();
+    measure<LFUCache>();
+    measure<ClockCache>();
+    measure<SieveCache>();
+
+    measure<NewTTLClockCache>();
+    measure<TTLClockCache>();
+    measure<TTLFIFOCache>();
+    measure<TTLLFUCache>();
+    measure<TTLLRUCache>();
+    measure<TTLSieveCache>();
+
+    measure<ComposedFIFOCache>();
+    measure<ComposedLRUCache>();
+    measure<ComposedClockCache>();
+    measure<ComposedSieveCache>();
+    measure<ComposedTTLLRUCache>();
+    measure<ComposedTTLClockCache>();
+    // NOTE The full metadata is the baseline for the packed caches below.
+    measure<ComposedCache<LRUOrder, TTLExpiry, AdmitAll, FullMetadata>>();
+    measure<ComposedTTLFIFOPackedMetadataCache>();
+    measure<ComposedTTLLRUPackedMetadataCache>();
+    measure<ComposedTTLClockPackedMetadataCache>();
+    measure<ComposedTTLSievePackedMetadataCache>();
+    return 0;
+}
@@ -9,12 +9,15 @@
  *          do not have a lot of benchmarks currently. My trepidation is
  *          that I'd need to change it back if I do add more benchmarks.
  */
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "array/print_array.h"
 #include "arrays/array_size.h"
 #include "hash/MurmurHash3.h"
+#include "hash/hash_batch.h"
 #include "hash/miscellaneous_hash.h"
 #include "hash/splitmix64.h"
 #include "logger/logger.h"
@@ -24,6 +27,7 @@
 
 #define TIME_HASH(f)         time_hash(f, #f)
 #define TEST_DISTRIBUTION(f) test_hash_distribution(f, #f)
+#define BATCH_SIZE           (1 << 12)
 
 size_t const NUM_VALUES_FOR_PERF = 1 << 27;
 size_t const NUM_VALUES_FOR_DISTRIBUTION = 1 << 20;
@@ -77,6 +81,45 @@ time_hash(uint64_t (*const f)(uint64_t const key), char const *const fname)
     LOGGER_INFO("%s time: %f", fname, t1 - t0);
 }
 
+/// @brief  Time hashing in batches, as a decoded trace block would be.
+static void
+time_batch_hash(bool (*const f)(enum HashBatchKernel const kernel,
+                                uint64_t const *const keys,
+                                Hash64BitType *const hashes,
+                                size_t const n),
+                char const *const fname)
+{
+    static uint64_t keys[BATCH_SIZE];
+    static Hash64BitType hashes[BATCH_SIZE];
+    enum HashBatchKernel const kernels[] = {HASH_BATCH_KERNEL_SCALAR,
+                                            HASH_BATCH_KERNEL_AVX2,
+                                            HASH_BATCH_KERNEL_AVX512};
+    for (size_t k = 0; k < ARRAY_SIZE(kernels); ++k) {
+        if (!HashBatchKernel__is_supported(kernels[k])) {
+            printf("| %-26s | %-7s | %12s | %10s |\n",
+                   fname,
+                   HashBatchKernel__name(kernels[k]),
+                   "unsupported",
+                   "");
+            continue;
+        }
+        double const t0 = get_wall_time_sec();
+        for (size_t i = 0; i < NUM_VALUES_FOR_PERF; i += BATCH_SIZE) {
+            for (size_t j = 0; j < BATCH_SIZE; ++j) {
+                keys[j] = i + j;
+            }
+            f(kernels[k], keys, hashes, BATCH_SIZE);
+        }
+        double const t1 = get_wall_time_sec();
+        double const keys_per_sec = NUM_VALUES_FOR_PERF / (t1 - t0);
+        printf("| %-26s | %-7s | %12.1f | %10.2f |\n",
+               fname,
+               HashBatchKernel__name(kernels[k]),
+               keys_per_sec / 1e6,
+               keys_per_sec * sizeof(uint64_t) / 1e9);
+    }
+}
+
 /// @note   Taken from the cppreference website.
 ///         Source: https://en.cppreference.com/w/c/algorithm/qsort
 static int
@@ -159,6 +202,14 @@ main(void)
     TIME_HASH(wrap_SDBMHash);
     TIME_HASH(wrap_APHash);
 
+    printf("| %-26s | %-7s | %12s | %10s |\n",
+           "Hash",
+           "Kernel",
+           "Mkeys/s",
+           "GB/s");
+    time_batch_hash(splitmix64_hash__batch, "splitmix64_hash__batch");
+    time_batch_hash(MurmurHash3_x64_64__batch, "MurmurHash3_x64_64__batch");
+
     TEST_DISTRIBUTION(wrap_MurmurHash3_x64_128);
     TEST_DISTRIBUTION(splitmix64_hash);
     TEST_DISTRIBUTION(wrap_RSHash);
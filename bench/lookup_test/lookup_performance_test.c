@@ -2,25 +2,30 @@
  *
  *  @note   Perform memory tests on the various algorithms by running
  *          the following:
- *          `/usr/bin/time -v <exe> {boost,k,g}
+ *          `/usr/bin/time -v <exe> {boost,k,g,flat}
  *          Look for the 'Maximum resident set size (kbytes)'.
  *          It is important to type the full path '/usr/bin/time' since
  *          you do not want to confuse it with Bash's built-in 'time'.
  *          Source:
  *          https://stackoverflow.com/questions/774556/peak-memory-usage-of-a-linux-unix-process
+ *  @note   Pass a number (e.g. `<exe> 1000000000 flat k`) to change the
+ *          number of entries from the default of 2^20.
  */
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "logger/logger.h"
 #include "lookup/boost_hash_table.h"
+#include "lookup/flat_hash_table.h"
 #include "lookup/hash_table.h"
 #include "lookup/k_hash_table.h"
 #include "lookup/lookup.h"
 #include "timer/timer.h"
 
-size_t const NUM_VALUES_FOR_PERF = 1 << 20;
+static size_t num_values_for_perf = 1 << 20;
 
 /// @brief  Test the performance of various domains of the hash table.
 /// @note   I do not test remove operations, because these are not
@@ -37,20 +42,20 @@ time_hash_table(char const *const name,
                 void (*destroy)(void *const object))
 {
     double const t0 = get_wall_time_sec();
-    for (size_t i = 0; i < NUM_VALUES_FOR_PERF; ++i) {
+    for (size_t i = 0; i < num_values_for_perf; ++i) {
         put(object, i, i);
     }
     double const t1 = get_wall_time_sec();
-    for (size_t i = 0; i < NUM_VALUES_FOR_PERF; ++i) {
+    for (size_t i = 0; i < num_values_for_perf; ++i) {
         put(object, i, 2 * i);
     }
     double const t2 = get_wall_time_sec();
-    for (size_t i = 0; i < NUM_VALUES_FOR_PERF; ++i) {
+    for (size_t i = 0; i < num_values_for_perf; ++i) {
         lookup(object, i);
     }
     double const t3 = get_wall_time_sec();
-    for (size_t i = 0; i < NUM_VALUES_FOR_PERF; ++i) {
-        lookup(object, i + NUM_VALUES_FOR_PERF);
+    for (size_t i = 0; i < num_values_for_perf; ++i) {
+        lookup(object, i + num_values_for_perf);
     }
     double const t4 = get_wall_time_sec();
     destroy(object);
@@ -70,6 +75,7 @@ enum LookupType {
     BOOST_HASH_TABLE,
     K_HASH_TABLE,
     G_HASH_TABLE,
+    FLAT_HASH_TABLE,
 };
 
 void
@@ -118,6 +124,20 @@ run(enum LookupType const lookup_type)
             (void (*)(void *const))HashTable__destroy);
         break;
     }
+    case FLAT_HASH_TABLE: {
+        struct FlatHashTable fht = {0};
+        FlatHashTable__init(&fht);
+        time_hash_table(
+            "Flat Hash Table",
+            &fht,
+            (enum PutUniqueStatus(*)(void *const,
+                                     uint64_t const,
+                                     uint64_t const))FlatHashTable__put,
+            (struct LookupReturn(*)(void const *const,
+                                    uint64_t const))FlatHashTable__lookup,
+            (void (*)(void *const))FlatHashTable__destroy);
+        break;
+    }
     default:
         assert(0);
     }
@@ -126,27 +146,38 @@ run(enum LookupType const lookup_type)
 int
 main(int argc, char **argv)
 {
-    if (argc == 1) {
-        run(BOOST_HASH_TABLE);
-        run(G_HASH_TABLE);
-        run(K_HASH_TABLE);
-        return 0;
-    }
+    bool ran_any = false;
     for (int i = 1; i < argc; ++i) {
         assert(argv[i] != NULL);
+        char *end = NULL;
+        size_t const n = strtoull(argv[i], &end, 10);
+        if (*end == '\0' && n != 0) {
+            num_values_for_perf = n;
+            continue;
+        }
+        ran_any = true;
         if (strcmp(argv[i], "boost") == 0) {
             run(BOOST_HASH_TABLE);
         } else if (strcmp(argv[i], "k") == 0) {
             run(K_HASH_TABLE);
         } else if (strcmp(argv[i], "g") == 0) {
             run(G_HASH_TABLE);
+        } else if (strcmp(argv[i], "flat") == 0) {
+            run(FLAT_HASH_TABLE);
         } else {
             LOGGER_WARN("skipping unrecognized argument '%s'. Try any "
-                        "combination of 'boost', 'k', or 'g' (e.g. '%s boost k "
-                        "g'); or enter no arguments to run everything.",
+                        "combination of 'boost', 'k', 'g', or 'flat' (e.g. "
+                        "'%s boost k g flat'), optionally with a number of "
+                        "entries; or enter no names to run everything.",
                         argv[i],
                         argv[0]);
         }
     }
+    if (!ran_any) {
+        run(BOOST_HASH_TABLE);
+        run(G_HASH_TABLE);
+        run(K_HASH_TABLE);
+        run(FLAT_HASH_TABLE);
+    }
     return 0;
 }
@@ -0,0 +1,125 @@
+/** @brief  Test the throughput of the ParallelHashTable under contention.
+ *
+ *  Each thread runs a mix of lookups and puts on Zipfian-distributed keys,
+ *  so a few hot keys (and their stripes) take most of the accesses. I
+ *  run 1, 2, 4, ..., 64 threads and report the total throughput.
+ *
+ *  @note   Run `<exe> <theta> <put-percent>` to change the skew (default
+ *          0.99) or the percentage of puts (default 10).
+ */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "logger/logger.h"
+#include "lookup/lookup.h"
+#include "lookup/parallel_hash_table.h"
+#include "random/zipfian_random.h"
+#include "timer/timer.h"
+
+#define MAX_NUM_THREADS    64
+#define NUM_KEYS           (1 << 20)
+#define NUM_OPS_PER_THREAD (1 << 18)
+
+struct WorkerArgs {
+    struct ParallelHashTable *hash_table;
+    uint64_t const *keys;
+    unsigned put_percent;
+};
+
+static void *
+worker(void *args)
+{
+    struct WorkerArgs const *const w = args;
+    uint64_t found = 0;
+    for (size_t i = 0; i < NUM_OPS_PER_THREAD; ++i) {
+        if (i % 100 < w->put_percent) {
+            ParallelHashTable__put(w->hash_table, w->keys[i], i);
+        } else {
+            found += ParallelHashTable__lookup(w->hash_table, w->keys[i])
+                         .success;
+        }
+    }
+    return (void *)(uintptr_t)found;
+}
+
+/// @brief  Generate each thread's keys ahead of time, so that we do not
+///         time the random number generator.
+static uint64_t *
+generate_keys(double const theta)
+{
+    uint64_t *keys =
+        malloc(MAX_NUM_THREADS * NUM_OPS_PER_THREAD * sizeof(*keys));
+    if (keys == NULL) {
+        LOGGER_ERROR("failed to allocate keys");
+        return NULL;
+    }
+    for (size_t t = 0; t < MAX_NUM_THREADS; ++t) {
+        struct ZipfianRandom zrng = {0};
+        if (!ZipfianRandom__init(&zrng, NUM_KEYS, theta, t)) {
+            LOGGER_ERROR("failed to initialize Zipfian generator");
+            free(keys);
+            return NULL;
+        }
+        for (size_t i = 0; i < NUM_OPS_PER_THREAD; ++i) {
+            keys[t * NUM_OPS_PER_THREAD + i] = ZipfianRandom__next(&zrng);
+        }
+        ZipfianRandom__destroy(&zrng);
+    }
+    return keys;
+}
+
+static bool
+run(uint64_t const *const keys,
+    size_t const num_threads,
+    unsigned const put_percent)
+{
+    struct ParallelHashTable me = {0};
+    pthread_t threads[MAX_NUM_THREADS] = {0};
+    struct WorkerArgs args[MAX_NUM_THREADS] = {0};
+    // NOTE I start empty so that we also measure the online resizing.
+    if (!ParallelHashTable__init(&me, 1)) {
+        LOGGER_ERROR("failed to initialize hash table");
+        return false;
+    }
+    double const t0 = get_wall_time_sec();
+    for (size_t t = 0; t < num_threads; ++t) {
+        args[t] = (struct WorkerArgs){.hash_table = &me,
+                                      .keys = &keys[t * NUM_OPS_PER_THREAD],
+                                      .put_percent = put_percent};
+        pthread_create(&threads[t], NULL, worker, &args[t]);
+    }
+    for (size_t t = 0; t < num_threads; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+    double const t1 = get_wall_time_sec();
+    printf("%2zu threads: %8.2f Mops/s (%zu keys)\n",
+           num_threads,
+           num_threads * NUM_OPS_PER_THREAD / (t1 - t0) / 1e6,
+           ParallelHashTable__get_size(&me));
+    ParallelHashTable__destroy(&me);
+    return true;
+}
+
+int
+main(int argc, char **argv)
+{
+    double const theta = argc > 1 ? atof(argv[1]) : 0.99;
+    unsigned const put_percent = argc > 2 ? atoi(argv[2]) : 10;
+    printf("Zipfian theta: %g | puts: %u%%\n", theta, put_percent);
+    uint64_t *keys = generate_keys(theta);
+    if (keys == NULL) {
+        return EXIT_FAILURE;
+    }
+    for (size_t n = 1; n <= MAX_NUM_THREADS; n *= 2) {
+        if (!run(keys, n, put_percent)) {
+            free(keys);
+            return EXIT_FAILURE;
+        }
+    }
+    free(keys);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,152 @@
+/** @brief  Time the vectorized kernels that build and compare MRCs, and
+ *          the batched comparison against many MRCs.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "array/array_kernels.h"
+#include "arrays/array_size.h"
+#include "histogram/histogram.h"
+#include "logger/logger.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "timer/timer.h"
+
+#define NUM_BINS   (1 << 20)
+#define NUM_REPS   100
+#define NUM_MRCS   16
+#define NUM_VALUES (1 << 22)
+
+static enum ArrayKernel const KERNELS[] = {ARRAY_KERNEL_SCALAR,
+                                           ARRAY_KERNEL_AVX2,
+                                           ARRAY_KERNEL_AVX512};
+
+static void
+print_row(char const *const name,
+          enum ArrayKernel const kernel,
+          double const seconds)
+{
+    printf("| %-22s | %-7s | %10.1f |\n",
+           name,
+           ArrayKernel__name(kernel),
+           (double)NUM_BINS * NUM_REPS / seconds / 1e6);
+}
+
+static void
+time_kernels(struct Histogram const *const hist,
+             double *const a,
+             double *const b)
+{
+    printf("| %-22s | %-7s | %10s |\n", "Kernel", "ISA", "Mbins/s");
+    for (size_t k = 0; k < ARRAY_SIZE(KERNELS); ++k) {
+        if (!ArrayKernel__is_supported(KERNELS[k])) {
+            continue;
+        }
+        double t0 = get_wall_time_sec();
+        for (size_t r = 0; r < NUM_REPS; ++r) {
+            ArrayKernel__normalized_suffix_sums(KERNELS[k],
+                                                hist->histogram,
+                                                NUM_BINS,
+                                                hist->running_sum,
+                                                a);
+        }
+        print_row("histogram to MRC", KERNELS[k], get_wall_time_sec() - t0);
+
+        t0 = get_wall_time_sec();
+        for (size_t r = 0; r < NUM_REPS; ++r) {
+            ArrayKernel__scaled_iadd(KERNELS[k], b, a, NUM_BINS, 1e-3);
+        }
+        print_row("scaled iadd", KERNELS[k], get_wall_time_sec() - t0);
+
+        t0 = get_wall_time_sec();
+        volatile double sum = 0.0;
+        for (size_t r = 0; r < NUM_REPS; ++r) {
+            sum += ArrayKernel__sum_absolute_error(KERNELS[k], a, b, NUM_BINS);
+        }
+        print_row("absolute error", KERNELS[k], get_wall_time_sec() - t0);
+
+        t0 = get_wall_time_sec();
+        for (size_t r = 0; r < NUM_REPS; ++r) {
+            sum += ArrayKernel__sum_squared_error_u64(KERNELS[k],
+                                                      hist->histogram,
+                                                      hist->histogram,
+                                                      NUM_BINS);
+        }
+        print_row("histogram sq. error", KERNELS[k], get_wall_time_sec() - t0);
+    }
+}
+
+/// @brief  Compare NUM_MRCS MRCs against one oracle, one at a time and in
+///         a batch.
+static void
+time_batch(struct MissRateCurve const *const oracle,
+           struct MissRateCurve const *const *const mrcs)
+{
+    double errors[NUM_MRCS] = {0};
+    double const t0 = get_wall_time_sec();
+    for (size_t r = 0; r < NUM_REPS / 10; ++r) {
+        for (size_t k = 0; k < NUM_MRCS; ++k) {
+            errors[k] = MissRateCurve__mean_absolute_error(oracle, mrcs[k]);
+        }
+    }
+    double const t1 = get_wall_time_sec();
+    for (size_t r = 0; r < NUM_REPS / 10; ++r) {
+        MissRateCurve__batch_mean_absolute_error(oracle,
+                                                 mrcs,
+                                                 NUM_MRCS,
+                                                 errors);
+    }
+    double const t2 = get_wall_time_sec();
+    printf("%d MAEs: one at a time %f s | batched %f s\n",
+           NUM_MRCS,
+           (t1 - t0) / (NUM_REPS / 10),
+           (t2 - t1) / (NUM_REPS / 10));
+}
+
+int
+main(void)
+{
+    struct Histogram hist = {0};
+    struct MissRateCurve oracle = {0};
+    struct MissRateCurve mrcs[NUM_MRCS] = {{0}};
+    struct MissRateCurve const *mrc_ptrs[NUM_MRCS] = {0};
+    double *a = calloc(NUM_BINS, sizeof(*a));
+    double *b = calloc(NUM_BINS, sizeof(*b));
+    if (a == NULL || b == NULL ||
+        !Histogram__init(&hist,
+                         NUM_BINS,
+                         1,
+                         HistogramOutOfBoundsMode__allow_overflow)) {
+        LOGGER_ERROR("failed to allocate");
+        return EXIT_FAILURE;
+    }
+    uint64_t x = 1;
+    for (size_t i = 0; i < NUM_VALUES; ++i) {
+        x = 6364136223846793005 * x + 1442695040888963407;
+        Histogram__insert_scaled_finite(&hist, (x >> 33) % NUM_BINS, 1);
+    }
+    time_kernels(&hist, a, b);
+
+    MissRateCurve__init_from_histogram(&oracle, &hist);
+    for (size_t k = 0; k < NUM_MRCS; ++k) {
+        Histogram__clear(&hist);
+        for (size_t i = 0; i < NUM_VALUES / 16; ++i) {
+            x = 6364136223846793005 * x + 1442695040888963407;
+            Histogram__insert_scaled_finite(&hist, (x >> 33) % NUM_BINS, 1);
+        }
+        MissRateCurve__init_from_histogram(&mrcs[k], &hist);
+        mrc_ptrs[k] = &mrcs[k];
+    }
+    time_batch(&oracle, mrc_ptrs);
+
+    for (size_t k = 0; k < NUM_MRCS; ++k) {
+        MissRateCurve__destroy(&mrcs[k]);
+    }
+    MissRateCurve__destroy(&oracle);
+    Histogram__destroy(&hist);
+    free(a);
+    free(b);
+    return EXIT_SUCCESS;
+}
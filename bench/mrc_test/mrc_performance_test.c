@@ -7,6 +7,7 @@
 #include "random/zipfian_random.h"
 
 #include "evicting_map/evicting_map.h"
+#include "evicting_map/parallel_evicting_map.h"
 #include "mimir/mimir.h"
 #include "olken/olken.h"
 #include "parda_shards/parda_fixed_rate_shards.h"
@@ -76,14 +77,12 @@ test_all(void)
         Mimir__access_item,
         Mimir__destroy);
 
-#if 0
     PERFORMANCE_TEST(
         struct Mimir,
         me,
         Mimir__init(&me, 1000, hist_num_bins, hist_bin_size, MIMIR_STACKER),
         Mimir__access_item,
         Mimir__destroy);
-#endif
 
     PERFORMANCE_TEST(struct PardaFixedRateShards,
                      me,
@@ -174,6 +173,17 @@ test_sampling(void)
         EvictingMap__init(&me, 1e-3, 1 << 13, hist_num_bins, hist_bin_size),
         EvictingMap__access_item,
         EvictingMap__destroy);
+
+    PERFORMANCE_TEST(struct ParallelEvictingMap,
+                     me,
+                     ParallelEvictingMap__init(&me,
+                                               4,
+                                               1e-3,
+                                               1 << 13,
+                                               hist_num_bins,
+                                               hist_bin_size),
+                     ParallelEvictingMap__access_item,
+                     ParallelEvictingMap__destroy);
 #endif
 }
 
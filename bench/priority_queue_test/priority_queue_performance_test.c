@@ -0,0 +1,192 @@
+/** @brief  Compare the priority queues as fixed-size SHARDS's eviction
+ *          structure.
+ *
+ *  Fixed-size SHARDS keeps the 's_max' objects with the smallest hashes.
+ *  For each new object whose hash passes the threshold, it inserts the
+ *  hash into a max-priority queue; when the queue is full, it first
+ *  evicts the maximum hash and lowers the threshold to the next maximum.
+ *
+ *  I also report each queue's heap memory, as measured by glibc's
+ *  allocator, once it has processed every object.
+ *
+ *  @note   Run `<exe> <s_max>` to change the queue size (default 8192).
+ */
+#include <inttypes.h>
+#include <malloc.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hash/hash.h"
+#include "hash/types.h"
+#include "logger/logger.h"
+#include "priority_queue/heap.h"
+#include "priority_queue/indexed_heap.h"
+#include "priority_queue/radix_priority_queue.h"
+#include "priority_queue/splay_priority_queue.h"
+#include "timer/timer.h"
+#include "types/entry_type.h"
+
+#define NUM_OBJECTS (1 << 24)
+
+/// @brief  Get the number of bytes that the program has allocated.
+static size_t
+get_allocated_bytes(void)
+{
+    struct mallinfo2 const info = mallinfo2();
+    // NOTE Large allocations are mmap'ed, so they are not in 'uordblks'.
+    return info.uordblks + info.hblkhd;
+}
+
+static uint64_t
+run_heap(size_t const max_size, size_t *const bytes)
+{
+    struct Heap me = {0};
+    size_t const bytes_before = get_allocated_bytes();
+    uint64_t threshold = UINT64_MAX;
+    uint64_t num_evicted = 0;
+    if (!Heap__init_max_heap(&me, max_size)) {
+        LOGGER_ERROR("failed to initialize Heap");
+        return 0;
+    }
+    for (EntryType e = 0; e < NUM_OBJECTS; ++e) {
+        Hash64BitType const h = Hash64Bit(e);
+        if (h > threshold) {
+            continue;
+        }
+        if (Heap__is_full(&me)) {
+            ValueType evicted = 0;
+            Hash64BitType const max_hash = Heap__get_top_key(&me);
+            while (Heap__remove(&me, max_hash, &evicted)) {
+                ++num_evicted;
+            }
+            threshold = Heap__get_top_key(&me);
+        }
+        Heap__insert_if_room(&me, h, e);
+    }
+    *bytes = get_allocated_bytes() - bytes_before;
+    Heap__destroy(&me);
+    return num_evicted;
+}
+
+static uint64_t
+run_indexed_heap(size_t const max_size, size_t *const bytes)
+{
+    struct IndexedHeap me = {0};
+    size_t const bytes_before = get_allocated_bytes();
+    uint64_t threshold = UINT64_MAX;
+    uint64_t num_evicted = 0;
+    if (!IndexedHeap__init_max_heap(&me, max_size)) {
+        LOGGER_ERROR("failed to initialize IndexedHeap");
+        return 0;
+    }
+    for (EntryType e = 0; e < NUM_OBJECTS; ++e) {
+        Hash64BitType const h = Hash64Bit(e);
+        if (h > threshold) {
+            continue;
+        }
+        if (IndexedHeap__is_full(&me)) {
+            Hash64BitType const max_hash = IndexedHeap__get_top_key(&me);
+            while (me.length != 0 &&
+                   IndexedHeap__get_top_key(&me) == max_hash) {
+                IndexedHeap__pop(&me, NULL, NULL);
+                ++num_evicted;
+            }
+            threshold = IndexedHeap__get_top_key(&me);
+        }
+        IndexedHeap__insert_if_room(&me, h, e);
+    }
+    *bytes = get_allocated_bytes() - bytes_before;
+    IndexedHeap__destroy(&me);
+    return num_evicted;
+}
+
+static uint64_t
+run_splay(size_t const max_size, size_t *const bytes)
+{
+    struct SplayPriorityQueue me = {0};
+    size_t const bytes_before = get_allocated_bytes();
+    uint64_t threshold = UINT64_MAX;
+    uint64_t num_evicted = 0;
+    if (!SplayPriorityQueue__init(&me, max_size)) {
+        LOGGER_ERROR("failed to initialize SplayPriorityQueue");
+        return 0;
+    }
+    for (EntryType e = 0; e < NUM_OBJECTS; ++e) {
+        Hash64BitType const h = Hash64Bit(e);
+        if (h > threshold) {
+            continue;
+        }
+        if (SplayPriorityQueue__is_full(&me)) {
+            EntryType evicted = 0;
+            Hash64BitType const max_hash =
+                SplayPriorityQueue__get_max_hash(&me);
+            while (SplayPriorityQueue__remove(&me, max_hash, &evicted)) {
+                ++num_evicted;
+            }
+            threshold = SplayPriorityQueue__get_max_hash(&me);
+        }
+        SplayPriorityQueue__insert_if_room(&me, h, e);
+    }
+    *bytes = get_allocated_bytes() - bytes_before;
+    SplayPriorityQueue__destroy(&me);
+    return num_evicted;
+}
+
+static uint64_t
+run_radix(size_t const max_size, size_t *const bytes)
+{
+    struct RadixPriorityQueue me = {0};
+    size_t const bytes_before = get_allocated_bytes();
+    uint64_t threshold = UINT64_MAX;
+    uint64_t num_evicted = 0;
+    if (!RadixPriorityQueue__init(&me, max_size)) {
+        LOGGER_ERROR("failed to initialize RadixPriorityQueue");
+        return 0;
+    }
+    for (EntryType e = 0; e < NUM_OBJECTS; ++e) {
+        Hash64BitType const h = Hash64Bit(e);
+        if (h > threshold) {
+            continue;
+        }
+        if (RadixPriorityQueue__is_full(&me)) {
+            num_evicted += RadixPriorityQueue__remove_top(&me, NULL, NULL);
+            threshold = RadixPriorityQueue__get_top_key(&me);
+        }
+        RadixPriorityQueue__insert_if_room(&me, h, e);
+    }
+    *bytes = get_allocated_bytes() - bytes_before;
+    RadixPriorityQueue__destroy(&me);
+    return num_evicted;
+}
+
+static void
+time_priority_queue(char const *const name,
+                    uint64_t (*f)(size_t const max_size,
+                                  size_t *const bytes),
+                    size_t const max_size)
+{
+    size_t bytes = 0;
+    double const t0 = get_wall_time_sec();
+    uint64_t const num_evicted = f(max_size, &bytes);
+    double const t1 = get_wall_time_sec();
+    printf("%-20s: %8.4f sec | %10zu bytes (%" PRIu64 " evictions)\n",
+           name,
+           t1 - t0,
+           bytes,
+           num_evicted);
+}
+
+int
+main(int argc, char **argv)
+{
+    size_t const max_size = argc > 1 ? strtoul(argv[1], NULL, 10) : 8192;
+    printf("s_max: %zu | objects: %d\n", max_size, NUM_OBJECTS);
+    time_priority_queue("Heap", run_heap, max_size);
+    time_priority_queue("IndexedHeap", run_indexed_heap, max_size);
+    time_priority_queue("SplayPriorityQueue", run_splay, max_size);
+    time_priority_queue("RadixPriorityQueue", run_radix, max_size);
+    return EXIT_SUCCESS;
+}
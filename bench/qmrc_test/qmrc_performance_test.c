@@ -0,0 +1,122 @@
+/** @brief  Microbenchmark the QMRC epoch-array kernels.
+ *
+ *  For each number of buckets, I fill a QMRC with a Zipfian workload
+ *  and then time the two hot loops (i.e. the prefix sum for a lookup
+ *  and the search for the cheapest pair of buckets to merge) with each
+ *  kernel that this CPU supports.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arrays/array_size.h"
+#include "evicting_quickmrc/qmrc.h"
+#include "logger/logger.h"
+#include "random/uniform_random.h"
+#include "random/zipfian_random.h"
+#include "timer/timer.h"
+#include "unused/mark_unused.h"
+
+#define NUM_KEYS          (1 << 16)
+#define NUM_WARMUP_ACCESS (1 << 20)
+#define NUM_TIMED_CALLS   (1 << 20)
+
+static bool
+fill_qmrc(struct qmrc *const qmrc, size_t const nr_buckets)
+{
+    struct ZipfianRandom zrng = {0};
+    int *key_epochs = calloc(NUM_KEYS, sizeof(*key_epochs));
+    bool *seen = calloc(NUM_KEYS, sizeof(*seen));
+    if (key_epochs == NULL || seen == NULL ||
+        !ZipfianRandom__init(&zrng, NUM_KEYS, 0.99, 0) ||
+        !qmrc__init(qmrc, NUM_KEYS, nr_buckets, 0)) {
+        LOGGER_ERROR("failed to initialize");
+        free(key_epochs);
+        free(seen);
+        return false;
+    }
+    for (size_t i = 0; i < NUM_WARMUP_ACCESS; ++i) {
+        uint64_t const key = ZipfianRandom__next(&zrng) % NUM_KEYS;
+        if (seen[key]) {
+            qmrc__lookup(qmrc, key_epochs[key]);
+            key_epochs[key] = qmrc->epochs[0];
+        } else {
+            key_epochs[key] = qmrc__insert(qmrc);
+            seen[key] = true;
+        }
+    }
+    ZipfianRandom__destroy(&zrng);
+    free(key_epochs);
+    free(seen);
+    return true;
+}
+
+/// @brief  Time the lookup kernel with epochs that are spread uniformly
+///         over the occupied range.
+static double
+time_sum_until_epoch(struct qmrc const *const qmrc)
+{
+    struct UniformRandom urng = {0};
+    UniformRandom__init(&urng, 0);
+    int const max_epoch = qmrc->epochs[0];
+    volatile size_t sink = 0;
+    double const t0 = get_wall_time_sec();
+    for (size_t i = 0; i < NUM_TIMED_CALLS; ++i) {
+        int const epoch = (int)UniformRandom__within(&urng, 0, max_epoch);
+        int bucket_idx = 0;
+        sink += qmrc->sum_until_epoch(qmrc, epoch, &bucket_idx);
+    }
+    double const t1 = get_wall_time_sec();
+    UNUSED(sink);
+    return t1 - t0;
+}
+
+static double
+time_find_merge_idx(struct qmrc const *const qmrc)
+{
+    volatile int sink = 0;
+    double const t0 = get_wall_time_sec();
+    for (size_t i = 0; i < NUM_TIMED_CALLS / 16; ++i) {
+        size_t min_sum = 0;
+        sink += qmrc->find_merge_idx(qmrc, &min_sum);
+    }
+    double const t1 = get_wall_time_sec();
+    UNUSED(sink);
+    return t1 - t0;
+}
+
+int
+main(void)
+{
+    size_t const nr_buckets[] = {64, 128, 256, 512, 1024, 2048, 4096};
+    enum qmrc_kernel const kernels[] = {QMRC_KERNEL_SCALAR,
+                                        QMRC_KERNEL_AVX2,
+                                        QMRC_KERNEL_AVX512};
+
+    printf("| Buckets | Kernel | Lookup [ns/call] | Merge [ns/call] |\n");
+    printf("|---------|--------|------------------|-----------------|\n");
+    for (size_t i = 0; i < ARRAY_SIZE(nr_buckets); ++i) {
+        struct qmrc qmrc = {0};
+        if (!fill_qmrc(&qmrc, nr_buckets[i])) {
+            return EXIT_FAILURE;
+        }
+        for (size_t j = 0; j < ARRAY_SIZE(kernels); ++j) {
+            if (!qmrc__set_kernel(&qmrc, kernels[j])) {
+                continue;
+            }
+            double const lookup = time_sum_until_epoch(&qmrc);
+            double const merge = time_find_merge_idx(&qmrc);
+            printf("| %7zu | %6s | %16.2f | %15.2f |\n",
+                   nr_buckets[i],
+                   qmrc__kernel_name(kernels[j]),
+                   1e9 * lookup / NUM_TIMED_CALLS,
+                   1e9 * merge / (NUM_TIMED_CALLS / 16));
+        }
+        // NOTE The counts are not empty, so I do not call qmrc__destroy.
+        free(qmrc.counts);
+        free(qmrc.epochs);
+    }
+    return EXIT_SUCCESS;
+}
@@ -6,6 +6,7 @@
 #include <glib.h>
 
 #include "file/file.h"
+#include "io/binary_container.h"
 #include "logger/logger.h"
 #include "miss_rate_curve/miss_rate_curve.h"
 
@@ -14,7 +15,9 @@ struct CommandLineArguments {
 
     // Inputs
     char *oracle_path;
-    char *test_path;
+    // NOTE This is a NULL-terminated array, since we may pass '--test'
+    //      many times to compare many MRCs against the same oracle.
+    char **test_paths;
 };
 
 static struct CommandLineArguments
@@ -25,7 +28,7 @@ parse_command_line_arguments(int argc, char **argv)
     // Set defaults.
     struct CommandLineArguments args = {.executable = argv[0],
                                         .oracle_path = NULL,
-                                        .test_path = NULL};
+                                        .test_paths = NULL};
 
     // Command line options.
     GOptionEntry entries[] = {
@@ -39,9 +42,9 @@ parse_command_line_arguments(int argc, char **argv)
         {"test",
          0,
          0,
-         G_OPTION_ARG_STRING,
-         &args.test_path,
-         "path to the MRC to test",
+         G_OPTION_ARG_FILENAME_ARRAY,
+         &args.test_paths,
+         "path to an MRC to test (may be repeated)",
          NULL},
         G_OPTION_ENTRY_NULL,
     };
@@ -59,19 +62,20 @@ parse_command_line_arguments(int argc, char **argv)
     errno = 0;
 
     // Check the arguments for correctness.
-    if (args.oracle_path == NULL || args.test_path == NULL) {
-        LOGGER_ERROR("invalid MRC oracle path '%s' or test path '%s'",
-                     args.oracle_path == NULL ? "(null)" : args.oracle_path,
-                     args.test_path == NULL ? "(null)" : args.test_path);
+    if (args.oracle_path == NULL || args.test_paths == NULL) {
+        LOGGER_ERROR("invalid MRC oracle path '%s' or no test paths",
+                     args.oracle_path == NULL ? "(null)" : args.oracle_path);
         goto cleanup;
     }
     if (!file_exists(args.oracle_path)) {
         LOGGER_ERROR("input MRC path '%s' DNE", args.oracle_path);
         goto cleanup;
     }
-    if (!file_exists(args.test_path)) {
-        LOGGER_ERROR("input MRC path '%s' DNE", args.test_path);
-        goto cleanup;
+    for (char **path = args.test_paths; *path != NULL; ++path) {
+        if (!file_exists(*path)) {
+            LOGGER_ERROR("input MRC path '%s' DNE", *path);
+            goto cleanup;
+        }
     }
     g_option_context_free(context);
     return args;
@@ -83,28 +87,110 @@ cleanup:
     exit(-1);
 }
 
+/// @brief  Open an MRC, viewing dense binary containers in place and
+///         loading anything else.
+/// @note   I still verify the container's checksum, but that is one
+///         sequential read with no allocation, parsing, or copying.
+static bool
+open_mrc(struct MissRateCurve *const mrc,
+         struct BinaryContainer *const container,
+         char const *const path)
+{
+    if (BinaryContainer__is_container(path) &&
+        BinaryContainer__open(container,
+                              path,
+                              BINARY_CONTAINER_KIND_MISS_RATE_CURVE,
+                              true) &&
+        container->index == NULL) {
+        return MissRateCurve__init_view(mrc, container);
+    }
+    BinaryContainer__close(container);
+    return MissRateCurve__load(mrc, path);
+}
+
+static void
+close_mrc(struct MissRateCurve *const mrc,
+          struct BinaryContainer *const container)
+{
+    if (container->header != NULL) {
+        // NOTE The MRC is a view into the container, so I do not free it.
+        BinaryContainer__close(container);
+        *mrc = (struct MissRateCurve){0};
+    } else {
+        MissRateCurve__destroy(mrc);
+    }
+}
+
 int
 main(int argc, char **argv)
 {
     struct CommandLineArguments args = {0};
     args = parse_command_line_arguments(argc, argv);
 
+    int status = EXIT_FAILURE;
     struct MissRateCurve oracle = {0};
-    struct MissRateCurve test = {0};
+    struct BinaryContainer oracle_container = {0};
+    size_t num_tests = 0;
+    while (args.test_paths[num_tests] != NULL) {
+        ++num_tests;
+    }
+    struct MissRateCurve *tests = calloc(num_tests, sizeof(*tests));
+    struct BinaryContainer *containers =
+        calloc(num_tests, sizeof(*containers));
+    struct MissRateCurve const **test_ptrs =
+        calloc(num_tests, sizeof(*test_ptrs));
+    double *maes = calloc(num_tests, sizeof(*maes));
+    double *mses = calloc(num_tests, sizeof(*mses));
+    if (tests == NULL || containers == NULL || test_ptrs == NULL ||
+        maes == NULL || mses == NULL) {
+        LOGGER_ERROR("failed to allocate %zu tests", num_tests);
+        goto cleanup;
+    }
 
-    if (!MissRateCurve__load(&oracle, args.oracle_path)) {
+    if (!open_mrc(&oracle, &oracle_container, args.oracle_path)) {
         LOGGER_ERROR("failed to load oracle from '%s'", args.oracle_path);
-        return EXIT_FAILURE;
+        goto cleanup;
     }
-    if (!MissRateCurve__load(&test, args.test_path)) {
-        LOGGER_ERROR("failed to load test from '%s'", args.test_path);
-        return EXIT_FAILURE;
+    for (size_t i = 0; i < num_tests; ++i) {
+        if (!open_mrc(&tests[i], &containers[i], args.test_paths[i])) {
+            LOGGER_ERROR("failed to load test from '%s'", args.test_paths[i]);
+            goto cleanup;
+        }
+        test_ptrs[i] = &tests[i];
     }
 
-    double const mae = MissRateCurve__mean_absolute_error(&oracle, &test);
-    double const mse = MissRateCurve__mean_squared_error(&oracle, &test);
-    LOGGER_INFO("MAE: %f | MSE: %f", mae, mse);
+    // NOTE I compare every test against the oracle in one pass over it.
+    if (!MissRateCurve__batch_mean_absolute_error(&oracle,
+                                                  test_ptrs,
+                                                  num_tests,
+                                                  maes) ||
+        !MissRateCurve__batch_mean_squared_error(&oracle,
+                                                 test_ptrs,
+                                                 num_tests,
+                                                 mses)) {
+        LOGGER_ERROR("failed to compare MRCs");
+        goto cleanup;
+    }
+    for (size_t i = 0; i < num_tests; ++i) {
+        LOGGER_INFO("%s | MAE: %f | MSE: %f",
+                    args.test_paths[i],
+                    maes[i],
+                    mses[i]);
+    }
 
     LOGGER_INFO("=== SUCCESS ===");
-    return 0;
+    status = EXIT_SUCCESS;
+cleanup:
+    close_mrc(&oracle, &oracle_container);
+    for (size_t i = 0; tests != NULL && containers != NULL && i < num_tests;
+         ++i) {
+        close_mrc(&tests[i], &containers[i]);
+    }
+    free(tests);
+    free(containers);
+    free(test_ptrs);
+    free(maes);
+    free(mses);
+    g_strfreev(args.test_paths);
+    return status;
 }
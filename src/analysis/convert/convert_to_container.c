@@ -0,0 +1,158 @@
+/**
+ *  @brief  Convert a histogram or MRC (in either the legacy format or the
+ *          binary container) into a binary container.
+ *
+ *  This lets us upgrade the outputs of old runs in place, e.g.
+ *  ./convert_to_container_exe --type mrc --input x-mrc.bin --output x-mrc.bin
+ */
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glib.h>
+
+#include "file/file.h"
+#include "histogram/histogram.h"
+#include "logger/logger.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+
+struct CommandLineArguments {
+    char *executable;
+
+    char *input_path;
+    char *output_path;
+    // Either 'histogram' or 'mrc'
+    char *type;
+    gboolean sparse;
+};
+
+static struct CommandLineArguments
+parse_command_line_arguments(int argc, char **argv)
+{
+    gchar *help_msg = NULL;
+
+    // Set defaults.
+    struct CommandLineArguments args = {.executable = argv[0],
+                                        .input_path = NULL,
+                                        .output_path = NULL,
+                                        .type = NULL,
+                                        .sparse = FALSE};
+
+    // Command line options.
+    GOptionEntry entries[] = {
+        {"input",
+         'i',
+         0,
+         G_OPTION_ARG_FILENAME,
+         &args.input_path,
+         "path to the input histogram or MRC",
+         NULL},
+        {"output",
+         'o',
+         0,
+         G_OPTION_ARG_FILENAME,
+         &args.output_path,
+         "path to the output container (may equal the input)",
+         NULL},
+        {"type",
+         't',
+         0,
+         G_OPTION_ARG_STRING,
+         &args.type,
+         "type of the input: {histogram,mrc}",
+         NULL},
+        {"sparse",
+         0,
+         0,
+         G_OPTION_ARG_NONE,
+         &args.sparse,
+         "store only non-zero bins (histogram) or changes (MRC)",
+         NULL},
+        G_OPTION_ENTRY_NULL,
+    };
+
+    GError *error = NULL;
+    GOptionContext *context;
+    context = g_option_context_new("- convert to the binary container");
+    g_option_context_add_main_entries(context, entries, NULL);
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_print("option parsing failed: %s\n", error->message);
+        goto cleanup;
+    }
+    // Come on, GLib! The 'g_option_context_parse' changes the errno to
+    // 2 and leaves it for me to clean up. Or maybe I'm using it wrong.
+    errno = 0;
+
+    // Check the arguments for correctness.
+    if (args.input_path == NULL || args.output_path == NULL ||
+        args.type == NULL) {
+        LOGGER_ERROR("input, output, and type are required");
+        goto cleanup;
+    }
+    if (strcmp(args.type, "histogram") != 0 && strcmp(args.type, "mrc") != 0) {
+        LOGGER_ERROR("unrecognized type '%s'", args.type);
+        goto cleanup;
+    }
+    if (!file_exists(args.input_path)) {
+        LOGGER_ERROR("input path '%s' DNE", args.input_path);
+        goto cleanup;
+    }
+    g_option_context_free(context);
+    return args;
+cleanup:
+    help_msg = g_option_context_get_help(context, FALSE, NULL);
+    g_print("%s", help_msg);
+    free(help_msg);
+    g_option_context_free(context);
+    exit(-1);
+}
+
+/// @note   I load the whole input before writing the output, so the
+///         output may overwrite the input.
+static bool
+convert_histogram(struct CommandLineArguments const *const args)
+{
+    struct Histogram hist = {0};
+    if (!Histogram__load(&hist, args->input_path)) {
+        LOGGER_ERROR("failed to load histogram from '%s'", args->input_path);
+        return false;
+    }
+    bool const r =
+        Histogram__save_binary(&hist, args->output_path, args->sparse);
+    Histogram__destroy(&hist);
+    return r;
+}
+
+static bool
+convert_mrc(struct CommandLineArguments const *const args)
+{
+    struct MissRateCurve mrc = {0};
+    if (!MissRateCurve__load(&mrc, args->input_path)) {
+        LOGGER_ERROR("failed to load MRC from '%s'", args->input_path);
+        return false;
+    }
+    bool const r =
+        MissRateCurve__save_binary(&mrc, args->output_path, args->sparse);
+    MissRateCurve__destroy(&mrc);
+    return r;
+}
+
+int
+main(int argc, char **argv)
+{
+    struct CommandLineArguments args = {0};
+    args = parse_command_line_arguments(argc, argv);
+
+    bool const ok = strcmp(args.type, "histogram") == 0
+                        ? convert_histogram(&args)
+                        : convert_mrc(&args);
+    if (!ok) {
+        LOGGER_ERROR("failed to convert '%s' to '%s'",
+                     args.input_path,
+                     args.output_path);
+    }
+    g_free(args.input_path);
+    g_free(args.output_path);
+    g_free(args.type);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -287,6 +287,8 @@ def get_runner_arguments_from_log(
         rf"mode=(\w+), "
         rf"adj=(true|false), "
         rf"qmrc_size=(\d+), "
+        # Older logs do not have the snapshot interval.
+        rf"(?:snapshot=(\d+), )?"
         rf"dictionary={{.*}}"
         rf"\)"
     )
@@ -311,6 +313,7 @@ def get_runner_arguments_from_log(
             mode=m.group(8),
             adj=str2bool(m.group(9)),
             qmrc_size=int(m.group(10)),
+            snapshot=int(m.group(11) or 0),
         )
         for m in matching_lines
     ]
@@ -0,0 +1,74 @@
+"""Read the binary container from 'src/lib/io/include/io/binary_container.h'.
+
+The plotting scripts want (scaled index, value) pairs like the legacy
+sparse formats, so that is what I return. I memory map the file, so
+only the sections we read are loaded.
+"""
+
+from pathlib import Path
+
+import numpy as np
+
+MAGIC = b"CACHEBIN"
+VERSION = 1
+KIND_HISTOGRAM = 1
+KIND_MISS_RATE_CURVE = 2
+LAYOUT_SPARSE = 1
+
+HEADER_DTYPE = np.dtype(
+    [
+        ("magic", "S8"),
+        ("version", np.uint32),
+        ("kind", np.uint32),
+        ("layout", np.uint32),
+        ("fill", np.uint32),
+        ("num_elements", np.uint64),
+        ("num_entries", np.uint64),
+        ("values_offset", np.uint64),
+        ("index_offset", np.uint64),
+        ("file_size", np.uint64),
+        ("checksum", np.uint64),
+        ("metadata", np.uint64, (6,)),
+        ("reserved", np.uint64),
+    ]
+)
+assert HEADER_DTYPE.itemsize == 128
+
+# The first metadata field is the bin size for both histograms and MRCs.
+METADATA_BIN_SIZE = 0
+HISTOGRAM_METADATA_RUNNING_SUM = 3
+
+
+def is_binary_container(path: Path) -> bool:
+    with open(path, "rb") as f:
+        return f.read(len(MAGIC)) == MAGIC
+
+
+def read_header(path: Path) -> np.ndarray:
+    header = np.fromfile(path, dtype=HEADER_DTYPE, count=1)[0]
+    if header["magic"] != MAGIC or header["version"] != VERSION:
+        raise ValueError(f"'{path}' is not a version {VERSION} container")
+    return header
+
+
+def read_sparse(path: Path, kind: int) -> tuple[np.ndarray, np.ndarray, np.ndarray]:
+    """Return the header, the scaled indices, and the stored values.
+
+    For sparse MRCs, the omitted bins equal the previous value, so the
+    pairs are ready for a 'where="post"' step plot."""
+    header = read_header(path)
+    if header["kind"] != kind:
+        raise ValueError(f"expected kind {kind}, got {header['kind']}")
+    n = int(header["num_entries"])
+    value_dtype = np.uint64 if kind == KIND_HISTOGRAM else np.float64
+    mm = np.memmap(path, dtype=np.uint8, mode="r")
+    values = np.frombuffer(
+        mm, dtype=value_dtype, count=n, offset=int(header["values_offset"])
+    )
+    if header["layout"] == LAYOUT_SPARSE:
+        index = np.frombuffer(
+            mm, dtype=np.uint64, count=n, offset=int(header["index_offset"])
+        )
+    else:
+        index = np.arange(n, dtype=np.uint64)
+    return header, index * header["metadata"][METADATA_BIN_SIZE], values
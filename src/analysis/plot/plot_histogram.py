@@ -8,6 +8,13 @@ from pathlib import Path
 import numpy as np
 import matplotlib.pyplot as plt
 
+from binary_container import (
+    HISTOGRAM_METADATA_RUNNING_SUM,
+    KIND_HISTOGRAM,
+    is_binary_container,
+    read_sparse,
+)
+
 
 def plot_sparse_histogram(
     input_paths: list[Path], output_path: Path, log_x: bool, log_y: bool, cdf: bool
@@ -31,14 +38,23 @@ def plot_sparse_histogram(
     fig.supylabel("Frequency")
 
     for i, input_path in enumerate(input_paths):
-        header = np.fromfile(input_path, dtype=header_dtype, count=1)
-        sparse_array = np.fromfile(
-            input_path, dtype=dtype, offset=header_dtype.itemsize
-        )
-        index, frequency = sparse_array[:]["index"], sparse_array[:]["frequency"]
+        if is_binary_container(input_path):
+            header, index, frequency = read_sparse(input_path, KIND_HISTOGRAM)
+            # NOTE Dense containers store the empty bins too.
+            nonzero = frequency != 0
+            index, frequency = index[nonzero], frequency[nonzero]
+            running_sum = header["metadata"][HISTOGRAM_METADATA_RUNNING_SUM]
+        else:
+            header = np.fromfile(input_path, dtype=header_dtype, count=1)
+            sparse_array = np.fromfile(
+                input_path, dtype=dtype, offset=header_dtype.itemsize
+            )
+            index = sparse_array[:]["index"]
+            frequency = sparse_array[:]["frequency"]
+            running_sum = header[0]["running_sum"]
         axs[0][i].title.set_text(input_path.stem)
         if cdf:
-            frequency = np.cumsum(frequency) / header[0]["running_sum"]
+            frequency = np.cumsum(frequency) / running_sum
         if log_x and log_y:
             axs[0][i].loglog(index, frequency)
         elif log_x:
@@ -6,6 +6,8 @@ from warnings import warn
 import numpy as np
 import matplotlib.pyplot as plt
 
+from binary_container import KIND_MISS_RATE_CURVE, is_binary_container, read_sparse
+
 
 def timing(f):
     """I ripped this off of StackOverFlow: https://stackoverflow.com/questions/1622943/timeit-versus-timing-decorator"""
@@ -31,6 +33,18 @@ def read_and_plot_mrc(path: Path, label: str, debug: bool, separator: str):
         warn(f"{str(path)} DNE")
         return
     dt = np.dtype([("index", np.uint64), ("miss-rate", np.float64)])
+    if separator == "" and is_binary_container(path):
+        _, index, miss_rate = read_sparse(path, KIND_MISS_RATE_CURVE)
+        sparse_mrc = np.empty(len(index), dtype=dt)
+        sparse_mrc["index"], sparse_mrc["miss-rate"] = index, miss_rate
+    else:
+        sparse_mrc = read_legacy_mrc(path, dt, separator)
+    if debug:
+        print(sparse_mrc)
+    plt.step(sparse_mrc["index"], sparse_mrc["miss-rate"], where="post", label=label)
+
+
+def read_legacy_mrc(path: Path, dt: np.dtype, separator: str):
     with open(path, "rb") as f:
         if separator == "":
             _ = np.fromfile(
@@ -41,9 +55,7 @@ def read_and_plot_mrc(path: Path, label: str, debug: bool, separator: str):
             sparse_mrc = np.fromfile(f, dtype=dt)
         else:
             sparse_mrc = np.loadtxt(f, dtype=dt, delimiter=separator)
-    if debug:
-        print(sparse_mrc)
-    plt.step(sparse_mrc["index"], sparse_mrc["miss-rate"], where="post", label=label)
+    return sparse_mrc
 
 
 @timing
@@ -0,0 +1,568 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ARRAY_KERNELS_X86
+#include <immintrin.h>
+#endif /* __x86_64__ || __i386__ */
+
+#include "array/array_kernels.h"
+#include "cpu_features/cpu_features.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// SCALAR KERNELS
+////////////////////////////////////////////////////////////////////////////////
+
+/// @param  remainder: the total minus the values before these ones.
+static uint64_t
+normalized_suffix_sums_scalar(uint64_t const *const values,
+                              size_t const n,
+                              uint64_t remainder,
+                              uint64_t const total,
+                              double *const out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = (double)remainder / (double)total;
+        remainder -= values[i];
+    }
+    return remainder;
+}
+
+static void
+scaled_iadd_scalar(double *const dst,
+                   double const *const src,
+                   size_t const n,
+                   double const scale)
+{
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] += scale * src[i];
+    }
+}
+
+/// @param  broadcast: whether to compare 'lhs[0]' against every 'rhs[i]'
+///                    rather than 'lhs[i]'.
+/// @note   The flags are constant at every call site, so the compiler
+///         generates a specialized loop for each.
+static inline double
+sum_error_scalar(double const *const lhs,
+                 bool const broadcast,
+                 double const *const rhs,
+                 size_t const n,
+                 bool const squared)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double const d = lhs[broadcast ? 0 : i] - rhs[i];
+        sum += squared ? d * d : (d < 0.0 ? -d : d);
+    }
+    return sum;
+}
+
+static inline double
+sum_squared_error_u64_scalar(uint64_t const *const lhs,
+                             uint64_t const *const rhs,
+                             size_t const n)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double const d = (double)lhs[i] - (rhs == NULL ? 0.0 : rhs[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+#ifdef ARRAY_KERNELS_X86
+
+////////////////////////////////////////////////////////////////////////////////
+/// AVX2 KERNELS
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief  Convert unsigned 64-bit lanes to doubles, rounding exactly as a
+///         scalar cast does.
+/// @note   AVX2 has no such instruction, so I convert the 32-bit halves
+///         exactly with the 2^52 and 2^84 exponent tricks and round once
+///         when I add them.
+__attribute__((target("avx2"))) static inline __m256d
+u64_to_double_avx2(__m256i const x)
+{
+    __m256i const exp52 = _mm256_castpd_si256(_mm256_set1_pd(0x1p52));
+    __m256i const exp84 = _mm256_castpd_si256(_mm256_set1_pd(0x1p84));
+    // NOTE These are exactly 2^52 + lo and 2^84 + hi * 2^32.
+    __m256d const lo = _mm256_castsi256_pd(_mm256_blend_epi32(x, exp52, 0xAA));
+    __m256d const hi =
+        _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(x, 32), exp84));
+    __m256d const hi_minus_2p52 =
+        _mm256_sub_pd(hi, _mm256_set1_pd(0x1p84 + 0x1p52));
+    return _mm256_add_pd(hi_minus_2p52, lo);
+}
+
+__attribute__((target("avx2"))) static inline double
+horizontal_sum_avx2(__m256d const v)
+{
+    __m128d const sum = _mm_add_pd(_mm256_castpd256_pd128(v),
+                                   _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(sum) + _mm_cvtsd_f64(_mm_unpackhi_pd(sum, sum));
+}
+
+/// @brief  Compute the inclusive prefix sum of the four lanes.
+__attribute__((target("avx2"))) static inline __m256i
+prefix_sum_avx2(__m256i x)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    // NOTE Shift the lanes up by one, then by two, filling with zeros.
+    x = _mm256_add_epi64(
+        x,
+        _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)),
+                           zero,
+                           0x03));
+    x = _mm256_add_epi64(
+        x,
+        _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)),
+                           zero,
+                           0x0F));
+    return x;
+}
+
+__attribute__((target("avx2"))) static uint64_t
+normalized_suffix_sums_avx2(uint64_t const *const values,
+                            size_t const n,
+                            uint64_t const total,
+                            double *const out)
+{
+    __m256d const total_pd = _mm256_set1_pd((double)total);
+    __m256i remainder = _mm256_set1_epi64x((int64_t)total);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i const v = _mm256_loadu_si256((__m256i const *)&values[i]);
+        __m256i const inclusive = prefix_sum_avx2(v);
+        // NOTE out[i] uses the sum of the values strictly before i.
+        __m256i const r =
+            _mm256_add_epi64(_mm256_sub_epi64(remainder, inclusive), v);
+        _mm256_storeu_pd(&out[i],
+                         _mm256_div_pd(u64_to_double_avx2(r), total_pd));
+        remainder = _mm256_sub_epi64(
+            remainder,
+            _mm256_permute4x64_epi64(inclusive, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+    return normalized_suffix_sums_scalar(
+        &values[i],
+        n - i,
+        (uint64_t)_mm256_extract_epi64(remainder, 0),
+        total,
+        &out[i]);
+}
+
+__attribute__((target("avx2"))) static void
+scaled_iadd_avx2(double *const dst,
+                 double const *const src,
+                 size_t const n,
+                 double const scale)
+{
+    __m256d const s = _mm256_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d const x = _mm256_mul_pd(s, _mm256_loadu_pd(&src[i]));
+        _mm256_storeu_pd(&dst[i], _mm256_add_pd(_mm256_loadu_pd(&dst[i]), x));
+    }
+    scaled_iadd_scalar(&dst[i], &src[i], n - i, scale);
+}
+
+__attribute__((target("avx2"))) static inline __m256d
+error_avx2(__m256d const lhs, __m256d const rhs, bool const squared)
+{
+    __m256d const d = _mm256_sub_pd(lhs, rhs);
+    return squared ? _mm256_mul_pd(d, d)
+                   : _mm256_andnot_pd(_mm256_set1_pd(-0.0), d);
+}
+
+__attribute__((target("avx2"))) static inline double
+sum_error_avx2(double const *const lhs,
+               bool const broadcast,
+               double const *const rhs,
+               size_t const n,
+               bool const squared)
+{
+    // NOTE I keep four accumulators to hide the latency of the additions.
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+    __m256d const b = broadcast ? _mm256_set1_pd(lhs[0]) : _mm256_setzero_pd();
+#define LHS_AVX2(j) (broadcast ? b : _mm256_loadu_pd(&lhs[(j)]))
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256d const r0 = _mm256_loadu_pd(&rhs[i]);
+        __m256d const r1 = _mm256_loadu_pd(&rhs[i + 4]);
+        __m256d const r2 = _mm256_loadu_pd(&rhs[i + 8]);
+        __m256d const r3 = _mm256_loadu_pd(&rhs[i + 12]);
+        acc0 = _mm256_add_pd(acc0, error_avx2(LHS_AVX2(i), r0, squared));
+        acc1 = _mm256_add_pd(acc1, error_avx2(LHS_AVX2(i + 4), r1, squared));
+        acc2 = _mm256_add_pd(acc2, error_avx2(LHS_AVX2(i + 8), r2, squared));
+        acc3 = _mm256_add_pd(acc3, error_avx2(LHS_AVX2(i + 12), r3, squared));
+    }
+    for (; i + 4 <= n; i += 4) {
+        __m256d const r0 = _mm256_loadu_pd(&rhs[i]);
+        acc0 = _mm256_add_pd(acc0, error_avx2(LHS_AVX2(i), r0, squared));
+    }
+#undef LHS_AVX2
+    __m256d const acc =
+        _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3));
+    return horizontal_sum_avx2(acc) +
+           sum_error_scalar(broadcast ? lhs : &lhs[i],
+                            broadcast,
+                            &rhs[i],
+                            n - i,
+                            squared);
+}
+
+__attribute__((target("avx2"))) static double
+sum_squared_error_u64_avx2(uint64_t const *const lhs,
+                           uint64_t const *const rhs,
+                           size_t const n)
+{
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256d d0 = u64_to_double_avx2(
+            _mm256_loadu_si256((__m256i const *)&lhs[i]));
+        __m256d d1 = u64_to_double_avx2(
+            _mm256_loadu_si256((__m256i const *)&lhs[i + 4]));
+        if (rhs != NULL) {
+            d0 = _mm256_sub_pd(d0,
+                               u64_to_double_avx2(_mm256_loadu_si256(
+                                   (__m256i const *)&rhs[i])));
+            d1 = _mm256_sub_pd(d1,
+                               u64_to_double_avx2(_mm256_loadu_si256(
+                                   (__m256i const *)&rhs[i + 4])));
+        }
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(d0, d0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(d1, d1));
+    }
+    return horizontal_sum_avx2(_mm256_add_pd(acc0, acc1)) +
+           sum_squared_error_u64_scalar(&lhs[i],
+                                        rhs == NULL ? NULL : &rhs[i],
+                                        n - i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// AVX-512 KERNELS
+////////////////////////////////////////////////////////////////////////////////
+
+// NOTE I need AVX512DQ for the unsigned 64-bit to double conversions.
+#define AVX512_TARGET "avx512f,avx512dq"
+
+/// @brief  Compute the inclusive prefix sum of the eight lanes.
+__attribute__((target(AVX512_TARGET))) static inline __m512i
+prefix_sum_avx512(__m512i x)
+{
+    __m512i const zero = _mm512_setzero_si512();
+    // NOTE Shift the lanes up by one, two, then four, filling with zeros.
+    x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 7));
+    x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 6));
+    x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 4));
+    return x;
+}
+
+__attribute__((target(AVX512_TARGET))) static uint64_t
+normalized_suffix_sums_avx512(uint64_t const *const values,
+                              size_t const n,
+                              uint64_t const total,
+                              double *const out)
+{
+    __m512d const total_pd = _mm512_set1_pd((double)total);
+    __m512i const last_lane = _mm512_set1_epi64(7);
+    __m512i remainder = _mm512_set1_epi64((int64_t)total);
+    for (size_t i = 0; i < n; i += 8) {
+        // NOTE I finish the tail with a masked vector rather than a loop.
+        __mmask8 const m =
+            n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512i const v = _mm512_maskz_loadu_epi64(m, &values[i]);
+        __m512i const inclusive = prefix_sum_avx512(v);
+        __m512i const r =
+            _mm512_add_epi64(_mm512_sub_epi64(remainder, inclusive), v);
+        _mm512_mask_storeu_pd(&out[i],
+                              m,
+                              _mm512_div_pd(_mm512_cvtepu64_pd(r), total_pd));
+        remainder = _mm512_sub_epi64(
+            remainder,
+            _mm512_permutexvar_epi64(last_lane, inclusive));
+    }
+    return (uint64_t)_mm_cvtsi128_si64(_mm512_castsi512_si128(remainder));
+}
+
+__attribute__((target(AVX512_TARGET))) static void
+scaled_iadd_avx512(double *const dst,
+                   double const *const src,
+                   size_t const n,
+                   double const scale)
+{
+    __m512d const s = _mm512_set1_pd(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d const x = _mm512_mul_pd(s, _mm512_loadu_pd(&src[i]));
+        _mm512_storeu_pd(&dst[i], _mm512_add_pd(_mm512_loadu_pd(&dst[i]), x));
+    }
+    __mmask8 const m = (__mmask8)((1u << (n - i)) - 1);
+    __m512d const x = _mm512_mul_pd(s, _mm512_maskz_loadu_pd(m, &src[i]));
+    _mm512_mask_storeu_pd(&dst[i],
+                          m,
+                          _mm512_add_pd(_mm512_maskz_loadu_pd(m, &dst[i]), x));
+}
+
+__attribute__((target(AVX512_TARGET))) static inline __m512d
+error_avx512(__m512d const lhs, __m512d const rhs, bool const squared)
+{
+    __m512d const d = _mm512_sub_pd(lhs, rhs);
+    return squared ? _mm512_mul_pd(d, d) : _mm512_abs_pd(d);
+}
+
+__attribute__((target(AVX512_TARGET))) static inline double
+sum_error_avx512(double const *const lhs,
+                 bool const broadcast,
+                 double const *const rhs,
+                 size_t const n,
+                 bool const squared)
+{
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+    __m512d const b = broadcast ? _mm512_set1_pd(lhs[0]) : _mm512_setzero_pd();
+#define LHS_AVX512(j) (broadcast ? b : _mm512_loadu_pd(&lhs[(j)]))
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m512d const r0 = _mm512_loadu_pd(&rhs[i]);
+        __m512d const r1 = _mm512_loadu_pd(&rhs[i + 8]);
+        __m512d const r2 = _mm512_loadu_pd(&rhs[i + 16]);
+        __m512d const r3 = _mm512_loadu_pd(&rhs[i + 24]);
+        acc0 = _mm512_add_pd(acc0, error_avx512(LHS_AVX512(i), r0, squared));
+        acc1 =
+            _mm512_add_pd(acc1, error_avx512(LHS_AVX512(i + 8), r1, squared));
+        acc2 =
+            _mm512_add_pd(acc2, error_avx512(LHS_AVX512(i + 16), r2, squared));
+        acc3 =
+            _mm512_add_pd(acc3, error_avx512(LHS_AVX512(i + 24), r3, squared));
+    }
+    for (; i + 8 <= n; i += 8) {
+        __m512d const r0 = _mm512_loadu_pd(&rhs[i]);
+        acc0 = _mm512_add_pd(acc0, error_avx512(LHS_AVX512(i), r0, squared));
+    }
+#undef LHS_AVX512
+    __mmask8 const m = (__mmask8)((1u << (n - i)) - 1);
+    __m512d const l = broadcast ? b : _mm512_maskz_loadu_pd(m, &lhs[i]);
+    __m512d const r = _mm512_maskz_loadu_pd(m, &rhs[i]);
+    acc1 = _mm512_add_pd(acc1,
+                         _mm512_maskz_mov_pd(m, error_avx512(l, r, squared)));
+    return _mm512_reduce_add_pd(
+        _mm512_add_pd(_mm512_add_pd(acc0, acc1), _mm512_add_pd(acc2, acc3)));
+}
+
+__attribute__((target(AVX512_TARGET))) static double
+sum_squared_error_u64_avx512(uint64_t const *const lhs,
+                             uint64_t const *const rhs,
+                             size_t const n)
+{
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    for (size_t i = 0; i < n; i += 8) {
+        __mmask8 const m =
+            n - i >= 8 ? (__mmask8)0xFF : (__mmask8)((1u << (n - i)) - 1);
+        __m512d d = _mm512_cvtepu64_pd(_mm512_maskz_loadu_epi64(m, &lhs[i]));
+        if (rhs != NULL) {
+            d = _mm512_sub_pd(
+                d,
+                _mm512_cvtepu64_pd(_mm512_maskz_loadu_epi64(m, &rhs[i])));
+        }
+        // NOTE I alternate accumulators to hide the latency of the adds.
+        if (i % 16 == 0) {
+            acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(d, d));
+        } else {
+            acc1 = _mm512_add_pd(acc1, _mm512_mul_pd(d, d));
+        }
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+}
+
+#endif /* ARRAY_KERNELS_X86 */
+
+////////////////////////////////////////////////////////////////////////////////
+/// PUBLIC API
+////////////////////////////////////////////////////////////////////////////////
+
+bool
+ArrayKernel__is_supported(enum ArrayKernel const kernel)
+{
+    switch (kernel) {
+    case ARRAY_KERNEL_SCALAR:
+        return true;
+#ifdef ARRAY_KERNELS_X86
+    case ARRAY_KERNEL_AVX2:
+        return CpuFeatures__supports(CPU_FEATURE_AVX2);
+    case ARRAY_KERNEL_AVX512:
+        return CpuFeatures__supports(CPU_FEATURE_AVX512F |
+                                     CPU_FEATURE_AVX512DQ);
+#endif /* ARRAY_KERNELS_X86 */
+    default:
+        return false;
+    }
+}
+
+enum ArrayKernel
+ArrayKernel__best(void)
+{
+    if (ArrayKernel__is_supported(ARRAY_KERNEL_AVX512))
+        return ARRAY_KERNEL_AVX512;
+    if (ArrayKernel__is_supported(ARRAY_KERNEL_AVX2))
+        return ARRAY_KERNEL_AVX2;
+    return ARRAY_KERNEL_SCALAR;
+}
+
+char const *
+ArrayKernel__name(enum ArrayKernel const kernel)
+{
+    switch (kernel) {
+    case ARRAY_KERNEL_SCALAR:
+        return "scalar";
+    case ARRAY_KERNEL_AVX2:
+        return "avx2";
+    case ARRAY_KERNEL_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+/// @brief  Fall back to the scalar kernel if the CPU does not support this
+///         one.
+static enum ArrayKernel
+get_supported(enum ArrayKernel const kernel)
+{
+    return ArrayKernel__is_supported(kernel) ? kernel : ARRAY_KERNEL_SCALAR;
+}
+
+uint64_t
+ArrayKernel__normalized_suffix_sums(enum ArrayKernel const kernel,
+                                    uint64_t const *const values,
+                                    size_t const n,
+                                    uint64_t const total,
+                                    double *const out)
+{
+    switch (get_supported(kernel)) {
+#ifdef ARRAY_KERNELS_X86
+    case ARRAY_KERNEL_AVX2:
+        return normalized_suffix_sums_avx2(values, n, total, out);
+    case ARRAY_KERNEL_AVX512:
+        return normalized_suffix_sums_avx512(values, n, total, out);
+#endif /* ARRAY_KERNELS_X86 */
+    default:
+        return normalized_suffix_sums_scalar(values, n, total, total, out);
+    }
+}
+
+void
+ArrayKernel__scaled_iadd(enum ArrayKernel const kernel,
+                         double *const dst,
+                         double const *const src,
+                         size_t const n,
+                         double const scale)
+{
+    switch (get_supported(kernel)) {
+#ifdef ARRAY_KERNELS_X86
+    case ARRAY_KERNEL_AVX2:
+        scaled_iadd_avx2(dst, src, n, scale);
+        return;
+    case ARRAY_KERNEL_AVX512:
+        scaled_iadd_avx512(dst, src, n, scale);
+        return;
+#endif /* ARRAY_KERNELS_X86 */
+    default:
+        scaled_iadd_scalar(dst, src, n, scale);
+        return;
+    }
+}
+
+/// @brief  Dispatch one of the four error reductions.
+static double
+sum_error(enum ArrayKernel const kernel,
+          double const *const lhs,
+          bool const broadcast,
+          double const *const rhs,
+          size_t const n,
+          bool const squared)
+{
+    switch (get_supported(kernel)) {
+#ifdef ARRAY_KERNELS_X86
+    case ARRAY_KERNEL_AVX2:
+        if (squared) {
+            return broadcast ? sum_error_avx2(lhs, true, rhs, n, true)
+                             : sum_error_avx2(lhs, false, rhs, n, true);
+        }
+        return broadcast ? sum_error_avx2(lhs, true, rhs, n, false)
+                         : sum_error_avx2(lhs, false, rhs, n, false);
+    case ARRAY_KERNEL_AVX512:
+        if (squared) {
+            return broadcast ? sum_error_avx512(lhs, true, rhs, n, true)
+                             : sum_error_avx512(lhs, false, rhs, n, true);
+        }
+        return broadcast ? sum_error_avx512(lhs, true, rhs, n, false)
+                         : sum_error_avx512(lhs, false, rhs, n, false);
+#endif /* ARRAY_KERNELS_X86 */
+    default:
+        if (squared) {
+            return broadcast ? sum_error_scalar(lhs, true, rhs, n, true)
+                             : sum_error_scalar(lhs, false, rhs, n, true);
+        }
+        return broadcast ? sum_error_scalar(lhs, true, rhs, n, false)
+                         : sum_error_scalar(lhs, false, rhs, n, false);
+    }
+}
+
+double
+ArrayKernel__sum_absolute_error(enum ArrayKernel const kernel,
+                                double const *const lhs,
+                                double const *const rhs,
+                                size_t const n)
+{
+    return sum_error(kernel, lhs, false, rhs, n, false);
+}
+
+double
+ArrayKernel__sum_squared_error(enum ArrayKernel const kernel,
+                               double const *const lhs,
+                               double const *const rhs,
+                               size_t const n)
+{
+    return sum_error(kernel, lhs, false, rhs, n, true);
+}
+
+double
+ArrayKernel__sum_absolute_error_broadcast(enum ArrayKernel const kernel,
+                                          double const lhs,
+                                          double const *const rhs,
+                                          size_t const n)
+{
+    return sum_error(kernel, &lhs, true, rhs, n, false);
+}
+
+double
+ArrayKernel__sum_squared_error_broadcast(enum ArrayKernel const kernel,
+                                         double const lhs,
+                                         double const *const rhs,
+                                         size_t const n)
+{
+    return sum_error(kernel, &lhs, true, rhs, n, true);
+}
+
+double
+ArrayKernel__sum_squared_error_u64(enum ArrayKernel const kernel,
+                                   uint64_t const *const lhs,
+                                   uint64_t const *const rhs,
+                                   size_t const n)
+{
+    switch (get_supported(kernel)) {
+#ifdef ARRAY_KERNELS_X86
+    case ARRAY_KERNEL_AVX2:
+        return sum_squared_error_u64_avx2(lhs, rhs, n);
+    case ARRAY_KERNEL_AVX512:
+        return sum_squared_error_u64_avx512(lhs, rhs, n);
+#endif /* ARRAY_KERNELS_X86 */
+    default:
+        return sum_squared_error_u64_scalar(lhs, rhs, n);
+    }
+}
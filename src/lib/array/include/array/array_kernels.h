@@ -0,0 +1,100 @@
+/** @brief  Vectorized prefix sums and reductions over whole arrays, for
+ *          building and comparing MRCs.
+ *
+ *  Converting a histogram into an MRC and comparing MRCs are scalar loops
+ *  over millions of bins, and the accuracy sweeps run them thousands of
+ *  times per trace. These kernels process four (AVX2) or eight (AVX-512)
+ *  bins at a time.
+ *
+ *  The kernels are chosen at runtime (see 'cpu_features/cpu_features.h').
+ *  Unlike in 'hash/hash_batch.h', if the CPU does not support the
+ *  requested kernel, then I silently fall back to the scalar kernel.
+ *
+ *  @note   The prefix sums produce exactly the same results as the scalar
+ *          kernel. The reductions add in a different order, so they may
+ *          differ from it in the last few bits.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* !__cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum ArrayKernel {
+    ARRAY_KERNEL_SCALAR,
+    ARRAY_KERNEL_AVX2,
+    ARRAY_KERNEL_AVX512,
+};
+
+bool
+ArrayKernel__is_supported(enum ArrayKernel const kernel);
+
+/// @brief  Get the fastest kernel that this CPU supports.
+enum ArrayKernel
+ArrayKernel__best(void);
+
+char const *
+ArrayKernel__name(enum ArrayKernel const kernel);
+
+/// @brief  Compute 'out[i] = (total - values[0] - ... - values[i - 1]) /
+///         total', i.e. the fraction of the total at or after index i.
+/// @return The remainder, 'total - values[0] - ... - values[n - 1]'.
+/// @note   The caller must ensure that the values sum to at most 'total'.
+uint64_t
+ArrayKernel__normalized_suffix_sums(enum ArrayKernel const kernel,
+                                    uint64_t const *const values,
+                                    size_t const n,
+                                    uint64_t const total,
+                                    double *const out);
+
+/// @brief  Compute 'dst[i] += scale * src[i]'.
+void
+ArrayKernel__scaled_iadd(enum ArrayKernel const kernel,
+                         double *const dst,
+                         double const *const src,
+                         size_t const n,
+                         double const scale);
+
+/// @brief  Compute the sum of '|lhs[i] - rhs[i]|'.
+double
+ArrayKernel__sum_absolute_error(enum ArrayKernel const kernel,
+                                double const *const lhs,
+                                double const *const rhs,
+                                size_t const n);
+
+/// @brief  Compute the sum of '(lhs[i] - rhs[i])^2'.
+double
+ArrayKernel__sum_squared_error(enum ArrayKernel const kernel,
+                               double const *const lhs,
+                               double const *const rhs,
+                               size_t const n);
+
+/// @brief  Compute the sum of '|lhs - rhs[i]|'.
+double
+ArrayKernel__sum_absolute_error_broadcast(enum ArrayKernel const kernel,
+                                          double const lhs,
+                                          double const *const rhs,
+                                          size_t const n);
+
+/// @brief  Compute the sum of '(lhs - rhs[i])^2'.
+double
+ArrayKernel__sum_squared_error_broadcast(enum ArrayKernel const kernel,
+                                         double const lhs,
+                                         double const *const rhs,
+                                         size_t const n);
+
+/// @brief  Compute the sum of '((double)lhs[i] - (double)rhs[i])^2'.
+/// @param  rhs: may be NULL, in which case I treat it as all zeros.
+double
+ArrayKernel__sum_squared_error_u64(enum ArrayKernel const kernel,
+                                   uint64_t const *const lhs,
+                                   uint64_t const *const rhs,
+                                   size_t const n);
+
+#ifdef __cplusplus
+}
+#endif /* !__cplusplus */
@@ -0,0 +1,110 @@
+/** @brief  A Fenwick tree (i.e. binary indexed tree) over 'n' counts, so
+ *          that we can update a count and sum a prefix in O(log n) time.
+ *          QuickMRC and Mimir both use this to compute stack distances.
+ *
+ *  The tree is 1-indexed, so the caller allocates (n + 1) elements. The
+ *  counts themselves are 0-indexed, as usual. Deltas may be "negative"
+ *  because unsigned arithmetic wraps.
+ */
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+static inline size_t
+fenwick_tree_lowest_set_bit(size_t const x)
+{
+    return x & (~x + 1);
+}
+
+/// @brief  Add 'delta' to count 'idx'.
+static inline void
+fenwick_tree_add(uint64_t *const tree,
+                 size_t const n,
+                 size_t const idx,
+                 uint64_t const delta)
+{
+    assert(tree != NULL && idx < n);
+    for (size_t i = idx + 1; i <= n; i += fenwick_tree_lowest_set_bit(i)) {
+        tree[i] += delta;
+    }
+}
+
+/// @brief  Sum the counts [0, end).
+static inline uint64_t
+fenwick_tree_prefix_sum(uint64_t const *const tree, size_t const end)
+{
+    assert(tree != NULL);
+    uint64_t sum = 0;
+    for (size_t i = end; i > 0; i -= fenwick_tree_lowest_set_bit(i)) {
+        sum += tree[i];
+    }
+    return sum;
+}
+
+/// @brief  Get count 'i' from an array of 'stride' byte elements.
+static inline uint64_t
+fenwick_tree_get_count(void const *const counts,
+                       size_t const stride,
+                       size_t const i)
+{
+    return *(uint64_t const *)((char const *)counts + i * stride);
+}
+
+/// @brief  Rebuild the tree after counts [0, num_changed) have changed
+///         without changing their total.
+/// @param  counts: the first count, where each is 'stride' bytes after the
+///                 previous one (e.g. a field of an array of structs).
+/// @note   The nodes that only cover changed counts are rebuilt in O(M)
+///         time. The nodes that cover all of the changed counts have the
+///         same sum. The only other nodes that cover any changed count are
+///         the O(log N) nodes that partially overlap, which we recompute
+///         from their O(log N) children.
+static inline void
+fenwick_tree_rebuild_prefix(uint64_t *const tree,
+                            size_t const n,
+                            size_t const num_changed,
+                            void const *const counts,
+                            size_t const stride)
+{
+    assert(tree != NULL && counts != NULL && num_changed <= n);
+    for (size_t i = 1; i <= num_changed; ++i) {
+        tree[i] = fenwick_tree_get_count(counts, stride, i - 1);
+    }
+    for (size_t i = 1; i <= num_changed; ++i) {
+        size_t const parent = i + fenwick_tree_lowest_set_bit(i);
+        if (parent <= num_changed) {
+            tree[parent] += tree[i];
+        }
+    }
+    if (num_changed == 0) {
+        return;
+    }
+    for (size_t i = num_changed + fenwick_tree_lowest_set_bit(num_changed);
+         i <= n;
+         i += fenwick_tree_lowest_set_bit(i)) {
+        size_t const start = i - fenwick_tree_lowest_set_bit(i);
+        if (start == 0) {
+            // NOTE This node and all of its ancestors cover every changed
+            //      count.
+            break;
+        }
+        uint64_t sum = fenwick_tree_get_count(counts, stride, i - 1);
+        for (size_t child = i - 1; child > start;
+             child -= fenwick_tree_lowest_set_bit(child)) {
+            sum += tree[child];
+        }
+        tree[i] = sum;
+    }
+}
+
+/// @brief  Build the tree from all 'n' counts in O(n) time.
+static inline void
+fenwick_tree_build(uint64_t *const tree,
+                   size_t const n,
+                   void const *const counts,
+                   size_t const stride)
+{
+    fenwick_tree_rebuild_prefix(tree, n, n, counts, stride);
+}
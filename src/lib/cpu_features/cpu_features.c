@@ -0,0 +1,41 @@
+#include <stdbool.h>
+
+#include "cpu_features/cpu_features.h"
+
+/// @brief  Set once the features are detected, so that a CPU without any
+///         of them does not look undetected.
+#define CPU_FEATURES_DETECTED (1U << 31)
+
+static unsigned cached_features = 0;
+
+static unsigned
+detect_features(void)
+{
+    unsigned features = CPU_FEATURES_DETECTED;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        features |= CPU_FEATURE_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        features |= CPU_FEATURE_AVX512F;
+    }
+    if (__builtin_cpu_supports("avx512dq")) {
+        features |= CPU_FEATURE_AVX512DQ;
+    }
+#endif /* __x86_64__ || __i386__ */
+    return features;
+}
+
+bool
+CpuFeatures__supports(unsigned const features)
+{
+    // NOTE Threads that race to detect the features all find the same
+    //      ones, so it does not matter whose store wins.
+    unsigned cached = __atomic_load_n(&cached_features, __ATOMIC_RELAXED);
+    if (cached == 0) {
+        cached = detect_features();
+        __atomic_store_n(&cached_features, cached, __ATOMIC_RELAXED);
+    }
+    return (cached & features) == features;
+}
@@ -0,0 +1,34 @@
+/** @brief  Detect the CPU's vector extensions once, for the kernels that
+ *          are chosen at runtime (e.g. 'array/array_kernels.h',
+ *          'hash/hash_batch.h', and QMRC's epoch array).
+ *
+ *  Those kernels are compiled with the 'target' attribute, so the
+ *  libraries that hold them need no '-mavx2' flag and still run on CPUs
+ *  without these extensions. Before running a kernel, they ask here
+ *  whether this CPU supports it.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* !__cplusplus */
+
+#include <stdbool.h>
+
+enum CpuFeature {
+    CPU_FEATURE_AVX2 = 1 << 0,
+    CPU_FEATURE_AVX512F = 1 << 1,
+    CPU_FEATURE_AVX512DQ = 1 << 2,
+};
+
+/// @brief  Check whether the CPU supports all of 'features', a bitwise OR
+///         of 'enum CpuFeature'.
+/// @note   I detect the features on the first call and cache them, so
+///         this is cheap enough to call before every kernel. It is
+///         thread-safe. On CPUs other than x86, I report no features.
+bool
+CpuFeatures__supports(unsigned const features);
+
+#ifdef __cplusplus
+}
+#endif /* !__cplusplus */
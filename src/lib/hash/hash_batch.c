@@ -0,0 +1,334 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HASH_BATCH_X86
+#include <immintrin.h>
+#endif /* __x86_64__ || __i386__ */
+
+#include "cpu_features/cpu_features.h"
+#include "hash/MurmurHash3.h"
+#include "hash/hash.h"
+#include "hash/hash_batch.h"
+#include "hash/splitmix64.h"
+#include "hash/types.h"
+
+#define SPLITMIX64_GAMMA UINT64_C(0x9e3779b97f4a7c15)
+#define SPLITMIX64_M1    UINT64_C(0xbf58476d1ce4e5b9)
+#define SPLITMIX64_M2    UINT64_C(0x94d049bb133111eb)
+#define MURMUR3_C1       UINT64_C(0x87c37b91114253d5)
+#define MURMUR3_C2       UINT64_C(0x4cf5ad432745937f)
+#define MURMUR3_F1       UINT64_C(0xff51afd7ed558ccd)
+#define MURMUR3_F2       UINT64_C(0xc4ceb9fe1a85ec53)
+
+static inline Hash64BitType
+murmur3_x64_64_scalar(uint64_t const key)
+{
+    uint64_t hash[2] = {0, 0};
+    MurmurHash3_x64_128(&key, sizeof(key), 0, hash);
+    return hash[0];
+}
+
+static void
+splitmix64_hash__batch_scalar(uint64_t const *const keys,
+                              Hash64BitType *const hashes,
+                              size_t const n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        hashes[i] = splitmix64_hash(keys[i]);
+    }
+}
+
+static void
+murmur3_x64_64__batch_scalar(uint64_t const *const keys,
+                             Hash64BitType *const hashes,
+                             size_t const n)
+{
+    for (size_t i = 0; i < n; ++i) {
+        hashes[i] = murmur3_x64_64_scalar(keys[i]);
+    }
+}
+
+#ifdef HASH_BATCH_X86
+
+////////////////////////////////////////////////////////////////////////////////
+/// AVX2 KERNELS
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief  Multiply 64-bit lanes, keeping the low 64 bits.
+/// @note   AVX2 only multiplies 32-bit halves, so I build the product
+///         from lo*lo + ((hi*lo + lo*hi) << 32), dropping hi*hi, which
+///         overflows out of the low 64 bits anyway.
+__attribute__((target("avx2"))) static inline __m256i
+mullo64_avx2(__m256i const a, __m256i const b)
+{
+    __m256i const lo = _mm256_mul_epu32(a, b);
+    __m256i const cross =
+        _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                         _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+/// @brief  Compute 'x ^= x >> shift' on 64-bit lanes.
+#define XORSHIFT_AVX2(x, shift)                                                \
+    _mm256_xor_si256((x), _mm256_srli_epi64((x), (shift)))
+
+__attribute__((target("avx2"))) static inline __m256i
+splitmix64_avx2(__m256i k)
+{
+    k = _mm256_add_epi64(k, _mm256_set1_epi64x(SPLITMIX64_GAMMA));
+    k = mullo64_avx2(XORSHIFT_AVX2(k, 30), _mm256_set1_epi64x(SPLITMIX64_M1));
+    k = mullo64_avx2(XORSHIFT_AVX2(k, 27), _mm256_set1_epi64x(SPLITMIX64_M2));
+    return XORSHIFT_AVX2(k, 31);
+}
+
+__attribute__((target("avx2"))) static inline __m256i
+fmix64_avx2(__m256i k)
+{
+    k = mullo64_avx2(XORSHIFT_AVX2(k, 33), _mm256_set1_epi64x(MURMUR3_F1));
+    k = mullo64_avx2(XORSHIFT_AVX2(k, 33), _mm256_set1_epi64x(MURMUR3_F2));
+    return XORSHIFT_AVX2(k, 33);
+}
+
+/// @brief  MurmurHash3_x64_128 specialized to an 8-byte key and a seed of
+///         0, where the whole key is the 'tail' and mixes into h1 alone.
+__attribute__((target("avx2"))) static inline __m256i
+murmur3_x64_64_avx2(__m256i k)
+{
+    k = mullo64_avx2(k, _mm256_set1_epi64x(MURMUR3_C1));
+    k = _mm256_or_si256(_mm256_slli_epi64(k, 31), _mm256_srli_epi64(k, 33));
+    k = mullo64_avx2(k, _mm256_set1_epi64x(MURMUR3_C2));
+    __m256i const len = _mm256_set1_epi64x(sizeof(uint64_t));
+    __m256i h1 = _mm256_xor_si256(k, len);
+    __m256i h2 = len;
+    h1 = _mm256_add_epi64(h1, h2);
+    h2 = _mm256_add_epi64(h2, h1);
+    h1 = fmix64_avx2(h1);
+    h2 = fmix64_avx2(h2);
+    return _mm256_add_epi64(h1, h2);
+}
+
+__attribute__((target("avx2"))) static void
+splitmix64_hash__batch_avx2(uint64_t const *const keys,
+                            Hash64BitType *const hashes,
+                            size_t const n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i const k = _mm256_loadu_si256((__m256i const *)&keys[i]);
+        _mm256_storeu_si256((__m256i *)&hashes[i], splitmix64_avx2(k));
+    }
+    splitmix64_hash__batch_scalar(&keys[i], &hashes[i], n - i);
+}
+
+__attribute__((target("avx2"))) static void
+murmur3_x64_64__batch_avx2(uint64_t const *const keys,
+                           Hash64BitType *const hashes,
+                           size_t const n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i const k = _mm256_loadu_si256((__m256i const *)&keys[i]);
+        _mm256_storeu_si256((__m256i *)&hashes[i], murmur3_x64_64_avx2(k));
+    }
+    murmur3_x64_64__batch_scalar(&keys[i], &hashes[i], n - i);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// AVX-512 KERNELS
+////////////////////////////////////////////////////////////////////////////////
+
+// NOTE AVX-512DQ has a native 64-bit multiply and AVX-512F a rotate.
+#define AVX512_TARGET "avx512f,avx512dq"
+#define XORSHIFT_AVX512(x, shift)                                              \
+    _mm512_xor_si512((x), _mm512_srli_epi64((x), (shift)))
+
+__attribute__((target(AVX512_TARGET))) static inline __m512i
+splitmix64_avx512(__m512i k)
+{
+    k = _mm512_add_epi64(k, _mm512_set1_epi64(SPLITMIX64_GAMMA));
+    k = _mm512_mullo_epi64(XORSHIFT_AVX512(k, 30),
+                           _mm512_set1_epi64(SPLITMIX64_M1));
+    k = _mm512_mullo_epi64(XORSHIFT_AVX512(k, 27),
+                           _mm512_set1_epi64(SPLITMIX64_M2));
+    return XORSHIFT_AVX512(k, 31);
+}
+
+__attribute__((target(AVX512_TARGET))) static inline __m512i
+fmix64_avx512(__m512i k)
+{
+    k = _mm512_mullo_epi64(XORSHIFT_AVX512(k, 33),
+                           _mm512_set1_epi64(MURMUR3_F1));
+    k = _mm512_mullo_epi64(XORSHIFT_AVX512(k, 33),
+                           _mm512_set1_epi64(MURMUR3_F2));
+    return XORSHIFT_AVX512(k, 33);
+}
+
+__attribute__((target(AVX512_TARGET))) static inline __m512i
+murmur3_x64_64_avx512(__m512i k)
+{
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(MURMUR3_C1));
+    k = _mm512_rol_epi64(k, 31);
+    k = _mm512_mullo_epi64(k, _mm512_set1_epi64(MURMUR3_C2));
+    __m512i const len = _mm512_set1_epi64(sizeof(uint64_t));
+    __m512i h1 = _mm512_xor_si512(k, len);
+    __m512i h2 = len;
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+    h1 = fmix64_avx512(h1);
+    h2 = fmix64_avx512(h2);
+    return _mm512_add_epi64(h1, h2);
+}
+
+__attribute__((target(AVX512_TARGET))) static void
+splitmix64_hash__batch_avx512(uint64_t const *const keys,
+                              Hash64BitType *const hashes,
+                              size_t const n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i const k = _mm512_loadu_si512(&keys[i]);
+        _mm512_storeu_si512(&hashes[i], splitmix64_avx512(k));
+    }
+    // NOTE I finish the tail with a masked vector rather than a loop.
+    __mmask8 const m = (__mmask8)((1u << (n - i)) - 1);
+    __m512i const k = _mm512_maskz_loadu_epi64(m, &keys[i]);
+    _mm512_mask_storeu_epi64(&hashes[i], m, splitmix64_avx512(k));
+}
+
+__attribute__((target(AVX512_TARGET))) static void
+murmur3_x64_64__batch_avx512(uint64_t const *const keys,
+                             Hash64BitType *const hashes,
+                             size_t const n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i const k = _mm512_loadu_si512(&keys[i]);
+        _mm512_storeu_si512(&hashes[i], murmur3_x64_64_avx512(k));
+    }
+    __mmask8 const m = (__mmask8)((1u << (n - i)) - 1);
+    __m512i const k = _mm512_maskz_loadu_epi64(m, &keys[i]);
+    _mm512_mask_storeu_epi64(&hashes[i], m, murmur3_x64_64_avx512(k));
+}
+
+#endif /* HASH_BATCH_X86 */
+
+////////////////////////////////////////////////////////////////////////////////
+/// PUBLIC API
+////////////////////////////////////////////////////////////////////////////////
+
+bool
+HashBatchKernel__is_supported(enum HashBatchKernel const kernel)
+{
+    switch (kernel) {
+    case HASH_BATCH_KERNEL_SCALAR:
+        return true;
+#ifdef HASH_BATCH_X86
+    case HASH_BATCH_KERNEL_AVX2:
+        return CpuFeatures__supports(CPU_FEATURE_AVX2);
+    case HASH_BATCH_KERNEL_AVX512:
+        return CpuFeatures__supports(CPU_FEATURE_AVX512F |
+                                     CPU_FEATURE_AVX512DQ);
+#endif /* HASH_BATCH_X86 */
+    default:
+        return false;
+    }
+}
+
+enum HashBatchKernel
+HashBatchKernel__best(void)
+{
+    if (HashBatchKernel__is_supported(HASH_BATCH_KERNEL_AVX512))
+        return HASH_BATCH_KERNEL_AVX512;
+    if (HashBatchKernel__is_supported(HASH_BATCH_KERNEL_AVX2))
+        return HASH_BATCH_KERNEL_AVX2;
+    return HASH_BATCH_KERNEL_SCALAR;
+}
+
+char const *
+HashBatchKernel__name(enum HashBatchKernel const kernel)
+{
+    switch (kernel) {
+    case HASH_BATCH_KERNEL_SCALAR:
+        return "scalar";
+    case HASH_BATCH_KERNEL_AVX2:
+        return "avx2";
+    case HASH_BATCH_KERNEL_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
+bool
+splitmix64_hash__batch(enum HashBatchKernel const kernel,
+                       uint64_t const *const keys,
+                       Hash64BitType *const hashes,
+                       size_t const n)
+{
+    if (!HashBatchKernel__is_supported(kernel))
+        return false;
+    switch (kernel) {
+    case HASH_BATCH_KERNEL_SCALAR:
+        splitmix64_hash__batch_scalar(keys, hashes, n);
+        return true;
+#ifdef HASH_BATCH_X86
+    case HASH_BATCH_KERNEL_AVX2:
+        splitmix64_hash__batch_avx2(keys, hashes, n);
+        return true;
+    case HASH_BATCH_KERNEL_AVX512:
+        splitmix64_hash__batch_avx512(keys, hashes, n);
+        return true;
+#endif /* HASH_BATCH_X86 */
+    default:
+        return false;
+    }
+}
+
+bool
+MurmurHash3_x64_64__batch(enum HashBatchKernel const kernel,
+                          uint64_t const *const keys,
+                          Hash64BitType *const hashes,
+                          size_t const n)
+{
+    if (!HashBatchKernel__is_supported(kernel))
+        return false;
+    switch (kernel) {
+    case HASH_BATCH_KERNEL_SCALAR:
+        murmur3_x64_64__batch_scalar(keys, hashes, n);
+        return true;
+#ifdef HASH_BATCH_X86
+    case HASH_BATCH_KERNEL_AVX2:
+        murmur3_x64_64__batch_avx2(keys, hashes, n);
+        return true;
+    case HASH_BATCH_KERNEL_AVX512:
+        murmur3_x64_64__batch_avx512(keys, hashes, n);
+        return true;
+#endif /* HASH_BATCH_X86 */
+    default:
+        return false;
+    }
+}
+
+void
+Hash64Bit__batch(uint64_t const *const keys,
+                 Hash64BitType *const hashes,
+                 size_t const n)
+{
+    // NOTE Checking the CPU's features is cheap next to a whole batch.
+    enum HashBatchKernel const kernel = HashBatchKernel__best();
+    switch (HASH_FUNCTION_SELECT) {
+    case 0:
+        MurmurHash3_x64_64__batch(kernel, keys, hashes, n);
+        break;
+    case 1:
+        splitmix64_hash__batch(kernel, keys, hashes, n);
+        break;
+    default:
+        for (size_t i = 0; i < n; ++i) {
+            hashes[i] = Hash64Bit(keys[i]);
+        }
+        break;
+    }
+}
@@ -0,0 +1,65 @@
+/** @brief  Hash whole arrays of keys at once with SIMD.
+ *
+ *  The samplers hash one key at a time, which leaves most of a modern
+ *  core's vector units idle. These functions hash n keys into n hashes,
+ *  four at a time with AVX2 or eight at a time with AVX-512, and produce
+ *  exactly the same hashes as the scalar functions in 'hash/hash.h'.
+ *
+ *  The kernels are chosen at runtime (see 'cpu_features/cpu_features.h').
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* !__cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hash/types.h"
+
+enum HashBatchKernel {
+    HASH_BATCH_KERNEL_SCALAR,
+    HASH_BATCH_KERNEL_AVX2,
+    HASH_BATCH_KERNEL_AVX512,
+};
+
+bool
+HashBatchKernel__is_supported(enum HashBatchKernel const kernel);
+
+/// @brief  Get the fastest kernel that this CPU supports.
+enum HashBatchKernel
+HashBatchKernel__best(void);
+
+char const *
+HashBatchKernel__name(enum HashBatchKernel const kernel);
+
+/// @brief  Compute 'hashes[i] = splitmix64_hash(keys[i])'.
+/// @return False if the kernel is not supported (and we did nothing).
+bool
+splitmix64_hash__batch(enum HashBatchKernel const kernel,
+                       uint64_t const *const keys,
+                       Hash64BitType *const hashes,
+                       size_t const n);
+
+/// @brief  Compute the first 64 bits of 'MurmurHash3_x64_128' of each
+///         8-byte key with a seed of 0, as in 'Hash64Bit'.
+/// @return False if the kernel is not supported (and we did nothing).
+bool
+MurmurHash3_x64_64__batch(enum HashBatchKernel const kernel,
+                          uint64_t const *const keys,
+                          Hash64BitType *const hashes,
+                          size_t const n);
+
+/// @brief  Compute 'hashes[i] = Hash64Bit(keys[i])' with the best kernel.
+/// @note   The miscellaneous hashes are inherently byte-serial, so I
+///         compute them with a scalar loop.
+void
+Hash64Bit__batch(uint64_t const *const keys,
+                 Hash64BitType *const hashes,
+                 size_t const n);
+
+#ifdef __cplusplus
+}
+#endif /* !__cplusplus */
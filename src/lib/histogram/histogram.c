@@ -10,9 +10,11 @@
 
 #include <glib.h>
 
+#include "array/array_kernels.h"
 #include "arrays/array_size.h"
 #include "histogram/histogram.h"
 #include "invariants/implies.h"
+#include "io/binary_container.h"
 #include "io/io.h"
 #include "logger/logger.h"
 #include "math/positive_ceiling_divide.h"
@@ -52,10 +54,53 @@ init_histogram(struct Histogram *const me,
     me->infinity = infinity;
     me->running_sum = running_sum;
     me->out_of_bounds_mode = out_of_bounds_mode;
+    me->block_sums = NULL;
 
     return true;
 }
 
+static inline size_t
+get_num_blocks(size_t const num_bins)
+{
+    return (num_bins + HISTOGRAM_BLOCK_SIZE - 1) >> HISTOGRAM_BLOCK_SHIFT;
+}
+
+/// @brief  Sum the bins in [begin, end).
+static inline uint64_t
+sum_bins(struct Histogram const *const me,
+         size_t const begin,
+         size_t const end)
+{
+    uint64_t sum = 0;
+    for (size_t i = begin; i < end; ++i) {
+        sum += me->histogram[i];
+    }
+    return sum;
+}
+
+/// @brief  Recompute the block sums from scratch.
+/// @note   Upon failure, I disable the block sums rather than leave them
+///         stale.
+static bool
+rebuild_block_sums(struct Histogram *const me)
+{
+    size_t const num_blocks = get_num_blocks(me->num_bins);
+    uint64_t *const block_sums =
+        realloc(me->block_sums, num_blocks * sizeof(*block_sums));
+    if (block_sums == NULL) {
+        LOGGER_ERROR("failed to allocate %zu block sums", num_blocks);
+        free(me->block_sums);
+        me->block_sums = NULL;
+        return false;
+    }
+    memset(block_sums, 0, num_blocks * sizeof(*block_sums));
+    for (size_t i = 0; i < me->num_bins; ++i) {
+        block_sums[i >> HISTOGRAM_BLOCK_SHIFT] += me->histogram[i];
+    }
+    me->block_sums = block_sums;
+    return true;
+}
+
 bool
 Histogram__init(struct Histogram *me,
                 size_t const num_bins,
@@ -224,16 +269,25 @@ stretch_histogram_if_necessary(struct Histogram *const me,
     }
 
     // NOTE This is a low entropy decision.
+    bool r = true;
     switch (me->out_of_bounds_mode) {
     case HistogramOutOfBoundsMode__allow_overflow:
         return true;
     case HistogramOutOfBoundsMode__merge_bins:
-        return merge_bins(me, index, horizontal_scale);
+        r = merge_bins(me, index, horizontal_scale);
+        break;
     case HistogramOutOfBoundsMode__realloc:
-        return alloc_more_histogram(me, index, horizontal_scale, 1.5);
+        r = alloc_more_histogram(me, index, horizontal_scale, 1.5);
+        break;
     default:
         return true;
     }
+    // NOTE Merging or reallocating moves the bins, so I recompute the
+    //      block sums. This is amortized like the stretch itself.
+    if (r && me->block_sums != NULL && !rebuild_block_sums(me)) {
+        LOGGER_WARN("disabled the prefix sums");
+    }
+    return r;
 }
 
 bool
@@ -258,7 +312,11 @@ Histogram__insert_scaled_finite(struct Histogram *me,
     //      spread it around. The optimizing compiler should remove it.
     if (fits_in_histogram(me, index, scale)) {
         uint64_t const scaled_index = scale * index;
-        me->histogram[scaled_index / me->bin_size] += scale;
+        size_t const bin = scaled_index / me->bin_size;
+        me->histogram[bin] += scale;
+        if (me->block_sums != NULL) {
+            me->block_sums[bin >> HISTOGRAM_BLOCK_SHIFT] += scale;
+        }
         me->running_sum += scale;
     } else {
         me->false_infinity += scale;
@@ -307,6 +365,11 @@ Histogram__clear(struct Histogram *const me)
     }
 
     memset(me->histogram, 0, me->num_bins * sizeof(*me->histogram));
+    if (me->block_sums != NULL) {
+        memset(me->block_sums,
+               0,
+               get_num_blocks(me->num_bins) * sizeof(*me->block_sums));
+    }
     me->false_infinity = 0;
     me->infinity = 0;
     me->running_sum = 0;
@@ -472,6 +535,11 @@ Histogram__adjust_first_buckets(struct Histogram *me, int64_t const adjustment)
     }
 
     me->running_sum += adjustment - tmp_adj;
+    // NOTE This only runs once, in post-processing, so I do not bother to
+    //      update the touched blocks individually.
+    if (me->block_sums != NULL) {
+        rebuild_block_sums(me);
+    }
 
     // If the adjustment is larger than the number of elements, then
     // we have a problem!
@@ -643,10 +711,169 @@ cleanup:
     return false;
 }
 
+enum HistogramContainerMetadata {
+    HISTOGRAM_CONTAINER_BIN_SIZE,
+    HISTOGRAM_CONTAINER_FALSE_INFINITY,
+    HISTOGRAM_CONTAINER_INFINITY,
+    HISTOGRAM_CONTAINER_RUNNING_SUM,
+    HISTOGRAM_CONTAINER_OUT_OF_BOUNDS_MODE,
+};
+
+bool
+Histogram__save_binary(struct Histogram const *const me,
+                       char const *const path,
+                       bool const sparse)
+{
+    uint64_t *index = NULL, *values = NULL;
+    uint64_t num_entries = 0;
+    bool r = false;
+    if (!is_initialized(me) || path == NULL) {
+        return false;
+    }
+    uint64_t const metadata[BINARY_CONTAINER_METADATA_LENGTH] = {
+        [HISTOGRAM_CONTAINER_BIN_SIZE] = me->bin_size,
+        [HISTOGRAM_CONTAINER_FALSE_INFINITY] = me->false_infinity,
+        [HISTOGRAM_CONTAINER_INFINITY] = me->infinity,
+        [HISTOGRAM_CONTAINER_RUNNING_SUM] = me->running_sum,
+        [HISTOGRAM_CONTAINER_OUT_OF_BOUNDS_MODE] = me->out_of_bounds_mode,
+    };
+    if (!sparse) {
+        return BinaryContainer__save(path,
+                                     BINARY_CONTAINER_KIND_HISTOGRAM,
+                                     BINARY_CONTAINER_FILL_ZERO,
+                                     metadata,
+                                     me->num_bins,
+                                     me->histogram,
+                                     NULL,
+                                     me->num_bins);
+    }
+    for (size_t i = 0; i < me->num_bins; ++i) {
+        num_entries += me->histogram[i] != 0;
+    }
+    // NOTE I allocate at least one entry so that an empty histogram still
+    //      has non-NULL arrays.
+    index = malloc((num_entries + 1) * sizeof(*index));
+    values = malloc((num_entries + 1) * sizeof(*values));
+    if (index == NULL || values == NULL) {
+        LOGGER_ERROR("failed to allocate %" PRIu64 " entries", num_entries);
+        goto cleanup;
+    }
+    for (size_t i = 0, j = 0; i < me->num_bins; ++i) {
+        if (me->histogram[i] != 0) {
+            index[j] = i;
+            values[j] = me->histogram[i];
+            ++j;
+        }
+    }
+    r = BinaryContainer__save(path,
+                              BINARY_CONTAINER_KIND_HISTOGRAM,
+                              BINARY_CONTAINER_FILL_ZERO,
+                              metadata,
+                              me->num_bins,
+                              values,
+                              index,
+                              num_entries);
+cleanup:
+    free(index);
+    free(values);
+    return r;
+}
+
+static bool
+container_metadata_is_valid(struct BinaryContainer const *const container)
+{
+    uint64_t const *const metadata = container->header->metadata;
+    if (container->header->num_elements == 0 ||
+        metadata[HISTOGRAM_CONTAINER_BIN_SIZE] == 0 ||
+        metadata[HISTOGRAM_CONTAINER_OUT_OF_BOUNDS_MODE] >=
+            HistogramOutOfBoundsMode__INVALID) {
+        LOGGER_ERROR("bad histogram metadata");
+        return false;
+    }
+    return true;
+}
+
+static void
+init_metadata_from_container(struct Histogram *const me,
+                             struct BinaryContainer const *const container)
+{
+    uint64_t const *const metadata = container->header->metadata;
+    me->num_bins = container->header->num_elements;
+    me->bin_size = metadata[HISTOGRAM_CONTAINER_BIN_SIZE];
+    me->false_infinity = metadata[HISTOGRAM_CONTAINER_FALSE_INFINITY];
+    me->infinity = metadata[HISTOGRAM_CONTAINER_INFINITY];
+    me->running_sum = metadata[HISTOGRAM_CONTAINER_RUNNING_SUM];
+    me->out_of_bounds_mode = metadata[HISTOGRAM_CONTAINER_OUT_OF_BOUNDS_MODE];
+    me->block_sums = NULL;
+}
+
+bool
+Histogram__init_view(struct Histogram *const me,
+                     struct BinaryContainer const *const container)
+{
+    if (me == NULL || container == NULL || container->header == NULL ||
+        container->header->kind != BINARY_CONTAINER_KIND_HISTOGRAM) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    if (container->index != NULL) {
+        LOGGER_ERROR("cannot view a sparse histogram in place");
+        return false;
+    }
+    if (!container_metadata_is_valid(container)) {
+        return false;
+    }
+    init_metadata_from_container(me, container);
+    // NOTE The memory map is read-only, so writing through this pointer
+    //      will fault. I cast away the const because 'struct Histogram'
+    //      has no read-only variant.
+    me->histogram = (uint64_t *)container->values;
+    return true;
+}
+
+static bool
+load_container(struct Histogram *const me, char const *const path)
+{
+    struct BinaryContainer container = {0};
+    if (!BinaryContainer__open(&container,
+                               path,
+                               BINARY_CONTAINER_KIND_HISTOGRAM,
+                               true)) {
+        LOGGER_ERROR("failed to open '%s'", path);
+        return false;
+    }
+    if (!container_metadata_is_valid(&container)) {
+        goto cleanup;
+    }
+    init_metadata_from_container(me, &container);
+    if (!init_histogram(me,
+                        me->num_bins,
+                        me->bin_size,
+                        me->false_infinity,
+                        me->infinity,
+                        me->running_sum,
+                        me->out_of_bounds_mode)) {
+        LOGGER_ERROR("init failed");
+        goto cleanup;
+    }
+    if (!BinaryContainer__copy_dense(&container, me->histogram)) {
+        LOGGER_ERROR("failed to read histogram");
+        Histogram__destroy(me);
+        goto cleanup;
+    }
+    return BinaryContainer__close(&container);
+cleanup:
+    BinaryContainer__close(&container);
+    return false;
+}
+
 /// @brief  Read the full histogram from a file.
 bool
 Histogram__load(struct Histogram *const me, char const *const path)
 {
+    if (BinaryContainer__is_container(path)) {
+        return load_container(me, path);
+    }
     FILE *fp = fopen(path, "rb");
     if (fp == NULL) {
         LOGGER_ERROR("fopen failed to open '%s'", path);
@@ -714,10 +941,82 @@ Histogram__validate(struct Histogram const *const me)
                      me->running_sum);
         return false;
     }
+    for (size_t b = 0;
+         me->block_sums != NULL && b < get_num_blocks(me->num_bins);
+         ++b) {
+        size_t const begin = b << HISTOGRAM_BLOCK_SHIFT;
+        size_t const end = begin + HISTOGRAM_BLOCK_SIZE < me->num_bins
+                               ? begin + HISTOGRAM_BLOCK_SIZE
+                               : me->num_bins;
+        uint64_t const block_sum = sum_bins(me, begin, end);
+        if (block_sum != me->block_sums[b]) {
+            LOGGER_ERROR("incorrect sum of block %zu: %" PRIu64
+                         " vs %" PRIu64,
+                         b,
+                         block_sum,
+                         me->block_sums[b]);
+            return false;
+        }
+    }
 
     return true;
 }
 
+bool
+Histogram__enable_prefix_sums(struct Histogram *const me)
+{
+    if (!is_initialized(me)) {
+        return false;
+    }
+    return rebuild_block_sums(me);
+}
+
+/// @brief  Sum the bins from 'first' to the end of the histogram.
+static uint64_t
+sum_bins_from(struct Histogram const *const me, size_t const first)
+{
+    assert(first < me->num_bins);
+    if (me->block_sums == NULL) {
+        return sum_bins(me, first, me->num_bins);
+    }
+    size_t const num_blocks = get_num_blocks(me->num_bins);
+    size_t const block = first >> HISTOGRAM_BLOCK_SHIFT;
+    size_t const block_begin = block << HISTOGRAM_BLOCK_SHIFT;
+    uint64_t sum = 0;
+    // NOTE I add up whichever side of the block has fewer blocks and, if
+    //      that is the front, subtract it from the total of the bins.
+    if (block < num_blocks / 2) {
+        for (size_t b = 0; b < block; ++b) {
+            sum += me->block_sums[b];
+        }
+        sum += sum_bins(me, block_begin, first);
+        return me->running_sum - me->false_infinity - me->infinity - sum;
+    }
+    size_t const block_end = block_begin + HISTOGRAM_BLOCK_SIZE;
+    sum += sum_bins(me,
+                    first,
+                    block_end < me->num_bins ? block_end : me->num_bins);
+    for (size_t b = block + 1; b < num_blocks; ++b) {
+        sum += me->block_sums[b];
+    }
+    return sum;
+}
+
+double
+Histogram__get_fraction_at_least(struct Histogram const *const me,
+                                 uint64_t const value)
+{
+    if (!is_initialized(me) || me->running_sum == 0) {
+        return 0.0;
+    }
+    size_t const bin = value / me->bin_size;
+    uint64_t at_least = me->false_infinity + me->infinity;
+    if (bin < me->num_bins) {
+        at_least += sum_bins_from(me, bin);
+    }
+    return (double)at_least / (double)me->running_sum;
+}
+
 double
 Histogram__euclidean_error(struct Histogram const *const lhs,
                            struct Histogram const *const rhs)
@@ -739,20 +1038,21 @@ Histogram__euclidean_error(struct Histogram const *const lhs,
         LOGGER_WARN("empty histogram array");
     }
 
-    double mse = 0.0;
-    for (size_t i = 0; i < MIN(lhs->num_bins, rhs->num_bins); ++i) {
-        double diff = (double)lhs->histogram[i] - rhs->histogram[i];
-        mse += diff * diff;
-    }
+    enum ArrayKernel const kernel = ArrayKernel__best();
+    size_t const min_num_bins = MIN(lhs->num_bins, rhs->num_bins);
+    size_t const max_num_bins = MAX(lhs->num_bins, rhs->num_bins);
+    struct Histogram const *const longer =
+        lhs->num_bins > rhs->num_bins ? lhs : rhs;
+    double mse = ArrayKernel__sum_squared_error_u64(kernel,
+                                                    lhs->histogram,
+                                                    rhs->histogram,
+                                                    min_num_bins);
     // For the histogram, after the end of shorter histogram, we assume
     // the shorter histogram's frequency values would have been zero.
-    for (size_t i = MIN(lhs->num_bins, rhs->num_bins);
-         i < MAX(lhs->num_bins, rhs->num_bins);
-         ++i) {
-        double diff = lhs->num_bins > rhs->num_bins ? lhs->histogram[i]
-                                                    : rhs->histogram[i];
-        mse += diff * diff;
-    }
+    mse += ArrayKernel__sum_squared_error_u64(kernel,
+                                              &longer->histogram[min_num_bins],
+                                              NULL,
+                                              max_num_bins - min_num_bins);
     double diff = (double)lhs->false_infinity - rhs->false_infinity;
     mse += diff * diff;
     diff = (double)lhs->infinity - rhs->infinity;
@@ -760,21 +1060,80 @@ Histogram__euclidean_error(struct Histogram const *const lhs,
     return sqrt(mse);
 }
 
+/// @brief  Add 'src_num_bins' bins of 'src_bin_size' into 'dst', whose
+///         bins are of 'dst_bin_size'.
+/// @note   Each source bin goes into the destination bin that holds its
+///         lower bound. This is exact if 'dst_bin_size' is a multiple of
+///         'src_bin_size' (e.g. after merging bins), which is the common
+///         case. Otherwise, some frequencies land one bin early.
+static void
+add_bins(uint64_t *const dst,
+         size_t const dst_bin_size,
+         uint64_t const *const src,
+         size_t const src_num_bins,
+         size_t const src_bin_size)
+{
+    if (dst_bin_size == src_bin_size) {
+        for (size_t i = 0; i < src_num_bins; ++i) {
+            dst[i] += src[i];
+        }
+        return;
+    }
+    for (size_t i = 0; i < src_num_bins; ++i) {
+        dst[i * src_bin_size / dst_bin_size] += src[i];
+    }
+}
+
+/// @brief  Move the frequencies into 'num_bins' bins of 'bin_size'.
+/// @note   The new bins must cover at least the old range.
+static bool
+rebin(struct Histogram *const me, size_t const num_bins, size_t const bin_size)
+{
+    assert(num_bins * bin_size >= me->num_bins * me->bin_size);
+    uint64_t *const histogram = calloc(num_bins, sizeof(*histogram));
+    if (histogram == NULL) {
+        LOGGER_ERROR("failed to allocate %zu bins", num_bins);
+        return false;
+    }
+    add_bins(histogram, bin_size, me->histogram, me->num_bins, me->bin_size);
+    free(me->histogram);
+    me->histogram = histogram;
+    me->num_bins = num_bins;
+    me->bin_size = bin_size;
+    return true;
+}
+
 bool
 Histogram__iadd(struct Histogram *const me, struct Histogram const *const other)
 {
-    assert(me != NULL);
-    assert(other != NULL);
-    assert(me->histogram != NULL);
-    assert(other->histogram != NULL);
-    assert(me->bin_size == other->bin_size);
-    assert(me->num_bins == other->num_bins);
+    if (!is_initialized(me) || !is_initialized(other)) {
+        return false;
+    }
 
-    for (size_t i = 0; i < me->num_bins; ++i) {
-        me->histogram[i] += other->histogram[i];
+    // NOTE I merge into the coarser bin size and the larger range, so
+    //      that neither histogram loses any values to the false
+    //      infinity. Histograms that merged their bins (and so doubled
+    //      their bin size) still line up exactly.
+    size_t const bin_size = MAX(me->bin_size, other->bin_size);
+    size_t const range =
+        MAX(me->num_bins * me->bin_size, other->num_bins * other->bin_size);
+    size_t const num_bins = POSITIVE_CEILING_DIVIDE(range, bin_size);
+    if (num_bins != me->num_bins || bin_size != me->bin_size) {
+        if (!rebin(me, num_bins, bin_size)) {
+            return false;
+        }
     }
+    add_bins(me->histogram,
+             me->bin_size,
+             other->histogram,
+             other->num_bins,
+             other->bin_size);
     me->false_infinity += other->false_infinity;
     me->infinity += other->infinity;
+    me->running_sum += other->running_sum;
+    if (me->block_sums != NULL) {
+        rebuild_block_sums(me);
+    }
 
     return true;
 }
@@ -786,6 +1145,7 @@ Histogram__destroy(struct Histogram *me)
         return;
     }
     free(me->histogram);
+    free(me->block_sums);
     *me = (struct Histogram){0};
     return;
 }
@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "io/binary_container.h"
+
 static char const *const HISTOGRAM_MODE_STRINGS[] = {
     "allow_overflow",
     "merge_bins",
@@ -39,6 +41,11 @@ bool
 HistogramOutOfBoundsMode__parse(enum HistogramOutOfBoundsMode *me,
                                 char const *const str);
 
+/// @brief  The number of bins summed by each of the optional block sums
+///         (see 'Histogram__enable_prefix_sums').
+#define HISTOGRAM_BLOCK_SHIFT 6
+#define HISTOGRAM_BLOCK_SIZE  (1 << HISTOGRAM_BLOCK_SHIFT)
+
 /// @brief  Track (potentially scaled) equal-sized values by frequency.
 /// @note   I assume no overflow in any of these values!
 struct Histogram {
@@ -54,6 +61,10 @@ struct Histogram {
     uint64_t running_sum;
 
     enum HistogramOutOfBoundsMode out_of_bounds_mode;
+
+    /// The sum of each block of HISTOGRAM_BLOCK_SIZE bins, or NULL if
+    /// disabled. This lets us query the miss rate while still inserting.
+    uint64_t *block_sums;
 };
 
 bool
@@ -101,6 +112,9 @@ void
 Histogram__write_as_json(FILE *const stream, struct Histogram const *const me);
 
 /// @brief  Read the full histogram from a file.
+/// @note   I accept both the legacy format (from 'Histogram__save') and
+///         the binary container (from 'Histogram__save_binary'), which I
+///         tell apart by its magic string.
 bool
 Histogram__load(struct Histogram *const me, char const *const path);
 
@@ -108,10 +122,45 @@ Histogram__load(struct Histogram *const me, char const *const path);
 bool
 Histogram__save(struct Histogram const *const me, char const *const path);
 
+/// @brief  Save the histogram as a binary container (see
+///         'io/binary_container.h').
+/// @param  sparse: whether to store only the non-zero bins. A dense file
+///                 can be viewed in place with 'Histogram__init_view'.
+bool
+Histogram__save_binary(struct Histogram const *const me,
+                       char const *const path,
+                       bool const sparse);
+
+/// @brief  View a dense histogram container in place, without copying.
+/// @note   The histogram borrows the container's read-only memory, so do
+///         not modify or destroy it; close the container when done.
+bool
+Histogram__init_view(struct Histogram *const me,
+                     struct BinaryContainer const *const container);
+
 /// @brief  Write the Histogram as a JSON object to stdout.
 void
 Histogram__print_as_json(struct Histogram const *const me);
 
+/// @brief  Maintain the sum of every block of HISTOGRAM_BLOCK_SIZE bins,
+///         so that we can query the histogram in O(num_bins / block size)
+///         time without rebuilding an MRC.
+/// @note   This costs one more addition per insert. If you write to the
+///         'histogram' array directly, then call this again to rebuild
+///         the sums.
+bool
+Histogram__enable_prefix_sums(struct Histogram *const me);
+
+/// @brief  Get the fraction of values that are at least 'value', i.e. the
+///         miss rate of a cache of size 'value'.
+/// @note   This matches 'MissRateCurve__init_from_histogram' at multiples
+///         of the bin size. Past the last bin, I count every false
+///         infinity as a miss. It is O(num_bins / HISTOGRAM_BLOCK_SIZE)
+///         with prefix sums enabled and O(num_bins) otherwise.
+double
+Histogram__get_fraction_at_least(struct Histogram const *const me,
+                                 uint64_t const value);
+
 /// @brief  Adjust the histogram starting from the first bucket.
 /// @note   This is for the SHARDS-Adj algorithm.
 bool
@@ -127,7 +176,9 @@ Histogram__euclidean_error(struct Histogram const *const lhs,
 /// @brief  Add 'other' histogram into 'me'.
 /// @note   Python uses '__iadd__' to service the '+=' operator. That's
 ///         how I arrived at this somewhat cryptic name.
-/// @todo   Add error checking.
+/// @note   If the bin sizes or number of bins differ, then I rebin 'me'
+///         to the larger bin size and the larger range. This is exact if
+///         the larger bin size is a multiple of the smaller one.
 bool
 Histogram__iadd(struct Histogram *const me,
                 struct Histogram const *const other);
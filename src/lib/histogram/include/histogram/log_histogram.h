@@ -0,0 +1,133 @@
+/** @brief  A histogram with log-spaced bins, which bounds the relative
+ *          error of each value rather than the absolute error (like
+ *          HdrHistogram).
+ *
+ *  The dense 'Histogram' needs one bin per 'bin_size' values, so it needs
+ *  millions of bins (i.e. megabytes) to cover a large cache at a useful
+ *  precision. However, we rarely care whether a reuse distance is 10^9 or
+ *  10^9 + 1; only the relative precision matters. Here, I keep the top
+ *  'significant_bits' bits of each value:
+ *
+ *  1. Values below 2^significant_bits get a bin each, so they are exact.
+ *  2. Every other power of two, [2^e, 2^(e+1)), is split into
+ *     2^significant_bits equal sub-bins of width 2^(e - significant_bits).
+ *
+ *  Thus, each bin's width is at most 2^-significant_bits of its values,
+ *  and we find a value's bin in O(1) with a count-leading-zeros. For
+ *  example, with 7 significant bits (< 0.8% error), covering up to 2^34
+ *  (about 1.7 * 10^10) takes 3584 bins, or 28 KiB.
+ *
+ *  @note   Like the 'Histogram', I record finite values beyond the last
+ *          bin as 'false infinities'.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define LOG_HISTOGRAM_MAX_SIGNIFICANT_BITS 16
+
+struct LogHistogram {
+    uint64_t *histogram;
+    /// Number of bins in the histogram
+    size_t num_bins;
+    /// Number of bits of each value that we keep exactly, so there are
+    /// 2^significant_bits bins per power of two.
+    unsigned significant_bits;
+    /// We have seen this before, but we do not track stacks this large
+    uint64_t false_infinity;
+    /// We have not seen this before
+    uint64_t infinity;
+    uint64_t running_sum;
+};
+
+/// @param  significant_bits: the relative error of each bin is at most
+///                           2^-significant_bits.
+/// @param  max_value: the largest value to track without overflowing to
+///                    the 'false_infinity'.
+bool
+LogHistogram__init(struct LogHistogram *const me,
+                   unsigned const significant_bits,
+                   uint64_t const max_value);
+
+void
+LogHistogram__destroy(struct LogHistogram *const me);
+
+/// @brief  Get the bin that holds a value. This may be past the last bin.
+size_t
+LogHistogram__get_bin_index(struct LogHistogram const *const me,
+                            uint64_t const value);
+
+/// @brief  Get the smallest value in a bin.
+uint64_t
+LogHistogram__get_bin_lower_bound(struct LogHistogram const *const me,
+                                  size_t const bin_index);
+
+/// @brief  Get the number of values in a bin.
+uint64_t
+LogHistogram__get_bin_width(struct LogHistogram const *const me,
+                            size_t const bin_index);
+
+bool
+LogHistogram__insert_finite(struct LogHistogram *const me,
+                            uint64_t const index);
+
+/// @brief  Insert a non-infinite, scaled index. By scaled, I mean that the
+///         index represents multiple elements.
+/// @note   This matches 'Histogram__insert_scaled_finite', so it scales
+///         the index too.
+bool
+LogHistogram__insert_scaled_finite(struct LogHistogram *const me,
+                                   uint64_t const index,
+                                   uint64_t const scale);
+
+/// @brief  Insert a value that represents 'weight' elements.
+/// @note   Unlike 'LogHistogram__insert_scaled_finite', I do not scale the
+///         value, e.g. for reuse times that are measured in global time.
+bool
+LogHistogram__insert_weighted_finite(struct LogHistogram *const me,
+                                     uint64_t const value,
+                                     uint64_t const weight);
+
+bool
+LogHistogram__insert_infinite(struct LogHistogram *const me);
+
+bool
+LogHistogram__insert_scaled_infinite(struct LogHistogram *const me,
+                                     uint64_t const scale);
+
+/// @brief  Get the fraction of values that are at least 'value'.
+/// @note   I assume that the values are uniform within each bin.
+double
+LogHistogram__get_fraction_at_least(struct LogHistogram const *const me,
+                                    uint64_t const value);
+
+/// @brief  Add 'other' histogram into 'me'.
+/// @note   Both must have the same number of significant bits. If 'other'
+///         has more bins, then I record its extra values as 'false
+///         infinities'.
+bool
+LogHistogram__iadd(struct LogHistogram *const me,
+                   struct LogHistogram const *const other);
+
+void
+LogHistogram__clear(struct LogHistogram *const me);
+
+bool
+LogHistogram__validate(struct LogHistogram const *const me);
+
+/// @brief  Write the LogHistogram as a JSON object to an arbitrary stream.
+void
+LogHistogram__write_as_json(FILE *const stream,
+                            struct LogHistogram const *const me);
+
+/// @brief  Save the full histogram to a file.
+bool
+LogHistogram__save(struct LogHistogram const *const me,
+                   char const *const path);
+
+/// @brief  Read the full histogram from a file.
+bool
+LogHistogram__load(struct LogHistogram *const me, char const *const path);
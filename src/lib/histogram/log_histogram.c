@@ -0,0 +1,419 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "histogram/log_histogram.h"
+#include "io/binary_container.h"
+#include "logger/logger.h"
+
+static inline uint64_t
+get_num_sub_bins(struct LogHistogram const *const me)
+{
+    return UINT64_C(1) << me->significant_bits;
+}
+
+static bool
+is_initialized(struct LogHistogram const *const me)
+{
+    if (me == NULL) {
+        LOGGER_ERROR("LogHistogram is NULL");
+        return false;
+    }
+    if (me->num_bins == 0 || me->histogram == NULL) {
+        LOGGER_ERROR("array of frequencies is empty");
+        return false;
+    }
+    if (me->significant_bits > LOG_HISTOGRAM_MAX_SIGNIFICANT_BITS) {
+        LOGGER_ERROR("too many significant bits (%u)", me->significant_bits);
+        return false;
+    }
+    return true;
+}
+
+/// @note   This does not depend on the number of bins, so I can call it
+///         before I allocate them.
+static inline size_t
+get_bin_index(unsigned const significant_bits, uint64_t const value)
+{
+    if (value < UINT64_C(1) << significant_bits) {
+        return value;
+    }
+    // NOTE 'e' is the position of the most significant bit, so the shift
+    //      keeps the top 'significant_bits + 1' bits of the value, of
+    //      which the top one is always set.
+    unsigned const e = 63 - __builtin_clzll(value);
+    unsigned const shift = e - significant_bits;
+    return ((size_t)shift << significant_bits) + (value >> shift);
+}
+
+bool
+LogHistogram__init(struct LogHistogram *const me,
+                   unsigned const significant_bits,
+                   uint64_t const max_value)
+{
+    if (me == NULL || significant_bits > LOG_HISTOGRAM_MAX_SIGNIFICANT_BITS) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    size_t const num_bins = get_bin_index(significant_bits, max_value) + 1;
+    *me = (struct LogHistogram){
+        .histogram = calloc(num_bins, sizeof(*me->histogram)),
+        .num_bins = num_bins,
+        .significant_bits = significant_bits,
+        .false_infinity = 0,
+        .infinity = 0,
+        .running_sum = 0,
+    };
+    if (me->histogram == NULL) {
+        LOGGER_ERROR("failed to allocate %zu bins", num_bins);
+        *me = (struct LogHistogram){0};
+        return false;
+    }
+    return true;
+}
+
+void
+LogHistogram__destroy(struct LogHistogram *const me)
+{
+    if (me == NULL) {
+        return;
+    }
+    free(me->histogram);
+    *me = (struct LogHistogram){0};
+}
+
+size_t
+LogHistogram__get_bin_index(struct LogHistogram const *const me,
+                            uint64_t const value)
+{
+    assert(me != NULL);
+    return get_bin_index(me->significant_bits, value);
+}
+
+uint64_t
+LogHistogram__get_bin_lower_bound(struct LogHistogram const *const me,
+                                  size_t const bin_index)
+{
+    assert(me != NULL);
+    uint64_t const num_sub_bins = get_num_sub_bins(me);
+    if (bin_index < num_sub_bins) {
+        return bin_index;
+    }
+    // NOTE This inverts 'get_bin_index'.
+    size_t const shift = (bin_index >> me->significant_bits) - 1;
+    uint64_t const mantissa = bin_index & (num_sub_bins - 1);
+    return (num_sub_bins + mantissa) << shift;
+}
+
+uint64_t
+LogHistogram__get_bin_width(struct LogHistogram const *const me,
+                            size_t const bin_index)
+{
+    assert(me != NULL);
+    if (bin_index < get_num_sub_bins(me)) {
+        return 1;
+    }
+    return UINT64_C(1) << ((bin_index >> me->significant_bits) - 1);
+}
+
+bool
+LogHistogram__insert_finite(struct LogHistogram *const me,
+                            uint64_t const index)
+{
+    return LogHistogram__insert_scaled_finite(me, index, 1);
+}
+
+bool
+LogHistogram__insert_scaled_finite(struct LogHistogram *const me,
+                                   uint64_t const index,
+                                   uint64_t const scale)
+{
+    return LogHistogram__insert_weighted_finite(me, scale * index, scale);
+}
+
+bool
+LogHistogram__insert_weighted_finite(struct LogHistogram *const me,
+                                     uint64_t const value,
+                                     uint64_t const weight)
+{
+    if (!is_initialized(me)) {
+        return false;
+    }
+    size_t const i = get_bin_index(me->significant_bits, value);
+    if (i < me->num_bins) {
+        me->histogram[i] += weight;
+    } else {
+        me->false_infinity += weight;
+    }
+    me->running_sum += weight;
+    return true;
+}
+
+bool
+LogHistogram__insert_infinite(struct LogHistogram *const me)
+{
+    return LogHistogram__insert_scaled_infinite(me, 1);
+}
+
+bool
+LogHistogram__insert_scaled_infinite(struct LogHistogram *const me,
+                                     uint64_t const scale)
+{
+    if (!is_initialized(me)) {
+        return false;
+    }
+    me->infinity += scale;
+    me->running_sum += scale;
+    return true;
+}
+
+double
+LogHistogram__get_fraction_at_least(struct LogHistogram const *const me,
+                                    uint64_t const value)
+{
+    if (!is_initialized(me) || me->running_sum == 0) {
+        return 0.0;
+    }
+    size_t const i = get_bin_index(me->significant_bits, value);
+    double at_least = me->false_infinity + me->infinity;
+    if (i >= me->num_bins) {
+        return at_least / me->running_sum;
+    }
+    for (size_t j = i + 1; j < me->num_bins; ++j) {
+        at_least += me->histogram[j];
+    }
+    // NOTE I count the part of the value's own bin that is at least it.
+    uint64_t const lower = LogHistogram__get_bin_lower_bound(me, i);
+    uint64_t const width = LogHistogram__get_bin_width(me, i);
+    at_least += (double)me->histogram[i] * (lower + width - value) / width;
+    return at_least / me->running_sum;
+}
+
+bool
+LogHistogram__iadd(struct LogHistogram *const me,
+                   struct LogHistogram const *const other)
+{
+    if (!is_initialized(me) || !is_initialized(other)) {
+        return false;
+    }
+    if (me->significant_bits != other->significant_bits) {
+        LOGGER_ERROR("mismatched significant bits (%u vs %u)",
+                     me->significant_bits,
+                     other->significant_bits);
+        return false;
+    }
+    size_t const num_common_bins =
+        me->num_bins < other->num_bins ? me->num_bins : other->num_bins;
+    for (size_t i = 0; i < num_common_bins; ++i) {
+        me->histogram[i] += other->histogram[i];
+    }
+    for (size_t i = num_common_bins; i < other->num_bins; ++i) {
+        me->false_infinity += other->histogram[i];
+    }
+    me->false_infinity += other->false_infinity;
+    me->infinity += other->infinity;
+    me->running_sum += other->running_sum;
+    return true;
+}
+
+void
+LogHistogram__clear(struct LogHistogram *const me)
+{
+    if (!is_initialized(me)) {
+        return;
+    }
+    memset(me->histogram, 0, me->num_bins * sizeof(*me->histogram));
+    me->false_infinity = 0;
+    me->infinity = 0;
+    me->running_sum = 0;
+}
+
+bool
+LogHistogram__validate(struct LogHistogram const *const me)
+{
+    if (!is_initialized(me)) {
+        return false;
+    }
+    uint64_t sum = me->false_infinity + me->infinity;
+    for (size_t i = 0; i < me->num_bins; ++i) {
+        sum += me->histogram[i];
+    }
+    if (sum != me->running_sum) {
+        LOGGER_ERROR("incorrect sum %" PRIu64 " vs %" PRIu64,
+                     sum,
+                     me->running_sum);
+        return false;
+    }
+    return true;
+}
+
+void
+LogHistogram__write_as_json(FILE *const stream,
+                            struct LogHistogram const *const me)
+{
+    if (me == NULL) {
+        fprintf(stream, "{\"type\": null}\n");
+        return;
+    }
+    if (me->histogram == NULL) {
+        fprintf(stream,
+                "{\"type\": \"LogHistogram\", \".histogram\": null}\n");
+        return;
+    }
+    fprintf(stream,
+            "{\"type\": \"LogHistogram\", \".num_bins\": %zu"
+            ", \".significant_bits\": %u, \".running_sum\": %" PRIu64
+            ", \".histogram\": {",
+            me->num_bins,
+            me->significant_bits,
+            me->running_sum);
+    bool first_value = true;
+    for (size_t i = 0; i < me->num_bins; ++i) {
+        if (me->histogram[i] != 0) {
+            fprintf(stream,
+                    "%s\"%" PRIu64 "\": %" PRIu64,
+                    first_value ? "" : ", ",
+                    LogHistogram__get_bin_lower_bound(me, i),
+                    me->histogram[i]);
+            first_value = false;
+        }
+    }
+    fprintf(stream,
+            "}, \".false_infinity\": %" PRIu64 ", \".infinity\": %" PRIu64
+            "}\n",
+            me->false_infinity,
+            me->infinity);
+}
+
+enum LogHistogramContainerMetadata {
+    LOG_HISTOGRAM_CONTAINER_SIGNIFICANT_BITS,
+    LOG_HISTOGRAM_CONTAINER_FALSE_INFINITY,
+    LOG_HISTOGRAM_CONTAINER_INFINITY,
+    LOG_HISTOGRAM_CONTAINER_RUNNING_SUM,
+};
+
+bool
+LogHistogram__save(struct LogHistogram const *const me,
+                   char const *const path)
+{
+    uint64_t *index = NULL, *values = NULL;
+    uint64_t num_entries = 0;
+    bool r = false;
+    if (!is_initialized(me) || path == NULL) {
+        return false;
+    }
+    uint64_t const metadata[BINARY_CONTAINER_METADATA_LENGTH] = {
+        [LOG_HISTOGRAM_CONTAINER_SIGNIFICANT_BITS] = me->significant_bits,
+        [LOG_HISTOGRAM_CONTAINER_FALSE_INFINITY] = me->false_infinity,
+        [LOG_HISTOGRAM_CONTAINER_INFINITY] = me->infinity,
+        [LOG_HISTOGRAM_CONTAINER_RUNNING_SUM] = me->running_sum,
+    };
+    // NOTE Like 'Histogram__save_binary', I store only the non-zero bins.
+    //      I allocate at least one entry so that an empty histogram still
+    //      has non-NULL arrays.
+    for (size_t i = 0; i < me->num_bins; ++i) {
+        num_entries += me->histogram[i] != 0;
+    }
+    index = malloc((num_entries + 1) * sizeof(*index));
+    values = malloc((num_entries + 1) * sizeof(*values));
+    if (index == NULL || values == NULL) {
+        LOGGER_ERROR("failed to allocate %" PRIu64 " entries", num_entries);
+        goto cleanup;
+    }
+    for (size_t i = 0, j = 0; i < me->num_bins; ++i) {
+        if (me->histogram[i] != 0) {
+            index[j] = i;
+            values[j] = me->histogram[i];
+            ++j;
+        }
+    }
+    r = BinaryContainer__save(path,
+                              BINARY_CONTAINER_KIND_LOG_HISTOGRAM,
+                              BINARY_CONTAINER_FILL_ZERO,
+                              metadata,
+                              me->num_bins,
+                              values,
+                              index,
+                              num_entries);
+cleanup:
+    free(index);
+    free(values);
+    return r;
+}
+
+/// @brief  Check the metadata before I trust it to size an allocation.
+/// @note   Every bin index up to that of UINT64_MAX is reachable, so any
+///         number of bins from 1 to that index plus one is consistent with
+///         the number of significant bits.
+static bool
+container_metadata_is_valid(struct BinaryContainer const *const container)
+{
+    uint64_t const *const metadata = container->header->metadata;
+    uint64_t const significant_bits =
+        metadata[LOG_HISTOGRAM_CONTAINER_SIGNIFICANT_BITS];
+    if (significant_bits > LOG_HISTOGRAM_MAX_SIGNIFICANT_BITS) {
+        LOGGER_ERROR("too many significant bits (%" PRIu64 ")",
+                     significant_bits);
+        return false;
+    }
+    uint64_t const max_num_bins =
+        get_bin_index((unsigned)significant_bits, UINT64_MAX) + 1;
+    uint64_t const num_bins = container->header->num_elements;
+    if (num_bins == 0 || num_bins > max_num_bins) {
+        LOGGER_ERROR("%" PRIu64 " bins is inconsistent with %" PRIu64
+                     " significant bits (expected 1..%" PRIu64 ")",
+                     num_bins,
+                     significant_bits,
+                     max_num_bins);
+        return false;
+    }
+    return true;
+}
+
+bool
+LogHistogram__load(struct LogHistogram *const me, char const *const path)
+{
+    struct BinaryContainer container = {0};
+    if (me == NULL || path == NULL) {
+        return false;
+    }
+    if (!BinaryContainer__open(&container,
+                               path,
+                               BINARY_CONTAINER_KIND_LOG_HISTOGRAM,
+                               true)) {
+        LOGGER_ERROR("failed to open '%s'", path);
+        return false;
+    }
+    if (!container_metadata_is_valid(&container)) {
+        goto cleanup;
+    }
+    uint64_t const *const metadata = container.header->metadata;
+    *me = (struct LogHistogram){
+        .histogram = calloc(container.header->num_elements,
+                            sizeof(*me->histogram)),
+        .num_bins = container.header->num_elements,
+        .significant_bits = metadata[LOG_HISTOGRAM_CONTAINER_SIGNIFICANT_BITS],
+        .false_infinity = metadata[LOG_HISTOGRAM_CONTAINER_FALSE_INFINITY],
+        .infinity = metadata[LOG_HISTOGRAM_CONTAINER_INFINITY],
+        .running_sum = metadata[LOG_HISTOGRAM_CONTAINER_RUNNING_SUM],
+    };
+    if (me->histogram == NULL) {
+        LOGGER_ERROR("failed to allocate %zu bins", me->num_bins);
+        *me = (struct LogHistogram){0};
+        goto cleanup;
+    }
+    if (!BinaryContainer__copy_dense(&container, me->histogram)) {
+        LOGGER_ERROR("failed to read histogram");
+        LogHistogram__destroy(me);
+        goto cleanup;
+    }
+    return BinaryContainer__close(&container);
+cleanup:
+    BinaryContainer__close(&container);
+    return false;
+}
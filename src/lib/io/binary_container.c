@@ -0,0 +1,514 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "io/binary_container.h"
+#include "io/io.h"
+#include "logger/logger.h"
+
+static_assert(sizeof(struct BinaryContainerHeader) == 128,
+              "the header layout is part of the file format");
+static_assert(sizeof(BINARY_CONTAINER_MAGIC) - 1 ==
+                  sizeof(((struct BinaryContainerHeader *)NULL)->magic),
+              "magic must fill its field exactly");
+
+// NOTE These are the XXH64 primes. The checksum below follows the
+//      structure of XXH64 (four independent lanes, then an avalanche),
+//      but it only needs to catch truncation and corruption, so I do not
+//      promise bit-compatibility with it.
+static uint64_t const PRIME1 = 0x9E3779B185EBCA87ULL;
+static uint64_t const PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+static uint64_t const PRIME3 = 0x165667B19E3779F9ULL;
+static uint64_t const PRIME4 = 0x85EBCA77C2B2AE63ULL;
+
+static inline uint64_t
+rotl(uint64_t const x, unsigned const r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t
+round_lane(uint64_t const acc, uint64_t const word)
+{
+    return rotl(acc + word * PRIME2, 31) * PRIME1;
+}
+
+static inline uint64_t
+read_word(uint8_t const *const p)
+{
+    uint64_t word = 0;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+/// @brief  Hash 'num_bytes' bytes into the running checksum 'seed'.
+static uint64_t
+checksum(uint64_t const seed, void const *const data, size_t const num_bytes)
+{
+    uint8_t const *p = data;
+    uint8_t const *const end = p + num_bytes;
+    uint64_t h = 0;
+    if (num_bytes >= 32) {
+        // NOTE The four lanes are independent, so the CPU can overlap
+        //      their multiplies. This runs at memory bandwidth.
+        uint64_t a = seed + PRIME1 + PRIME2, b = seed + PRIME2, c = seed,
+                 d = seed - PRIME1;
+        for (; p + 32 <= end; p += 32) {
+            a = round_lane(a, read_word(p));
+            b = round_lane(b, read_word(p + 8));
+            c = round_lane(c, read_word(p + 16));
+            d = round_lane(d, read_word(p + 24));
+        }
+        h = rotl(a, 1) + rotl(b, 7) + rotl(c, 12) + rotl(d, 18);
+    } else {
+        h = seed + PRIME3;
+    }
+    h += num_bytes;
+    for (; p + 8 <= end; p += 8) {
+        h ^= round_lane(0, read_word(p));
+        h = rotl(h, 27) * PRIME1 + PRIME4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * PRIME3;
+        h = rotl(h, 11) * PRIME1;
+    }
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+static uint64_t
+align_up(uint64_t const offset)
+{
+    return (offset + BINARY_CONTAINER_ALIGNMENT - 1) /
+           BINARY_CONTAINER_ALIGNMENT * BINARY_CONTAINER_ALIGNMENT;
+}
+
+/// @brief  Checksum the header (with the checksum field zeroed) and then
+///         each section in the order they appear in the file.
+/// @note   I skip the padding, which is always zero.
+static uint64_t
+compute_checksum(struct BinaryContainerHeader const *const header,
+                 void const *const values,
+                 uint64_t const *const index)
+{
+    struct BinaryContainerHeader h = *header;
+    h.checksum = 0;
+    uint64_t r = checksum(0, &h, sizeof(h));
+    r = checksum(r, values, header->num_entries * sizeof(uint64_t));
+    if (index != NULL) {
+        r = checksum(r, index, header->num_entries * sizeof(*index));
+    }
+    return r;
+}
+
+static bool
+write_section(FILE *const fp,
+              uint64_t const offset,
+              void const *const data,
+              size_t const num_bytes)
+{
+    static uint8_t const zeros[BINARY_CONTAINER_ALIGNMENT] = {0};
+    long const pos = ftell(fp);
+    if (pos < 0 || (uint64_t)pos > offset) {
+        LOGGER_ERROR("bad file position %ld (expected <= %" PRIu64 ")",
+                     pos,
+                     offset);
+        return false;
+    }
+    size_t const padding = offset - (uint64_t)pos;
+    assert(padding < sizeof(zeros));
+    if (fwrite(zeros, 1, padding, fp) != padding ||
+        fwrite(data, 1, num_bytes, fp) != num_bytes) {
+        LOGGER_ERROR("failed to write %zu bytes", num_bytes);
+        return false;
+    }
+    return true;
+}
+
+bool
+BinaryContainer__save(char const *const path,
+                      enum BinaryContainerKind const kind,
+                      enum BinaryContainerFill const fill,
+                      uint64_t const metadata[BINARY_CONTAINER_METADATA_LENGTH],
+                      uint64_t const num_elements,
+                      void const *const values,
+                      uint64_t const *const index,
+                      uint64_t const num_entries)
+{
+    if (path == NULL || metadata == NULL || values == NULL ||
+        num_entries > num_elements ||
+        (index == NULL && num_entries != num_elements)) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    if (index != NULL && fill == BINARY_CONTAINER_FILL_PREVIOUS &&
+        (num_entries == 0 || index[0] != 0)) {
+        LOGGER_ERROR("a sparse file filled with the previous value must "
+                     "store the first element");
+        return false;
+    }
+
+    uint64_t const values_offset =
+        align_up(sizeof(struct BinaryContainerHeader));
+    uint64_t const values_end = values_offset + num_entries * sizeof(uint64_t);
+    uint64_t const index_offset = index == NULL ? 0 : align_up(values_end);
+    struct BinaryContainerHeader header = {
+        .magic = {0},
+        .version = BINARY_CONTAINER_VERSION,
+        .kind = kind,
+        .layout = index == NULL ? BINARY_CONTAINER_LAYOUT_DENSE
+                                : BINARY_CONTAINER_LAYOUT_SPARSE,
+        .fill = fill,
+        .num_elements = num_elements,
+        .num_entries = num_entries,
+        .values_offset = values_offset,
+        .index_offset = index_offset,
+        .file_size = index == NULL
+                         ? values_end
+                         : index_offset + num_entries * sizeof(*index),
+        .checksum = 0,
+        .metadata = {0},
+        .reserved = 0,
+    };
+    memcpy(header.magic, BINARY_CONTAINER_MAGIC, sizeof(header.magic));
+    memcpy(header.metadata, metadata, sizeof(header.metadata));
+    header.checksum = compute_checksum(&header, values, index);
+
+    FILE *fp = fopen(path, "wb");
+    if (fp == NULL) {
+        LOGGER_ERROR("could not open '%s'", path);
+        return false;
+    }
+    if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        LOGGER_ERROR("failed to write header");
+        goto cleanup;
+    }
+    if (!write_section(fp,
+                       values_offset,
+                       values,
+                       num_entries * sizeof(uint64_t))) {
+        LOGGER_ERROR("failed to write values");
+        goto cleanup;
+    }
+    if (index != NULL &&
+        !write_section(fp, index_offset, index, num_entries * sizeof(*index))) {
+        LOGGER_ERROR("failed to write index");
+        goto cleanup;
+    }
+    if (fclose(fp) != 0) {
+        LOGGER_ERROR("failed to close '%s'", path);
+        return false;
+    }
+    return true;
+cleanup:
+    fclose(fp);
+    return false;
+}
+
+static bool
+section_is_valid(struct BinaryContainerHeader const *const header,
+                 uint64_t const offset)
+{
+    // NOTE I check the sizes with division so that a corrupted number of
+    //      entries cannot overflow the multiplication.
+    return offset % BINARY_CONTAINER_ALIGNMENT == 0 &&
+           offset >= sizeof(*header) && offset <= header->file_size &&
+           header->num_entries <=
+               (header->file_size - offset) / sizeof(uint64_t);
+}
+
+/// @brief  Check whether the values and index sections share any bytes,
+///         so that a crafted file cannot alias one with the other.
+/// @note   Both sections must already be valid, so the ends cannot
+///         overflow.
+static bool
+sections_overlap(struct BinaryContainerHeader const *const header)
+{
+    uint64_t const num_bytes = header->num_entries * sizeof(uint64_t);
+    return num_bytes != 0 &&
+           header->values_offset < header->index_offset + num_bytes &&
+           header->index_offset < header->values_offset + num_bytes;
+}
+
+static bool
+header_is_valid(struct BinaryContainerHeader const *const header,
+                size_t const num_bytes,
+                enum BinaryContainerKind const kind)
+{
+    if (memcmp(header->magic, BINARY_CONTAINER_MAGIC, sizeof(header->magic))) {
+        LOGGER_ERROR("bad magic");
+        return false;
+    }
+    if (header->version != BINARY_CONTAINER_VERSION) {
+        LOGGER_ERROR("unsupported version %" PRIu32, header->version);
+        return false;
+    }
+    if (header->kind != (uint32_t)kind) {
+        LOGGER_ERROR("expected kind %d, got %" PRIu32, kind, header->kind);
+        return false;
+    }
+    if (header->file_size != num_bytes) {
+        LOGGER_ERROR("file is %zu bytes but should be %" PRIu64
+                     " (truncated?)",
+                     num_bytes,
+                     header->file_size);
+        return false;
+    }
+    if (header->num_entries > header->num_elements ||
+        !section_is_valid(header, header->values_offset)) {
+        LOGGER_ERROR("bad values section");
+        return false;
+    }
+    switch (header->layout) {
+    case BINARY_CONTAINER_LAYOUT_DENSE:
+        if (header->num_entries != header->num_elements ||
+            header->index_offset != 0) {
+            LOGGER_ERROR("bad dense layout");
+            return false;
+        }
+        break;
+    case BINARY_CONTAINER_LAYOUT_SPARSE:
+        if (!section_is_valid(header, header->index_offset)) {
+            LOGGER_ERROR("bad index section");
+            return false;
+        }
+        if (sections_overlap(header)) {
+            LOGGER_ERROR("index section overlaps the values section");
+            return false;
+        }
+        break;
+    default:
+        LOGGER_ERROR("unrecognized layout %" PRIu32, header->layout);
+        return false;
+    }
+    if (header->fill != BINARY_CONTAINER_FILL_ZERO &&
+        header->fill != BINARY_CONTAINER_FILL_PREVIOUS) {
+        LOGGER_ERROR("unrecognized fill %" PRIu32, header->fill);
+        return false;
+    }
+    return true;
+}
+
+/// @brief  Check that the index is strictly increasing and in bounds, so
+///         that the binary search is well defined.
+static bool
+index_is_valid(struct BinaryContainer const *const me)
+{
+    uint64_t const n = me->header->num_entries;
+    if (me->index == NULL) {
+        return true;
+    }
+    if (me->header->fill == BINARY_CONTAINER_FILL_PREVIOUS &&
+        (n == 0 || me->index[0] != 0)) {
+        LOGGER_ERROR("missing first element");
+        return false;
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        if (me->index[i] >= me->header->num_elements ||
+            (i != 0 && me->index[i] <= me->index[i - 1])) {
+            LOGGER_ERROR("bad index at entry %" PRIu64, i);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool
+BinaryContainer__open(struct BinaryContainer *const me,
+                      char const *const path,
+                      enum BinaryContainerKind const kind,
+                      bool const verify)
+{
+    if (me == NULL || path == NULL) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    *me = (struct BinaryContainer){0};
+    if (!MemoryMap__init(&me->mm, path, "rb")) {
+        LOGGER_ERROR("failed to map '%s'", path);
+        return false;
+    }
+    if (me->mm.num_bytes < sizeof(struct BinaryContainerHeader)) {
+        LOGGER_ERROR("'%s' is too small for a header", path);
+        goto cleanup;
+    }
+    // NOTE The memory map is page-aligned, so every section is aligned.
+    me->header = me->mm.buffer;
+    if (!header_is_valid(me->header, me->mm.num_bytes, kind)) {
+        LOGGER_ERROR("bad header in '%s'", path);
+        goto cleanup;
+    }
+    uint8_t const *const base = me->mm.buffer;
+    me->values = &base[me->header->values_offset];
+    me->index = me->header->layout == BINARY_CONTAINER_LAYOUT_SPARSE
+                    ? (uint64_t const *)&base[me->header->index_offset]
+                    : NULL;
+    if (verify) {
+        if (compute_checksum(me->header, me->values, me->index) !=
+            me->header->checksum) {
+            LOGGER_ERROR("checksum mismatch in '%s'", path);
+            goto cleanup;
+        }
+        if (!index_is_valid(me)) {
+            LOGGER_ERROR("bad index in '%s'", path);
+            goto cleanup;
+        }
+    }
+    return true;
+cleanup:
+    BinaryContainer__close(me);
+    return false;
+}
+
+bool
+BinaryContainer__is_container(char const *const path)
+{
+    char magic[sizeof(BINARY_CONTAINER_MAGIC) - 1] = {0};
+    if (path == NULL) {
+        return false;
+    }
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return false;
+    }
+    bool const r = fread(magic, 1, sizeof(magic), fp) == sizeof(magic) &&
+                   memcmp(magic, BINARY_CONTAINER_MAGIC, sizeof(magic)) == 0;
+    fclose(fp);
+    return r;
+}
+
+/// @brief  Find the position of the last entry whose element index is at
+///         most 'i', or 'num_entries' if there is none.
+static uint64_t
+find_entry(struct BinaryContainer const *const me, uint64_t const i)
+{
+    uint64_t lo = 0, hi = me->header->num_entries;
+    // Invariant: index[0..lo) <= i < index[hi..num_entries)
+    while (lo < hi) {
+        uint64_t const mid = lo + (hi - lo) / 2;
+        if (me->index[mid] <= i) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo == 0 ? me->header->num_entries : lo - 1;
+}
+
+uint64_t
+BinaryContainer__get_u64(struct BinaryContainer const *const me,
+                         uint64_t const i)
+{
+    assert(me != NULL && me->header != NULL);
+    assert(i < me->header->num_elements);
+    uint64_t const *const values = me->values;
+    if (me->index == NULL) {
+        return values[i];
+    }
+    uint64_t const entry = find_entry(me, i);
+    if (entry == me->header->num_entries) {
+        return 0;
+    }
+    if (me->index[entry] == i ||
+        me->header->fill == BINARY_CONTAINER_FILL_PREVIOUS) {
+        return values[entry];
+    }
+    return 0;
+}
+
+double
+BinaryContainer__get_f64(struct BinaryContainer const *const me,
+                         uint64_t const i)
+{
+    // NOTE The bits of 0.0 are all zero, so a zero fill works for doubles.
+    uint64_t const bits = BinaryContainer__get_u64(me, i);
+    double r = 0.0;
+    memcpy(&r, &bits, sizeof(r));
+    return r;
+}
+
+bool
+BinaryContainer__copy_dense(struct BinaryContainer const *const me,
+                            void *const dst)
+{
+    if (me == NULL || me->header == NULL || dst == NULL) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    uint64_t const num_elements = me->header->num_elements;
+    uint64_t const num_entries = me->header->num_entries;
+    uint64_t const *const values = me->values;
+    uint64_t *const out = dst;
+    if (me->index == NULL) {
+        memcpy(out, values, num_elements * sizeof(*out));
+        return true;
+    }
+    // NOTE I sweep the index once rather than searching for each element.
+    bool const fill_previous =
+        me->header->fill == BINARY_CONTAINER_FILL_PREVIOUS;
+    uint64_t entry = 0, fill = 0;
+    for (uint64_t i = 0; i < num_elements; ++i) {
+        if (entry < num_entries && me->index[entry] == i) {
+            out[i] = values[entry];
+            fill = fill_previous ? values[entry] : 0;
+            ++entry;
+        } else {
+            out[i] = fill;
+        }
+    }
+    if (entry != num_entries) {
+        LOGGER_ERROR("unsorted index (used %" PRIu64 " of %" PRIu64
+                     " entries)",
+                     entry,
+                     num_entries);
+        return false;
+    }
+    return true;
+}
+
+void
+BinaryContainer__write_as_json(FILE *const stream,
+                               struct BinaryContainer const *const me)
+{
+    if (stream == NULL) {
+        LOGGER_ERROR("stream is NULL");
+        return;
+    }
+    if (me == NULL || me->header == NULL) {
+        fprintf(stream, "{\"type\": null}\n");
+        return;
+    }
+    struct BinaryContainerHeader const *const h = me->header;
+    fprintf(stream,
+            "{\"type\": \"BinaryContainer\", \".version\": %" PRIu32
+            ", \".kind\": %" PRIu32 ", \".layout\": \"%s\""
+            ", \".num_elements\": %" PRIu64 ", \".num_entries\": %" PRIu64
+            ", \".file_size\": %" PRIu64 ", \".checksum\": \"%016" PRIx64
+            "\"}\n",
+            h->version,
+            h->kind,
+            h->layout == BINARY_CONTAINER_LAYOUT_DENSE ? "dense" : "sparse",
+            h->num_elements,
+            h->num_entries,
+            h->file_size,
+            h->checksum);
+}
+
+bool
+BinaryContainer__close(struct BinaryContainer *const me)
+{
+    if (me == NULL) {
+        return false;
+    }
+    bool const r = me->mm.buffer == NULL || MemoryMap__destroy(&me->mm);
+    *me = (struct BinaryContainer){0};
+    return r;
+}
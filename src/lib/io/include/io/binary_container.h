@@ -0,0 +1,154 @@
+/** @brief  A versioned binary container for arrays of 64-bit values (i.e.
+ *          histograms and MRCs) that one can memory map and use in place.
+ *
+ *  The legacy formats (see 'Histogram__save' and 'MissRateCurve__save')
+ *  are streams of (index, value) pairs that we must parse and copy into a
+ *  freshly allocated array. Comparing thousands of oracle MRCs means
+ *  reading every one of them in full. Here, the file is laid out so that
+ *  the arrays are usable straight out of the memory map:
+ *
+ *  1. A 128 byte header with a magic string, version, kind, the layout,
+ *     the offsets of each section, the file size, and a checksum.
+ *  2. The values, aligned to 64 bytes.
+ *  3. For sparse files, the (sorted) element index of each value, also
+ *     aligned to 64 bytes. A sparse file omits elements that equal the
+ *     fill value (zero or the previous value).
+ *
+ *  Opening the file only checks the header, so the operating system only
+ *  reads the pages that we touch. Verifying the checksum reads everything.
+ *
+ *  @note   Like the legacy formats, I assume that the endianness of the
+ *          writer and reader are the same.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* !__cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "io/io.h"
+
+#define BINARY_CONTAINER_MAGIC           "CACHEBIN"
+#define BINARY_CONTAINER_VERSION         1
+#define BINARY_CONTAINER_ALIGNMENT       64
+#define BINARY_CONTAINER_METADATA_LENGTH 6
+
+enum BinaryContainerKind {
+    BINARY_CONTAINER_KIND_INVALID = 0,
+    /// Values are uint64 frequencies.
+    BINARY_CONTAINER_KIND_HISTOGRAM = 1,
+    /// Values are float64 miss rates.
+    BINARY_CONTAINER_KIND_MISS_RATE_CURVE = 2,
+    /// Values are uint64 frequencies of logarithmically-sized bins.
+    BINARY_CONTAINER_KIND_LOG_HISTOGRAM = 3,
+};
+
+enum BinaryContainerLayout {
+    BINARY_CONTAINER_LAYOUT_DENSE = 0,
+    BINARY_CONTAINER_LAYOUT_SPARSE = 1,
+};
+
+/// @brief  The value of elements that a sparse file omits.
+enum BinaryContainerFill {
+    /// Omitted elements are zero (e.g. empty histogram bins).
+    BINARY_CONTAINER_FILL_ZERO = 0,
+    /// Omitted elements equal the last stored element before them (e.g.
+    /// flat stretches of an MRC). The first element must be stored.
+    BINARY_CONTAINER_FILL_PREVIOUS = 1,
+};
+
+/// @brief  The on-disk header. The offsets are from the start of the file.
+struct BinaryContainerHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t kind;
+    uint32_t layout;
+    uint32_t fill;
+    /// Number of logical elements (e.g. histogram bins)
+    uint64_t num_elements;
+    /// Number of stored values (equal to 'num_elements' if dense)
+    uint64_t num_entries;
+    uint64_t values_offset;
+    /// Zero if dense
+    uint64_t index_offset;
+    uint64_t file_size;
+    /// Checksum of the header (with this field zeroed) and the sections
+    uint64_t checksum;
+    /// Kind-specific fields (e.g. the bin size)
+    uint64_t metadata[BINARY_CONTAINER_METADATA_LENGTH];
+    uint64_t reserved;
+};
+
+struct BinaryContainer {
+    struct MemoryMap mm;
+    struct BinaryContainerHeader const *header;
+    /// Points into the memory map. These are uint64 or double, depending
+    /// on the kind.
+    void const *values;
+    /// Points into the memory map. NULL if dense.
+    uint64_t const *index;
+};
+
+/// @brief  Write a container.
+/// @param  values: 'num_entries' 8-byte values.
+/// @param  index: the sorted element index of each value, or NULL to
+///                write a dense container (where 'num_entries' must equal
+///                'num_elements').
+bool
+BinaryContainer__save(char const *const path,
+                      enum BinaryContainerKind const kind,
+                      enum BinaryContainerFill const fill,
+                      uint64_t const metadata[BINARY_CONTAINER_METADATA_LENGTH],
+                      uint64_t const num_elements,
+                      void const *const values,
+                      uint64_t const *const index,
+                      uint64_t const num_entries);
+
+/// @brief  Memory map a container and check its header.
+/// @param  kind: the expected kind.
+/// @param  verify: whether to also verify the checksum and the sparse
+///                 index. This reads the entire file.
+bool
+BinaryContainer__open(struct BinaryContainer *const me,
+                      char const *const path,
+                      enum BinaryContainerKind const kind,
+                      bool const verify);
+
+/// @brief  Check whether a file starts with the container's magic string,
+///         so that we can tell it apart from the legacy formats.
+bool
+BinaryContainer__is_container(char const *const path);
+
+/// @brief  Get the logical element 'i' as raw bits, applying the sparse
+///         fill if necessary.
+/// @note   This is O(1) for dense containers and O(log(num_entries)) for
+///         sparse ones.
+uint64_t
+BinaryContainer__get_u64(struct BinaryContainer const *const me,
+                         uint64_t const i);
+
+double
+BinaryContainer__get_f64(struct BinaryContainer const *const me,
+                         uint64_t const i);
+
+/// @brief  Expand the container into a dense array of 'num_elements'
+///         8-byte values.
+bool
+BinaryContainer__copy_dense(struct BinaryContainer const *const me,
+                            void *const dst);
+
+void
+BinaryContainer__write_as_json(FILE *const stream,
+                               struct BinaryContainer const *const me);
+
+bool
+BinaryContainer__close(struct BinaryContainer *const me);
+
+#ifdef __cplusplus
+}
+#endif /* !__cplusplus */
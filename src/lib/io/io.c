@@ -39,6 +39,14 @@ file_to_mmap(struct MemoryMap *const me,
     }
 
     buffer = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // NOTE This fails for empty files, since we cannot map zero bytes.
+    if (buffer == MAP_FAILED) {
+        LOGGER_ERROR("failed to mmap '%s'", fpath);
+        if (fclose(fp) == EOF) {
+            LOGGER_ERROR("failed to close '%s' too", fpath);
+        }
+        return false;
+    }
     *me = (struct MemoryMap){.buffer = buffer, .num_bytes = sb.st_size};
     return true;
 }
@@ -52,9 +52,28 @@ EvictingHashTable__init(struct EvictingHashTable *me,
         LOGGER_ERROR("failed to initialize with length %zu", length);
         return false;
     }
-    Hash64BitType *hashes = malloc(length * sizeof(*hashes));
+    // NOTE I align each seqlock's group of hashes to its own cache line
+    //      (8 hashes of 8 bytes), so that threads that partition the work
+    //      by seqlock never share a line of hashes. 'aligned_alloc'
+    //      requires the size to be a multiple of the alignment.
+    size_t const group_size =
+        EVICTING_HASH_TABLE_SLOTS_PER_SEQLOCK * sizeof(Hash64BitType);
+    Hash64BitType *hashes = aligned_alloc(
+        group_size,
+        (length * sizeof(*hashes) + group_size - 1) / group_size * group_size);
     if (hashes == NULL) {
         LOGGER_ERROR("failed to initialize hashes with length %zu", length);
+        free(data);
+        return false;
+    }
+    size_t const num_seqlocks =
+        (length + EVICTING_HASH_TABLE_SLOTS_PER_SEQLOCK - 1) /
+        EVICTING_HASH_TABLE_SLOTS_PER_SEQLOCK;
+    uint64_t *seqlocks = calloc(num_seqlocks, sizeof(*seqlocks));
+    if (seqlocks == NULL) {
+        LOGGER_ERROR("failed to initialize %zu seqlocks", num_seqlocks);
+        free(data);
+        free(hashes);
         return false;
     }
     // NOTE I'm not sure what the best way of representing all 1's. I
@@ -66,6 +85,8 @@ EvictingHashTable__init(struct EvictingHashTable *me,
         .values = data,
         .hashes = hashes,
         .length = length,
+        .seqlocks = seqlocks,
+        .num_seqlocks = num_seqlocks,
         .init_sampling_ratio = init_sampling_ratio,
         // HACK Set the threshold to some low number to begin
         //      (otherwise, we end up with teething performance issues).
@@ -165,6 +186,186 @@ EvictingHashTable__refresh_threshold(struct EvictingHashTable *me)
     me->global_threshold = max_hash;
 }
 
+static inline void
+seqlock_acquire(uint64_t *const seqlock)
+{
+    uint64_t seq = __atomic_load_n(seqlock, __ATOMIC_RELAXED);
+    while (true) {
+        // NOTE The acquire ordering stops the writes to the slot from
+        //      being reordered before the sequence number becomes odd.
+        if ((seq & 1) == 0 && __atomic_compare_exchange_n(seqlock,
+                                                          &seq,
+                                                          seq + 1,
+                                                          true,
+                                                          __ATOMIC_ACQUIRE,
+                                                          __ATOMIC_RELAXED)) {
+            return;
+        }
+        seq = __atomic_load_n(seqlock, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void
+seqlock_release(uint64_t *const seqlock)
+{
+    __atomic_fetch_add(seqlock, 1, __ATOMIC_RELEASE);
+}
+
+/// @brief  Atomically add to the HyperLogLog denominator and refresh
+///         the memoized scale factor.
+static void
+update_statistics_concurrent(struct EvictingHashTable *me,
+                             double const delta_denominator)
+{
+    double old_denominator = 0.0, new_denominator = 0.0;
+    __atomic_load(&me->running_denominator, &old_denominator, __ATOMIC_RELAXED);
+    do {
+        new_denominator = old_denominator + delta_denominator;
+    } while (!__atomic_compare_exchange(&me->running_denominator,
+                                        &old_denominator,
+                                        &new_denominator,
+                                        true,
+                                        __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+    // NOTE The other fields are constant after initialization, so we
+    //      only need to atomically load the ones that change.
+    struct EvictingHashTable const snapshot = {
+        .hashes = me->hashes,
+        .values = me->values,
+        .length = me->length,
+        .init_sampling_ratio = me->init_sampling_ratio,
+        .num_inserted = __atomic_load_n(&me->num_inserted, __ATOMIC_RELAXED),
+        .running_denominator = new_denominator,
+        .hll_alpha_m = me->hll_alpha_m,
+    };
+    double const scale_factor =
+        EvictingHashTable__estimate_scale_factor(&snapshot);
+    __atomic_store(&me->scale_factor, &scale_factor, __ATOMIC_RELAXED);
+}
+
+struct SampledLookupReturn
+EvictingHashTable__lookup_concurrent(struct EvictingHashTable *me,
+                                     KeyType key)
+{
+    if (!me || !me->hashes || !me->values || !me->seqlocks ||
+        me->length == 0)
+        return (struct SampledLookupReturn){.status = SAMPLED_NOTFOUND};
+
+    Hash64BitType const hash = Hash64Bit(key);
+    if (hash > __atomic_load_n(&me->global_threshold, __ATOMIC_RELAXED))
+        return (struct SampledLookupReturn){.status = SAMPLED_IGNORED};
+
+    size_t const idx = hash % me->length;
+    uint64_t *const seqlock =
+        &me->seqlocks[EvictingHashTable__seqlock_index(me, hash)];
+    uint64_t seq = 0;
+    Hash64BitType old_hash = 0;
+    ValueType incumbent = 0;
+    do {
+        seq = __atomic_load_n(seqlock, __ATOMIC_ACQUIRE);
+        old_hash = __atomic_load_n(&me->hashes[idx], __ATOMIC_RELAXED);
+        incumbent = __atomic_load_n(&me->values[idx], __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) || seq != __atomic_load_n(seqlock, __ATOMIC_RELAXED));
+
+    if (hash == old_hash)
+        return (struct SampledLookupReturn){.status = SAMPLED_FOUND,
+                                            .hash = old_hash,
+                                            .timestamp = incumbent};
+    if (hash < old_hash)
+        return (struct SampledLookupReturn){.status = SAMPLED_NOTFOUND};
+    if (old_hash == UINT64_MAX)
+        return (struct SampledLookupReturn){.status = SAMPLED_HITHERTOEMPTY};
+    return (struct SampledLookupReturn){.status = SAMPLED_IGNORED};
+}
+
+struct SampledTryPutReturn
+EvictingHashTable__try_put_hash_concurrent(struct EvictingHashTable *me,
+                                           Hash64BitType const hash,
+                                           ValueType value)
+{
+    if (!me || !me->hashes || !me->values || !me->seqlocks ||
+        me->length == 0)
+        return (struct SampledTryPutReturn){.status = SAMPLED_NOTFOUND};
+
+    if (hash > __atomic_load_n(&me->global_threshold, __ATOMIC_RELAXED))
+        return (struct SampledTryPutReturn){.status = SAMPLED_IGNORED};
+
+    size_t const idx = hash % me->length;
+    // NOTE This lock-free check filters out most accesses. The hashes
+    //      in a slot only ever decrease, so if we would be ignored now,
+    //      then we would also be ignored once we hold the lock.
+    if (hash > __atomic_load_n(&me->hashes[idx], __ATOMIC_RELAXED))
+        return (struct SampledTryPutReturn){.status = SAMPLED_IGNORED};
+
+    uint64_t *const seqlock =
+        &me->seqlocks[EvictingHashTable__seqlock_index(me, hash)];
+    seqlock_acquire(seqlock);
+    Hash64BitType const old_hash = me->hashes[idx];
+    ValueType const old_value = me->values[idx];
+    if (hash > old_hash) {
+        seqlock_release(seqlock);
+        return (struct SampledTryPutReturn){.status = SAMPLED_IGNORED};
+    }
+    __atomic_store_n(&me->values[idx], value, __ATOMIC_RELAXED);
+    __atomic_store_n(&me->hashes[idx], hash, __ATOMIC_RELAXED);
+    seqlock_release(seqlock);
+
+    if (hash == old_hash) {
+        return (struct SampledTryPutReturn){.status = SAMPLED_UPDATED,
+                                            .new_hash = hash,
+                                            .old_hash = hash,
+                                            .old_value = old_value};
+    }
+    assert(hash < old_hash);
+    if (old_hash == UINT64_MAX) {
+        size_t const num_inserted =
+            __atomic_add_fetch(&me->num_inserted, 1, __ATOMIC_RELAXED);
+        if (num_inserted == me->length) {
+            EvictingHashTable__refresh_threshold_concurrent(me);
+        }
+        update_statistics_concurrent(me,
+                                     exp2(-clz(hash) - 1) -
+                                         me->init_sampling_ratio);
+        return (struct SampledTryPutReturn){.status = SAMPLED_INSERTED,
+                                            .new_hash = hash};
+    }
+    if (old_hash == __atomic_load_n(&me->global_threshold, __ATOMIC_RELAXED)) {
+        EvictingHashTable__refresh_threshold_concurrent(me);
+    }
+    update_statistics_concurrent(me,
+                                 exp2(-clz(hash) - 1) -
+                                     exp2(-clz(old_hash) - 1));
+    return (struct SampledTryPutReturn){.status = SAMPLED_REPLACED,
+                                        .new_hash = hash,
+                                        .old_hash = old_hash,
+                                        .old_value = old_value};
+}
+
+struct SampledTryPutReturn
+EvictingHashTable__try_put_concurrent(struct EvictingHashTable *me,
+                                      KeyType key,
+                                      ValueType value)
+{
+    return EvictingHashTable__try_put_hash_concurrent(me,
+                                                      Hash64Bit(key),
+                                                      value);
+}
+
+void
+EvictingHashTable__refresh_threshold_concurrent(struct EvictingHashTable *me)
+{
+    if (!me || !me->hashes || !me->values || me->length == 0)
+        return;
+    Hash64BitType max_hash = 0;
+    for (size_t i = 0; i < me->length; ++i) {
+        Hash64BitType hash = __atomic_load_n(&me->hashes[i], __ATOMIC_RELAXED);
+        if (hash > max_hash)
+            max_hash = hash;
+    }
+    __atomic_store_n(&me->global_threshold, max_hash, __ATOMIC_RELAXED);
+}
+
 void
 EvictingHashTable__print_as_json(struct EvictingHashTable *me)
 {
@@ -207,5 +408,6 @@ EvictingHashTable__destroy(struct EvictingHashTable *me)
         return;
     free(me->values);
     free(me->hashes);
+    free(me->seqlocks);
     *me = (struct EvictingHashTable){0};
 }
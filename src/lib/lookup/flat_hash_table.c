@@ -0,0 +1,308 @@
+/** Use SIMD control bytes to create a hash table with keys and values
+ *  of type uint64_t. See the header for a description. */
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
+
+#include "hash/hash.h"
+#include "logger/logger.h"
+#include "lookup/flat_hash_table.h"
+#include "lookup/lookup.h"
+#include "types/entry_type.h"
+#include "types/time_stamp_type.h"
+
+#define GROUP_WIDTH FLAT_HASH_TABLE_GROUP_WIDTH
+/// @brief  The control byte of an empty slot. Full slots hold the top 7
+///         bits of their key's hash, so only empty slots have the top bit.
+#define EMPTY_CTRL ((uint8_t)0x80)
+
+static inline size_t
+get_home_slot(struct FlatHashTable const *const me, uint64_t const hash)
+{
+    return hash & (me->num_slots - 1);
+}
+
+static inline uint8_t
+get_ctrl(uint64_t const hash)
+{
+    return (uint8_t)(hash >> 57);
+}
+
+/// @brief  Get a bit mask of the control bytes in a group that equal 'b'.
+static inline uint32_t
+match_byte(uint8_t const *const group, uint8_t const b)
+{
+#ifdef __SSE2__
+    __m128i const ctrl = _mm_loadu_si128((__m128i const *)group);
+    return (uint32_t)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)b)));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < GROUP_WIDTH; ++i) {
+        mask |= (uint32_t)(group[i] == b) << i;
+    }
+    return mask;
+#endif /* __SSE2__ */
+}
+
+/// @brief  Get a bit mask of the empty slots in a group.
+static inline uint32_t
+match_empty(uint8_t const *const group)
+{
+#ifdef __SSE2__
+    // NOTE Only empty slots have the top bit set, which is exactly what
+    //      the movemask instruction extracts.
+    return (uint32_t)_mm_movemask_epi8(
+        _mm_loadu_si128((__m128i const *)group));
+#else
+    return match_byte(group, EMPTY_CTRL);
+#endif /* __SSE2__ */
+}
+
+/// @brief  Set a control byte and its mirror past the end of the table.
+static inline void
+set_ctrl(struct FlatHashTable *const me, size_t const slot, uint8_t const c)
+{
+    me->ctrl[slot] = c;
+    if (slot < GROUP_WIDTH - 1) {
+        me->ctrl[me->num_slots + slot] = c;
+    }
+}
+
+/// @brief  Find the key's slot or else the empty slot where it belongs.
+/// @note   The table always has an empty slot, so this terminates.
+static inline size_t
+find_slot(struct FlatHashTable const *const me,
+          uint64_t const key,
+          uint64_t const hash,
+          bool *const found)
+{
+    size_t const mask = me->num_slots - 1;
+    uint8_t const ctrl = get_ctrl(hash);
+    // NOTE The key is almost always in its home slot, so I fetch that
+    //      entry's cache line in parallel with the control bytes.
+    __builtin_prefetch(&me->entries[get_home_slot(me, hash)]);
+    for (size_t pos = get_home_slot(me, hash);;
+         pos = (pos + GROUP_WIDTH) & mask) {
+        uint8_t const *const group = &me->ctrl[pos];
+        uint32_t const empty = match_empty(group);
+        uint32_t candidates = match_byte(group, ctrl);
+        // NOTE The key, if present, lies before the first empty slot.
+        if (empty) {
+            candidates &= (empty & -empty) - 1;
+        }
+        for (; candidates; candidates &= candidates - 1) {
+            size_t const slot = (pos + __builtin_ctz(candidates)) & mask;
+            if (me->entries[slot].key == key) {
+                *found = true;
+                return slot;
+            }
+        }
+        if (empty) {
+            *found = false;
+            return (pos + __builtin_ctz(empty)) & mask;
+        }
+    }
+}
+
+static bool
+allocate(struct FlatHashTable *const me, size_t const num_slots)
+{
+    assert(num_slots >= GROUP_WIDTH && (num_slots & (num_slots - 1)) == 0);
+    size_t const num_ctrl = num_slots + GROUP_WIDTH - 1;
+    uint8_t *ctrl = malloc(num_ctrl);
+    struct FlatHashTableEntry *entries = malloc(num_slots * sizeof(*entries));
+    if (ctrl == NULL || entries == NULL) {
+        LOGGER_ERROR("failed to allocate %zu slots", num_slots);
+        free(ctrl);
+        free(entries);
+        return false;
+    }
+    memset(ctrl, EMPTY_CTRL, num_ctrl);
+    *me = (struct FlatHashTable){.ctrl = ctrl,
+                                 .entries = entries,
+                                 .num_slots = num_slots,
+                                 .size = 0};
+    return true;
+}
+
+static bool
+resize(struct FlatHashTable *const me, size_t const new_num_slots)
+{
+    struct FlatHashTable new_me = {0};
+    if (!allocate(&new_me, new_num_slots)) {
+        return false;
+    }
+    for (size_t i = 0; i < me->num_slots; ++i) {
+        if (me->ctrl[i] == EMPTY_CTRL) {
+            continue;
+        }
+        uint64_t const hash = Hash64Bit(me->entries[i].key);
+        bool found = false;
+        size_t const slot =
+            find_slot(&new_me, me->entries[i].key, hash, &found);
+        assert(!found);
+        set_ctrl(&new_me, slot, get_ctrl(hash));
+        new_me.entries[slot] = me->entries[i];
+    }
+    new_me.size = me->size;
+    FlatHashTable__destroy(me);
+    *me = new_me;
+    return true;
+}
+
+/// @brief  Check whether one more entry would exceed the 7/8 load factor.
+static inline bool
+is_too_full(size_t const size, size_t const num_slots)
+{
+    return (size + 1) * 8 > num_slots * 7;
+}
+
+bool
+FlatHashTable__init(struct FlatHashTable *const me)
+{
+    return FlatHashTable__init_with_capacity(me, 0);
+}
+
+bool
+FlatHashTable__init_with_capacity(struct FlatHashTable *const me,
+                                  size_t const capacity)
+{
+    if (me == NULL) {
+        return false;
+    }
+    size_t num_slots = GROUP_WIDTH;
+    while (is_too_full(capacity, num_slots)) {
+        num_slots *= 2;
+    }
+    return allocate(me, num_slots);
+}
+
+size_t
+FlatHashTable__get_size(struct FlatHashTable const *const me)
+{
+    if (me == NULL) {
+        return 0;
+    }
+    return me->size;
+}
+
+struct LookupReturn
+FlatHashTable__lookup(struct FlatHashTable const *const me,
+                      EntryType const key)
+{
+    if (me == NULL || me->ctrl == NULL) {
+        return (struct LookupReturn){.success = false, .timestamp = 0};
+    }
+    bool found = false;
+    size_t const slot = find_slot(me, key, Hash64Bit(key), &found);
+    if (!found) {
+        return (struct LookupReturn){.success = false, .timestamp = 0};
+    }
+    return (struct LookupReturn){.success = true,
+                                 .timestamp = me->entries[slot].value};
+}
+
+enum PutUniqueStatus
+FlatHashTable__put(struct FlatHashTable *const me,
+                   EntryType const key,
+                   TimeStampType const value)
+{
+    if (me == NULL || me->ctrl == NULL) {
+        return LOOKUP_PUTUNIQUE_ERROR;
+    }
+    uint64_t const hash = Hash64Bit(key);
+    bool found = false;
+    size_t slot = find_slot(me, key, hash, &found);
+    if (found) {
+        me->entries[slot].value = value;
+        return LOOKUP_PUTUNIQUE_REPLACE_VALUE;
+    }
+    // NOTE I only grow for new keys, so replacing a value never moves
+    //      the table.
+    if (is_too_full(me->size, me->num_slots)) {
+        if (!resize(me, 2 * me->num_slots)) {
+            return LOOKUP_PUTUNIQUE_ERROR;
+        }
+        slot = find_slot(me, key, hash, &found);
+        assert(!found);
+    }
+    set_ctrl(me, slot, get_ctrl(hash));
+    me->entries[slot] =
+        (struct FlatHashTableEntry){.key = key, .value = value};
+    ++me->size;
+    return LOOKUP_PUTUNIQUE_INSERT_KEY_VALUE;
+}
+
+struct LookupReturn
+FlatHashTable__remove(struct FlatHashTable *const me, EntryType const key)
+{
+    if (me == NULL || me->ctrl == NULL) {
+        return (struct LookupReturn){.success = false, .timestamp = 0};
+    }
+    bool found = false;
+    size_t hole = find_slot(me, key, Hash64Bit(key), &found);
+    if (!found) {
+        return (struct LookupReturn){.success = false, .timestamp = 0};
+    }
+    TimeStampType const stolen_value = me->entries[hole].value;
+    // NOTE Rather than leave a tombstone, I shift back every later entry
+    //      in the run whose home slot is at or before the hole, so that
+    //      every key still lies between its home and the next empty slot.
+    size_t const mask = me->num_slots - 1;
+    for (size_t i = (hole + 1) & mask; me->ctrl[i] != EMPTY_CTRL;
+         i = (i + 1) & mask) {
+        size_t const home =
+            get_home_slot(me, Hash64Bit(me->entries[i].key));
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            set_ctrl(me, hole, me->ctrl[i]);
+            me->entries[hole] = me->entries[i];
+            hole = i;
+        }
+    }
+    set_ctrl(me, hole, EMPTY_CTRL);
+    --me->size;
+    return (struct LookupReturn){.success = true, .timestamp = stolen_value};
+}
+
+bool
+FlatHashTable__write(struct FlatHashTable const *const me,
+                     FILE *const stream,
+                     bool const newline)
+{
+    if (me == NULL || me->ctrl == NULL || stream == NULL) {
+        return false;
+    }
+    fprintf(stream, "{");
+    for (size_t i = 0; i < me->num_slots; ++i) {
+        if (me->ctrl[i] != EMPTY_CTRL) {
+            fprintf(stream,
+                    "%" PRIu64 ": %" PRIu64 ", ",
+                    me->entries[i].key,
+                    me->entries[i].value);
+        }
+    }
+    fprintf(stream, "}%s", newline ? "\n" : "");
+    return true;
+}
+
+void
+FlatHashTable__destroy(struct FlatHashTable *const me)
+{
+    if (me == NULL) {
+        return;
+    }
+    free(me->ctrl);
+    free(me->entries);
+    *me = (struct FlatHashTable){0};
+}
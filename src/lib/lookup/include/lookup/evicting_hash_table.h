@@ -13,6 +13,11 @@
  * 2. It is trivially parallelizable, and
  * 3. It trivially yields a HyperLogLog counter!
  *
+ * For the parallelism, each cache line of hashes is guarded by a
+ * sequence lock. Writers take the lock (after a lock-free check of
+ * whether they would be ignored anyway, which is the common case) and
+ * readers retry if the sequence number changed underneath them.
+ *
  * @note    Changing the hash function breaks my beautiful test cases.
  * @note    I remove the key to improve speed. Now, it is a hash-only
  *          algorithm. There should be some correction factor because of
@@ -37,10 +42,18 @@
 #include "types/value_type.h"
 #include "unused/mark_unused.h"
 
+/// @brief  Number of hashes that share a single sequence lock. I chose
+///         this so that one lock covers one 64 byte cache line.
+#define EVICTING_HASH_TABLE_SLOTS_PER_SEQLOCK 8
+
 struct EvictingHashTable {
     Hash64BitType *hashes;
     ValueType *values;
     size_t length;
+    // NOTE These are only used by the *_concurrent functions. An odd
+    //      value means that a writer is in the middle of an update.
+    uint64_t *seqlocks;
+    size_t num_seqlocks;
     double init_sampling_ratio;
     Hash64BitType global_threshold;
 
@@ -267,6 +280,47 @@ EvictingHashTable__try_put(struct EvictingHashTable *me,
     }
 }
 
+/// @brief  Get the index of the sequence lock that guards a hash.
+/// @note   Threads that partition the work by this index never contend
+///         on the same lock nor share any cache lines of hashes.
+static inline size_t
+EvictingHashTable__seqlock_index(struct EvictingHashTable const *const me,
+                                 Hash64BitType const hash)
+{
+    return (hash % me->length) / EVICTING_HASH_TABLE_SLOTS_PER_SEQLOCK;
+}
+
+/// @brief  Thread-safe version of EvictingHashTable__lookup().
+struct SampledLookupReturn
+EvictingHashTable__lookup_concurrent(struct EvictingHashTable *me,
+                                     KeyType key);
+
+/// @brief  Thread-safe version of EvictingHashTable__try_put() where
+///         the caller has already hashed the key.
+/// @note   Concurrent puts to the same slot are linearized by the
+///         sequence lock, but in no particular order. If the values are
+///         timestamps, then the caller must ensure that a slot is only
+///         ever written in time order (e.g. by having a single thread
+///         own each sequence lock).
+struct SampledTryPutReturn
+EvictingHashTable__try_put_hash_concurrent(struct EvictingHashTable *me,
+                                           Hash64BitType const hash,
+                                           ValueType value);
+
+/// @brief  Thread-safe version of EvictingHashTable__try_put().
+struct SampledTryPutReturn
+EvictingHashTable__try_put_concurrent(struct EvictingHashTable *me,
+                                      KeyType key,
+                                      ValueType value);
+
+/// @brief  Thread-safe version of EvictingHashTable__refresh_threshold().
+/// @note   A racing refresh may compute a stale (i.e. too high)
+///         threshold. This is safe, since the threshold is only a
+///         filter; the hashes in the table only ever decrease once it
+///         is full.
+void
+EvictingHashTable__refresh_threshold_concurrent(struct EvictingHashTable *me);
+
 void
 EvictingHashTable__print_as_json(struct EvictingHashTable *me);
 
@@ -0,0 +1,81 @@
+/** @brief  An open-addressing hash table from uint64_t to uint64_t with
+ *          SIMD control bytes, in the style of Abseil's Swiss tables.
+ *
+ *  Every slot has a one byte control word: either EMPTY (0x80) or the top
+ *  7 bits of the key's hash. A probe loads 16 control bytes at once and
+ *  compares them all against the hash's 7 bits with a single SIMD
+ *  instruction (SSE2 on x86-64, a portable loop elsewhere), so I only
+ *  touch the keys whose control bytes match, which is rarely more than
+ *  one. The keys and values are stored inline, so unlike the GLib
+ *  HashTable, there is no per-entry allocation or pointer chasing.
+ *
+ *  Slots are probed linearly from the key's home slot, a group of 16 at a
+ *  time. Thus, a key always lies between its home slot and the next empty
+ *  slot, which lets me remove keys by shifting their successors back
+ *  rather than by leaving tombstones. The table doubles when it is 7/8
+ *  full, so it never fills up and never degrades with deletions.
+ *
+ *  The API matches the KHashTable's.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lookup/lookup.h"
+#include "types/entry_type.h"
+#include "types/time_stamp_type.h"
+
+/// @brief  Number of control bytes that we compare at once.
+#define FLAT_HASH_TABLE_GROUP_WIDTH 16
+
+struct FlatHashTableEntry {
+    uint64_t key;
+    uint64_t value;
+};
+
+struct FlatHashTable {
+    // NOTE There are 'num_slots + FLAT_HASH_TABLE_GROUP_WIDTH - 1'
+    //      control bytes, where the last ones mirror the first ones so
+    //      that a group that wraps around the end can be loaded at once.
+    uint8_t *ctrl;
+    struct FlatHashTableEntry *entries;
+    // NOTE This is a power of two.
+    size_t num_slots;
+    size_t size;
+};
+
+bool
+FlatHashTable__init(struct FlatHashTable *const me);
+
+/// @brief  Initialize with room for at least 'capacity' entries before
+///         the first resize.
+bool
+FlatHashTable__init_with_capacity(struct FlatHashTable *const me,
+                                  size_t const capacity);
+
+size_t
+FlatHashTable__get_size(struct FlatHashTable const *const me);
+
+struct LookupReturn
+FlatHashTable__lookup(struct FlatHashTable const *const me,
+                      EntryType const key);
+
+/// @return Returns whether we inserted, replaced, or errored.
+enum PutUniqueStatus
+FlatHashTable__put(struct FlatHashTable *const me,
+                   EntryType const key,
+                   TimeStampType const value);
+
+struct LookupReturn
+FlatHashTable__remove(struct FlatHashTable *const me, EntryType const key);
+
+bool
+FlatHashTable__write(struct FlatHashTable const *const me,
+                     FILE *const stream,
+                     bool const newline);
+
+void
+FlatHashTable__destroy(struct FlatHashTable *const me);
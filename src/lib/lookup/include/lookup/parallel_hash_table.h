@@ -1,34 +1,74 @@
+/** @brief  A concurrent, resizable hash table from EntryType to
+ *          TimeStampType.
+ *
+ *  The table is split into PARALLEL_HASH_TABLE_NUM_STRIPES stripes by
+ *  the top bits of the key's hash. Each stripe is an independent
+ *  open-addressing (linear probing) array guarded by a sequence lock:
+ *
+ *  1. Writers take the stripe's sequence lock, so writers to different
+ *     stripes never contend.
+ *  2. Readers never lock. They read optimistically and retry if the
+ *     stripe's sequence number changed underneath them.
+ *  3. A stripe that becomes 3/4 full doubles under its own lock, so the
+ *     table resizes online, one stripe at a time, while the other
+ *     stripes remain fully available.
+ *
+ *  A reader may still be probing a stripe's old array after a writer
+ *  replaces it, so I cannot free the old array immediately. Rather than
+ *  track reader epochs, I retire old arrays onto a list and free them
+ *  when the table is destroyed. Since each array is double the size of
+ *  the one before it, the retired arrays take less memory than the live
+ *  ones.
+ *
+ *  @note   This replaces the old fixed array of mutex-guarded linked
+ *          lists (ParallelList), whose chains grew without bound.
+ */
 #pragma once
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #include "lookup/lookup.h"
-#include "lookup/parallel_list.h"
 #include "types/entry_type.h"
 #include "types/time_stamp_type.h"
 
+#define PARALLEL_HASH_TABLE_NUM_STRIPES 256
+
+struct ParallelHashTableArray;
+
+struct ParallelHashTableStripe {
+    // NOTE An odd value means that a writer is in the middle of an update.
+    uint64_t seqlock;
+    struct ParallelHashTableArray *array;
+    size_t size;
+    // NOTE The arrays that this stripe has outgrown, which readers may
+    //      still be accessing.
+    struct ParallelHashTableArray *retired;
+} __attribute__((aligned(64)));
+
 struct ParallelHashTable {
-    struct ParallelList *table;
-    size_t length;
+    struct ParallelHashTableStripe *stripes;
 };
 
+/// @param  num_buckets: The number of entries that we expect, so that
+///                      we resize less often. The table grows beyond it.
 bool
 ParallelHashTable__init(struct ParallelHashTable *me, size_t num_buckets);
 
+/// @brief  Update if the key exists, otherwise insert.
 bool
 ParallelHashTable__put(struct ParallelHashTable *me,
                        EntryType entry,
                        TimeStampType timestamp);
 
-bool
-ParallelHashTable__put(struct ParallelHashTable *me,
-                       EntryType entry,
-                       TimeStampType new_timestamp);
-
 struct LookupReturn
 ParallelHashTable__lookup(struct ParallelHashTable *me, EntryType);
 
+/// @note   This is not thread-safe with respect to concurrent writers.
+size_t
+ParallelHashTable__get_size(struct ParallelHashTable *me);
+
 void
 ParallelHashTable__destroy(struct ParallelHashTable *me);
 
@@ -1,23 +1,232 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <sched.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "hash/splitmix64.h"
+#include "logger/logger.h"
 #include "lookup/lookup.h"
 #include "lookup/parallel_hash_table.h"
-#include "lookup/parallel_list.h"
 #include "types/entry_type.h"
 #include "types/time_stamp_type.h"
 
+#define NUM_STRIPES     PARALLEL_HASH_TABLE_NUM_STRIPES
+#define MIN_NUM_SLOTS   16
+#define SPINS_PER_YIELD 64
+/// @brief  The tag of an empty slot. Full slots hold 7 bits of their
+///         key's hash with the top bit set, so that they are never 0.
+#define EMPTY_TAG 0
+
+struct ParallelHashTableSlot {
+    EntryType entry;
+    TimeStampType timestamp;
+};
+
+struct ParallelHashTableArray {
+    struct ParallelHashTableArray *next_retired;
+    // NOTE This is a power of two.
+    size_t num_slots;
+    // NOTE This points just past the slots in the same allocation.
+    uint8_t *tags;
+    struct ParallelHashTableSlot slots[];
+};
+
+static inline struct ParallelHashTableStripe *
+get_stripe(struct ParallelHashTable const *const me, uint64_t const hash)
+{
+    // NOTE I use the top bits for the stripe and the bottom bits for the
+    //      slot, so that they are independent.
+    return &me->stripes[hash >> 56 & (NUM_STRIPES - 1)];
+}
+
+static inline uint8_t
+get_tag(uint64_t const hash)
+{
+    return 0x80 | (uint8_t)(hash >> 48 & 0x7F);
+}
+
+static struct ParallelHashTableArray *
+allocate_array(size_t const num_slots)
+{
+    assert(num_slots >= MIN_NUM_SLOTS && (num_slots & (num_slots - 1)) == 0);
+    struct ParallelHashTableArray *a =
+        calloc(1,
+               sizeof(*a) + num_slots * sizeof(*a->slots) +
+                   num_slots * sizeof(*a->tags));
+    if (a == NULL) {
+        LOGGER_ERROR("failed to allocate %zu slots", num_slots);
+        return NULL;
+    }
+    a->num_slots = num_slots;
+    a->tags = (uint8_t *)&a->slots[num_slots];
+    return a;
+}
+
+/// @brief  Find the entry's slot or else the empty slot where it belongs.
+/// @note   Only a stripe's writer may call this, since the reads are not
+///         atomic.
+static size_t
+find_slot(struct ParallelHashTableArray const *const a,
+          EntryType const entry,
+          uint64_t const hash,
+          bool *const found)
+{
+    size_t const mask = a->num_slots - 1;
+    uint8_t const tag = get_tag(hash);
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        if (a->tags[i] == EMPTY_TAG) {
+            *found = false;
+            return i;
+        }
+        if (a->tags[i] == tag && a->slots[i].entry == entry) {
+            *found = true;
+            return i;
+        }
+    }
+}
+
+/// @brief  Probe for an entry without holding the stripe's lock.
+/// @note   The caller must validate the result with the sequence lock,
+///         since a writer may modify the array as we read it. In that
+///         case, the probe may see no empty slot, so I bound it.
+static struct LookupReturn
+probe_concurrent(struct ParallelHashTableArray const *const a,
+                 EntryType const entry,
+                 uint64_t const hash)
+{
+    size_t const mask = a->num_slots - 1;
+    uint8_t const tag = get_tag(hash);
+    size_t i = hash & mask;
+    for (size_t n = 0; n < a->num_slots; ++n, i = (i + 1) & mask) {
+        uint8_t const t = __atomic_load_n(&a->tags[i], __ATOMIC_RELAXED);
+        if (t == EMPTY_TAG) {
+            break;
+        }
+        if (t == tag &&
+            __atomic_load_n(&a->slots[i].entry, __ATOMIC_RELAXED) == entry) {
+            return (struct LookupReturn){
+                .success = true,
+                .timestamp = __atomic_load_n(&a->slots[i].timestamp,
+                                             __ATOMIC_RELAXED)};
+        }
+    }
+    return (struct LookupReturn){.success = false, .timestamp = 0};
+}
+
+/// @brief  Wait for a stripe's writer to finish.
+/// @note   I yield every so often because, with more threads than cores,
+///         the writer may be descheduled while holding the lock, in which
+///         case spinning only delays it further.
+static inline void
+backoff(size_t *const num_spins)
+{
+    if (++*num_spins % SPINS_PER_YIELD == 0) {
+        sched_yield();
+    }
+}
+
+static inline void
+seqlock_acquire(uint64_t *const seqlock)
+{
+    uint64_t seq = __atomic_load_n(seqlock, __ATOMIC_RELAXED);
+    size_t num_spins = 0;
+    while (true) {
+        // NOTE The acquire ordering stops the writes to the stripe from
+        //      being reordered before the sequence number becomes odd.
+        if ((seq & 1) == 0 && __atomic_compare_exchange_n(seqlock,
+                                                          &seq,
+                                                          seq + 1,
+                                                          true,
+                                                          __ATOMIC_ACQUIRE,
+                                                          __ATOMIC_RELAXED)) {
+            return;
+        }
+        backoff(&num_spins);
+        seq = __atomic_load_n(seqlock, __ATOMIC_RELAXED);
+    }
+}
+
+static inline void
+seqlock_release(uint64_t *const seqlock)
+{
+    __atomic_fetch_add(seqlock, 1, __ATOMIC_RELEASE);
+}
+
+/// @brief  Double a stripe's array. The caller must hold its lock.
+static bool
+grow_stripe(struct ParallelHashTableStripe *const stripe)
+{
+    struct ParallelHashTableArray *const old = stripe->array;
+    struct ParallelHashTableArray *const grown =
+        allocate_array(2 * old->num_slots);
+    if (grown == NULL) {
+        return false;
+    }
+    // NOTE No reader can see the new array until I publish it, so I can
+    //      fill it with plain writes.
+    for (size_t i = 0; i < old->num_slots; ++i) {
+        if (old->tags[i] == EMPTY_TAG) {
+            continue;
+        }
+        uint64_t const hash = splitmix64_hash(old->slots[i].entry);
+        bool found = false;
+        size_t const j = find_slot(grown, old->slots[i].entry, hash, &found);
+        assert(!found);
+        grown->slots[j] = old->slots[i];
+        grown->tags[j] = old->tags[i];
+    }
+    __atomic_store_n(&stripe->array, grown, __ATOMIC_RELEASE);
+    old->next_retired = stripe->retired;
+    stripe->retired = old;
+    return true;
+}
+
+static void
+free_arrays(struct ParallelHashTableArray *a)
+{
+    while (a != NULL) {
+        struct ParallelHashTableArray *const next = a->next_retired;
+        free(a);
+        a = next;
+    }
+}
+
 bool
 ParallelHashTable__init(struct ParallelHashTable *me, size_t num_buckets)
 {
     if (me == NULL || num_buckets == 0)
         return false;
-    *me = (struct ParallelHashTable){
-        .table = (struct ParallelList *)calloc(sizeof(*me->table), num_buckets),
-        .length = num_buckets};
+    size_t num_slots = MIN_NUM_SLOTS;
+    while (num_slots * 3 / 4 < num_buckets / NUM_STRIPES) {
+        num_slots *= 2;
+    }
+    struct ParallelHashTableStripe *stripes =
+        aligned_alloc(_Alignof(struct ParallelHashTableStripe),
+                      NUM_STRIPES * sizeof(*stripes));
+    if (stripes == NULL) {
+        LOGGER_ERROR("failed to allocate %d stripes", NUM_STRIPES);
+        return false;
+    }
+    for (size_t i = 0; i < NUM_STRIPES; ++i) {
+        stripes[i] = (struct ParallelHashTableStripe){
+            .seqlock = 0,
+            .array = allocate_array(num_slots),
+            .size = 0,
+            .retired = NULL};
+        if (stripes[i].array == NULL) {
+            for (size_t j = 0; j < i; ++j) {
+                free_arrays(stripes[j].array);
+            }
+            free(stripes);
+            return false;
+        }
+    }
+    *me = (struct ParallelHashTable){.stripes = stripes};
     return true;
 }
 
@@ -26,20 +235,72 @@ ParallelHashTable__put(struct ParallelHashTable *me,
                        EntryType entry,
                        TimeStampType timestamp)
 {
-    if (me == NULL || me->table == NULL || me->length == 0)
+    if (me == NULL || me->stripes == NULL)
         return false;
-    Hash64BitType hash = splitmix64_hash(entry);
-    return ParallelList__put(&me->table[hash % me->length], entry, timestamp);
+    uint64_t const hash = splitmix64_hash(entry);
+    struct ParallelHashTableStripe *const stripe = get_stripe(me, hash);
+    seqlock_acquire(&stripe->seqlock);
+    bool found = false;
+    size_t i = find_slot(stripe->array, entry, hash, &found);
+    if (found) {
+        __atomic_store_n(&stripe->array->slots[i].timestamp,
+                         timestamp,
+                         __ATOMIC_RELAXED);
+        seqlock_release(&stripe->seqlock);
+        return true;
+    }
+    if ((stripe->size + 1) * 4 > stripe->array->num_slots * 3) {
+        if (!grow_stripe(stripe)) {
+            seqlock_release(&stripe->seqlock);
+            return false;
+        }
+        i = find_slot(stripe->array, entry, hash, &found);
+        assert(!found);
+    }
+    struct ParallelHashTableArray *const a = stripe->array;
+    __atomic_store_n(&a->slots[i].entry, entry, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->slots[i].timestamp, timestamp, __ATOMIC_RELAXED);
+    __atomic_store_n(&a->tags[i], get_tag(hash), __ATOMIC_RELAXED);
+    ++stripe->size;
+    seqlock_release(&stripe->seqlock);
+    return true;
 }
 
 struct LookupReturn
 ParallelHashTable__lookup(struct ParallelHashTable *me, EntryType entry)
 {
     struct LookupReturn r = {.success = false};
-    if (me == NULL || me->table == NULL || me->length == 0)
+    if (me == NULL || me->stripes == NULL)
         return r;
-    Hash64BitType hash = splitmix64_hash(entry);
-    return ParallelList__lookup(&me->table[hash % me->length], entry);
+    uint64_t const hash = splitmix64_hash(entry);
+    struct ParallelHashTableStripe *const stripe = get_stripe(me, hash);
+    uint64_t seq = 0;
+    size_t num_spins = 0;
+    do {
+        seq = __atomic_load_n(&stripe->seqlock, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            backoff(&num_spins);
+            continue;
+        }
+        struct ParallelHashTableArray const *const a =
+            __atomic_load_n(&stripe->array, __ATOMIC_ACQUIRE);
+        r = probe_concurrent(a, entry, hash);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((seq & 1) ||
+             seq != __atomic_load_n(&stripe->seqlock, __ATOMIC_RELAXED));
+    return r;
+}
+
+size_t
+ParallelHashTable__get_size(struct ParallelHashTable *me)
+{
+    if (me == NULL || me->stripes == NULL)
+        return 0;
+    size_t size = 0;
+    for (size_t i = 0; i < NUM_STRIPES; ++i) {
+        size += me->stripes[i].size;
+    }
+    return size;
 }
 
 void
@@ -47,27 +308,34 @@ ParallelHashTable__destroy(struct ParallelHashTable *me)
 {
     if (me == NULL)
         return;
-    if (me->table == NULL || me->length == 0) {
+    if (me->stripes == NULL) {
         *me = (struct ParallelHashTable){0};
         return;
     }
-    for (size_t i = 0; i < me->length; ++i) {
-        ParallelList__destroy(&me->table[i]);
+    for (size_t i = 0; i < NUM_STRIPES; ++i) {
+        free_arrays(me->stripes[i].array);
+        free_arrays(me->stripes[i].retired);
     }
-    free(me->table);
+    free(me->stripes);
     *me = (struct ParallelHashTable){0};
 }
 
 void
 ParallelHashTable__print(struct ParallelHashTable *me)
 {
-    if (me == NULL || me->table == NULL || me->length == 0)
+    if (me == NULL || me->stripes == NULL)
         return;
 
-    printf("[%zu]{\n", me->length);
-    for (size_t i = 0; i < me->length; ++i) {
-        ParallelList__print(&me->table[i]);
-        printf(", ");
+    printf("[%zu]{", ParallelHashTable__get_size(me));
+    for (size_t i = 0; i < NUM_STRIPES; ++i) {
+        struct ParallelHashTableArray const *const a = me->stripes[i].array;
+        for (size_t j = 0; j < a->num_slots; ++j) {
+            if (a->tags[j] != EMPTY_TAG) {
+                printf("%" PRIu64 ": %" PRIu64 ", ",
+                       (uint64_t)a->slots[j].entry,
+                       (uint64_t)a->slots[j].timestamp);
+            }
+        }
     }
     printf("}\n");
 }
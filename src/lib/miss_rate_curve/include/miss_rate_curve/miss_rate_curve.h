@@ -7,6 +7,8 @@
 
 #include "histogram/fractional_histogram.h"
 #include "histogram/histogram.h"
+#include "histogram/log_histogram.h"
+#include "io/binary_container.h"
 
 struct MissRateCurve {
     double *miss_rate;
@@ -32,6 +34,30 @@ bool
 MissRateCurve__init_from_histogram(struct MissRateCurve *me,
                                    struct Histogram const *const histogram);
 
+/// @brief  Sample the miss rate at the start of every block of
+///         HISTOGRAM_BLOCK_SIZE histogram bins, using the histogram's
+///         prefix sums (see 'Histogram__enable_prefix_sums').
+/// @note   This costs O(num_bins / HISTOGRAM_BLOCK_SIZE), so we can take
+///         snapshots while the histogram is still being filled.
+/// @param  me: either zeroed or a previous result of this function, whose
+///             memory I reuse if the number of bins has not changed.
+bool
+MissRateCurve__refresh_coarse_from_histogram(
+    struct MissRateCurve *const me,
+    struct Histogram const *const histogram);
+
+/// @brief  Sample the miss rate at the cache sizes 0, bin_size, ...,
+///         (num_mrc_bins - 1) * bin_size.
+/// @note   Unlike the other initializers, the log histogram has no natural
+///         bin size, so the caller chooses the MRC's resolution. Within a
+///         log bin, I interpolate linearly.
+bool
+MissRateCurve__init_from_log_histogram(
+    struct MissRateCurve *const me,
+    struct LogHistogram const *const histogram,
+    uint64_t const num_mrc_bins,
+    uint64_t const bin_size);
+
 /// NOTE    The arguments are in a terrible order. Sorry.
 bool
 MissRateCurve__init_from_parda_histogram(struct MissRateCurve *me,
@@ -46,13 +72,34 @@ MissRateCurve__save(struct MissRateCurve const *const me,
                     char const *restrict const file_name);
 
 /// @brief  Load a sparse MRC curve from a file.
+/// @note   I accept both the legacy format (from 'MissRateCurve__save')
+///         and the binary container (from 'MissRateCurve__save_binary').
 bool
 MissRateCurve__load(struct MissRateCurve *const me,
                     char const *restrict const file_name);
 
+/// @brief  Save the MRC as a binary container (see 'io/binary_container.h').
+/// @param  sparse: whether to store only the bins where the miss rate
+///                 changes. A dense file can be viewed in place with
+///                 'MissRateCurve__init_view'.
+bool
+MissRateCurve__save_binary(struct MissRateCurve const *const me,
+                           char const *const file_name,
+                           bool const sparse);
+
+/// @brief  View a dense MRC container in place, without copying.
+/// @note   The MRC borrows the container's read-only memory, so do not
+///         modify or destroy it; close the container when done.
+bool
+MissRateCurve__init_view(struct MissRateCurve *const me,
+                         struct BinaryContainer const *const container);
+
 /// @note   This is useful when trying to average many MRCs without
 ///         needing to load all of the histograms at once.
 /// @note   I am not entirely content with the semantics of this function.
+/// @note   If the bin sizes or number of bins differ, then I resample 'me'
+///         at the larger bin size over the larger range. Past its end, an
+///         MRC keeps its final miss rate.
 bool
 MissRateCurve__scaled_iadd(struct MissRateCurve *const me,
                            struct MissRateCurve const *const other,
@@ -75,6 +122,29 @@ double
 MissRateCurve__mean_squared_error(struct MissRateCurve const *const lhs,
                                   struct MissRateCurve const *const rhs);
 
+/// @brief  Compute the mean absolute error of each of 'num_mrcs' MRCs
+///         against one oracle, i.e. 'errors[k] = MAE(oracle, mrcs[k])'.
+/// @note   This makes one pass over the oracle, comparing each block of it
+///         against every MRC, rather than one pass per MRC.
+/// @return False if the oracle or arrays are invalid. Otherwise, true, and
+///         each error is as in 'MissRateCurve__mean_absolute_error'
+///         (i.e. INFINITY if that MRC is invalid).
+bool
+MissRateCurve__batch_mean_absolute_error(
+    struct MissRateCurve const *const oracle,
+    struct MissRateCurve const *const *const mrcs,
+    size_t const num_mrcs,
+    double *const errors);
+
+/// @brief  Compute the mean squared error of each of 'num_mrcs' MRCs
+///         against one oracle. See 'MissRateCurve__batch_mean_absolute_error'.
+bool
+MissRateCurve__batch_mean_squared_error(
+    struct MissRateCurve const *const oracle,
+    struct MissRateCurve const *const *const mrcs,
+    size_t const num_mrcs,
+    double *const errors);
+
 void
 MissRateCurve__write_as_json(FILE *stream,
                              struct MissRateCurve const *const me);
@@ -0,0 +1,59 @@
+/** @brief  Hand coarse MRCs from the thread that fills a histogram to a
+ *          thread that reads them, without either ever waiting.
+ *
+ *  This is a triple buffer. The writer fills its 'back' buffer and swaps
+ *  it with the shared 'middle' buffer; the reader swaps its 'front' buffer
+ *  with the middle one if it is fresh. Each swap is one atomic exchange,
+ *  so publishing costs O(num_bins / HISTOGRAM_BLOCK_SIZE) to build the
+ *  coarse MRC and O(1) to hand it off. The reader always sees the latest
+ *  complete MRC, but it may skip some if it reads less often than the
+ *  writer publishes.
+ *
+ *  @note   Only one thread may publish and only one thread may consume.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "histogram/histogram.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+
+struct MissRateCurveSnapshots {
+    struct MissRateCurve buffers[3];
+    /// The number of the publish that filled each buffer, or zero.
+    uint64_t versions[3];
+
+    /// Owned by the writer
+    unsigned back;
+    uint64_t num_published;
+
+    /// Owned by the reader
+    unsigned front;
+
+    /// Shared: the index of the middle buffer, plus a flag that marks
+    /// whether the writer published it since the reader last took it.
+    unsigned middle;
+};
+
+bool
+MissRateCurveSnapshots__init(struct MissRateCurveSnapshots *const me);
+
+/// @brief  Build a coarse MRC from the histogram and hand it to the reader.
+/// @note   Call this from the thread that fills the histogram, which must
+///         have its prefix sums enabled (see 'Histogram__enable_prefix_sums').
+bool
+MissRateCurveSnapshots__publish(struct MissRateCurveSnapshots *const me,
+                                struct Histogram const *const histogram);
+
+/// @brief  Get the latest published MRC.
+/// @param  version: if not NULL, I store the number of the publish that
+///                  produced the MRC, so the reader can tell if it is new.
+/// @return The MRC, which is valid until the next call to this function, or
+///         NULL if nothing has been published yet.
+struct MissRateCurve const *
+MissRateCurveSnapshots__consume(struct MissRateCurveSnapshots *const me,
+                                uint64_t *const version);
+
+void
+MissRateCurveSnapshots__destroy(struct MissRateCurveSnapshots *const me);
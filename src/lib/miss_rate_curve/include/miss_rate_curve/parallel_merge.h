@@ -0,0 +1,59 @@
+/** @brief  Merge many histograms or MRCs across threads.
+ *
+ *  Combining the saved histograms of a phase sampler or the per-thread
+ *  histograms of a parallel engine with 'Histogram__iadd' is a serial fold
+ *  over every input. Here, each of 'num_threads' workers folds a
+ *  contiguous slice of the inputs, and then the workers' partial results
+ *  are merged pairwise in a tree of depth log2(num_threads).
+ *
+ *  The inputs are streamed: I ask the caller to load each input only when
+ *  I am about to merge it and I destroy it right after. At most two
+ *  inputs per worker are resident at once, so the inputs can live on disk
+ *  (e.g. 'Histogram__load'). For inputs that are already in memory, the
+ *  loader can move them into 'dst' instead of copying.
+ *
+ *  Inputs with different bin sizes or numbers of bins are rebinned (see
+ *  'Histogram__iadd' and 'MissRateCurve__scaled_iadd').
+ *
+ *  @note   The floating-point sums of MRCs are added in a different order
+ *          than a serial fold, so they may differ in the last few bits.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "histogram/histogram.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+
+/// @brief  Initialize 'dst' as the input 'i'. I call this from multiple
+///         threads at once, but never twice with the same 'i'.
+/// @note   Upon failure, 'dst' must be zeroed or safe to destroy.
+typedef bool (*ParallelMergeHistogramLoader)(void *const data,
+                                             size_t const i,
+                                             struct Histogram *const dst);
+
+typedef bool (*ParallelMergeMissRateCurveLoader)(
+    void *const data,
+    size_t const i,
+    struct MissRateCurve *const dst);
+
+/// @brief  Initialize 'me' as the sum of 'num_inputs' histograms.
+/// @param  num_threads: the number of workers, including the calling
+///                      thread. I use at most one per input.
+bool
+ParallelMerge__histograms(struct Histogram *const me,
+                          size_t const num_inputs,
+                          ParallelMergeHistogramLoader const load,
+                          void *const data,
+                          size_t const num_threads);
+
+/// @brief  Initialize 'me' as the sum of 'num_inputs' MRCs.
+/// @note   To average them, add the sum into a zeroed MRC with a scale of
+///         '1.0 / num_inputs' (see 'MissRateCurve__scaled_iadd').
+bool
+ParallelMerge__miss_rate_curves(struct MissRateCurve *const me,
+                                size_t const num_inputs,
+                                ParallelMergeMissRateCurveLoader const load,
+                                void *const data,
+                                size_t const num_threads);
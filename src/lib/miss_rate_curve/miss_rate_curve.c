@@ -12,7 +12,10 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include "array/array_kernels.h"
 #include "histogram/fractional_histogram.h"
+#include "histogram/log_histogram.h"
+#include "io/binary_container.h"
 #include "io/io.h"
 #include "logger/logger.h"
 #include "math/doubles_are_equal.h"
@@ -137,17 +140,18 @@ MissRateCurve__init_from_histogram(struct MissRateCurve *me,
     me->bin_size = histogram->bin_size;
 
     // Generate the MRC
+    // TODO(dchu): Check for division by zero! How do we intelligently
+    //              resolve this?
+    // NOTE The vectorized kernel subtracts whole blocks at once, so rather
+    //      than checking that each subtraction is non-negative, I check
+    //      that exactly the infinities are left over. If the bins summed
+    //      to more than the total, then this would wrap around and fail.
     const uint64_t total = histogram->running_sum;
-    uint64_t tmp = total;
-    for (uint64_t i = 0; i < histogram->num_bins; ++i) {
-        const uint64_t h = histogram->histogram[i];
-        // TODO(dchu): Check for division by zero! How do we intelligently
-        //              resolve this?
-        me->miss_rate[i] = (double)tmp / (double)total;
-        // The subtraction should yield a non-negative result
-        g_assert_cmpuint(tmp, >=, h);
-        tmp -= h;
-    }
+    uint64_t tmp = ArrayKernel__normalized_suffix_sums(ArrayKernel__best(),
+                                                       histogram->histogram,
+                                                       histogram->num_bins,
+                                                       total,
+                                                       me->miss_rate);
     me->miss_rate[histogram->num_bins] = (double)tmp / (double)total;
     tmp -= histogram->false_infinity;
     me->miss_rate[histogram->num_bins + 1] = (double)tmp / (double)total;
@@ -156,6 +160,104 @@ MissRateCurve__init_from_histogram(struct MissRateCurve *me,
     return true;
 }
 
+bool
+MissRateCurve__refresh_coarse_from_histogram(
+    struct MissRateCurve *const me,
+    struct Histogram const *const histogram)
+{
+    if (me == NULL || histogram == NULL || histogram->histogram == NULL ||
+        histogram->num_bins == 0 || histogram->bin_size == 0) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    if (histogram->block_sums == NULL) {
+        LOGGER_ERROR("prefix sums are not enabled");
+        return false;
+    }
+    size_t const num_blocks =
+        (histogram->num_bins + HISTOGRAM_BLOCK_SIZE - 1) / HISTOGRAM_BLOCK_SIZE;
+    size_t const num_bins = num_blocks + 2;
+    // NOTE I only reallocate when the histogram has grown, so periodic
+    //      snapshots do not allocate.
+    if (me->num_bins != num_bins) {
+        double *const miss_rate =
+            realloc(me->miss_rate, num_bins * sizeof(*miss_rate));
+        if (miss_rate == NULL) {
+            LOGGER_ERROR("failed to allocate %zu bins", num_bins);
+            return false;
+        }
+        me->miss_rate = miss_rate;
+        me->num_bins = num_bins;
+    }
+    me->bin_size = histogram->bin_size * HISTOGRAM_BLOCK_SIZE;
+
+    uint64_t const total = histogram->running_sum;
+    if (total == 0) {
+        memset(me->miss_rate, 0, num_bins * sizeof(*me->miss_rate));
+        return true;
+    }
+    // NOTE The miss rate at the start of each block is the fraction of
+    //      values in that block or later, which is the same suffix sum
+    //      that 'MissRateCurve__init_from_histogram' computes per bin.
+    uint64_t tmp = ArrayKernel__normalized_suffix_sums(ArrayKernel__best(),
+                                                       histogram->block_sums,
+                                                       num_blocks,
+                                                       total,
+                                                       me->miss_rate);
+    me->miss_rate[num_blocks] = (double)tmp / (double)total;
+    tmp -= histogram->false_infinity;
+    me->miss_rate[num_blocks + 1] = (double)tmp / (double)total;
+    return true;
+}
+
+bool
+MissRateCurve__init_from_log_histogram(
+    struct MissRateCurve *const me,
+    struct LogHistogram const *const histogram,
+    uint64_t const num_mrc_bins,
+    uint64_t const bin_size)
+{
+    if (me == NULL || histogram == NULL || histogram->histogram == NULL ||
+        histogram->num_bins == 0) {
+        return false;
+    }
+    if (!MissRateCurve__alloc_empty(me, num_mrc_bins, bin_size)) {
+        return false;
+    }
+    if (histogram->running_sum == 0) {
+        LOGGER_WARN("empty histogram");
+        return true;
+    }
+    double const total = histogram->running_sum;
+    // NOTE I sweep the cache sizes and the log bins together, where
+    //      'below' counts the values in the bins before bin 'j'. Thus, this
+    //      takes O(num_mrc_bins + histogram->num_bins) time.
+    uint64_t below = 0;
+    size_t j = 0;
+    for (uint64_t i = 0; i < num_mrc_bins; ++i) {
+        uint64_t const cache_size = i * bin_size;
+        while (j < histogram->num_bins &&
+               LogHistogram__get_bin_lower_bound(histogram, j) +
+                       LogHistogram__get_bin_width(histogram, j) <=
+                   cache_size) {
+            below += histogram->histogram[j];
+            ++j;
+        }
+        double at_least = total - below;
+        if (j < histogram->num_bins) {
+            uint64_t const lower =
+                LogHistogram__get_bin_lower_bound(histogram, j);
+            if (cache_size > lower) {
+                at_least -= (double)histogram->histogram[j] *
+                            (cache_size - lower) /
+                            LogHistogram__get_bin_width(histogram, j);
+            }
+        }
+        me->miss_rate[i] = at_least / total;
+    }
+    return true;
+}
+
 bool
 MissRateCurve__init_from_parda_histogram(struct MissRateCurve *me,
                                          uint64_t histogram_length,
@@ -269,6 +371,135 @@ cleanup:
     return false;
 }
 
+enum MissRateCurveContainerMetadata {
+    MISS_RATE_CURVE_CONTAINER_BIN_SIZE,
+};
+
+bool
+MissRateCurve__save_binary(struct MissRateCurve const *const me,
+                           char const *const file_name,
+                           bool const sparse)
+{
+    uint64_t *index = NULL;
+    double *values = NULL;
+    uint64_t num_entries = 0;
+    bool r = false;
+    if (!is_initialized(me) || file_name == NULL) {
+        return false;
+    }
+    uint64_t const metadata[BINARY_CONTAINER_METADATA_LENGTH] = {
+        [MISS_RATE_CURVE_CONTAINER_BIN_SIZE] = me->bin_size,
+    };
+    if (!sparse) {
+        return BinaryContainer__save(file_name,
+                                     BINARY_CONTAINER_KIND_MISS_RATE_CURVE,
+                                     BINARY_CONTAINER_FILL_PREVIOUS,
+                                     metadata,
+                                     me->num_bins,
+                                     me->miss_rate,
+                                     NULL,
+                                     me->num_bins);
+    }
+    // NOTE Like 'MissRateCurve__save', I only store the bins where the
+    //      miss rate changes (and the first bin).
+    index = malloc(me->num_bins * sizeof(*index));
+    values = malloc(me->num_bins * sizeof(*values));
+    if (index == NULL || values == NULL) {
+        LOGGER_ERROR("failed to allocate %zu entries", me->num_bins);
+        goto cleanup;
+    }
+    for (size_t i = 0; i < me->num_bins; ++i) {
+        if (i == 0 || me->miss_rate[i] != me->miss_rate[i - 1]) {
+            index[num_entries] = i;
+            values[num_entries] = me->miss_rate[i];
+            ++num_entries;
+        }
+    }
+    r = BinaryContainer__save(file_name,
+                              BINARY_CONTAINER_KIND_MISS_RATE_CURVE,
+                              BINARY_CONTAINER_FILL_PREVIOUS,
+                              metadata,
+                              me->num_bins,
+                              values,
+                              index,
+                              num_entries);
+cleanup:
+    free(index);
+    free(values);
+    return r;
+}
+
+bool
+MissRateCurve__init_view(struct MissRateCurve *const me,
+                         struct BinaryContainer const *const container)
+{
+    if (me == NULL || container == NULL || container->header == NULL ||
+        container->header->kind != BINARY_CONTAINER_KIND_MISS_RATE_CURVE) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    if (container->index != NULL) {
+        LOGGER_ERROR("cannot view a sparse MRC in place");
+        return false;
+    }
+    uint64_t const bin_size =
+        container->header->metadata[MISS_RATE_CURVE_CONTAINER_BIN_SIZE];
+    if (container->header->num_elements == 0 || bin_size == 0) {
+        LOGGER_ERROR("bad MRC metadata");
+        return false;
+    }
+    // NOTE The memory map is read-only, so writing through this pointer
+    //      will fault. I cast away the const because 'struct
+    //      MissRateCurve' has no read-only variant.
+    *me = (struct MissRateCurve){
+        .miss_rate = (double *)container->values,
+        .num_bins = container->header->num_elements,
+        .bin_size = bin_size,
+    };
+    return true;
+}
+
+static bool
+load_container(struct MissRateCurve *const me,
+               char const *restrict const file_name)
+{
+    struct BinaryContainer container = {0};
+    struct MissRateCurve mrc = {0};
+    if (!BinaryContainer__open(&container,
+                               file_name,
+                               BINARY_CONTAINER_KIND_MISS_RATE_CURVE,
+                               true)) {
+        LOGGER_ERROR("failed to open '%s'", file_name);
+        return false;
+    }
+    uint64_t const num_bins = container.header->num_elements;
+    uint64_t const bin_size =
+        container.header->metadata[MISS_RATE_CURVE_CONTAINER_BIN_SIZE];
+    if (num_bins == 0 || bin_size == 0) {
+        LOGGER_ERROR("bad MRC metadata");
+        goto cleanup;
+    }
+    mrc = (struct MissRateCurve){
+        .miss_rate = calloc(num_bins, sizeof(*mrc.miss_rate)),
+        .num_bins = num_bins,
+        .bin_size = bin_size,
+    };
+    if (mrc.miss_rate == NULL) {
+        LOGGER_ERROR("allocation failed!");
+        goto cleanup;
+    }
+    if (!BinaryContainer__copy_dense(&container, mrc.miss_rate)) {
+        LOGGER_ERROR("failed to read MRC");
+        goto cleanup;
+    }
+    *me = mrc;
+    return BinaryContainer__close(&container);
+cleanup:
+    free(mrc.miss_rate);
+    BinaryContainer__close(&container);
+    return false;
+}
+
 bool
 MissRateCurve__load(struct MissRateCurve *const me,
                     char const *restrict const file_name)
@@ -276,6 +507,10 @@ MissRateCurve__load(struct MissRateCurve *const me,
     if (me == NULL || file_name == NULL) {
         return false;
     }
+    if (BinaryContainer__is_container(file_name)) {
+        *me = (struct MissRateCurve){0};
+        return load_container(me, file_name);
+    }
 
     // NOTE I ensure the cleanup works fine by setting the input data
     //      structure to {0}.
@@ -340,6 +575,37 @@ cleanup:
     return false;
 }
 
+/// @brief  Get the miss rate at 'cache_size'.
+/// @note   I treat the MRC as a step function that keeps its final value
+///         past the end, as the error metrics do.
+static inline double
+get_miss_rate_at(struct MissRateCurve const *const me, size_t const cache_size)
+{
+    size_t const i = cache_size / me->bin_size;
+    return me->miss_rate[MIN(i, me->num_bins - 1)];
+}
+
+/// @brief  Sample the MRC at 'num_bins' cache sizes of 'bin_size' apart.
+static bool
+resample(struct MissRateCurve *const me,
+         size_t const num_bins,
+         size_t const bin_size)
+{
+    double *const miss_rate = malloc(num_bins * sizeof(*miss_rate));
+    if (miss_rate == NULL) {
+        LOGGER_ERROR("failed to allocate %zu bins", num_bins);
+        return false;
+    }
+    for (size_t i = 0; i < num_bins; ++i) {
+        miss_rate[i] = get_miss_rate_at(me, i * bin_size);
+    }
+    free(me->miss_rate);
+    me->miss_rate = miss_rate;
+    me->num_bins = num_bins;
+    me->bin_size = bin_size;
+    return true;
+}
+
 bool
 MissRateCurve__scaled_iadd(struct MissRateCurve *const me,
                            struct MissRateCurve const *const other,
@@ -349,17 +615,33 @@ MissRateCurve__scaled_iadd(struct MissRateCurve *const me,
         return false;
     }
 
-    if (me->num_bins != other->num_bins || me->bin_size != other->bin_size) {
-        LOGGER_ERROR(
-            "num_bins (%zu vs %zu) and bin_size (%zu vs %zu) must match",
-            me->num_bins,
-            other->num_bins,
-            me->bin_size,
-            other->bin_size);
-        return false;
+    // NOTE Like 'Histogram__iadd', I use the coarser bin size and the
+    //      larger range. The last bin is at cache size
+    //      '(num_bins - 1) * bin_size'.
+    size_t const bin_size = MAX(me->bin_size, other->bin_size);
+    size_t const max_cache_size = MAX((me->num_bins - 1) * me->bin_size,
+                                      (other->num_bins - 1) * other->bin_size);
+    size_t const num_bins = (max_cache_size + bin_size - 1) / bin_size + 1;
+    if (num_bins != me->num_bins || bin_size != me->bin_size) {
+        if (!resample(me, num_bins, bin_size)) {
+            return false;
+        }
     }
-    for (size_t i = 0; i < me->num_bins; ++i) {
-        me->miss_rate[i] += scale * other->miss_rate[i];
+    if (other->bin_size != bin_size) {
+        for (size_t i = 0; i < num_bins; ++i) {
+            me->miss_rate[i] += scale * get_miss_rate_at(other, i * bin_size);
+        }
+        return true;
+    }
+    ArrayKernel__scaled_iadd(ArrayKernel__best(),
+                             me->miss_rate,
+                             other->miss_rate,
+                             other->num_bins,
+                             scale);
+    // NOTE A shorter MRC stays at its final miss rate.
+    double const last = scale * other->miss_rate[other->num_bins - 1];
+    for (size_t i = other->num_bins; i < num_bins; ++i) {
+        me->miss_rate[i] += last;
     }
     return true;
 }
@@ -414,94 +696,127 @@ get_working_set_size(struct MissRateCurve const *const me)
     if (!is_initialized(me)) {
         return 0;
     }
-    size_t max_cache_size = 0;
-    // We start from 1 just because it simplifies the logic. I believe
-    // this is correct as it is... well, duh! Otherwise I wouldn't have
-    // written it this way!
-    for (size_t i = 1; i < me->num_bins; ++i) {
-        // NOTE Miss rate is monotonically decreasing for LRU...
-        assert(me->miss_rate[i] <= me->miss_rate[i - 1]);
+    // NOTE I search backward for the last drop in the miss rate, since
+    //      the MRC is usually flat for a long way past the working set.
+    //      Miss rate is monotonically decreasing for LRU, so this matches
+    //      a forward search (which 'MissRateCurve__validate' checks).
+    for (size_t i = me->num_bins - 1; i > 0; --i) {
         if (me->miss_rate[i] < me->miss_rate[i - 1]) {
-            max_cache_size = i;
+            return i;
         }
     }
-    assert(max_cache_size < me->num_bins);
-    return max_cache_size;
+    return 0;
 }
 
+/// @brief  Sum the errors over the two ranges that make up the MRCs'
+///         comparison. Over [0, min_wss], I compare the MRCs directly;
+///         over [min_wss, max_wss], I compare the MRC with the larger
+///         working set against the other's final miss rate.
+/// @note   Yes, I count the error at 'min_wss' twice. This matches how
+///         the MAE has always been computed, so I keep it.
 static inline double
-absolute_error(double const a, double const b)
+sum_errors_in_range(enum ArrayKernel const kernel,
+                    struct MissRateCurve const *const lhs,
+                    struct MissRateCurve const *const rhs,
+                    size_t const lhs_wss,
+                    size_t const rhs_wss,
+                    size_t const begin,
+                    size_t const end,
+                    bool const squared)
 {
-    return ABS(a - b);
+    size_t const min_wss = MIN(lhs_wss, rhs_wss);
+    size_t const max_wss = MAX(lhs_wss, rhs_wss);
+    // NOTE I use the '<' operator because that's what GLib's 'MIN'
+    //      function uses and I wanted to use the identical operator so
+    //      the compiler can best see this (it doesn't really matter).
+    struct MissRateCurve const *const min_wss_mrc =
+        lhs_wss < rhs_wss ? lhs : rhs;
+    struct MissRateCurve const *const max_wss_mrc =
+        lhs_wss < rhs_wss ? rhs : lhs;
+    assert(min_wss < min_wss_mrc->num_bins);
+    assert(max_wss < max_wss_mrc->num_bins);
+
+    double sum = 0.0;
+    size_t b = begin, e = MIN(end, min_wss + 1);
+    if (b < e) {
+        sum += squared ? ArrayKernel__sum_squared_error(kernel,
+                                                        &lhs->miss_rate[b],
+                                                        &rhs->miss_rate[b],
+                                                        e - b)
+                       : ArrayKernel__sum_absolute_error(kernel,
+                                                         &lhs->miss_rate[b],
+                                                         &rhs->miss_rate[b],
+                                                         e - b);
+    }
+    double const mr_at_min_wss_of_min_wss_mrc = min_wss_mrc->miss_rate[min_wss];
+    b = MAX(begin, min_wss);
+    e = MIN(end, max_wss + 1);
+    if (b < e) {
+        sum += squared ? ArrayKernel__sum_squared_error_broadcast(
+                             kernel,
+                             mr_at_min_wss_of_min_wss_mrc,
+                             &max_wss_mrc->miss_rate[b],
+                             e - b)
+                       : ArrayKernel__sum_absolute_error_broadcast(
+                             kernel,
+                             mr_at_min_wss_of_min_wss_mrc,
+                             &max_wss_mrc->miss_rate[b],
+                             e - b);
+    }
+    return sum;
 }
 
-static inline double
-squared_error(double const a, double const b)
+/// @brief  Check that two MRCs are comparable.
+static bool
+are_comparable(struct MissRateCurve const *const lhs,
+               struct MissRateCurve const *const rhs)
 {
-    return (a - b) * (a - b);
+    if (!is_initialized(lhs) || !is_initialized(rhs)) {
+        return false;
+    }
+    if (lhs->bin_size == 0 || rhs->bin_size == 0 ||
+        lhs->bin_size != rhs->bin_size) {
+        LOGGER_ERROR("cannot compare MRCs with different (or zero) bin sizes "
+                     "(%zu vs %zu)",
+                     lhs->bin_size,
+                     rhs->bin_size);
+        return false;
+    }
+    return true;
 }
 
-/// @brief  Calculate the mean of some comparison function.
-/// @note   I hope the C compiler inlines the function pointer!
+/// @brief  Calculate the mean of the absolute or squared errors.
 static inline double
 compute_mean_of_comparison(struct MissRateCurve const *const lhs,
                            struct MissRateCurve const *const rhs,
-                           double (*compare)(double const, double const))
+                           bool const squared)
 {
     // NOTE This condition holds when lhs == rhs == NULL and when they
     //      are a non-NULL value as well!
     if (lhs == rhs) {
         return 0.0;
     }
-    if (!is_initialized(lhs) || !is_initialized(rhs)) {
-        return INFINITY;
-    }
-    if (lhs->bin_size == 0 || rhs->bin_size == 0 ||
-        lhs->bin_size != rhs->bin_size) {
-        LOGGER_ERROR("cannot compare MRCs with different (or zero) bin sizes "
-                     "(%zu vs %zu)",
-                     lhs->bin_size,
-                     rhs->bin_size);
+    if (!are_comparable(lhs, rhs)) {
         return INFINITY;
     }
 
     size_t const lhs_wss = get_working_set_size(lhs);
     size_t const rhs_wss = get_working_set_size(rhs);
-    // NOTE I rely on the optimizing compiler to recognize that these
-    //      if statements are logically equivalent. However, when I have
-    //      it this way, I can const-qualify everything. Yay!
-    size_t const min_wss = MIN(lhs_wss, rhs_wss);
     size_t const max_wss = MAX(lhs_wss, rhs_wss);
-    // NOTE I use the '<' operator because that's what GLib's 'MIN'
-    //      function uses and I wanted to use the identical operator so
-    //      the compiler can best see this (it doesn't really matter).
-    struct MissRateCurve const *const min_wss_mrc =
-        lhs_wss < rhs_wss ? lhs : rhs;
-    struct MissRateCurve const *const max_wss_mrc =
-        lhs_wss < rhs_wss ? rhs : lhs;
-    assert(min_wss_mrc != max_wss_mrc &&
-           "my logic is incorrect above or we passed in two of the same "
-           "MRCs and my handling of that case was deleted");
-    assert(min_wss < min_wss_mrc->num_bins);
-    assert(max_wss < max_wss_mrc->num_bins);
-
     // NOTE This may elucidate some of the boundary checking logic:
     //      0. WSS(min_wss_mrc) <= WSS(max_wss_mrc) [by definition]
     //      1. WSS(min_wss_mrc) <= |min_wss_mrc|
     //      2. WSS(max_wss_mrc) <= |max_wss_mrc|
     //      But there is no bound on the sizes of either MRCs and the
     //      size of min_wss_mrc versus WSS(max_wss_mrc).
-    double comparison_sum = 0.0;
-    // NOTE I can safely use the '<=' operator because I have checked
-    //      that the WSS is strictly less than the size of each buffer.
-    for (uint64_t i = 0; i <= min_wss; ++i) {
-        comparison_sum += compare(lhs->miss_rate[i], rhs->miss_rate[i]);
-    }
-    double const mr_at_min_wss_of_min_wss_mrc = min_wss_mrc->miss_rate[min_wss];
-    for (uint64_t i = min_wss; i <= max_wss; ++i) {
-        comparison_sum +=
-            compare(mr_at_min_wss_of_min_wss_mrc, max_wss_mrc->miss_rate[i]);
-    }
+    double const comparison_sum = sum_errors_in_range(ArrayKernel__best(),
+                                                      lhs,
+                                                      rhs,
+                                                      lhs_wss,
+                                                      rhs_wss,
+                                                      0,
+                                                      max_wss + 1,
+                                                      squared);
     return comparison_sum / (double)(max_wss == 0 ? 1 : max_wss);
 }
 
@@ -509,14 +824,92 @@ double
 MissRateCurve__mean_absolute_error(struct MissRateCurve const *const lhs,
                                    struct MissRateCurve const *const rhs)
 {
-    return compute_mean_of_comparison(lhs, rhs, absolute_error);
+    return compute_mean_of_comparison(lhs, rhs, false);
 }
 
 double
 MissRateCurve__mean_squared_error(struct MissRateCurve const *const lhs,
                                   struct MissRateCurve const *const rhs)
 {
-    return compute_mean_of_comparison(lhs, rhs, squared_error);
+    return compute_mean_of_comparison(lhs, rhs, true);
+}
+
+/// @brief  I compare each block of the oracle against every MRC while it
+///         is still in the L1 cache. This is 16 KiB of doubles.
+#define BATCH_BLOCK_SIZE 2048
+
+static bool
+batch_compare(struct MissRateCurve const *const oracle,
+              struct MissRateCurve const *const *const mrcs,
+              size_t const num_mrcs,
+              double *const errors,
+              bool const squared)
+{
+    if (!is_initialized(oracle) || mrcs == NULL || errors == NULL) {
+        return false;
+    }
+    size_t *const wss = malloc(num_mrcs * sizeof(*wss));
+    if (wss == NULL) {
+        LOGGER_ERROR("failed to allocate working set sizes");
+        return false;
+    }
+    size_t const oracle_wss = get_working_set_size(oracle);
+    size_t end = 0;
+    for (size_t k = 0; k < num_mrcs; ++k) {
+        errors[k] = 0.0;
+        wss[k] = 0;
+        if (mrcs[k] == oracle) {
+            continue;
+        }
+        if (!are_comparable(oracle, mrcs[k])) {
+            errors[k] = INFINITY;
+            continue;
+        }
+        wss[k] = get_working_set_size(mrcs[k]);
+        end = MAX(end, MAX(oracle_wss, wss[k]) + 1);
+    }
+    enum ArrayKernel const kernel = ArrayKernel__best();
+    for (size_t begin = 0; begin < end; begin += BATCH_BLOCK_SIZE) {
+        for (size_t k = 0; k < num_mrcs; ++k) {
+            if (mrcs[k] == oracle || isinf(errors[k])) {
+                continue;
+            }
+            errors[k] += sum_errors_in_range(kernel,
+                                             oracle,
+                                             mrcs[k],
+                                             oracle_wss,
+                                             wss[k],
+                                             begin,
+                                             begin + BATCH_BLOCK_SIZE,
+                                             squared);
+        }
+    }
+    for (size_t k = 0; k < num_mrcs; ++k) {
+        size_t const max_wss = MAX(oracle_wss, wss[k]);
+        errors[k] /= (double)(max_wss == 0 ? 1 : max_wss);
+    }
+    free(wss);
+    return true;
+}
+
+bool
+MissRateCurve__batch_mean_absolute_error(
+    struct MissRateCurve const *const oracle,
+    struct MissRateCurve const *const *const mrcs,
+    size_t const num_mrcs,
+    double *const errors)
+{
+    return batch_compare(oracle, mrcs, num_mrcs, errors, false);
+}
+
+bool
+MissRateCurve__batch_mean_squared_error(
+    struct MissRateCurve const *const oracle,
+    struct MissRateCurve const *const *const mrcs,
+    size_t const num_mrcs,
+    double *const errors)
+{
+    return batch_compare(oracle, mrcs, num_mrcs, errors, true);
 }
 
 bool
@@ -0,0 +1,90 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "histogram/histogram.h"
+#include "logger/logger.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "miss_rate_curve/miss_rate_curve_snapshots.h"
+
+#define INDEX_MASK 3U
+#define FRESH      4U
+
+bool
+MissRateCurveSnapshots__init(struct MissRateCurveSnapshots *const me)
+{
+    if (me == NULL) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    // NOTE The buffers start empty; 'MissRateCurve__refresh_coarse_...'
+    //      allocates them on the first publish that uses each one.
+    *me = (struct MissRateCurveSnapshots){
+        .buffers = {{0}},
+        .versions = {0},
+        .back = 0,
+        .num_published = 0,
+        .front = 1,
+        .middle = 2,
+    };
+    return true;
+}
+
+bool
+MissRateCurveSnapshots__publish(struct MissRateCurveSnapshots *const me,
+                                struct Histogram const *const histogram)
+{
+    if (me == NULL) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    if (!MissRateCurve__refresh_coarse_from_histogram(&me->buffers[me->back],
+                                                      histogram)) {
+        LOGGER_ERROR("failed to build MRC");
+        return false;
+    }
+    me->versions[me->back] = ++me->num_published;
+    // NOTE The release publishes the MRC to the reader; the acquire makes
+    //      sure that the reader is done with the buffer that we get back.
+    unsigned const old = __atomic_exchange_n(&me->middle,
+                                             me->back | FRESH,
+                                             __ATOMIC_ACQ_REL);
+    me->back = old & INDEX_MASK;
+    return true;
+}
+
+struct MissRateCurve const *
+MissRateCurveSnapshots__consume(struct MissRateCurveSnapshots *const me,
+                                uint64_t *const version)
+{
+    if (me == NULL) {
+        LOGGER_ERROR("bad input");
+        return NULL;
+    }
+    // NOTE The relaxed load is only a hint to skip the exchange; the
+    //      exchange itself synchronizes with the writer.
+    if (__atomic_load_n(&me->middle, __ATOMIC_RELAXED) & FRESH) {
+        unsigned const old =
+            __atomic_exchange_n(&me->middle, me->front, __ATOMIC_ACQ_REL);
+        me->front = old & INDEX_MASK;
+    }
+    if (version != NULL) {
+        *version = me->versions[me->front];
+    }
+    if (me->versions[me->front] == 0) {
+        return NULL;
+    }
+    return &me->buffers[me->front];
+}
+
+void
+MissRateCurveSnapshots__destroy(struct MissRateCurveSnapshots *const me)
+{
+    if (me == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        MissRateCurve__destroy(&me->buffers[i]);
+    }
+    *me = (struct MissRateCurveSnapshots){0};
+}
@@ -0,0 +1,261 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "histogram/histogram.h"
+#include "logger/logger.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "miss_rate_curve/parallel_merge.h"
+
+enum MergeKind {
+    MERGE_KIND_HISTOGRAM,
+    MERGE_KIND_MISS_RATE_CURVE,
+};
+
+union MergeItem {
+    struct Histogram histogram;
+    struct MissRateCurve miss_rate_curve;
+};
+
+struct Merge {
+    enum MergeKind kind;
+    union {
+        ParallelMergeHistogramLoader histogram;
+        ParallelMergeMissRateCurveLoader miss_rate_curve;
+    } load;
+    void *data;
+    /// One partial result per worker
+    union MergeItem *partials;
+};
+
+/// @brief  Either fold the inputs [begin, end) into partial 'dst' or, if
+///         'end' is zero, merge partial 'begin' into partial 'dst'.
+struct MergeTask {
+    struct Merge const *merge;
+    size_t dst;
+    size_t begin;
+    size_t end;
+    bool started;
+    bool ok;
+};
+
+static bool
+load_item(struct Merge const *const me, size_t const i, union MergeItem *dst)
+{
+    switch (me->kind) {
+    case MERGE_KIND_HISTOGRAM:
+        return me->load.histogram(me->data, i, &dst->histogram);
+    case MERGE_KIND_MISS_RATE_CURVE:
+        return me->load.miss_rate_curve(me->data, i, &dst->miss_rate_curve);
+    default:
+        assert(0 && "impossible");
+        return false;
+    }
+}
+
+static bool
+iadd_item(struct Merge const *const me,
+          union MergeItem *const dst,
+          union MergeItem const *const src)
+{
+    switch (me->kind) {
+    case MERGE_KIND_HISTOGRAM:
+        return Histogram__iadd(&dst->histogram, &src->histogram);
+    case MERGE_KIND_MISS_RATE_CURVE:
+        return MissRateCurve__scaled_iadd(&dst->miss_rate_curve,
+                                          &src->miss_rate_curve,
+                                          1.0);
+    default:
+        assert(0 && "impossible");
+        return false;
+    }
+}
+
+static void
+destroy_item(struct Merge const *const me, union MergeItem *const item)
+{
+    switch (me->kind) {
+    case MERGE_KIND_HISTOGRAM:
+        Histogram__destroy(&item->histogram);
+        break;
+    case MERGE_KIND_MISS_RATE_CURVE:
+        MissRateCurve__destroy(&item->miss_rate_curve);
+        break;
+    default:
+        assert(0 && "impossible");
+    }
+}
+
+static void *
+merge_task(void *arg)
+{
+    struct MergeTask *const task = arg;
+    struct Merge const *const me = task->merge;
+    union MergeItem *const dst = &me->partials[task->dst];
+
+    if (task->end == 0) {
+        union MergeItem *const src = &me->partials[task->begin];
+        task->ok = iadd_item(me, dst, src);
+        destroy_item(me, src);
+        return NULL;
+    }
+
+    // NOTE I stream the inputs so that only the partial result and one
+    //      input are resident.
+    task->ok = load_item(me, task->begin, dst);
+    for (size_t i = task->begin + 1; task->ok && i < task->end; ++i) {
+        union MergeItem input = {0};
+        task->ok = load_item(me, i, &input) && iadd_item(me, dst, &input);
+        destroy_item(me, &input);
+    }
+    if (!task->ok) {
+        LOGGER_ERROR("failed to merge inputs [%zu, %zu)",
+                     task->begin,
+                     task->end);
+    }
+    return NULL;
+}
+
+/// @brief  Run each task on its own thread and wait for them all.
+/// @note   I run the first task on the calling thread. If I cannot start a
+///         thread, then I run its task on the calling thread too.
+static bool
+run_tasks(pthread_t *const threads,
+          struct MergeTask *const tasks,
+          size_t const num_tasks)
+{
+    for (size_t i = 1; i < num_tasks; ++i) {
+        tasks[i].started =
+            pthread_create(&threads[i], NULL, merge_task, &tasks[i]) == 0;
+        if (!tasks[i].started) {
+            LOGGER_WARN("failed to create thread, so merging serially");
+            merge_task(&tasks[i]);
+        }
+    }
+    merge_task(&tasks[0]);
+
+    bool ok = true;
+    for (size_t i = 0; i < num_tasks; ++i) {
+        if (tasks[i].started) {
+            pthread_join(threads[i], NULL);
+        }
+        ok = ok && tasks[i].ok;
+    }
+    return ok;
+}
+
+static bool
+merge_all(struct Merge *const me,
+          union MergeItem *const result,
+          size_t const num_inputs,
+          size_t const num_threads)
+{
+    bool ok = false;
+    if (num_inputs == 0) {
+        LOGGER_ERROR("expected non-zero number of inputs");
+        return false;
+    }
+    size_t const num_workers = MIN(MAX(num_threads, 1), num_inputs);
+    pthread_t *const threads = calloc(num_workers, sizeof(*threads));
+    struct MergeTask *const tasks = calloc(num_workers, sizeof(*tasks));
+    me->partials = calloc(num_workers, sizeof(*me->partials));
+    if (threads == NULL || tasks == NULL || me->partials == NULL) {
+        LOGGER_ERROR("failed to allocate %zu workers", num_workers);
+        goto cleanup;
+    }
+
+    // Each worker folds a contiguous slice of the inputs...
+    for (size_t w = 0; w < num_workers; ++w) {
+        tasks[w] = (struct MergeTask){
+            .merge = me,
+            .dst = w,
+            .begin = w * num_inputs / num_workers,
+            .end = (w + 1) * num_inputs / num_workers,
+        };
+    }
+    if (!run_tasks(threads, tasks, num_workers)) {
+        goto cleanup;
+    }
+    // ... and then we merge the partial results pairwise, halving the
+    // number of them each round.
+    for (size_t stride = 1; stride < num_workers; stride *= 2) {
+        size_t num_tasks = 0;
+        for (size_t w = 0; w + stride < num_workers; w += 2 * stride) {
+            tasks[num_tasks++] = (struct MergeTask){
+                .merge = me,
+                .dst = w,
+                .begin = w + stride,
+                .end = 0,
+            };
+        }
+        if (!run_tasks(threads, tasks, num_tasks)) {
+            goto cleanup;
+        }
+    }
+    *result = me->partials[0];
+    me->partials[0] = (union MergeItem){0};
+    ok = true;
+cleanup:
+    if (me->partials != NULL) {
+        for (size_t w = 0; w < num_workers; ++w) {
+            destroy_item(me, &me->partials[w]);
+        }
+    }
+    free(me->partials);
+    me->partials = NULL;
+    free(tasks);
+    free(threads);
+    return ok;
+}
+
+bool
+ParallelMerge__histograms(struct Histogram *const me,
+                          size_t const num_inputs,
+                          ParallelMergeHistogramLoader const load,
+                          void *const data,
+                          size_t const num_threads)
+{
+    if (me == NULL || load == NULL) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    struct Merge merge = {
+        .kind = MERGE_KIND_HISTOGRAM,
+        .load.histogram = load,
+        .data = data,
+    };
+    union MergeItem result = {0};
+    if (!merge_all(&merge, &result, num_inputs, num_threads)) {
+        return false;
+    }
+    *me = result.histogram;
+    return true;
+}
+
+bool
+ParallelMerge__miss_rate_curves(struct MissRateCurve *const me,
+                                size_t const num_inputs,
+                                ParallelMergeMissRateCurveLoader const load,
+                                void *const data,
+                                size_t const num_threads)
+{
+    if (me == NULL || load == NULL) {
+        LOGGER_ERROR("bad input");
+        return false;
+    }
+    struct Merge merge = {
+        .kind = MERGE_KIND_MISS_RATE_CURVE,
+        .load.miss_rate_curve = load,
+        .data = data,
+    };
+    union MergeItem result = {0};
+    if (!merge_all(&merge, &result, num_inputs, num_threads)) {
+        return false;
+    }
+    *me = result.miss_rate_curve;
+    return true;
+}
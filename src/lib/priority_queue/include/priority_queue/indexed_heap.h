@@ -0,0 +1,119 @@
+/** @brief  An indexed 4-ary {min,max}-heap, which supports changing the
+ *          priority of, or removing, any value in O(log n) time.
+ *
+ *  The plain 'Heap' can only remove its top, so a value whose priority
+ *  changes (e.g. an object whose TTL is refreshed) must stay in the heap
+ *  until it reaches the top. Here, I keep a map from each value to its
+ *  position in the heap, which lets me find any value in O(1) and then
+ *  sift it up or down.
+ *
+ *  Compared to the binary 'Heap':
+ *  1. Each node has 4 children, so the heap is half as tall. A sift down
+ *     compares more children per level, but the 4 children's keys are
+ *     adjacent and usually share a cache line.
+ *  2. I store the keys and values in separate arrays, so comparisons
+ *     only ever touch the keys.
+ *  3. I sift a 'hole' rather than swapping, so each level costs one move
+ *     (and one map update) rather than a swap.
+ *
+ *  @note   Values must be unique, since they identify the elements. Keys
+ *          (i.e. priorities) may repeat.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* !__cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lookup/flat_hash_table.h"
+#include "types/key_type.h"
+#include "types/value_type.h"
+
+struct IndexedHeap {
+    // NOTE The key and value at an index belong to the same element.
+    KeyType *keys;
+    ValueType *values;
+    size_t length;
+    size_t capacity;
+    bool (*cmp)(KeyType const lhs, KeyType const rhs);
+    // Map from each value to its index in the arrays above.
+    struct FlatHashTable positions;
+};
+
+bool
+IndexedHeap__init_max_heap(struct IndexedHeap *const me, size_t const max_size);
+
+bool
+IndexedHeap__init_min_heap(struct IndexedHeap *const me, size_t const max_size);
+
+bool
+IndexedHeap__validate(struct IndexedHeap const *const me);
+
+bool
+IndexedHeap__write_as_json(FILE *stream, struct IndexedHeap const *const me);
+
+bool
+IndexedHeap__is_full(struct IndexedHeap const *const me);
+
+bool
+IndexedHeap__contains(struct IndexedHeap const *const me,
+                      ValueType const value);
+
+/// @brief  Insert key/value if there is room and the value is not already
+///         in the heap.
+bool
+IndexedHeap__insert_if_room(struct IndexedHeap *const me,
+                            KeyType const key,
+                            ValueType const value);
+
+/// @brief  Insert key/value with resize if necessary.
+/// @note   This fails if the value is already in the heap. Use
+///         'IndexedHeap__update_key' to change its key instead.
+bool
+IndexedHeap__insert(struct IndexedHeap *const me,
+                    KeyType const key,
+                    ValueType const value);
+
+/// @brief  Get the key at the 'top' of the queue (i.e. in position 0).
+/// @return Returns key at position 0; otherwise 0 if error.
+KeyType
+IndexedHeap__get_top_key(struct IndexedHeap const *const me);
+
+/// @brief  Get the key of a value in the heap.
+bool
+IndexedHeap__get_key(struct IndexedHeap const *const me,
+                     ValueType const value,
+                     KeyType *const key_return);
+
+/// @brief  Remove the top element.
+/// @param  key_return, value_return: may be NULL.
+bool
+IndexedHeap__pop(struct IndexedHeap *const me,
+                 KeyType *const key_return,
+                 ValueType *const value_return);
+
+/// @brief  Change the key of a value that is already in the heap. This
+///         handles both increasing and decreasing the key.
+bool
+IndexedHeap__update_key(struct IndexedHeap *const me,
+                        ValueType const value,
+                        KeyType const new_key);
+
+/// @brief  Remove a value from anywhere in the heap.
+/// @param  key_return: the removed value's key. This may be NULL.
+bool
+IndexedHeap__remove(struct IndexedHeap *const me,
+                    ValueType const value,
+                    KeyType *const key_return);
+
+void
+IndexedHeap__destroy(struct IndexedHeap *const me);
+
+#ifdef __cplusplus
+}
+#endif /* !__cplusplus */
@@ -0,0 +1,100 @@
+/** @brief  A fixed-size, monotone max-priority queue that buckets keys by
+ *          their highest bit that differs from the current maximum (i.e.
+ *          a radix heap).
+ *
+ *  Fixed-size SHARDS only ever evicts the maximum hash and its threshold
+ *  only ever shrinks, which is exactly the monotone access pattern that a
+ *  radix heap serves well. I keep 'last', an upper bound on every key, and
+ *  put each key into bucket 'b', where 'b - 1' is the highest bit in which
+ *  it differs from 'last' (bucket 0 holds keys equal to 'last'). Thus:
+ *
+ *  1. Inserting a key is an O(1) append to its bucket. There is no
+ *     sifting and no pointer chasing.
+ *  2. Bucket 0 holds exactly the maximum keys, so evicting the maximum is
+ *     a bulk drop of bucket 0.
+ *  3. When bucket 0 is empty, I find the first non-empty bucket, set
+ *     'last' to its largest key, and redistribute it into lower buckets.
+ *     Each key only moves to a strictly lower bucket, so it moves at most
+ *     64 times over its lifetime, but in practice, only a few times.
+ *
+ *  @note   A key that exceeds 'last' (e.g. an object that SHARDS sampled
+ *          just before its threshold dropped) forces me to rebucket all
+ *          the keys. This is rare.
+ */
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* !__cplusplus */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "types/key_type.h"
+#include "types/value_type.h"
+
+/// @brief  One bucket per bit, plus one for the keys equal to 'last'.
+#define RADIX_PRIORITY_QUEUE_NUM_BUCKETS 65
+
+struct RadixPriorityQueueItem {
+    KeyType key;
+    ValueType value;
+};
+
+struct RadixPriorityQueueBucket {
+    struct RadixPriorityQueueItem *items;
+    size_t length;
+    size_t capacity;
+};
+
+struct RadixPriorityQueue {
+    struct RadixPriorityQueueBucket buckets[RADIX_PRIORITY_QUEUE_NUM_BUCKETS];
+    // NOTE Every key is less than or equal to this. When bucket 0 is
+    //      non-empty, this is the maximum key.
+    KeyType last;
+    size_t length;
+    size_t capacity;
+};
+
+bool
+RadixPriorityQueue__init(struct RadixPriorityQueue *const me,
+                         size_t const max_size);
+
+bool
+RadixPriorityQueue__validate(struct RadixPriorityQueue const *const me);
+
+bool
+RadixPriorityQueue__is_full(struct RadixPriorityQueue const *const me);
+
+bool
+RadixPriorityQueue__insert_if_room(struct RadixPriorityQueue *const me,
+                                   KeyType const key,
+                                   ValueType const value);
+
+/// @brief  Get the maximum key.
+/// @note   This is not const because it may redistribute a bucket.
+/// @return Returns the maximum key; otherwise 0 if empty or error.
+KeyType
+RadixPriorityQueue__get_top_key(struct RadixPriorityQueue *const me);
+
+/// @brief  Remove every item whose key equals the maximum key.
+/// @param  eviction_hook: (void *, ValueType) -> void
+///         The hook to run on each removed value. This may be NULL.
+/// @return The number of items removed.
+size_t
+RadixPriorityQueue__remove_top(struct RadixPriorityQueue *const me,
+                               void (*eviction_hook)(void *data,
+                                                     ValueType value),
+                               void *eviction_data);
+
+/// @brief  Get the number of bytes that the buckets have allocated.
+size_t
+RadixPriorityQueue__get_memory_usage(struct RadixPriorityQueue const *const me);
+
+void
+RadixPriorityQueue__destroy(struct RadixPriorityQueue *const me);
+
+#ifdef __cplusplus
+}
+#endif /* !__cplusplus */
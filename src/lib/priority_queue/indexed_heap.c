@@ -0,0 +1,421 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arrays/is_last.h"
+#include "logger/logger.h"
+#include "lookup/flat_hash_table.h"
+#include "lookup/lookup.h"
+#include "priority_queue/indexed_heap.h"
+#include "types/key_type.h"
+#include "types/value_type.h"
+
+#define ARITY 4
+
+/// @brief  Returns if lhs is greater than rhs.
+static inline bool
+gt(KeyType const lhs, KeyType const rhs)
+{
+    return lhs > rhs;
+}
+
+/// @brief  Returns if lhs is less than rhs.
+static inline bool
+lt(KeyType const lhs, KeyType const rhs)
+{
+    return lhs < rhs;
+}
+
+static inline size_t
+get_first_child(size_t const i)
+{
+    return ARITY * i + 1;
+}
+
+static inline size_t
+get_parent(size_t const i)
+{
+    return (i - 1) / ARITY;
+}
+
+/// @brief  Put an element at an index and record its new position.
+/// @note   The value must already be in the position map, so this never
+///         allocates and thus never fails.
+static inline void
+place(struct IndexedHeap *const me,
+      size_t const idx,
+      KeyType const key,
+      ValueType const value)
+{
+    assert(me && idx < me->length);
+    me->keys[idx] = key;
+    me->values[idx] = value;
+    enum PutUniqueStatus s = FlatHashTable__put(&me->positions, value, idx);
+    assert(s == LOOKUP_PUTUNIQUE_REPLACE_VALUE);
+    (void)s;
+}
+
+/// @brief  Move the element at 'idx' toward the root until its parent
+///         has a higher priority.
+/// @note   Rather than swapping at each level, I move the parents down
+///         into a 'hole' and place the element once at the end.
+static void
+sift_up(struct IndexedHeap *const me, size_t idx)
+{
+    assert(me && idx < me->length);
+    KeyType const key = me->keys[idx];
+    ValueType const value = me->values[idx];
+    while (idx > 0) {
+        size_t const parent = get_parent(idx);
+        if (!me->cmp(key, me->keys[parent])) {
+            break;
+        }
+        place(me, idx, me->keys[parent], me->values[parent]);
+        idx = parent;
+    }
+    place(me, idx, key, value);
+}
+
+/// @brief  Move the element at 'idx' toward the leaves until none of its
+///         children has a higher priority.
+static void
+sift_down(struct IndexedHeap *const me, size_t idx)
+{
+    assert(me && idx < me->length);
+    KeyType const key = me->keys[idx];
+    ValueType const value = me->values[idx];
+    while (true) {
+        size_t const first = get_first_child(idx);
+        if (first >= me->length) {
+            break;
+        }
+        size_t const end =
+            first + ARITY < me->length ? first + ARITY : me->length;
+        size_t best = first;
+        for (size_t c = first + 1; c < end; ++c) {
+            if (me->cmp(me->keys[c], me->keys[best])) {
+                best = c;
+            }
+        }
+        if (!me->cmp(me->keys[best], key)) {
+            break;
+        }
+        place(me, idx, me->keys[best], me->values[best]);
+        idx = best;
+    }
+    place(me, idx, key, value);
+}
+
+/// @brief  Restore the heap property after the key at 'idx' changed.
+static inline void
+fix(struct IndexedHeap *const me, size_t const idx)
+{
+    if (idx > 0 && me->cmp(me->keys[idx], me->keys[get_parent(idx)])) {
+        sift_up(me, idx);
+    } else {
+        sift_down(me, idx);
+    }
+}
+
+/// @brief  Find a value's index in the heap.
+static inline bool
+find(struct IndexedHeap const *const me,
+     ValueType const value,
+     size_t *const idx)
+{
+    struct LookupReturn r = FlatHashTable__lookup(&me->positions, value);
+    if (!r.success) {
+        return false;
+    }
+    assert(r.timestamp < me->length && me->values[r.timestamp] == value);
+    *idx = r.timestamp;
+    return true;
+}
+
+static void
+remove_at(struct IndexedHeap *const me, size_t const idx)
+{
+    assert(me && idx < me->length);
+    struct LookupReturn r =
+        FlatHashTable__remove(&me->positions, me->values[idx]);
+    assert(r.success && r.timestamp == idx);
+    (void)r;
+    size_t const last = --me->length;
+    if (idx == last) {
+        return;
+    }
+    // NOTE The last element may belong either above or below the hole,
+    //      since it may come from a different subtree.
+    me->keys[idx] = me->keys[last];
+    me->values[idx] = me->values[last];
+    fix(me, idx);
+}
+
+static bool
+initialize(struct IndexedHeap *const me,
+           size_t const max_size,
+           bool (*cmp)(KeyType const lhs, KeyType const rhs))
+{
+    if (me == NULL) {
+        return false;
+    }
+    *me = (struct IndexedHeap){.keys = calloc(max_size, sizeof(*me->keys)),
+                               .values =
+                                   calloc(max_size, sizeof(*me->values)),
+                               .length = 0,
+                               .capacity = max_size,
+                               .cmp = cmp};
+    if (max_size != 0 && (me->keys == NULL || me->values == NULL)) {
+        LOGGER_ERROR("calloc failed");
+        goto cleanup;
+    }
+    if (!FlatHashTable__init_with_capacity(&me->positions, max_size)) {
+        LOGGER_ERROR("failed to initialize position map");
+        goto cleanup;
+    }
+    return true;
+cleanup:
+    IndexedHeap__destroy(me);
+    return false;
+}
+
+bool
+IndexedHeap__init_max_heap(struct IndexedHeap *const me, size_t const max_size)
+{
+    return initialize(me, max_size, gt);
+}
+
+bool
+IndexedHeap__init_min_heap(struct IndexedHeap *const me, size_t const max_size)
+{
+    return initialize(me, max_size, lt);
+}
+
+bool
+IndexedHeap__validate(struct IndexedHeap const *const me)
+{
+    // Being NULL is consistent even if I can't do anything with it.
+    if (me == NULL) {
+        LOGGER_WARN("got NULL in consistency validation");
+        return true;
+    }
+    if (me->length > me->capacity) {
+        LOGGER_ERROR("length (%zu) must be less than capacity (%zu)",
+                     me->length,
+                     me->capacity);
+        return false;
+    }
+    if (FlatHashTable__get_size(&me->positions) != me->length) {
+        LOGGER_ERROR("position map size (%zu) must equal length (%zu)",
+                     FlatHashTable__get_size(&me->positions),
+                     me->length);
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < me->length; ++i) {
+        size_t idx = 0;
+        if (!find(me, me->values[i], &idx) || idx != i) {
+            LOGGER_ERROR("value %" PRIu64 " at position %zu is not indexed",
+                         me->values[i],
+                         i);
+            ok = false;
+        }
+        if (i > 0 && me->cmp(me->keys[i], me->keys[get_parent(i)])) {
+            LOGGER_ERROR("at position %zu, my priority (%" PRIu64
+                         ") must not exceed my parent's (%" PRIu64 ")",
+                         i,
+                         me->keys[i],
+                         me->keys[get_parent(i)]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+bool
+IndexedHeap__write_as_json(FILE *stream, struct IndexedHeap const *const me)
+{
+    if (stream == NULL) {
+        LOGGER_ERROR("invalid stream");
+        return false;
+    }
+    if (me == NULL) {
+        fprintf(stream, "{\"type\": null}\n");
+        return false;
+    }
+    fprintf(stream,
+            "{\"type\": \"IndexedHeap\", \".length\": %zu, \".capacity\": "
+            "%zu, \".data\": [",
+            me->length,
+            me->capacity);
+    for (size_t i = 0; i < me->length; ++i) {
+        fprintf(stream,
+                "{\".key\": %" PRIu64 ", \".value\": %" PRIu64 "}",
+                me->keys[i],
+                me->values[i]);
+        if (!is_last(i, me->length)) {
+            fprintf(stream, ", ");
+        }
+    }
+    fprintf(stream, "]}\n");
+    return true;
+}
+
+bool
+IndexedHeap__is_full(struct IndexedHeap const *const me)
+{
+    if (me == NULL) {
+        // NOTE I match the plain Heap, where NULL is implicitly full.
+        return true;
+    }
+    assert(me->length <= me->capacity);
+    return me->length == me->capacity;
+}
+
+bool
+IndexedHeap__contains(struct IndexedHeap const *const me,
+                      ValueType const value)
+{
+    size_t idx = 0;
+    return me != NULL && find(me, value, &idx);
+}
+
+bool
+IndexedHeap__insert_if_room(struct IndexedHeap *const me,
+                            KeyType const key,
+                            ValueType const value)
+{
+    if (me == NULL || IndexedHeap__is_full(me)) {
+        return false;
+    }
+    if (IndexedHeap__contains(me, value)) {
+        LOGGER_WARN("value %" PRIu64 " is already in the heap", value);
+        return false;
+    }
+    if (FlatHashTable__put(&me->positions, value, me->length) !=
+        LOOKUP_PUTUNIQUE_INSERT_KEY_VALUE) {
+        LOGGER_ERROR("failed to index value %" PRIu64, value);
+        return false;
+    }
+    size_t const target = me->length;
+    ++me->length;
+    me->keys[target] = key;
+    me->values[target] = value;
+    sift_up(me, target);
+    return true;
+}
+
+bool
+IndexedHeap__insert(struct IndexedHeap *const me,
+                    KeyType const key,
+                    ValueType const value)
+{
+    if (me == NULL) {
+        return false;
+    }
+    if (IndexedHeap__is_full(me)) {
+        size_t const new_capacity = me->capacity ? 2 * me->capacity : 1;
+        KeyType *const keys =
+            realloc(me->keys, new_capacity * sizeof(*me->keys));
+        if (keys == NULL) {
+            LOGGER_ERROR("failed to reallocate");
+            return false;
+        }
+        me->keys = keys;
+        ValueType *const values =
+            realloc(me->values, new_capacity * sizeof(*me->values));
+        if (values == NULL) {
+            LOGGER_ERROR("failed to reallocate");
+            return false;
+        }
+        me->values = values;
+        me->capacity = new_capacity;
+    }
+    return IndexedHeap__insert_if_room(me, key, value);
+}
+
+KeyType
+IndexedHeap__get_top_key(struct IndexedHeap const *const me)
+{
+    if (me == NULL || me->length == 0) {
+        return 0;
+    }
+    return me->keys[0];
+}
+
+bool
+IndexedHeap__get_key(struct IndexedHeap const *const me,
+                     ValueType const value,
+                     KeyType *const key_return)
+{
+    size_t idx = 0;
+    if (me == NULL || key_return == NULL || !find(me, value, &idx)) {
+        return false;
+    }
+    *key_return = me->keys[idx];
+    return true;
+}
+
+bool
+IndexedHeap__pop(struct IndexedHeap *const me,
+                 KeyType *const key_return,
+                 ValueType *const value_return)
+{
+    if (me == NULL || me->length == 0) {
+        return false;
+    }
+    if (key_return != NULL) {
+        *key_return = me->keys[0];
+    }
+    if (value_return != NULL) {
+        *value_return = me->values[0];
+    }
+    remove_at(me, 0);
+    return true;
+}
+
+bool
+IndexedHeap__update_key(struct IndexedHeap *const me,
+                        ValueType const value,
+                        KeyType const new_key)
+{
+    size_t idx = 0;
+    if (me == NULL || !find(me, value, &idx)) {
+        return false;
+    }
+    me->keys[idx] = new_key;
+    fix(me, idx);
+    return true;
+}
+
+bool
+IndexedHeap__remove(struct IndexedHeap *const me,
+                    ValueType const value,
+                    KeyType *const key_return)
+{
+    size_t idx = 0;
+    if (me == NULL || !find(me, value, &idx)) {
+        return false;
+    }
+    if (key_return != NULL) {
+        *key_return = me->keys[idx];
+    }
+    remove_at(me, idx);
+    return true;
+}
+
+void
+IndexedHeap__destroy(struct IndexedHeap *const me)
+{
+    if (me == NULL) {
+        return;
+    }
+    free(me->keys);
+    free(me->values);
+    FlatHashTable__destroy(&me->positions);
+    *me = (struct IndexedHeap){0};
+}
@@ -0,0 +1,239 @@
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "logger/logger.h"
+#include "priority_queue/radix_priority_queue.h"
+#include "types/key_type.h"
+#include "types/value_type.h"
+
+#define NUM_BUCKETS         RADIX_PRIORITY_QUEUE_NUM_BUCKETS
+#define MIN_BUCKET_CAPACITY 16
+
+/// @brief  Get the bucket of a key relative to 'last'.
+static inline size_t
+get_bucket_index(KeyType const last, KeyType const key)
+{
+    assert(key <= last);
+    return key == last ? 0 : 64 - __builtin_clzll(last ^ key);
+}
+
+static bool
+push(struct RadixPriorityQueueBucket *const bucket,
+     struct RadixPriorityQueueItem const item)
+{
+    if (bucket->length == bucket->capacity) {
+        size_t const new_capacity = bucket->capacity
+                                        ? 2 * bucket->capacity
+                                        : MIN_BUCKET_CAPACITY;
+        struct RadixPriorityQueueItem *const items =
+            realloc(bucket->items, new_capacity * sizeof(*items));
+        if (items == NULL) {
+            LOGGER_ERROR("failed to reallocate bucket");
+            return false;
+        }
+        bucket->items = items;
+        bucket->capacity = new_capacity;
+    }
+    bucket->items[bucket->length++] = item;
+    return true;
+}
+
+/// @brief  Move every item to its bucket relative to a larger 'last'.
+/// @note   An item may move to a higher bucket, in which case I visit it
+///         again when I reach that bucket, where it stays.
+static bool
+rebucket(struct RadixPriorityQueue *const me, KeyType const new_last)
+{
+    assert(me && new_last >= me->last);
+    me->last = new_last;
+    for (size_t b = 0; b < NUM_BUCKETS; ++b) {
+        struct RadixPriorityQueueBucket *const bucket = &me->buckets[b];
+        for (size_t i = 0; i < bucket->length;) {
+            size_t const t = get_bucket_index(new_last, bucket->items[i].key);
+            if (t == b) {
+                ++i;
+                continue;
+            }
+            if (!push(&me->buckets[t], bucket->items[i])) {
+                return false;
+            }
+            bucket->items[i] = bucket->items[--bucket->length];
+        }
+    }
+    return true;
+}
+
+/// @brief  Ensure that bucket 0 holds the maximum keys, if there are any.
+static bool
+refill_top_bucket(struct RadixPriorityQueue *const me)
+{
+    assert(me);
+    if (me->buckets[0].length != 0 || me->length == 0) {
+        return true;
+    }
+    size_t b = 1;
+    while (me->buckets[b].length == 0) {
+        ++b;
+        assert(b < NUM_BUCKETS);
+    }
+    struct RadixPriorityQueueBucket *const bucket = &me->buckets[b];
+    KeyType new_last = 0;
+    for (size_t i = 0; i < bucket->length; ++i) {
+        if (bucket->items[i].key > new_last) {
+            new_last = bucket->items[i].key;
+        }
+    }
+    // NOTE Relative to the new 'last', every item in this bucket goes to
+    //      a lower bucket, since they all share bits 'b - 1' and above.
+    me->last = new_last;
+    for (size_t i = 0; i < bucket->length; ++i) {
+        size_t const t = get_bucket_index(new_last, bucket->items[i].key);
+        assert(t < b);
+        if (!push(&me->buckets[t], bucket->items[i])) {
+            return false;
+        }
+    }
+    // NOTE I free the emptied bucket because, as 'last' shrinks, each
+    //      bucket in turn holds most of the keys and would otherwise
+    //      keep its peak allocation forever.
+    free(bucket->items);
+    *bucket = (struct RadixPriorityQueueBucket){0};
+    return true;
+}
+
+bool
+RadixPriorityQueue__init(struct RadixPriorityQueue *const me,
+                         size_t const max_size)
+{
+    if (me == NULL || max_size == 0) {
+        return false;
+    }
+    *me = (struct RadixPriorityQueue){.last = UINT64_MAX,
+                                      .length = 0,
+                                      .capacity = max_size};
+    return true;
+}
+
+bool
+RadixPriorityQueue__validate(struct RadixPriorityQueue const *const me)
+{
+    // Being NULL is consistent even if I can't do anything with it.
+    if (me == NULL) {
+        LOGGER_WARN("got NULL in consistency validation");
+        return true;
+    }
+    size_t length = 0;
+    for (size_t b = 0; b < NUM_BUCKETS; ++b) {
+        struct RadixPriorityQueueBucket const *const bucket = &me->buckets[b];
+        for (size_t i = 0; i < bucket->length; ++i) {
+            KeyType const key = bucket->items[i].key;
+            if (key > me->last || get_bucket_index(me->last, key) != b) {
+                LOGGER_ERROR("key %" PRIu64 " does not belong in bucket %zu "
+                             "(last: %" PRIu64 ")",
+                             key,
+                             b,
+                             me->last);
+                return false;
+            }
+        }
+        length += bucket->length;
+    }
+    if (length != me->length || me->length > me->capacity) {
+        LOGGER_ERROR("length (%zu) must equal the buckets' lengths (%zu) "
+                     "and not exceed the capacity (%zu)",
+                     me->length,
+                     length,
+                     me->capacity);
+        return false;
+    }
+    return true;
+}
+
+bool
+RadixPriorityQueue__is_full(struct RadixPriorityQueue const *const me)
+{
+    if (me == NULL) {
+        // NOTE I match the plain Heap, where NULL is implicitly full.
+        return true;
+    }
+    assert(me->length <= me->capacity);
+    return me->length == me->capacity;
+}
+
+bool
+RadixPriorityQueue__insert_if_room(struct RadixPriorityQueue *const me,
+                                   KeyType const key,
+                                   ValueType const value)
+{
+    if (me == NULL || RadixPriorityQueue__is_full(me)) {
+        return false;
+    }
+    if (key > me->last && !rebucket(me, key)) {
+        return false;
+    }
+    struct RadixPriorityQueueItem const item = {.key = key, .value = value};
+    if (!push(&me->buckets[get_bucket_index(me->last, key)], item)) {
+        return false;
+    }
+    ++me->length;
+    return true;
+}
+
+KeyType
+RadixPriorityQueue__get_top_key(struct RadixPriorityQueue *const me)
+{
+    if (me == NULL || me->length == 0 || !refill_top_bucket(me)) {
+        return 0;
+    }
+    return me->last;
+}
+
+size_t
+RadixPriorityQueue__remove_top(struct RadixPriorityQueue *const me,
+                               void (*eviction_hook)(void *data,
+                                                     ValueType value),
+                               void *eviction_data)
+{
+    if (me == NULL || me->length == 0 || !refill_top_bucket(me)) {
+        return 0;
+    }
+    struct RadixPriorityQueueBucket *const top = &me->buckets[0];
+    size_t const num_removed = top->length;
+    if (eviction_hook != NULL) {
+        for (size_t i = 0; i < top->length; ++i) {
+            eviction_hook(eviction_data, top->items[i].value);
+        }
+    }
+    top->length = 0;
+    me->length -= num_removed;
+    return num_removed;
+}
+
+size_t
+RadixPriorityQueue__get_memory_usage(struct RadixPriorityQueue const *const me)
+{
+    if (me == NULL) {
+        return 0;
+    }
+    size_t bytes = sizeof(*me);
+    for (size_t b = 0; b < NUM_BUCKETS; ++b) {
+        bytes += me->buckets[b].capacity * sizeof(*me->buckets[b].items);
+    }
+    return bytes;
+}
+
+void
+RadixPriorityQueue__destroy(struct RadixPriorityQueue *const me)
+{
+    if (me == NULL) {
+        return;
+    }
+    for (size_t b = 0; b < NUM_BUCKETS; ++b) {
+        free(me->buckets[b].items);
+    }
+    *me = (struct RadixPriorityQueue){0};
+}
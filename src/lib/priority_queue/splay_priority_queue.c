@@ -16,9 +16,12 @@ struct SubtreeMultimap {
     struct SubtreeMultimap *right_subtree;
 };
 
-#define compare(i, j) ((int64_t)(i) - (int64_t)(j))
+#define compare(i, j) (((i) > (j)) - ((i) < (j)))
 /* This is the comparison.                                       */
 /* Returns <0 if i<j, =0 if i=j, and >0 if i>j                   */
+// NOTE I used to subtract the keys as signed integers, which overflows
+//      (and so misorders the keys) when they differ by 2^63 or more. This
+//      happens all the time with 64-bit hashes.
 
 #define node_size(x) (((x) == NULL) ? 0 : ((x)->cardinality))
 /* This macro returns the size of a node.  Unlike "x->cardinality",     */
@@ -12,6 +12,7 @@
 #include "histogram/histogram.h"
 #include "logger/logger.h"
 #include "miss_rate_curve/miss_rate_curve.h"
+#include "miss_rate_curve/parallel_merge.h"
 #include "sampler/phase_sampler.h"
 #include "unused/mark_unused.h"
 
@@ -92,6 +93,24 @@ PhaseSampler__change_histogram(struct PhaseSampler *const me,
     return true;
 }
 
+/// @brief  Load the i-th saved histogram as an MRC.
+static bool
+load_saved_mrc(void *const data,
+               size_t const i,
+               struct MissRateCurve *const dst)
+{
+    GPtrArray const *const saved_histograms = data;
+    char const *const hist_path = saved_histograms->pdata[i];
+    struct Histogram hist = {0};
+    if (!Histogram__load(&hist, hist_path)) {
+        LOGGER_ERROR("failed to load '%s'", hist_path);
+        return false;
+    }
+    bool const r = MissRateCurve__init_from_histogram(dst, &hist);
+    Histogram__destroy(&hist);
+    return r;
+}
+
 bool
 PhaseSampler__create_mrc(struct PhaseSampler const *const me,
                          struct MissRateCurve *const mrc,
@@ -112,19 +131,22 @@ PhaseSampler__create_mrc(struct PhaseSampler const *const me,
         LOGGER_ERROR("failed to allocate MRC");
         return false;
     }
-    for (size_t i = 0; i < me->saved_histograms->len; ++i) {
-        char *hist_path = me->saved_histograms->pdata[i];
-        struct Histogram hist = {0};
-        r = Histogram__load(&hist, hist_path);
-        assert(r);
-        struct MissRateCurve my_mrc = {0};
-        r = MissRateCurve__init_from_histogram(&my_mrc, &hist);
-        assert(r);
-        r = MissRateCurve__scaled_iadd(mrc,
-                                       &my_mrc,
-                                       (double)1 / me->saved_histograms->len);
-        assert(r);
-        Histogram__destroy(&hist);
+    // NOTE The merge loads each histogram only when it needs it, so we
+    //      never hold all of them in memory.
+    struct MissRateCurve sum = {0};
+    r = ParallelMerge__miss_rate_curves(&sum,
+                                        me->saved_histograms->len,
+                                        load_saved_mrc,
+                                        me->saved_histograms,
+                                        g_get_num_processors());
+    if (!r) {
+        LOGGER_ERROR("failed to merge MRCs");
+        MissRateCurve__destroy(mrc);
+        return false;
     }
-    return true;
+    r = MissRateCurve__scaled_iadd(mrc,
+                                   &sum,
+                                   (double)1 / me->saved_histograms->len);
+    MissRateCurve__destroy(&sum);
+    return r;
 }
@@ -3,6 +3,8 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include <glib.h>
+
 #include "arrays/reverse_index.h"
 #include "average_eviction_time/average_eviction_time.h"
 #include "histogram/histogram.h"
@@ -12,6 +14,7 @@
 #include "lookup/hash_table.h"
 #include "lookup/lookup.h"
 #include "miss_rate_curve/miss_rate_curve.h"
+#include "miss_rate_curve/parallel_merge.h"
 #include "sampler/phase_sampler.h"
 
 bool
@@ -234,6 +237,24 @@ convert_hist_to_mrc(struct Histogram const *const hist,
     return true;
 }
 
+/// @brief  Load the i-th saved histogram as an MRC.
+static bool
+load_saved_mrc(void *const data,
+               size_t const i,
+               struct MissRateCurve *const dst)
+{
+    GPtrArray const *const saved_histograms = data;
+    char const *const hist_path = saved_histograms->pdata[i];
+    struct Histogram hist = {0};
+    if (!Histogram__load(&hist, hist_path)) {
+        LOGGER_ERROR("failed to load '%s'", hist_path);
+        return false;
+    }
+    bool const r = convert_hist_to_mrc(&hist, dst);
+    Histogram__destroy(&hist);
+    return r;
+}
+
 bool
 AverageEvictionTime__to_mrc(struct AverageEvictionTime const *const me,
                             struct MissRateCurve *const mrc)
@@ -257,19 +278,18 @@ AverageEvictionTime__to_mrc(struct AverageEvictionTime const *const me,
         LOGGER_ERROR("failed to allocate MRC");
         return false;
     }
-    for (size_t i = 0; i < me->phase_sampler.saved_histograms->len; ++i) {
-        char *hist_path = me->phase_sampler.saved_histograms->pdata[i];
-        struct Histogram hist = {0};
-        r = Histogram__load(&hist, hist_path);
-        assert(r);
-        struct MissRateCurve my_mrc = {0};
-        r = convert_hist_to_mrc(&hist, &my_mrc);
-        assert(r);
-        r = MissRateCurve__scaled_iadd(mrc, &my_mrc, scale);
-        assert(r);
-        Histogram__destroy(&hist);
-        MissRateCurve__destroy(&my_mrc);
-    }
+    // NOTE The merge loads each saved histogram only when it needs it, so
+    //      we never hold all of them in memory.
+    struct MissRateCurve saved_sum = {0};
+    r = ParallelMerge__miss_rate_curves(&saved_sum,
+                                        me->phase_sampler.saved_histograms->len,
+                                        load_saved_mrc,
+                                        me->phase_sampler.saved_histograms,
+                                        g_get_num_processors());
+    assert(r);
+    r = MissRateCurve__scaled_iadd(mrc, &saved_sum, scale);
+    assert(r);
+    MissRateCurve__destroy(&saved_sum);
 
     // Add contribution from current histograms
     struct MissRateCurve my_mrc = {0};
@@ -0,0 +1,89 @@
+/** @brief  A fixed-memory, sampled version of the Average Eviction Time.
+ *
+ *  The exact AET tracks the last access time of every key, so its
+ *  memory grows with the cardinality of the trace. However, AET only
+ *  needs the reuse time histogram, which we can estimate by spatially
+ *  sampling the keys (as in SHARDS). The reuse times are still measured
+ *  in global time; we simply scale up the counts of the sampled keys.
+ *
+ *  Memory is bounded in two ways:
+ *  1. The fixed-size SHARDS sampler caps the number of tracked keys at
+ *     'max_size' by lowering the sampling threshold;
+ *  2. The reuse times are kept in a log-bucketed histogram (see
+ *     'LogHistogram'), whose size does not depend on the trace length.
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "histogram/histogram.h"
+#include "histogram/log_histogram.h"
+#include "lookup/k_hash_table.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "shards/fixed_size_shards_sampler.h"
+#include "types/entry_type.h"
+#include "types/time_stamp_type.h"
+
+/// @brief  The significant bits of the reuse time histogram, so the
+///         relative width of a bucket is at most 1 / 2^6.
+#define SAMPLED_AET_SIGNIFICANT_BITS 6
+
+struct SampledAverageEvictionTime {
+    struct FixedSizeShardsSampler sampler;
+    /// Maps each sampled key to the global time of its last access.
+    struct KHashTable hash_table;
+    TimeStampType current_time_stamp;
+
+    /// Scaled counts of the reuse times, where the first accesses of the
+    /// sampled keys are the infinities.
+    struct LogHistogram reuse_times;
+
+    /// This is only materialized upon post-processing so that we can
+    /// save it in the usual format.
+    struct Histogram histogram;
+    size_t histogram_num_bins;
+    size_t histogram_bin_size;
+};
+
+/// @param  starting_sampling_ratio: double const
+///         The initial spatial sampling ratio in (0.0, 1.0].
+/// @param  max_size: size_t const
+///         The maximum number of keys that we track at once.
+/// @param  histogram_num_bins, histogram_bin_size: size_t const
+///         The resolution of the output histogram and MRC.
+bool
+SampledAverageEvictionTime__init(struct SampledAverageEvictionTime *const me,
+                                 double const starting_sampling_ratio,
+                                 size_t const max_size,
+                                 size_t const histogram_num_bins,
+                                 size_t const histogram_bin_size);
+
+bool
+SampledAverageEvictionTime__access_item(struct SampledAverageEvictionTime *me,
+                                        EntryType entry);
+
+/// @brief  Materialize the uniformly binned reuse time histogram.
+bool
+SampledAverageEvictionTime__post_process(struct SampledAverageEvictionTime *me);
+
+/// @brief  Convert the log-bucketed reuse time histogram to an MRC.
+/// @details    This walks the buckets once, integrating P(t) as it goes
+///             and emitting each MRC bin as soon as the integral reaches
+///             its cache size (see AverageEvictionTime__to_mrc). Within
+///             a bucket, I assume that the reuse times are uniformly
+///             spread. This may be called at any point in the stream.
+bool
+SampledAverageEvictionTime__to_mrc(
+    struct SampledAverageEvictionTime const *const me,
+    struct MissRateCurve *const mrc);
+
+/// @note   The histogram is only valid after post-processing.
+bool
+SampledAverageEvictionTime__get_histogram(
+    struct SampledAverageEvictionTime const *const me,
+    struct Histogram const **const histogram);
+
+void
+SampledAverageEvictionTime__destroy(struct SampledAverageEvictionTime *me);
@@ -0,0 +1,272 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "average_eviction_time/sampled_average_eviction_time.h"
+#include "histogram/histogram.h"
+#include "histogram/log_histogram.h"
+#include "logger/logger.h"
+#include "lookup/k_hash_table.h"
+#include "lookup/lookup.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "shards/fixed_size_shards_sampler.h"
+#include "types/entry_type.h"
+#include "types/time_stamp_type.h"
+#include "unused/mark_unused.h"
+
+bool
+SampledAverageEvictionTime__init(struct SampledAverageEvictionTime *const me,
+                                 double const starting_sampling_ratio,
+                                 size_t const max_size,
+                                 size_t const histogram_num_bins,
+                                 size_t const histogram_bin_size)
+{
+    if (me == NULL || histogram_num_bins < 1 || histogram_bin_size < 1) {
+        LOGGER_ERROR("invalid arguments");
+        return false;
+    }
+    *me = (struct SampledAverageEvictionTime){
+        .histogram_num_bins = histogram_num_bins,
+        .histogram_bin_size = histogram_bin_size,
+    };
+    if (!FixedSizeShardsSampler__init(&me->sampler,
+                                      starting_sampling_ratio,
+                                      max_size,
+                                      false)) {
+        LOGGER_ERROR("failed to init fixed-size SHARDS sampler");
+        goto cleanup;
+    }
+    if (!KHashTable__init(&me->hash_table)) {
+        LOGGER_ERROR("failed to init hash table");
+        goto cleanup;
+    }
+    // NOTE I cover every reuse time so that there are no false infinities.
+    if (!LogHistogram__init(&me->reuse_times,
+                            SAMPLED_AET_SIGNIFICANT_BITS,
+                            UINT64_MAX)) {
+        LOGGER_ERROR("failed to init reuse time histogram");
+        goto cleanup;
+    }
+    if (!Histogram__init(&me->histogram,
+                         histogram_num_bins,
+                         histogram_bin_size,
+                         false)) {
+        LOGGER_ERROR("failed to init histogram");
+        goto cleanup;
+    }
+    return true;
+cleanup:
+    SampledAverageEvictionTime__destroy(me);
+    return false;
+}
+
+static void
+evict_item(void *eviction_data, EntryType entry)
+{
+    struct LookupReturn const r = KHashTable__remove(eviction_data, entry);
+    assert(r.success);
+    MAYBE_UNUSED(r);
+}
+
+bool
+SampledAverageEvictionTime__access_item(struct SampledAverageEvictionTime *me,
+                                        EntryType entry)
+{
+    if (me == NULL || me->reuse_times.histogram == NULL)
+        return false;
+
+    TimeStampType const now = me->current_time_stamp++;
+    if (!FixedSizeShardsSampler__sample(&me->sampler, entry)) {
+        return true;
+    }
+
+    struct LookupReturn const s = KHashTable__lookup(&me->hash_table, entry);
+    if (s.success) {
+        // NOTE As in the exact AET, the reuse time between two
+        //      neighbouring accesses is 0.
+        uint64_t const reuse_time = now - s.timestamp - 1;
+        if (KHashTable__put(&me->hash_table, entry, now) !=
+            LOOKUP_PUTUNIQUE_REPLACE_VALUE)
+            LOGGER_WARN("failed to replace value in hash table");
+        LogHistogram__insert_weighted_finite(&me->reuse_times,
+                                             reuse_time,
+                                             me->sampler.scale);
+    } else {
+        // NOTE The sampler may evict keys (and lower the threshold, thus
+        //      raising the scale) to make room, so I insert into it
+        //      first and then use the updated scale.
+        if (!FixedSizeShardsSampler__insert(&me->sampler,
+                                            entry,
+                                            evict_item,
+                                            &me->hash_table)) {
+            LOGGER_ERROR("fixed-size SHARDS sampler insertion failed");
+            return false;
+        }
+        if (KHashTable__put(&me->hash_table, entry, now) !=
+            LOOKUP_PUTUNIQUE_INSERT_KEY_VALUE)
+            LOGGER_WARN("failed to insert into hash table");
+        LogHistogram__insert_scaled_infinite(&me->reuse_times,
+                                             me->sampler.scale);
+    }
+    return true;
+}
+
+/// @brief  Spread the count of one log-bucket evenly across the uniform
+///         bins that it overlaps.
+/// @note   I distribute the cumulative count so that the total is
+///         preserved exactly despite the rounding.
+static void
+spread_bucket(struct Histogram *const hist,
+              uint64_t const lower,
+              uint64_t const width,
+              uint64_t const count)
+{
+    uint64_t const histogram_end = hist->num_bins * hist->bin_size;
+    uint64_t distributed = 0;
+    for (uint64_t t = lower; t < histogram_end && t - lower < width;) {
+        size_t const bin = t / hist->bin_size;
+        uint64_t const bin_end = (bin + 1) * hist->bin_size;
+        uint64_t const end =
+            bin_end - lower < width ? bin_end : lower + width;
+        uint64_t const cumulative =
+            end - lower == width
+                ? count
+                : (uint64_t)((double)count * (end - lower) / width);
+        hist->histogram[bin] += cumulative - distributed;
+        distributed = cumulative;
+        t = end;
+    }
+    hist->false_infinity += count - distributed;
+    hist->running_sum += count;
+}
+
+bool
+SampledAverageEvictionTime__post_process(struct SampledAverageEvictionTime *me)
+{
+    if (me == NULL || me->reuse_times.histogram == NULL)
+        return false;
+
+    struct LogHistogram const *const reuse_times = &me->reuse_times;
+    Histogram__clear(&me->histogram);
+    for (size_t i = 0; i < reuse_times->num_bins; ++i) {
+        if (reuse_times->histogram[i] == 0) {
+            continue;
+        }
+        spread_bucket(&me->histogram,
+                      LogHistogram__get_bin_lower_bound(reuse_times, i),
+                      LogHistogram__get_bin_width(reuse_times, i),
+                      reuse_times->histogram[i]);
+    }
+    me->histogram.false_infinity += reuse_times->false_infinity;
+    me->histogram.infinity = reuse_times->infinity;
+    me->histogram.running_sum +=
+        reuse_times->false_infinity + reuse_times->infinity;
+    return true;
+}
+
+/// @brief  Find the smallest offset j into a bucket such that the
+///         integral of P up to and including (lower + j) reaches the
+///         target.
+/// @details    With G reuse times at or above the bucket's lower bound
+///             and n of them uniformly spread across the bucket of
+///             width w, there are (G - n * x / w) reuse times at or
+///             above (lower + x). Thus, the integral over the first
+///             (j + 1) reuse times is (j + 1) * G - n * j * (j + 1) / 2w.
+static uint64_t
+find_offset_in_bucket(double const integral,
+                      double const target,
+                      double const at_or_above,
+                      double const count,
+                      uint64_t const width)
+{
+    uint64_t lo = 0, hi = width - 1;
+    while (lo < hi) {
+        uint64_t const mid = lo + (hi - lo) / 2;
+        double const j = (double)mid;
+        double const s =
+            (j + 1) * at_or_above - count * j * (j + 1) / (2 * (double)width);
+        if (integral + s >= target) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+bool
+SampledAverageEvictionTime__to_mrc(
+    struct SampledAverageEvictionTime const *const me,
+    struct MissRateCurve *const mrc)
+{
+    if (me == NULL || me->reuse_times.histogram == NULL || mrc == NULL)
+        return false;
+    if (!MissRateCurve__alloc_empty(mrc,
+                                    me->histogram_num_bins + 2,
+                                    me->histogram_bin_size)) {
+        LOGGER_ERROR("failed to allocate MRC");
+        return false;
+    }
+    struct LogHistogram const *const reuse_times = &me->reuse_times;
+    if (reuse_times->running_sum == 0) {
+        LOGGER_WARN("empty reuse time histogram");
+        return true;
+    }
+
+    // NOTE I keep everything in (scaled) counts rather than
+    //      probabilities and only divide by the total at the end.
+    double const total = (double)reuse_times->running_sum;
+    double const target_step = (double)mrc->bin_size * total;
+    double at_or_above = total;
+    double integral = 0.0;
+    size_t c = 0;
+    for (size_t i = 0; i < reuse_times->num_bins && c < mrc->num_bins; ++i) {
+        double const count = (double)reuse_times->histogram[i];
+        uint64_t const width = LogHistogram__get_bin_width(reuse_times, i);
+        double const w = (double)width;
+        double const bucket_integral = w * at_or_above - count * (w - 1) / 2;
+        for (; c < mrc->num_bins; ++c) {
+            double const target = c * target_step;
+            if (target > integral + bucket_integral) {
+                break;
+            }
+            uint64_t const j = find_offset_in_bucket(integral,
+                                                     target,
+                                                     at_or_above,
+                                                     count,
+                                                     width);
+            mrc->miss_rate[c] = (at_or_above - count * j / w) / total;
+        }
+        integral += bucket_integral;
+        at_or_above -= count;
+    }
+    // NOTE Beyond the final bucket, only the (false) infinities remain.
+    for (; c < mrc->num_bins; ++c) {
+        mrc->miss_rate[c] = at_or_above / total;
+    }
+    return true;
+}
+
+bool
+SampledAverageEvictionTime__get_histogram(
+    struct SampledAverageEvictionTime const *const me,
+    struct Histogram const **const histogram)
+{
+    if (me == NULL || histogram == NULL)
+        return false;
+    *histogram = &me->histogram;
+    return true;
+}
+
+void
+SampledAverageEvictionTime__destroy(struct SampledAverageEvictionTime *me)
+{
+    if (me == NULL)
+        return;
+    FixedSizeShardsSampler__destroy(&me->sampler);
+    KHashTable__destroy(&me->hash_table);
+    LogHistogram__destroy(&me->reuse_times);
+    Histogram__destroy(&me->histogram);
+    *me = (struct SampledAverageEvictionTime){0};
+}
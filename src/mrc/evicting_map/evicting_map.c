@@ -116,10 +116,12 @@ EvictingMap__init_full(struct EvictingMap *const me,
 static inline void
 handle_ignored(struct EvictingMap *me,
                struct SampledTryPutReturn s,
-               TimeStampType value)
+               TimeStampType value,
+               uint64_t const scale)
 {
     UNUSED(s);
     UNUSED(value);
+    UNUSED(scale);
     assert(me != NULL);
 
 #ifdef INTERVAL_STATISTICS
@@ -134,12 +136,12 @@ handle_ignored(struct EvictingMap *me,
 static inline void
 handle_inserted(struct EvictingMap *me,
                 struct SampledTryPutReturn s,
-                TimeStampType value)
+                TimeStampType value,
+                uint64_t const scale)
 {
     UNUSED(s);
     assert(me != NULL);
 
-    const uint64_t scale = me->hash_table.scale_factor;
     bool r = false;
     MAYBE_UNUSED(r);
 
@@ -157,11 +159,11 @@ handle_inserted(struct EvictingMap *me,
 static inline void
 handle_replaced(struct EvictingMap *me,
                 struct SampledTryPutReturn s,
-                TimeStampType timestamp)
+                TimeStampType timestamp,
+                uint64_t const scale)
 {
     assert(me != NULL);
 
-    const uint64_t scale = me->hash_table.scale_factor;
     bool r = false;
     MAYBE_UNUSED(r);
 
@@ -181,11 +183,11 @@ handle_replaced(struct EvictingMap *me,
 static inline void
 handle_updated(struct EvictingMap *me,
                struct SampledTryPutReturn s,
-               TimeStampType timestamp)
+               TimeStampType timestamp,
+               uint64_t const scale)
 {
     assert(me != NULL);
 
-    const uint64_t scale = me->hash_table.scale_factor;
     bool r = false;
     uint64_t distance = 0;
     MAYBE_UNUSED(r);
@@ -232,26 +234,40 @@ EvictingMap__access_item(struct EvictingMap *me, EntryType entry)
 #endif
     struct SampledTryPutReturn r =
         EvictingHashTable__try_put(&me->hash_table, entry, timestamp);
+    EvictingMap__apply_try_put(me, r, timestamp, me->hash_table.scale_factor);
+    if (r.status == SAMPLED_IGNORED) {
+        UPDATE_PROFILE_STATISTICS(&me->prof_stats_fast, start);
+    } else {
+        UPDATE_PROFILE_STATISTICS(&me->prof_stats_slow, start);
+    }
+    return true;
+}
+
+bool
+EvictingMap__apply_try_put(struct EvictingMap *me,
+                           struct SampledTryPutReturn const r,
+                           TimeStampType const timestamp,
+                           uint64_t const scale)
+{
+    if (me == NULL || timestamp != me->current_time_stamp)
+        return false;
     switch (r.status) {
     case SAMPLED_IGNORED:
         /* Do no work -- this is like SHARDS */
-        handle_ignored(me, r, timestamp);
-        UPDATE_PROFILE_STATISTICS(&me->prof_stats_fast, start);
+        handle_ignored(me, r, timestamp, scale);
         break;
     case SAMPLED_INSERTED:
-        handle_inserted(me, r, timestamp);
-        UPDATE_PROFILE_STATISTICS(&me->prof_stats_slow, start);
+        handle_inserted(me, r, timestamp, scale);
         break;
     case SAMPLED_REPLACED:
-        handle_replaced(me, r, timestamp);
-        UPDATE_PROFILE_STATISTICS(&me->prof_stats_slow, start);
+        handle_replaced(me, r, timestamp, scale);
         break;
     case SAMPLED_UPDATED:
-        handle_updated(me, r, timestamp);
-        UPDATE_PROFILE_STATISTICS(&me->prof_stats_slow, start);
+        handle_updated(me, r, timestamp, scale);
         break;
     default:
         assert(0 && "impossible");
+        return false;
     }
     return true;
 }
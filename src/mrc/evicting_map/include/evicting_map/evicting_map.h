@@ -59,6 +59,18 @@ EvictingMap__init_full(struct EvictingMap *const me,
 bool
 EvictingMap__access_item(struct EvictingMap *me, EntryType entry);
 
+/// @brief  Update the stack and histogram with the result of putting
+///         the access at 'timestamp' into the hash table.
+/// @note   This lets the hashing and hash table updates happen
+///         elsewhere (e.g. on other threads), so that only the tree
+///         updates need to be serialized. The timestamp must be the
+///         current timestamp, i.e. the results must be applied in order.
+bool
+EvictingMap__apply_try_put(struct EvictingMap *me,
+                           struct SampledTryPutReturn const r,
+                           TimeStampType const timestamp,
+                           uint64_t const scale);
+
 void
 EvictingMap__refresh_threshold(struct EvictingMap *me);
 
@@ -0,0 +1,115 @@
+/** @brief  A multi-threaded driver for the Evicting Map.
+ *
+ *  The accesses are buffered into blocks. For each block:
+ *  1. The worker threads hash disjoint slices of the block;
+ *  2. Each worker then walks the whole block in order but only puts
+ *     the hashes that fall into the sequence locks that it owns. This
+ *     means that each slot is only ever written by one thread and in
+ *     time order, so each slot evolves exactly as it would serially.
+ *     The sampled (i.e. non-ignored) results are appended to the
+ *     worker's own batch, which is therefore ordered by time;
+ *  3. The calling thread merges the per-thread batches by timestamp and
+ *     applies them to the stack-distance tree, which is not
+ *     thread-safe.
+ *
+ *  The only difference from the serial Evicting Map is that the scale
+ *  factor is estimated from a racy snapshot of the HyperLogLog state.
+ */
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "evicting_map/evicting_map.h"
+#include "hash/types.h"
+#include "histogram/histogram.h"
+#include "lookup/evicting_hash_table.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "types/entry_type.h"
+#include "types/time_stamp_type.h"
+
+#define PARALLEL_EVICTING_MAP_BLOCK_SIZE (1 << 16)
+
+struct ParallelEvictingMapEvent {
+    struct SampledTryPutReturn r;
+    TimeStampType timestamp;
+    uint64_t scale;
+};
+
+/// @brief  The sampled results of one worker for the current block.
+/// @note   I align these to a cache line so that workers do not
+///         false-share their lengths.
+struct ParallelEvictingMapBatch {
+    /// Room for PARALLEL_EVICTING_MAP_BLOCK_SIZE events
+    struct ParallelEvictingMapEvent *events;
+    size_t length;
+} __attribute__((aligned(64)));
+
+struct ParallelEvictingMap;
+
+struct ParallelEvictingMapWorker {
+    struct ParallelEvictingMap *map;
+    size_t id;
+};
+
+struct ParallelEvictingMap {
+    struct EvictingMap map;
+    size_t num_threads;
+
+    EntryType *block;
+    Hash64BitType *hashes;
+    // NOTE The worker that owns each access in the block.
+    uint32_t *owners;
+    size_t block_length;
+    TimeStampType block_start_time;
+
+    struct ParallelEvictingMapBatch *batches;
+    // NOTE The merge position within each batch.
+    size_t *heads;
+    struct ParallelEvictingMapWorker *workers;
+    pthread_t *threads;
+    size_t num_started_threads;
+    bool initialized_sync;
+    pthread_mutex_t startup_lock;
+    pthread_barrier_t start_barrier;
+    pthread_barrier_t hashed_barrier;
+    pthread_barrier_t finish_barrier;
+    bool shutdown;
+};
+
+bool
+ParallelEvictingMap__init(struct ParallelEvictingMap *const me,
+                          size_t const num_threads,
+                          double const init_sampling_ratio,
+                          uint64_t const num_hash_buckets,
+                          uint64_t const histogram_num_bins,
+                          uint64_t const histogram_bin_size);
+
+/// @brief  Buffer an access. The buffer is processed when it is full or
+///         upon post-processing.
+bool
+ParallelEvictingMap__access_item(struct ParallelEvictingMap *me,
+                                 EntryType entry);
+
+/// @brief  Process all of the buffered accesses.
+bool
+ParallelEvictingMap__flush(struct ParallelEvictingMap *me);
+
+bool
+ParallelEvictingMap__post_process(struct ParallelEvictingMap *me);
+
+bool
+ParallelEvictingMap__to_mrc(struct ParallelEvictingMap const *const me,
+                            struct MissRateCurve *const mrc);
+
+void
+ParallelEvictingMap__print_histogram_as_json(struct ParallelEvictingMap *me);
+
+void
+ParallelEvictingMap__destroy(struct ParallelEvictingMap *me);
+
+bool
+ParallelEvictingMap__get_histogram(struct ParallelEvictingMap const *const me,
+                                   struct Histogram const **const histogram);
@@ -0,0 +1,350 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "evicting_map/evicting_map.h"
+#include "evicting_map/parallel_evicting_map.h"
+#include "hash/hash.h"
+#include "hash/types.h"
+#include "histogram/histogram.h"
+#include "logger/logger.h"
+#include "lookup/evicting_hash_table.h"
+#include "miss_rate_curve/miss_rate_curve.h"
+#include "types/entry_type.h"
+#include "types/time_stamp_type.h"
+#include "unused/mark_unused.h"
+
+/// @brief  Marks an access that we know will be ignored without
+///         looking at the hash table.
+#define IGNORED_OWNER UINT32_MAX
+
+/// @brief  Hash a disjoint slice of the block and mark which thread
+///         owns each access.
+static void
+hash_slice(struct ParallelEvictingMap *const me, size_t const id)
+{
+    struct EvictingHashTable *const table = &me->map.hash_table;
+    size_t const begin = me->block_length * id / me->num_threads;
+    size_t const end = me->block_length * (id + 1) / me->num_threads;
+    // NOTE The threshold only ever decreases, so if an access is above
+    //      it now, then it will also be above it when it is processed.
+    Hash64BitType const threshold =
+        __atomic_load_n(&table->global_threshold, __ATOMIC_RELAXED);
+    for (size_t i = begin; i < end; ++i) {
+        Hash64BitType const hash = Hash64Bit(me->block[i]);
+        me->hashes[i] = hash;
+        me->owners[i] =
+            hash > threshold
+                ? IGNORED_OWNER
+                : EvictingHashTable__seqlock_index(table, hash) %
+                      me->num_threads;
+    }
+}
+
+/// @brief  Put the owned accesses into the hash table in time order.
+static void
+put_owned(struct ParallelEvictingMap *const me, size_t const id)
+{
+    struct EvictingHashTable *const table = &me->map.hash_table;
+    struct ParallelEvictingMapBatch *const batch = &me->batches[id];
+    batch->length = 0;
+    for (size_t i = 0; i < me->block_length; ++i) {
+        if (me->owners[i] != id) {
+            continue;
+        }
+        TimeStampType const timestamp = me->block_start_time + i;
+        struct SampledTryPutReturn const r =
+            EvictingHashTable__try_put_hash_concurrent(table,
+                                                       me->hashes[i],
+                                                       timestamp);
+        if (r.status == SAMPLED_IGNORED) {
+            continue;
+        }
+        double scale_factor = 0.0;
+        __atomic_load(&table->scale_factor, &scale_factor, __ATOMIC_RELAXED);
+        // NOTE The batch has room for the whole block, so I never change
+        //      a slot without recording its event.
+        assert(batch->length < PARALLEL_EVICTING_MAP_BLOCK_SIZE);
+        batch->events[batch->length++] = (struct ParallelEvictingMapEvent){
+            .r = r,
+            .timestamp = timestamp,
+            .scale = scale_factor,
+        };
+    }
+}
+
+static void *
+worker_main(void *args)
+{
+    struct ParallelEvictingMapWorker *const w = args;
+    struct ParallelEvictingMap *const me = w->map;
+
+    // NOTE We wait for the creating thread to release this lock so
+    //      that we know whether all of the other threads started.
+    pthread_mutex_lock(&me->startup_lock);
+    bool const shutdown = me->shutdown;
+    pthread_mutex_unlock(&me->startup_lock);
+    if (shutdown) {
+        return NULL;
+    }
+
+    while (true) {
+        pthread_barrier_wait(&me->start_barrier);
+        if (me->shutdown) {
+            break;
+        }
+        hash_slice(me, w->id);
+        pthread_barrier_wait(&me->hashed_barrier);
+        put_owned(me, w->id);
+        pthread_barrier_wait(&me->finish_barrier);
+    }
+    return NULL;
+}
+
+static void
+stop_workers(struct ParallelEvictingMap *const me)
+{
+    if (me->num_started_threads == 0) {
+        return;
+    }
+    if (me->num_started_threads == me->num_threads) {
+        me->shutdown = true;
+        pthread_barrier_wait(&me->start_barrier);
+    }
+    for (size_t i = 0; i < me->num_started_threads; ++i) {
+        pthread_join(me->threads[i], NULL);
+    }
+    me->num_started_threads = 0;
+}
+
+bool
+ParallelEvictingMap__init(struct ParallelEvictingMap *const me,
+                          size_t const num_threads,
+                          double const init_sampling_ratio,
+                          uint64_t const num_hash_buckets,
+                          uint64_t const histogram_num_bins,
+                          uint64_t const histogram_bin_size)
+{
+    if (me == NULL || num_threads == 0 || num_threads >= IGNORED_OWNER)
+        return false;
+    *me = (struct ParallelEvictingMap){.num_threads = num_threads};
+    if (!EvictingMap__init(&me->map,
+                           init_sampling_ratio,
+                           num_hash_buckets,
+                           histogram_num_bins,
+                           histogram_bin_size)) {
+        return false;
+    }
+    me->block = calloc(PARALLEL_EVICTING_MAP_BLOCK_SIZE, sizeof(*me->block));
+    me->hashes = calloc(PARALLEL_EVICTING_MAP_BLOCK_SIZE, sizeof(*me->hashes));
+    me->owners = calloc(PARALLEL_EVICTING_MAP_BLOCK_SIZE, sizeof(*me->owners));
+    me->batches = aligned_alloc(_Alignof(struct ParallelEvictingMapBatch),
+                                num_threads * sizeof(*me->batches));
+    me->heads = calloc(num_threads, sizeof(*me->heads));
+    me->workers = calloc(num_threads, sizeof(*me->workers));
+    me->threads = calloc(num_threads, sizeof(*me->threads));
+    if (me->batches != NULL) {
+        for (size_t i = 0; i < num_threads; ++i) {
+            me->batches[i] = (struct ParallelEvictingMapBatch){0};
+        }
+    }
+    if (me->block == NULL || me->hashes == NULL || me->owners == NULL ||
+        me->batches == NULL || me->heads == NULL || me->workers == NULL ||
+        me->threads == NULL) {
+        LOGGER_ERROR("failed to allocate for %zu threads", num_threads);
+        goto cleanup;
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        // NOTE A worker records at most one event per access, so I reserve
+        //      a whole block up front rather than grow the batch while the
+        //      worker is changing the hash table.
+        me->batches[i].events = malloc(PARALLEL_EVICTING_MAP_BLOCK_SIZE *
+                                       sizeof(*me->batches[i].events));
+        if (me->batches[i].events == NULL) {
+            LOGGER_ERROR("failed to allocate batch %zu", i);
+            goto cleanup;
+        }
+        me->workers[i] = (struct ParallelEvictingMapWorker){.map = me, .id = i};
+    }
+
+    pthread_mutex_init(&me->startup_lock, NULL);
+    pthread_barrier_init(&me->start_barrier, NULL, num_threads + 1);
+    pthread_barrier_init(&me->hashed_barrier, NULL, num_threads);
+    pthread_barrier_init(&me->finish_barrier, NULL, num_threads + 1);
+    me->initialized_sync = true;
+
+    pthread_mutex_lock(&me->startup_lock);
+    for (size_t i = 0; i < num_threads; ++i) {
+        if (pthread_create(&me->threads[i],
+                           NULL,
+                           worker_main,
+                           &me->workers[i]) != 0) {
+            LOGGER_ERROR("failed to create thread %zu of %zu", i, num_threads);
+            me->shutdown = true;
+            break;
+        }
+        ++me->num_started_threads;
+    }
+    pthread_mutex_unlock(&me->startup_lock);
+    if (me->shutdown) {
+        goto cleanup;
+    }
+    return true;
+
+cleanup:
+    ParallelEvictingMap__destroy(me);
+    return false;
+}
+
+bool
+ParallelEvictingMap__access_item(struct ParallelEvictingMap *me,
+                                 EntryType entry)
+{
+    if (me == NULL || me->block == NULL)
+        return false;
+    me->block[me->block_length++] = entry;
+    if (me->block_length == PARALLEL_EVICTING_MAP_BLOCK_SIZE) {
+        return ParallelEvictingMap__flush(me);
+    }
+    return true;
+}
+
+/// @brief  Find the worker whose next event is the earliest.
+/// @return The worker's index or SIZE_MAX if all batches are exhausted.
+static size_t
+earliest_batch(struct ParallelEvictingMap const *const me)
+{
+    size_t earliest = SIZE_MAX;
+    TimeStampType earliest_time = UINT64_MAX;
+    for (size_t i = 0; i < me->num_threads; ++i) {
+        struct ParallelEvictingMapBatch const *const batch = &me->batches[i];
+        if (me->heads[i] == batch->length) {
+            continue;
+        }
+        TimeStampType const t = batch->events[me->heads[i]].timestamp;
+        if (t < earliest_time) {
+            earliest = i;
+            earliest_time = t;
+        }
+    }
+    return earliest;
+}
+
+/// @brief  Advance the serial state up to (but excluding) 'timestamp'
+///         by treating all of the accesses in between as ignored.
+static void
+skip_until(struct ParallelEvictingMap *const me, TimeStampType const timestamp)
+{
+    struct SampledTryPutReturn const ignored = {.status = SAMPLED_IGNORED};
+    while (me->map.current_time_stamp < timestamp) {
+        EvictingMap__apply_try_put(&me->map,
+                                   ignored,
+                                   me->map.current_time_stamp,
+                                   0);
+    }
+}
+
+bool
+ParallelEvictingMap__flush(struct ParallelEvictingMap *me)
+{
+    if (me == NULL || me->num_started_threads != me->num_threads)
+        return false;
+    if (me->block_length == 0)
+        return true;
+
+    me->block_start_time = me->map.current_time_stamp;
+    pthread_barrier_wait(&me->start_barrier);
+    pthread_barrier_wait(&me->finish_barrier);
+
+    for (size_t i = 0; i < me->num_threads; ++i) {
+        me->heads[i] = 0;
+    }
+    // NOTE Each batch is already sorted by time, so we just need to
+    //      merge them. The number of threads is small, so a linear scan
+    //      for the earliest head is fine.
+    for (size_t i = earliest_batch(me); i != SIZE_MAX;
+         i = earliest_batch(me)) {
+        struct ParallelEvictingMapEvent const *const event =
+            &me->batches[i].events[me->heads[i]++];
+        skip_until(me, event->timestamp);
+        bool const r = EvictingMap__apply_try_put(&me->map,
+                                                  event->r,
+                                                  event->timestamp,
+                                                  event->scale);
+        assert(r);
+        MAYBE_UNUSED(r);
+    }
+    skip_until(me, me->block_start_time + me->block_length);
+    me->block_length = 0;
+    return true;
+}
+
+bool
+ParallelEvictingMap__post_process(struct ParallelEvictingMap *me)
+{
+    if (me == NULL)
+        return false;
+    if (!ParallelEvictingMap__flush(me))
+        return false;
+    return EvictingMap__post_process(&me->map);
+}
+
+bool
+ParallelEvictingMap__to_mrc(struct ParallelEvictingMap const *const me,
+                            struct MissRateCurve *const mrc)
+{
+    if (me == NULL)
+        return false;
+    return EvictingMap__to_mrc(&me->map, mrc);
+}
+
+void
+ParallelEvictingMap__print_histogram_as_json(struct ParallelEvictingMap *me)
+{
+    if (me == NULL) {
+        EvictingMap__print_histogram_as_json(NULL);
+        return;
+    }
+    EvictingMap__print_histogram_as_json(&me->map);
+}
+
+void
+ParallelEvictingMap__destroy(struct ParallelEvictingMap *me)
+{
+    if (me == NULL) {
+        return;
+    }
+    stop_workers(me);
+    if (me->initialized_sync) {
+        pthread_mutex_destroy(&me->startup_lock);
+        pthread_barrier_destroy(&me->start_barrier);
+        pthread_barrier_destroy(&me->hashed_barrier);
+        pthread_barrier_destroy(&me->finish_barrier);
+    }
+    if (me->batches != NULL) {
+        for (size_t i = 0; i < me->num_threads; ++i) {
+            free(me->batches[i].events);
+        }
+    }
+    free(me->block);
+    free(me->hashes);
+    free(me->owners);
+    free(me->batches);
+    free(me->heads);
+    free(me->workers);
+    free(me->threads);
+    EvictingMap__destroy(&me->map);
+    *me = (struct ParallelEvictingMap){0};
+}
+
+bool
+ParallelEvictingMap__get_histogram(struct ParallelEvictingMap const *const me,
+                                   struct Histogram const **const histogram)
+{
+    if (me == NULL)
+        return false;
+    return EvictingMap__get_histogram(&me->map, histogram);
+}
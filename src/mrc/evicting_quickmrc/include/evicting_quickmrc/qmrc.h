@@ -17,6 +17,15 @@
  *
  * below, we allocate epochs and counts arrays separately, which may provide
  * better locality */
+struct qmrc;
+
+/* implementations of the hot loops for different instruction sets. */
+enum qmrc_kernel {
+    QMRC_KERNEL_SCALAR,
+    QMRC_KERNEL_AVX2,
+    QMRC_KERNEL_AVX512,
+};
+
 struct qmrc {
     /* stores epoch at which a bucket is created.
      * current (most recent) epoch is stored in epochs[0]. */
@@ -35,6 +44,13 @@ struct qmrc {
 
     int nr_merge;
     int nr_zero;
+
+    /* kernels selected at runtime (see qmrc__set_kernel) */
+    enum qmrc_kernel kernel;
+    size_t (*sum_until_epoch)(struct qmrc const *qmrc,
+                              int epoch,
+                              int *bucket_idx);
+    int (*find_merge_idx)(struct qmrc const *qmrc, size_t *min_sum);
 #ifdef STATS
     size_t *lookup;
     size_t *delete;
@@ -48,6 +64,22 @@ qmrc__init(struct qmrc *qmrc,
            size_t nr_qmrc_buckets,
            size_t epoch_limit);
 
+/* whether this build and cpu support the kernel (checked via cpuid). */
+bool
+qmrc__kernel_is_supported(enum qmrc_kernel kernel);
+
+/* the fastest kernel supported by this cpu; qmrc__init() uses this. */
+enum qmrc_kernel
+qmrc__best_kernel(void);
+
+/* override the kernel, e.g. for testing or benchmarking. returns false
+ * if the kernel is not supported. */
+bool
+qmrc__set_kernel(struct qmrc *qmrc, enum qmrc_kernel kernel);
+
+char const *
+qmrc__kernel_name(enum qmrc_kernel kernel);
+
 size_t
 qmrc__lookup(struct qmrc *qmrc, int epoch);
 
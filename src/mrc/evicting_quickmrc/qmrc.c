@@ -1,7 +1,6 @@
 /** Taken from Ashvin Goel's QuickMRC implementation. */
 
 #include <assert.h>
-#include <immintrin.h>
 #include <limits.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -9,8 +8,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <x86intrin.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#define QMRC_X86
+#include <immintrin.h>
+#endif /* __x86_64__ || __i386__ */
+
+#include "cpu_features/cpu_features.h"
 #include "evicting_quickmrc/qmrc.h"
 
 #define likely(x)      __builtin_expect(!!(x), 1)
@@ -18,6 +22,12 @@
 
 #define CACHELINE_SIZE 64
 
+static inline size_t
+round_up_to_cacheline(size_t size)
+{
+    return (size + CACHELINE_SIZE - 1) / CACHELINE_SIZE * CACHELINE_SIZE;
+}
+
 /* remove idx element from buckets by
  * shifting all previous elements to the right by one. */
 static void
@@ -44,6 +54,313 @@ qmrc_update_max_keys(struct qmrc *qmrc)
     }
 }
 
+/*
+ * kernels
+ *
+ * the hot loops are compiled for each instruction set with the target
+ * attribute. qmrc__init() picks the best kernel that the cpu supports
+ * (see cpu_features.h) and qmrc__set_kernel() can override it.
+ *
+ * sum_until_epoch() returns the sum of counts[0..idx] (inclusive), where
+ * idx is the first bucket whose epoch is <= the given epoch. since the
+ * epochs are sorted in decreasing order, this is the bucket of the epoch.
+ *
+ * find_merge_idx() returns the first idx in [1, nr_buckets) that
+ * minimizes counts[idx - 1] + counts[idx] (or 0 if no sum is below
+ * INT_MAX, as in the original code).
+ */
+
+static size_t
+sum_until_epoch_scalar(struct qmrc const *qmrc, int epoch, int *bucket_idx)
+{
+    size_t sd = 0;
+    int idx = -1;
+
+    do {
+        idx++;
+        sd += qmrc->counts[idx];
+    } while (qmrc->epochs[idx] > epoch);
+
+    *bucket_idx = idx;
+    return sd;
+}
+
+static int
+find_merge_idx_scalar(struct qmrc const *qmrc, size_t *min_sum_out)
+{
+    int merge_idx = 0; /* index of bucket to merge */
+    size_t min_sum = INT_MAX;
+
+    for (size_t idx = 1; idx < qmrc->nr_buckets; idx++) {
+        size_t sum = qmrc->counts[idx - 1] + qmrc->counts[idx];
+        if (min_sum > sum) {
+            min_sum = sum;
+            merge_idx = idx;
+        }
+    }
+
+    *min_sum_out = min_sum;
+    return merge_idx;
+}
+
+#ifdef QMRC_X86
+
+#ifndef QMRC_NO_AVX2
+
+/* the epochs are 32-bit and the counts are 64-bit, so each step compares
+ * one vector of 8 epochs and adds two vectors of 4 counts. */
+__attribute__((target("avx2"))) static size_t
+sum_until_epoch_avx2(struct qmrc const *qmrc, int epoch, int *bucket_idx)
+{
+    __m256i const target = _mm256_set1_epi32(epoch);
+    __m256i sum_vec = _mm256_setzero_si256();
+    size_t idx = 0;
+
+    /* the arrays are cacheline aligned, so idx % 8 == 0 is 32B aligned */
+    for (; idx + 8 <= qmrc->nr_buckets; idx += 8) {
+        __m256i e = _mm256_load_si256((__m256i const *)(qmrc->epochs + idx));
+        __m256i gt = _mm256_cmpgt_epi32(e, target);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(gt));
+        if (mask != 0xFF)
+            break;
+        __m256i lo = _mm256_load_si256((__m256i const *)(qmrc->counts + idx));
+        __m256i hi =
+            _mm256_load_si256((__m256i const *)(qmrc->counts + idx + 4));
+        sum_vec = _mm256_add_epi64(sum_vec, _mm256_add_epi64(lo, hi));
+    }
+
+    __m128i sum128 = _mm_add_epi64(_mm256_castsi256_si128(sum_vec),
+                                   _mm256_extracti128_si256(sum_vec, 1));
+    size_t sd = (size_t)_mm_cvtsi128_si64(sum128) +
+                (size_t)_mm_extract_epi64(sum128, 1);
+
+    /* the bucket is within the next 8 buckets */
+    for (;; idx++) {
+        sd += qmrc->counts[idx];
+        if (qmrc->epochs[idx] <= epoch)
+            break;
+    }
+
+    *bucket_idx = (int)idx;
+    return sd;
+}
+
+/* note that avx2 only has a signed 64-bit comparison, but the counts are
+ * bounded by the number of keys, so they never reach 2^63. */
+__attribute__((target("avx2"))) static int
+find_merge_idx_avx2(struct qmrc const *qmrc, size_t *min_sum_out)
+{
+    __m256i best = _mm256_set1_epi64x(INT_MAX);
+    __m256i best_idx = _mm256_setzero_si256();
+    __m256i cur_idx = _mm256_setr_epi64x(1, 2, 3, 4);
+    __m256i const four = _mm256_set1_epi64x(4);
+    size_t idx = 1;
+
+    for (; idx + 4 <= qmrc->nr_buckets; idx += 4) {
+        __m256i a =
+            _mm256_loadu_si256((__m256i const *)(qmrc->counts + idx - 1));
+        __m256i b = _mm256_loadu_si256((__m256i const *)(qmrc->counts + idx));
+        __m256i sum = _mm256_add_epi64(a, b);
+        /* strictly less, so each lane keeps its first minimum */
+        __m256i lt = _mm256_cmpgt_epi64(best, sum);
+        best = _mm256_blendv_epi8(best, sum, lt);
+        best_idx = _mm256_blendv_epi8(best_idx, cur_idx, lt);
+        cur_idx = _mm256_add_epi64(cur_idx, four);
+    }
+
+    uint64_t lane_best[4], lane_idx[4];
+    _mm256_storeu_si256((__m256i *)lane_best, best);
+    _mm256_storeu_si256((__m256i *)lane_idx, best_idx);
+    size_t min_sum = INT_MAX;
+    int merge_idx = 0;
+    for (int i = 0; i < 4; i++) {
+        if (lane_best[i] < min_sum ||
+            (lane_best[i] == min_sum && lane_best[i] < INT_MAX &&
+             (int)lane_idx[i] < merge_idx)) {
+            min_sum = lane_best[i];
+            merge_idx = (int)lane_idx[i];
+        }
+    }
+
+    for (; idx < qmrc->nr_buckets; idx++) {
+        size_t sum = qmrc->counts[idx - 1] + qmrc->counts[idx];
+        if (min_sum > sum) {
+            min_sum = sum;
+            merge_idx = idx;
+        }
+    }
+
+    *min_sum_out = min_sum;
+    return merge_idx;
+}
+
+#endif /* QMRC_NO_AVX2 */
+
+#ifndef QMRC_NO_AVX512
+
+/* each step compares 16 epochs and adds two vectors of 8 counts. the
+ * final partial step uses the comparison mask to add only up to and
+ * including the bucket of the epoch. */
+__attribute__((target("avx512f"))) static size_t
+sum_until_epoch_avx512(struct qmrc const *qmrc, int epoch, int *bucket_idx)
+{
+    __m512i const target = _mm512_set1_epi32(epoch);
+    __m512i sum_vec = _mm512_setzero_si512();
+    size_t idx = 0;
+
+    for (; idx + 16 <= qmrc->nr_buckets; idx += 16) {
+        __m512i e = _mm512_load_si512((void const *)(qmrc->epochs + idx));
+        __mmask16 gt = _mm512_cmpgt_epi32_mask(e, target);
+        if (gt != 0xFFFF) {
+            /* the bucket is the first epoch that is not greater */
+            unsigned offset = __builtin_ctz(~(unsigned)gt);
+            __mmask16 take = (__mmask16)((2u << offset) - 1);
+            __m512i lo = _mm512_maskz_load_epi64((__mmask8)(take & 0xFF),
+                                                 qmrc->counts + idx);
+            __m512i hi = _mm512_maskz_load_epi64((__mmask8)(take >> 8),
+                                                 qmrc->counts + idx + 8);
+            sum_vec = _mm512_add_epi64(sum_vec, _mm512_add_epi64(lo, hi));
+            *bucket_idx = (int)(idx + offset);
+            return (size_t)_mm512_reduce_add_epi64(sum_vec);
+        }
+        __m512i lo = _mm512_load_si512((void const *)(qmrc->counts + idx));
+        __m512i hi = _mm512_load_si512((void const *)(qmrc->counts + idx + 8));
+        sum_vec = _mm512_add_epi64(sum_vec, _mm512_add_epi64(lo, hi));
+    }
+
+    size_t sd = (size_t)_mm512_reduce_add_epi64(sum_vec);
+    for (;; idx++) {
+        sd += qmrc->counts[idx];
+        if (qmrc->epochs[idx] <= epoch)
+            break;
+    }
+
+    *bucket_idx = (int)idx;
+    return sd;
+}
+
+__attribute__((target("avx512f"))) static int
+find_merge_idx_avx512(struct qmrc const *qmrc, size_t *min_sum_out)
+{
+    __m512i best = _mm512_set1_epi64(INT_MAX);
+    __m512i best_idx = _mm512_setzero_si512();
+    __m512i cur_idx = _mm512_setr_epi64(1, 2, 3, 4, 5, 6, 7, 8);
+    __m512i const eight = _mm512_set1_epi64(8);
+    size_t idx = 1;
+
+    for (; idx + 8 <= qmrc->nr_buckets; idx += 8) {
+        __m512i a = _mm512_loadu_si512((void const *)(qmrc->counts + idx - 1));
+        __m512i b = _mm512_loadu_si512((void const *)(qmrc->counts + idx));
+        __m512i sum = _mm512_add_epi64(a, b);
+        /* strictly less, so each lane keeps its first minimum */
+        __mmask8 lt = _mm512_cmplt_epu64_mask(sum, best);
+        best = _mm512_mask_mov_epi64(best, lt, sum);
+        best_idx = _mm512_mask_mov_epi64(best_idx, lt, cur_idx);
+        cur_idx = _mm512_add_epi64(cur_idx, eight);
+    }
+
+    size_t min_sum = (size_t)_mm512_reduce_min_epu64(best);
+    int merge_idx = 0;
+    if (min_sum < INT_MAX) {
+        /* break ties between lanes by taking the earliest index */
+        __mmask8 is_min =
+            _mm512_cmpeq_epu64_mask(best, _mm512_set1_epi64(min_sum));
+        __m512i candidates = _mm512_mask_mov_epi64(_mm512_set1_epi64(INT64_MAX),
+                                                   is_min,
+                                                   best_idx);
+        merge_idx = (int)_mm512_reduce_min_epu64(candidates);
+    }
+
+    for (; idx < qmrc->nr_buckets; idx++) {
+        size_t sum = qmrc->counts[idx - 1] + qmrc->counts[idx];
+        if (min_sum > sum) {
+            min_sum = sum;
+            merge_idx = idx;
+        }
+    }
+
+    *min_sum_out = min_sum;
+    return merge_idx;
+}
+
+#endif /* QMRC_NO_AVX512 */
+
+#endif /* QMRC_X86 */
+
+bool
+qmrc__kernel_is_supported(enum qmrc_kernel kernel)
+{
+    switch (kernel) {
+    case QMRC_KERNEL_SCALAR:
+        return true;
+#if defined(QMRC_X86) && !defined(QMRC_NO_AVX2)
+    case QMRC_KERNEL_AVX2:
+        return CpuFeatures__supports(CPU_FEATURE_AVX2);
+#endif
+#if defined(QMRC_X86) && !defined(QMRC_NO_AVX512)
+    case QMRC_KERNEL_AVX512:
+        return CpuFeatures__supports(CPU_FEATURE_AVX512F);
+#endif
+    default:
+        return false;
+    }
+}
+
+enum qmrc_kernel
+qmrc__best_kernel(void)
+{
+    if (qmrc__kernel_is_supported(QMRC_KERNEL_AVX512))
+        return QMRC_KERNEL_AVX512;
+    if (qmrc__kernel_is_supported(QMRC_KERNEL_AVX2))
+        return QMRC_KERNEL_AVX2;
+    return QMRC_KERNEL_SCALAR;
+}
+
+bool
+qmrc__set_kernel(struct qmrc *qmrc, enum qmrc_kernel kernel)
+{
+    if (!qmrc || !qmrc__kernel_is_supported(kernel))
+        return false;
+
+    switch (kernel) {
+    case QMRC_KERNEL_SCALAR:
+        qmrc->sum_until_epoch = sum_until_epoch_scalar;
+        qmrc->find_merge_idx = find_merge_idx_scalar;
+        break;
+#if defined(QMRC_X86) && !defined(QMRC_NO_AVX2)
+    case QMRC_KERNEL_AVX2:
+        qmrc->sum_until_epoch = sum_until_epoch_avx2;
+        qmrc->find_merge_idx = find_merge_idx_avx2;
+        break;
+#endif
+#if defined(QMRC_X86) && !defined(QMRC_NO_AVX512)
+    case QMRC_KERNEL_AVX512:
+        qmrc->sum_until_epoch = sum_until_epoch_avx512;
+        qmrc->find_merge_idx = find_merge_idx_avx512;
+        break;
+#endif
+    default:
+        return false;
+    }
+    qmrc->kernel = kernel;
+    return true;
+}
+
+char const *
+qmrc__kernel_name(enum qmrc_kernel kernel)
+{
+    switch (kernel) {
+    case QMRC_KERNEL_SCALAR:
+        return "scalar";
+    case QMRC_KERNEL_AVX2:
+        return "avx2";
+    case QMRC_KERNEL_AVX512:
+        return "avx512";
+    default:
+        return "unknown";
+    }
+}
+
 /* creates a new epoch by making space at qmrc->buckets[0]. */
 static void
 qmrc_merge(struct qmrc *qmrc)
@@ -60,13 +377,7 @@ qmrc_merge(struct qmrc *qmrc)
      * make sure that min_sum is the sum of the counts[] of two
      * consecutive buckets.
      */
-    for (size_t idx = 1; idx < qmrc->nr_buckets; idx++) {
-        size_t sum = qmrc->counts[idx - 1] + qmrc->counts[idx];
-        if (min_sum > sum) {
-            min_sum = sum;
-            merge_idx = idx;
-        }
-    }
+    merge_idx = qmrc->find_merge_idx(qmrc, &min_sum);
 
 #ifdef ASSERT
     assert(merge_idx > 0);
@@ -130,13 +441,14 @@ qmrc__init(struct qmrc *qmrc,
 
     qmrc->nr_buckets = nr_qmrc_buckets;
 
-    /* align buckets to cache size */
-    alloc_size = qmrc->nr_buckets * sizeof(int);
+    /* align buckets to cache size. aligned_alloc requires the size to
+     * be a multiple of the alignment, so round it up. */
+    alloc_size = round_up_to_cacheline(qmrc->nr_buckets * sizeof(int));
     qmrc->epochs = aligned_alloc(CACHELINE_SIZE, alloc_size);
     assert((intptr_t)qmrc->epochs % CACHELINE_SIZE == 0);
     memset(qmrc->epochs, 0, alloc_size);
 
-    alloc_size = qmrc->nr_buckets * sizeof(size_t);
+    alloc_size = round_up_to_cacheline(qmrc->nr_buckets * sizeof(size_t));
     qmrc->counts = aligned_alloc(CACHELINE_SIZE, alloc_size);
     assert((intptr_t)qmrc->counts % CACHELINE_SIZE == 0);
     memset(qmrc->counts, 0, alloc_size);
@@ -166,35 +478,11 @@ qmrc__init(struct qmrc *qmrc,
     assert(qmrc->merge);
 #endif /* STATS */
 
-    return true;
-}
+    qmrc__set_kernel(qmrc, qmrc__best_kernel());
 
-#ifndef QMRC_NO_AVX2
-
-/* helper or hsum_8x32 */
-static uint32_t
-hsum_epi32_avx(__m128i x)
-{
-    /* 3-op non-destructive AVX lets us save a byte without using movdqa */
-    __m128i hi64 = _mm_unpackhi_epi64(x, x);
-    __m128i sum64 = _mm_add_epi32(hi64, x);
-    /* swap the low two elements */
-    __m128i hi32 = _mm_shuffle_epi32(sum64, _MM_SHUFFLE(2, 3, 0, 1));
-    __m128i sum32 = _mm_add_epi32(sum64, hi32);
-    return (uint32_t)_mm_cvtsi128_si32(sum32);
-}
-
-/* returns sum of 8 ints in v, only needs AVX2 */
-static uint32_t
-hsum_8x32(__m256i v)
-{
-    __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(v),
-                                   _mm256_extracti128_si256(v, 1));
-    return hsum_epi32_avx(sum128);
+    return true;
 }
 
-#endif /* QMRC_NO_AVX2 */
-
 /*
  * key idea of qmrc
  *
@@ -225,31 +513,7 @@ qmrc__lookup(struct qmrc *qmrc, int epoch)
     size_t sd = 0;
     int idx = -1;
 
-#ifndef QMRC_NO_AVX2 /* avx2 provides a little benefit. */
-
-/* use avx2 when index of desired epoch is at least AVX2_THRESHOLD. */
-#define AVX2_THRESHOLD 16
-
-    if (qmrc->epochs[idx + AVX2_THRESHOLD] > epoch) {
-        /* Initialize sum vector to {0, 0, 0, 0, 0, 0, 0, 0} */
-        __m256i sum_vec = _mm256_setzero_si256();
-        idx += 8;
-        do {
-            /* load 32 bytes into tmp */
-            __m256i tmp =
-                _mm256_load_si256((__m256i *)(qmrc->counts + idx - 7));
-            sum_vec = _mm256_add_epi32(sum_vec, tmp);
-            idx += 8;
-        } while (qmrc->epochs[idx] > epoch);
-        sd = hsum_8x32(sum_vec);
-        idx -= 8;
-    }
-#endif /* QMRC_NO_AVX2 */
-
-    do {
-        idx++;
-        sd += qmrc->counts[idx];
-    } while (qmrc->epochs[idx] > epoch);
+    sd = qmrc->sum_until_epoch(qmrc, epoch, &idx);
 
 #ifdef ASSERT
     assert(idx < qmrc->nr_buckets);
@@ -25,6 +25,13 @@ MimirBuckets__init(struct MimirBuckets *me, const uint64_t num_real_buckets)
     if (me->buckets == NULL) {
         return false;
     }
+    me->count_tree =
+        (uint64_t *)calloc(num_real_buckets + 1, sizeof(*me->count_tree));
+    if (me->count_tree == NULL) {
+        free(me->buckets);
+        me->buckets = NULL;
+        return false;
+    }
     me->num_buckets = num_real_buckets;
     me->newest_bucket = num_real_buckets - 1;
     me->oldest_bucket = 0;
@@ -62,7 +69,7 @@ MimirBuckets__increment_newest_bucket(struct MimirBuckets *me)
         return false;
     }
     real_index = get_real_bucket_index(me, me->newest_bucket);
-    ++me->buckets[real_index];
+    add_to_real_bucket(me, real_index, 1);
     me->sum_of_bucket_indices += me->newest_bucket;
     return true;
 }
@@ -77,7 +84,7 @@ MimirBuckets__decrement_bucket(struct MimirBuckets *me,
     }
 
     real_index = get_real_bucket_index(me, bucket_index);
-    --me->buckets[real_index];
+    add_to_real_bucket(me, real_index, (uint64_t)-1);
     me->sum_of_bucket_indices -= bucket_index;
     return true;
 }
@@ -174,6 +181,8 @@ MimirBuckets__stacker_aging_policy(struct MimirBuckets *me,
         me->sum_of_bucket_indices -= me->buckets[old_real_index];
         me->buckets[old_real_index] = 0;
     }
+    // NOTE We shifted O(B) buckets, so it is no slower to rebuild the tree.
+    count_tree_rebuild(me);
     return true;
 }
 
@@ -191,8 +200,8 @@ MimirBuckets__age_by_one_bucket(struct MimirBuckets *me,
     //      positive.
     new_real_index =
         get_real_bucket_index(me, bucket_index + me->num_buckets - 1);
-    --me->buckets[old_real_index];
-    ++me->buckets[new_real_index];
+    add_to_real_bucket(me, old_real_index, (uint64_t)-1);
+    add_to_real_bucket(me, new_real_index, 1);
     // We are aging the bucket by 1, which means that it moves to a lower
     // bucket.
     me->sum_of_bucket_indices -= 1;
@@ -212,9 +221,10 @@ MimirBuckets__rounder_aging_policy(struct MimirBuckets *me)
     // All of the elements in the old-oldest bucket will be made newer by 1. We
     // do not use the me->sum_of_bucket_indices in the Rounder aging policy, but
     // I am doing this to better aid debugging.
-    me->sum_of_bucket_indices += me->buckets[old_oldest_real_index];
-    me->buckets[new_oldest_real_index] += me->buckets[old_oldest_real_index];
-    me->buckets[old_oldest_real_index] = 0;
+    uint64_t const old_oldest_count = me->buckets[old_oldest_real_index];
+    me->sum_of_bucket_indices += old_oldest_count;
+    add_to_real_bucket(me, new_oldest_real_index, old_oldest_count);
+    add_to_real_bucket(me, old_oldest_real_index, -old_oldest_count);
     ++me->oldest_bucket;
     ++me->newest_bucket;
     return true;
@@ -232,12 +242,12 @@ MimirBuckets__get_stack_distance(struct MimirBuckets *me, uint64_t bucket_index)
     //      I do this because the minimum allowable value for the bucket index
     //      is the me->oldest_bucket.
     bucket_index = MAX(bucket_index, me->oldest_bucket);
-    status.start = 0;
-    // Iterate from one-past the resident bucket (i.e. time_stamp) and the
+    // Sum from one-past the resident bucket (i.e. time_stamp) to the
     // newest bucket.
-    for (uint64_t i = bucket_index + 1; i <= me->newest_bucket; ++i) {
-        status.start += me->buckets[i % me->num_buckets];
-    }
+    status.start =
+        bucket_index == me->newest_bucket
+            ? 0
+            : count_tree_range_sum(me, bucket_index + 1, me->newest_bucket);
     status.range = me->buckets[bucket_index % me->num_buckets];
     status.success = true;
     return status;
@@ -326,6 +336,14 @@ MimirBuckets__validate(struct MimirBuckets *me)
         assert(0);
         return false;
     }
+    uint64_t prefix_sum = 0;
+    for (uint64_t i = 0; i < me->num_buckets; ++i) {
+        prefix_sum += me->buckets[i];
+        if (count_tree_prefix_sum(me, i + 1) != prefix_sum) {
+            assert(0);
+            return false;
+        }
+    }
     return true;
 }
 
@@ -336,5 +354,6 @@ MimirBuckets__destroy(struct MimirBuckets *me)
         return;
     }
     free(me->buckets);
+    free(me->count_tree);
     *me = (struct MimirBuckets){0};
 }
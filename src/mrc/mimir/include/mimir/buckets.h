@@ -18,6 +18,11 @@
 //      for errors. Or at least try to.
 struct MimirBuckets {
     uint64_t *buckets;
+    // NOTE This is a Fenwick tree (i.e. binary indexed tree) over the
+    //      real (i.e. circular) bucket indices. It is 1-indexed, so it has
+    //      (num_buckets + 1) elements. It lets us sum the buckets newer than
+    //      a given bucket in O(log B) rather than O(B) time.
+    uint64_t *count_tree;
     uint64_t num_buckets;
     // NOTE In Mimir's terminology, the newest bucket is that with the largest
     //      number. Conversely, the oldest is the one with the smallest.
@@ -6,9 +6,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include <glib.h>
-
 #include "histogram/fractional_histogram.h"
+#include "lookup/k_hash_table.h"
 #include "mimir/buckets.h"
 #include "types/entry_type.h"
 
@@ -21,7 +20,16 @@ enum MimirAgingPolicy {
 };
 
 struct Mimir {
-    GHashTable *hash_table;
+    // NOTE This maps each entry to a stamp. For Rounder, the stamp is the
+    //      bucket index. For Stacker, the stamp is an epoch, which we map
+    //      to a bucket index with 'epoch_starts'. This is so that Stacker
+    //      does not need to iterate through (and age) every entry in the
+    //      hash table.
+    struct KHashTable hash_table;
+    // NOTE The first epoch in each (real) bucket. This is non-decreasing
+    //      from the oldest to the newest bucket. Only used by Stacker.
+    uint64_t *epoch_starts;
+    uint64_t current_epoch;
     struct MimirBuckets buckets;
     struct FractionalHistogram histogram;
     enum MimirAgingPolicy aging_policy;
@@ -5,11 +5,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <glib.h>
+#include <inttypes.h>
 #include <sys/types.h>
 
 #include "histogram/fractional_histogram.h"
 #include "logger/logger.h"
+#include "lookup/k_hash_table.h"
+#include "lookup/lookup.h"
 #include "math/positive_ceiling_divide.h"
 #include "types/entry_type.h"
 
@@ -17,35 +19,63 @@
 #include "mimir/mimir.h"
 #include "unused/mark_unused.h"
 
-static gboolean
-entry_compare(gconstpointer a, gconstpointer b)
-{
-    return (a == b) ? TRUE : FALSE;
-}
-
 static void
 stacker_aging_policy(struct Mimir *me)
 {
-    assert(me != NULL && me->hash_table != NULL);
-    GHashTableIter iter;
-    g_hash_table_iter_init(&iter, me->hash_table);
-
-    uint64_t entry = 0, bucket_index = 0;
+    assert(me != NULL && me->epoch_starts != NULL);
     uint64_t average_stack_distance_bucket =
         MimirBuckets__get_average_bucket_index(&me->buckets);
-    while (g_hash_table_iter_next(&iter,
-                                  (gpointer *)&entry,
-                                  (gpointer *)&bucket_index) == TRUE) {
-        if (bucket_index >= average_stack_distance_bucket) {
-            g_hash_table_iter_replace(&iter, (gpointer)(bucket_index - 1));
+    if (!MimirBuckets__stacker_aging_policy(&me->buckets,
+                                            average_stack_distance_bucket)) {
+        return;
+    }
+    // NOTE Rather than decrementing the bucket index of every entry at or
+    //      above the average bucket, we merge the average bucket's epochs
+    //      into the next older bucket and shift the newer buckets' epochs
+    //      down by one. This is O(B) rather than O(N) and gives the same
+    //      bucket for every entry. Stacker never moves the oldest bucket,
+    //      so the logical and real bucket indices are equal.
+    for (uint64_t i = average_stack_distance_bucket;
+         i < me->buckets.newest_bucket;
+         ++i) {
+        me->epoch_starts[i] = me->epoch_starts[i + 1];
+    }
+    ++me->current_epoch;
+    me->epoch_starts[me->buckets.newest_bucket] = me->current_epoch;
+}
+
+/// @brief  Get the stamp that we store in the hash table for an entry
+///         that we put into the newest bucket.
+static uint64_t
+get_newest_stamp(struct Mimir *me)
+{
+    assert(me != NULL);
+    if (me->aging_policy == MIMIR_STACKER) {
+        return me->current_epoch;
+    }
+    return MimirBuckets__get_newest_bucket_index(&me->buckets);
+}
+
+/// @brief  Map a stamp from the hash table to its current bucket index.
+static uint64_t
+get_bucket_index(struct Mimir *me, uint64_t const stamp)
+{
+    assert(me != NULL);
+    if (me->aging_policy != MIMIR_STACKER) {
+        return stamp;
+    }
+    // Binary search for the newest bucket whose first epoch is at or before
+    // the stamp. The oldest bucket always starts at epoch 0.
+    uint64_t lo = me->buckets.oldest_bucket, hi = me->buckets.newest_bucket;
+    while (lo < hi) {
+        uint64_t const mid = lo + (hi - lo + 1) / 2;
+        if (me->epoch_starts[mid] <= stamp) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
         }
     }
-    // NOTE To optimize this repeated function call away, we could
-    //      age the counts of each buckets (i.e. factor this
-    //      function out of the loop). This is a future task, since
-    //      I want to get the algorithm working as described.
-    MimirBuckets__stacker_aging_policy(&me->buckets,
-                                       average_stack_distance_bucket);
+    return lo;
 }
 
 static void
@@ -68,8 +98,9 @@ age(struct Mimir *me)
 }
 
 static void
-hit(struct Mimir *me, EntryType entry, uint64_t bucket_index)
+hit(struct Mimir *me, EntryType entry, uint64_t stamp)
 {
+    uint64_t bucket_index = get_bucket_index(me, stamp);
     // Adjust the last bucket for the Rounder aging policy
     if (me->aging_policy == MIMIR_ROUNDER &&
         bucket_index < me->buckets.oldest_bucket) {
@@ -84,9 +115,10 @@ hit(struct Mimir *me, EntryType entry, uint64_t bucket_index)
         assert(0 && "newest_bucket should be non-zero");
         exit(EXIT_FAILURE);
     }
-    g_hash_table_replace(me->hash_table,
-                         (gpointer)entry,
-                         (gpointer)newest_bucket);
+    if (KHashTable__put(&me->hash_table, entry, get_newest_stamp(me)) !=
+        LOOKUP_PUTUNIQUE_REPLACE_VALUE) {
+        LOGGER_ERROR("failed to replace entry %" PRIu64, entry);
+    }
     // TODO(dchu): Maybe record the infinite distances for Parda!
 
     // Update histogram
@@ -121,9 +153,10 @@ miss(struct Mimir *me, EntryType entry)
         assert(0 && "newest_bucket should be non-zero");
         exit(EXIT_FAILURE);
     }
-    g_hash_table_insert(me->hash_table,
-                        (gpointer)entry,
-                        (gpointer)newest_bucket);
+    if (KHashTable__put(&me->hash_table, entry, get_newest_stamp(me)) !=
+        LOOKUP_PUTUNIQUE_INSERT_KEY_VALUE) {
+        LOGGER_ERROR("failed to insert entry %" PRIu64, entry);
+    }
 
     // Update the histogram
     FractionalHistogram__insert_scaled_infinite(&me->histogram, 1);
@@ -157,14 +190,20 @@ Mimir__init(struct Mimir *me,
     if (!r) {
         goto histogram_error;
     }
-    // NOTE Using the g_direct_hash function means that we need to pass our
-    //      entries as pointers to the hash table. It also means we cannot
-    //      destroy the values at the pointers, because the pointers are our
-    //      actual values!
-    me->hash_table = g_hash_table_new(g_direct_hash, entry_compare);
-    if (me->hash_table == NULL) {
+    r = KHashTable__init(&me->hash_table);
+    if (!r) {
         goto hash_table_error;
     }
+    // NOTE Every bucket starts at epoch 0, which means that the entries are
+    //      all put into the newest bucket until we first age.
+    me->epoch_starts = NULL;
+    me->current_epoch = 0;
+    if (aging_policy == MIMIR_STACKER) {
+        me->epoch_starts = calloc(num_buckets, sizeof(*me->epoch_starts));
+        if (me->epoch_starts == NULL) {
+            goto epoch_starts_error;
+        }
+    }
 
     // Initialize other things
     me->aging_policy = aging_policy;
@@ -172,6 +211,8 @@ Mimir__init(struct Mimir *me,
 
 // NOTE These are in reverse order so we perform the appropriate deconstruction
 //      upon an error.
+epoch_starts_error:
+    KHashTable__destroy(&me->hash_table);
 hash_table_error:
     FractionalHistogram__destroy(&me->histogram);
 histogram_error:
@@ -183,32 +224,19 @@ buckets_error:
 void
 Mimir__access_item(struct Mimir *me, EntryType entry)
 {
-    gboolean found = FALSE;
-    uint64_t bucket_index = 0;
     if (me == NULL) {
         return;
     }
 
-    found = g_hash_table_lookup_extended(me->hash_table,
-                                         (gconstpointer)entry,
-                                         NULL,
-                                         (gpointer *)&bucket_index);
-    if (found) {
-        hit(me, entry, bucket_index);
+    struct LookupReturn found = KHashTable__lookup(&me->hash_table, entry);
+    if (found.success) {
+        hit(me, entry, found.timestamp);
     } else {
         miss(me, entry);
     }
 }
 
-static void
-print_key_value(gpointer key, gpointer value, gpointer unused_user_data)
-{
-    EntryType entry = (EntryType)key;
-    uint64_t bucket_index = (uint64_t)value;
-    printf("\"%" PRIu64 "\": %" PRIu64 ", ", entry, bucket_index);
-    UNUSED(unused_user_data);
-}
-
+/// @note    For Stacker, this prints the epochs rather than bucket indices.
 void
 Mimir__print_hash_table(struct Mimir *me)
 {
@@ -216,9 +244,7 @@ Mimir__print_hash_table(struct Mimir *me)
         printf("{\"type\": null}\n");
         return;
     }
-    printf("{");
-    g_hash_table_foreach(me->hash_table, print_key_value, NULL);
-    printf("}\n");
+    KHashTable__write(&me->hash_table, stdout, true);
 }
 
 void
@@ -249,7 +275,8 @@ Mimir__validate(struct Mimir *me)
         assert(0);
         return false;
     }
-    if (me->buckets.num_unique_entries != g_hash_table_size(me->hash_table)) {
+    if (me->buckets.num_unique_entries !=
+        KHashTable__get_size(&me->hash_table)) {
         assert(0);
         return false;
     }
@@ -269,8 +296,7 @@ Mimir__destroy(struct Mimir *me)
     }
     FractionalHistogram__destroy(&me->histogram);
     MimirBuckets__destroy(&me->buckets);
-    if (me->hash_table != NULL) {
-        g_hash_table_destroy(me->hash_table);
-    }
+    KHashTable__destroy(&me->hash_table);
+    free(me->epoch_starts);
     *me = (struct Mimir){0};
 }
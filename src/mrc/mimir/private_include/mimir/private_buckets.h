@@ -13,6 +13,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "arrays/fenwick_tree.h"
 #include "math/positive_ceiling_divide.h"
 #include "mimir/buckets.h"
 
@@ -69,3 +70,62 @@ count_weighted_sum_of_bucket_indices(struct MimirBuckets *me)
     }
     return sum_of_bucket_indices;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+/// FENWICK TREE OVER THE REAL BUCKET INDICES
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief  Add 'delta' to the bucket with the real index 'real_index' and
+///         update the tree accordingly.
+/// @note   The delta may be "negative" because unsigned arithmetic wraps.
+static inline void
+add_to_real_bucket(struct MimirBuckets *me,
+                   uint64_t const real_index,
+                   uint64_t const delta)
+{
+    assert(me != NULL && me->count_tree != NULL &&
+           real_index < me->num_buckets);
+    me->buckets[real_index] += delta;
+    fenwick_tree_add(me->count_tree, me->num_buckets, real_index, delta);
+}
+
+/// @brief  Sum the buckets with real indices 0..real_index (exclusive).
+static inline uint64_t
+count_tree_prefix_sum(struct MimirBuckets *me, uint64_t const real_index)
+{
+    assert(me != NULL && me->count_tree != NULL &&
+           real_index <= me->num_buckets);
+    return fenwick_tree_prefix_sum(me->count_tree, real_index);
+}
+
+/// @brief  Rebuild the tree from the buckets in O(B) time. This is for when
+///         we change many buckets at once (or behind the tree's back).
+static inline void
+count_tree_rebuild(struct MimirBuckets *me)
+{
+    assert(me != NULL && me->count_tree != NULL && me->buckets != NULL);
+    fenwick_tree_build(me->count_tree,
+                       me->num_buckets,
+                       me->buckets,
+                       sizeof(*me->buckets));
+}
+
+/// @brief  Sum the buckets with logical indices in [first, last].
+/// @note   The range must not span more than num_buckets buckets, but it
+///         may wrap around the end of the circular buffer.
+static inline uint64_t
+count_tree_range_sum(struct MimirBuckets *me,
+                     uint64_t const first,
+                     uint64_t const last)
+{
+    assert(me != NULL && first <= last && last - first < me->num_buckets);
+    uint64_t const first_real = first % me->num_buckets;
+    uint64_t const last_real = last % me->num_buckets;
+    if (first_real <= last_real) {
+        return count_tree_prefix_sum(me, last_real + 1) -
+               count_tree_prefix_sum(me, first_real);
+    }
+    return count_tree_prefix_sum(me, me->num_buckets) -
+           count_tree_prefix_sum(me, first_real) +
+           count_tree_prefix_sum(me, last_real + 1);
+}
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "arrays/fenwick_tree.h"
 #include "types/time_stamp_type.h"
 
 #include "quickmrc/buckets.h"
@@ -18,10 +19,15 @@ QuickMRCBuckets__init(struct QuickMRCBuckets *me,
     if (me == NULL || default_num_buckets == 0)
         return false;
     void *buf = calloc(default_num_buckets, sizeof(*me->buckets));
-    if (buf == NULL)
+    uint64_t *tree = calloc(default_num_buckets + 1, sizeof(*tree));
+    if (buf == NULL || tree == NULL) {
+        free(buf);
+        free(tree);
         return false;
+    }
     const struct QuickMRCBuckets tmp = (struct QuickMRCBuckets){
         .buckets = (struct TimestampRangeCount *)buf,
+        .count_tree = tree,
         .num_buckets = default_num_buckets,
         .default_num_buckets = default_num_buckets,
         .max_bucket_size = max_bucket_size,
@@ -32,6 +38,45 @@ QuickMRCBuckets__init(struct QuickMRCBuckets *me,
     return true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// FENWICK TREE OVER THE BUCKET COUNTS
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief  Add 'delta' to the count of bucket 'idx'.
+/// @note   The delta may be "negative" because unsigned arithmetic wraps.
+static inline void
+count_tree_add(struct QuickMRCBuckets *me, uint64_t idx, uint64_t delta)
+{
+    assert(me != NULL && me->count_tree != NULL && idx < me->num_buckets);
+    fenwick_tree_add(me->count_tree, me->num_buckets, idx, delta);
+}
+
+/// @brief  Sum the counts of buckets 0..=idx.
+static inline uint64_t
+count_tree_prefix_sum(struct QuickMRCBuckets *me, uint64_t idx)
+{
+    assert(me != NULL && me->count_tree != NULL && idx < me->num_buckets);
+    return fenwick_tree_prefix_sum(me->count_tree, idx + 1);
+}
+
+/// @brief  Rebuild the tree after the counts of the first num_changed
+///         buckets have changed without changing their total.
+static void
+count_tree_rebuild_prefix(struct QuickMRCBuckets *me, uint64_t num_changed)
+{
+    assert(me != NULL && me->count_tree != NULL && me->buckets != NULL);
+    assert(0 < num_changed && num_changed <= me->num_buckets);
+    fenwick_tree_rebuild_prefix(me->count_tree,
+                                me->num_buckets,
+                                num_changed,
+                                &me->buckets[0].count,
+                                sizeof(*me->buckets));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// BUCKET OPERATIONS
+////////////////////////////////////////////////////////////////////////////////
+
 static bool
 is_newest_bucket_full(struct QuickMRCBuckets *me)
 {
@@ -100,6 +145,9 @@ age(struct QuickMRCBuckets *me)
     me->buckets[0] =
         (struct TimestampRangeCount){.count = 0,
                                      .max_timestamp = me->timestamp};
+    // NOTE Merging and shifting only changes buckets 0..=(min_pair + 1)
+    //      and it does not change their total count.
+    count_tree_rebuild_prefix(me, min_pair + 2);
     return true;
 }
 
@@ -108,6 +156,7 @@ increment_newest_bucket(struct QuickMRCBuckets *me)
 {
     assert(me != NULL && me->buckets != NULL);
     ++me->buckets[0].count;
+    count_tree_add(me, 0, 1);
     if (is_newest_bucket_full(me)) {
         if (!age(me))
             return false;
@@ -126,25 +175,51 @@ QuickMRCBuckets__insert_new(struct QuickMRCBuckets *me)
     return true;
 }
 
+/// @brief  Whether the bucket covers timestamps at or before 'old_timestamp'.
+/// @note   A max_timestamp of zero means the bucket is unused (or the very
+///         first bucket), so it catches everything.
+static inline bool
+is_bucket_at_or_before(struct QuickMRCBuckets *me,
+                       uint64_t idx,
+                       TimeStampType old_timestamp)
+{
+    return me->buckets[idx].max_timestamp == 0 ||
+           me->buckets[idx].max_timestamp < old_timestamp;
+}
+
+/// @brief  Find the newest bucket that covers the old timestamp.
+/// @note   Since the max_timestamps are non-increasing from newest to
+///         oldest, the predicate is false for a prefix of the buckets and
+///         true for the rest. We binary search for the boundary. If no
+///         bucket matches, then we return the oldest bucket.
+static uint64_t
+find_bucket(struct QuickMRCBuckets *me, TimeStampType old_timestamp)
+{
+    assert(me != NULL && me->buckets != NULL && me->num_buckets > 0);
+    uint64_t lo = 0, hi = me->num_buckets - 1;
+    while (lo < hi) {
+        uint64_t const mid = lo + (hi - lo) / 2;
+        if (is_bucket_at_or_before(me, mid, old_timestamp)) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
 /// Get the stack distance of a timestamp and decrement that timestamp.
 static uint64_t
 get_stack_distance_and_decrement(struct QuickMRCBuckets *me,
                                  TimeStampType old_timestamp)
 {
-    uint64_t stack_dist = 0;
     assert(me != NULL && me->buckets != NULL);
-    for (uint64_t i = 0; i < me->num_buckets; ++i) {
-        stack_dist += me->buckets[i].count;
-        if (me->buckets[i].max_timestamp == 0 ||
-            me->buckets[i].max_timestamp < old_timestamp) {
-            --me->buckets[i].count;
-            assert(stack_dist > 0 && "stack_dist should be at least 1");
-            return stack_dist - 1;
-        }
-    }
-    --me->buckets[me->num_buckets - 1].count;
+    uint64_t const idx = find_bucket(me, old_timestamp);
+    uint64_t const stack_dist = count_tree_prefix_sum(me, idx);
+    --me->buckets[idx].count;
+    count_tree_add(me, idx, (uint64_t)-1);
     assert(stack_dist > 0 && "stack_dist should be at least 1");
-    return stack_dist - 1; /* Found in oldest bucket */
+    return stack_dist - 1;
 }
 
 /// Decrement a bucket corresponding to the old timestamp. Get the stack
@@ -190,6 +265,7 @@ QuickMRCBuckets__destroy(struct QuickMRCBuckets *me)
     if (me == NULL)
         return;
     free(me->buckets);
+    free(me->count_tree);
     memset(me, 0, sizeof(*me));
     return;
 }
@@ -17,8 +17,16 @@ struct TimestampRangeCount {
     uint64_t count;
 };
 
+/// @note    The buckets are ordered from newest (index 0) to oldest, so the
+///          max_timestamps are non-increasing. This lets us binary search
+///          for the bucket that covers an old timestamp. The Fenwick tree
+///          (i.e. binary indexed tree) over the buckets' counts gives us
+///          the stack distance (i.e. the sum of the newer buckets' counts)
+///          in O(log N) rather than O(N) time.
 struct QuickMRCBuckets {
     struct TimestampRangeCount *buckets;
+    // NOTE This is 1-indexed, so it has (num_buckets + 1) elements.
+    uint64_t *count_tree;
     const uint64_t num_buckets;
     const uint64_t default_num_buckets;
     uint64_t max_bucket_size;
@@ -6,7 +6,7 @@
 #include "hash/types.h"
 #include "logger/logger.h"
 #include "math/ratio.h"
-#include "priority_queue/heap.h"
+#include "priority_queue/radix_priority_queue.h"
 #include "shards/fixed_size_shards_sampler.h"
 #include "types/entry_type.h"
 
@@ -21,7 +21,7 @@ FixedSizeShardsSampler__init(struct FixedSizeShardsSampler *const me,
         LOGGER_WARN("bad input");
         return false;
     }
-    if (!Heap__init_max_heap(&me->pq, max_size)) {
+    if (!RadixPriorityQueue__init(&me->pq, max_size)) {
         LOGGER_WARN("failed to initialize priority queue");
         goto cleanup;
     }
@@ -39,7 +39,7 @@ FixedSizeShardsSampler__init(struct FixedSizeShardsSampler *const me,
     };
     return true;
 cleanup:
-    Heap__destroy(&me->pq);
+    RadixPriorityQueue__destroy(&me->pq);
     return false;
 }
 
@@ -49,7 +49,7 @@ FixedSizeShardsSampler__destroy(struct FixedSizeShardsSampler *const me)
     if (me == NULL) {
         return;
     }
-    Heap__destroy(&me->pq);
+    RadixPriorityQueue__destroy(&me->pq);
     *me = (struct FixedSizeShardsSampler){0};
 }
 
@@ -73,22 +73,15 @@ make_room(struct FixedSizeShardsSampler *me,
           void (*eviction_hook)(void *data, EntryType key),
           void *eviction_data)
 {
-    EntryType entry = 0;
-
     if (me == NULL) {
         return;
     }
-    Hash64BitType max_hash = Heap__get_top_key(&me->pq);
-    while (Heap__remove(&me->pq, max_hash, &entry)) {
-        // This is where one would remove the entry/time-stamp from the
-        // hash table and tree.
-        if (eviction_hook != NULL) {
-            eviction_hook(eviction_data, entry);
-        }
-    }
+    // This is where one would remove the entry/time-stamp from the
+    // hash table and tree.
+    RadixPriorityQueue__remove_top(&me->pq, eviction_hook, eviction_data);
     // No more elements with the old max_hash. Now we can update the new
     //  sampling_ratio, threshold, and scale!
-    Hash64BitType new_max_hash = Heap__get_top_key(&me->pq);
+    Hash64BitType new_max_hash = RadixPriorityQueue__get_top_key(&me->pq);
     set_sampling_rate(me, new_max_hash);
     return;
 }
@@ -113,10 +106,12 @@ FixedSizeShardsSampler__insert(struct FixedSizeShardsSampler *me,
                                void (*eviction_hook)(void *data, EntryType key),
                                void *eviction_data)
 {
-    if (Heap__is_full(&me->pq)) {
+    if (RadixPriorityQueue__is_full(&me->pq)) {
         make_room(me, eviction_hook, eviction_data);
     }
-    if (!Heap__insert_if_room(&me->pq, Hash64Bit(entry), entry)) {
+    if (!RadixPriorityQueue__insert_if_room(&me->pq,
+                                            Hash64Bit(entry),
+                                            entry)) {
         return false;
     }
     return true;
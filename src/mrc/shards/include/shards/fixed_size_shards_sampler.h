@@ -3,7 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#include "priority_queue/heap.h"
+#include "priority_queue/radix_priority_queue.h"
 #include "types/entry_type.h"
 
 struct FixedSizeShardsSampler {
@@ -12,7 +12,9 @@ struct FixedSizeShardsSampler {
     uint64_t scale;
 
     // Fixed-Size SHARDS
-    struct Heap pq;
+    // NOTE I use a radix queue rather than a heap because we only ever
+    //      evict the maximum hash and the maximum only ever shrinks.
+    struct RadixPriorityQueue pq;
 
     // SHARDS Adjustment Parameters -- not supported yet!
     bool adjustment;
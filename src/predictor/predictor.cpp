@@ -7,18 +7,18 @@
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
-#include <map>
 #include <optional>
 #include <sys/types.h>
 #include <unordered_map>
 #include <vector>
 
 #include "cache_metadata/cache_access.hpp"
-#include "cache_metadata/cache_metadata.hpp"
+#include "cache_metadata/packed_cache_metadata.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "logger/logger.h"
 #include "math/saturation_arithmetic.h"
 #include "trace/reader.h"
+#include "ttl_cache/timing_wheel.hpp"
 
 using size_t = std::size_t;
 using uint64_t = std::uint64_t;
@@ -75,70 +75,118 @@ public:
     uint64_t wrongly_expired_bytes_ = 0;
 };
 
-/// @brief  Remove a specific <key, value> pair from a multimap,
-///         specifically the first instance of that pair.
-template <typename K, typename V>
-static bool
-remove_multimap_kv(std::multimap<K, V> &me, K const k, V const v)
-{
-    for (auto it = me.lower_bound(k); it != me.upper_bound(k); ++it) {
-        if (it->second == v) {
-            me.erase(it);
-            return true;
-        }
-    }
-    return false;
-}
+/// @brief  A handle to an object in the PredictiveCache, i.e. its index
+///         in the slab of entries. It is stable for the object's lifetime.
+using EntryHandle = std::uint32_t;
 
 class PredictiveCache {
 private:
+    static constexpr EntryHandle NIL = UINT32_MAX;
+    // NOTE The LRU list is circular through a sentinel at index 0, so
+    //      the least recently used object is entries_[0].lru_next.
+    static constexpr EntryHandle LRU_SENTINEL = 0;
+
+    struct Entry {
+        uint64_t key;
+        // NOTE The metadata's times count from the first insertion. Its
+        //      size class rounds down, so I keep the exact size for the
+        //      byte counts.
+        PackedCacheMetadata metadata;
+        std::uint32_t size_bytes;
+        EntryHandle lru_prev;
+        EntryHandle lru_next;
+        // NOTE This is NIL for objects that never expire.
+        TimingWheel::Handle ttl_handle;
+    };
+
+    void
+    lru_unlink(EntryHandle const h)
+    {
+        Entry &e = entries_[h];
+        entries_[e.lru_prev].lru_next = e.lru_next;
+        entries_[e.lru_next].lru_prev = e.lru_prev;
+    }
+
+    void
+    lru_push_back(EntryHandle const h)
+    {
+        EntryHandle const back = entries_[LRU_SENTINEL].lru_prev;
+        entries_[h].lru_prev = back;
+        entries_[h].lru_next = LRU_SENTINEL;
+        entries_[back].lru_next = h;
+        entries_[LRU_SENTINEL].lru_prev = h;
+    }
+
+    EntryHandle
+    allocate_entry()
+    {
+        if (!free_entries_.empty()) {
+            EntryHandle const h = free_entries_.back();
+            free_entries_.pop_back();
+            return h;
+        }
+        assert(entries_.size() < NIL);
+        entries_.push_back(Entry{0,
+                                 PackedCacheMetadata(),
+                                 0,
+                                 LRU_SENTINEL,
+                                 LRU_SENTINEL,
+                                 NIL});
+        return static_cast<EntryHandle>(entries_.size() - 1);
+    }
+
     void
     insert(uint64_t const key,
            uint64_t const size_bytes,
            uint64_t access_time_ms,
            uint64_t const expiration_time_ms)
     {
-        map_.emplace(
-            key,
-            CacheMetadata{size_bytes, access_time_ms, expiration_time_ms});
+        EntryHandle const h = allocate_entry();
+        Entry &e = entries_[h];
+        if (!epoch_ms_) {
+            epoch_ms_ = access_time_ms;
+        }
+        assert(size_bytes <= UINT32_MAX);
+        e.key = key;
+        e.metadata = PackedCacheMetadata(*epoch_ms_,
+                                         size_bytes,
+                                         access_time_ms,
+                                         expiration_time_ms);
+        e.size_bytes = static_cast<std::uint32_t>(size_bytes);
+        // NOTE Objects without a TTL saturate to UINT64_MAX and would
+        //      never leave the timing wheel, so I do not schedule them.
+        e.ttl_handle = expiration_time_ms == UINT64_MAX
+                           ? NIL
+                           : ttl_cache_.schedule(h, expiration_time_ms);
+        map_.emplace(key, h);
         // TODO If we've filled the cache (i.e. steady-state) and have
         //      some wiggle room for uncertainty, then we can optionally
         //      not add to one of the caches.
-        lru_cache_.emplace(access_time_ms, key);
-        ttl_cache_.emplace(expiration_time_ms, key);
+        lru_push_back(h);
         size_ += size_bytes;
         inserted_bytes_ += size_bytes;
     }
 
-    bool
-    update(uint64_t const key, uint64_t const access_time_ms)
+    void
+    update(EntryHandle const h, uint64_t const access_time_ms)
     {
-        auto &metadata = map_.at(key);
-        uint64_t old_tm = metadata.last_access_time_ms_;
         // NOTE I do not allow the TTL to be updated after the first
         //      insertion. This is to simplify semantics.
-        metadata.visit(access_time_ms, {});
-        for (auto it = lru_cache_.lower_bound(old_tm);
-             it != lru_cache_.upper_bound(old_tm);
-             ++it) {
-            if (it->second == key) {
-                auto nh = lru_cache_.extract(it);
-                nh.key() = access_time_ms;
-                lru_cache_.insert(std::move(nh));
-                return true;
-            }
-        }
-        return false;
+        entries_[h].metadata.visit(*epoch_ms_, access_time_ms, {});
+        // NOTE Access times never decrease, so moving the object to the
+        //      back keeps the list sorted by last access time, with ties
+        //      in the order of access.
+        lru_unlink(h);
+        lru_push_back(h);
     }
 
     void
-    evict(uint64_t const victim_key, EvictionCause const cause)
+    evict(EntryHandle const h, EvictionCause const cause)
     {
-        bool erased_lru = false, erased_ttl = false;
-        CacheMetadata &m = map_.at(victim_key);
-        uint64_t sz_bytes = m.size_;
-        uint64_t last_access = m.last_access_time_ms_;
-        uint64_t exp_tm = m.expiration_time_ms_;
+        Entry &e = entries_[h];
+        uint64_t sz_bytes = e.size_bytes;
+        uint64_t last_access = e.metadata.get_last_access_time_ms(*epoch_ms_);
+        uint64_t exp_tm = e.metadata.get_expiration_time_ms(*epoch_ms_);
 
         // Update metadata tracking
         switch (cause) {
@@ -164,34 +212,33 @@ private:
         }
 
         // Evict from map.
-        map_.erase(victim_key);
+        std::size_t i_erased = map_.erase(e.key);
+        assert(i_erased == 1);
         size_ -= sz_bytes;
         // Evict from LRU queue.
-        erased_lru = remove_multimap_kv(lru_cache_, last_access, victim_key);
-        if (!erased_lru) {
-            LOGGER_WARN("could not evict from LRU");
-        }
-        // Evict from TTL queue.
-        erased_ttl = remove_multimap_kv(ttl_cache_, exp_tm, victim_key);
-        if (!erased_ttl) {
-            LOGGER_WARN("could not evict from TTL");
+        lru_unlink(h);
+        // Evict from TTL queue. NOTE The timing wheel removes expired
+        // objects itself, so they arrive here with a NIL handle.
+        if (e.ttl_handle != NIL) {
+            ttl_cache_.erase(e.ttl_handle);
+            e.ttl_handle = NIL;
         }
+        free_entries_.push_back(h);
     }
 
     void
     evict_expired_objects(uint64_t const current_time_ms)
     {
-        std::vector<uint64_t> victims;
-        for (auto [exp_tm, key] : ttl_cache_) {
-            if (exp_tm >= current_time_ms) {
-                break;
-            }
-            victims.push_back(key);
-        }
-        // One cannot erase elements from a multimap while also iterating!
-        for (auto victim : victims) {
-            evict(victim, EvictionCause::TTL);
+        // NOTE Objects expire strictly after their expiration time,
+        //      whereas the timing wheel drains everything up to and
+        //      including the time that we give it.
+        if (current_time_ms == 0) {
+            return;
         }
+        ttl_cache_.drain_expired(current_time_ms - 1, [this](uint64_t h) {
+            entries_[h].ttl_handle = NIL;
+            evict(static_cast<EntryHandle>(h), EvictionCause::TTL);
+        });
     }
 
     bool
@@ -214,31 +261,24 @@ private:
             return false;
         }
         uint64_t evicted_bytes = 0;
-        std::vector<uint64_t> victims;
         // Otherwise, make room in the cache for the new object.
-        for (auto [tm, key] : lru_cache_) {
-            if (evicted_bytes >= nbytes) {
-                break;
-            }
-            evicted_bytes += map_.at(key).size_;
+        while (evicted_bytes < nbytes &&
+               entries_[LRU_SENTINEL].lru_next != LRU_SENTINEL) {
+            EntryHandle const victim = entries_[LRU_SENTINEL].lru_next;
+            Entry const &e = entries_[victim];
+            evicted_bytes += e.size_bytes;
             last_evicted_ =
-                std::max(last_evicted_, map_.at(key).last_access_time_ms_);
-            victims.push_back(key);
-        }
-        // One cannot evict elements from the map one is iterating over.
-        for (auto v : victims) {
-            evict(v, EvictionCause::LRU);
+                std::max(last_evicted_,
+                         e.metadata.get_last_access_time_ms(*epoch_ms_));
+            evict(victim, EvictionCause::LRU);
         }
         return true;
     }
 
     void
-    hit(CacheAccess const &access)
+    hit(CacheAccess const &access, EntryHandle const h)
     {
-        bool r = update(access.key, access.timestamp_ms);
-        if (!r) {
-            LOGGER_ERROR("could not update on hit");
-        }
+        update(h, access.timestamp_ms);
         statistics_.hit(access.size_bytes);
     }
 
@@ -272,8 +312,8 @@ public:
         int err = 0;
         current_time_ms_ = access.timestamp_ms;
         evict_expired_objects(access.timestamp_ms);
-        if (map_.count(access.key)) {
-            hit(access);
+        if (auto it = map_.find(access.key); it != map_.end()) {
+            hit(access, it->second);
         } else {
             if ((err = miss(access))) {
                 LOGGER_WARN("cannot handle miss");
@@ -302,13 +342,14 @@ public:
         return capacity_;
     }
 
-    CacheMetadata const *
+    PackedCacheMetadata const *
     get(uint64_t const key)
     {
-        if (map_.count(key)) {
-            return &map_.at(key);
+        auto it = map_.find(key);
+        if (it == map_.end()) {
+            return nullptr;
         }
-        return nullptr;
+        return &entries_[it->second].metadata;
     }
 
     void
@@ -317,13 +358,18 @@ public:
         std::cout << "> PredictiveCache(sz: " << size_ << ", cap: " << capacity_
                   << ")\n";
         std::cout << "> \tLRU: ";
-        for (auto [tm, key] : lru_cache_) {
-            std::cout << key << "@" << tm << ", ";
+        for (EntryHandle h = entries_[LRU_SENTINEL].lru_next;
+             h != LRU_SENTINEL;
+             h = entries_[h].lru_next) {
+            std::cout << entries_[h].key << "@"
+                      << entries_[h].metadata.get_last_access_time_ms(
+                             epoch_ms_.value_or(0))
+                      << ", ";
         }
         std::cout << "\n";
         std::cout << "> \tTTL: ";
-        for (auto [tm, key] : ttl_cache_) {
-            std::cout << key << "@" << tm << ", ";
+        for (auto [tm, h] : ttl_cache_.get_entries_in_expiration_order()) {
+            std::cout << entries_[h].key << "@" << tm << ", ";
         }
         std::cout << "\n";
     }
@@ -366,15 +412,21 @@ private:
     CacheStatistics statistics_;
 
     uint64_t current_time_ms_ = 0;
+    // The time of the first insertion, from which the metadata counts.
+    std::optional<uint64_t> epoch_ms_;
     // The maximum access time associated with any evicted object.
     uint64_t last_evicted_ = 0;
 
-    // Maps key to [last access time, expiration time]
-    std::unordered_map<uint64_t, CacheMetadata> map_;
-    // Maps last access time to keys.
-    std::multimap<uint64_t, uint64_t> lru_cache_;
-    // Maps expiration time to keys.
-    std::multimap<uint64_t, uint64_t> ttl_cache_;
+    // Maps key to its entry's handle.
+    std::unordered_map<uint64_t, EntryHandle> map_;
+    // The entries, which hold each object's metadata and its links in
+    // the LRU list (sorted by last access time). Index 0 is the LRU
+    // list's sentinel.
+    std::vector<Entry> entries_ = {
+        Entry{0, PackedCacheMetadata(), 0, LRU_SENTINEL, LRU_SENTINEL, NIL}};
+    std::vector<EntryHandle> free_entries_;
+    // Orders entry handles by expiration time.
+    TimingWheel ttl_cache_;
 };
 
 bool
@@ -473,15 +525,16 @@ main(int argc, char *argv[])
         assert(test_ttl());
         std::cout << "OK!" << std::endl;
         break;
-    case 3:
+    case 3: {
+        // NOTE I decode the trace once and share it between capacities.
+        CacheAccessTrace const trace(argv[1],
+                                     parse_trace_format_string(argv[2]));
         for (int i = 1; i < 11; ++i) {
-            assert(test_trace(
-                CacheAccessTrace(argv[1], parse_trace_format_string(argv[2])),
-                i * (size_t)1 << 30,
-                1.0));
+            assert(test_trace(trace, i * (size_t)1 << 30, 1.0));
         }
         std::cout << "OK!" << std::endl;
         break;
+    }
     default:
         std::cout << "Usage: predictor [<trace> <format>]" << std::endl;
         exit(1);
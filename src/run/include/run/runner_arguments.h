@@ -57,6 +57,7 @@ print_available_algorithms(FILE *stream);
 ///     - Size of histogram bins [optional. Default = 1]
 ///     - Histogram overflow strategy [optional. Default = reallocate]
 ///     - SHARDS adjustment [optional. Default = true for Fixed-Rate SHARDS]
+///     - Snapshot interval [optional. Default = 0, i.e. no snapshots]
 ///     The oracle contains:
 ///     - MRC path [both input/output]
 ///     - Histogram path [both input/output]
@@ -92,6 +93,9 @@ struct RunnerArguments {
     bool shards_adj;
     // The number of buckets allotted to the QuickMRC buffers.
     size_t qmrc_size;
+    // The number of accesses between snapshots of the MRC, or zero to
+    // not take any.
+    size_t snapshot_interval;
 
     struct Dictionary dictionary;
 };
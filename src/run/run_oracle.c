@@ -122,11 +122,11 @@ run_oracle(char const *const restrict trace_path,
         LOGGER_ERROR("failed to initialize MRC");
         goto cleanup_error;
     }
-    if (!Histogram__save(&olken.histogram, args->hist_path)) {
+    if (!Histogram__save_binary(&olken.histogram, args->hist_path, true)) {
         LOGGER_ERROR("failed to save histogram to '%s'", args->hist_path);
         goto cleanup_error;
     }
-    if (!MissRateCurve__save(&mrc, args->mrc_path)) {
+    if (!MissRateCurve__save_binary(&mrc, args->mrc_path, false)) {
         LOGGER_ERROR("failed to save MRC to '%s'", args->mrc_path);
         goto cleanup_error;
     }
@@ -199,11 +199,13 @@ run_oracle_with_ttl(char const *const restrict trace_path,
         LOGGER_ERROR("failed to initialize MRC");
         goto cleanup_error;
     }
-    if (!Histogram__save(&olken.olken.histogram, args->hist_path)) {
+    if (!Histogram__save_binary(&olken.olken.histogram,
+                                args->hist_path,
+                                true)) {
         LOGGER_ERROR("failed to save histogram to '%s'", args->hist_path);
         goto cleanup_error;
     }
-    if (!MissRateCurve__save(&mrc, args->mrc_path)) {
+    if (!MissRateCurve__save_binary(&mrc, args->mrc_path, false)) {
         LOGGER_ERROR("failed to save MRC to '%s'", args->mrc_path);
         goto cleanup_error;
     }
@@ -162,20 +162,26 @@ print_help(void)
             "<Algorithm>(runmode={run,tryread,onlyread},mrc=<file>,hist=<file>,"
             "sampling=<float64-in-[0,1]>,num_bins=<positive-int>,bin_size=<"
             "positive-int>,max_size=<positive-int>,mode={allow_overflow,merge_"
-            "bins,realloc},adj={true,false},qmrc_size=<positive-int>)\n");
+            "bins,realloc},adj={true,false},qmrc_size=<positive-int>,snapshot=<"
+            "positive-int>)\n");
     fprintf(LOGGER_STREAM,
             "    Example: "
             "Olken(runmode=run,mrc=olken-mrc.bin,hist=olken-hist.bin,sampling="
             "1.0,num_bins=100,bin_size=100,max_size=8000,mode=realloc,adj="
-            "false,qmrc_size=1)\n");
+            "false,qmrc_size=1,snapshot=1000000)\n");
     fprintf(LOGGER_STREAM,
             "    Default: "
             "<INVALID>(runmode=run,mrc=(null),hist=(null),sampling=1.0,num_"
             "bins=1048576,bin_size=1,max_size=8192,mode=realloc,adj=true,qmrc_"
-            "size=128)\n");
+            "size=128,snapshot=0)\n");
     fprintf(LOGGER_STREAM,
             "    Notes: we reserve the use of the characters '(),='. "
             "White spaces are not stripped.\n");
+    fprintf(LOGGER_STREAM,
+            "    Notes: snapshot=<N> logs a coarse MRC every N accesses. Only "
+            "Olken, Fixed-Rate-SHARDS, Fixed-Size-SHARDS, Evicting-Map, and "
+            "Evicting-QuickMRC support it; Average-Eviction-Time only builds "
+            "its histogram after the trace, so it warns and ignores it.\n");
     fprintf(LOGGER_STREAM,
             "    Notes: any unrecognized (or misspelled) parameters will be "
             "stored in the generic dictionary, whose values are also subject "
@@ -259,6 +265,12 @@ parse_argument_string(struct RunnerArguments *const me, bool *no_more_args)
             return false;
         }
         return parse_positive_size(&me->qmrc_size, value);
+    } else if (strcmp(param, "snapshot") == 0) {
+        if ((value = strtok(NULL, ",)")) == NULL) {
+            LOGGER_ERROR("invalid value for parameter '%s'", param);
+            return false;
+        }
+        return parse_positive_size(&me->snapshot_interval, value);
     } else if (strcmp(param, "help") == 0) {
         print_help();
         return false;
@@ -302,6 +314,7 @@ RunnerArguments__init(struct RunnerArguments *const me, char const *const str)
         .shards_adj = true,
         // NOTE This should give us approximately 1% error.
         .qmrc_size = 128,
+        .snapshot_interval = 0,
         .dictionary = (struct Dictionary){0},
     };
 
@@ -362,7 +375,7 @@ RunnerArguments__println(struct RunnerArguments const *const me, FILE *const fp)
     fprintf(fp,
             "RunnerArguments(algorithm=%s, mrc=%s, hist=%s, sampling=%g, "
             "num_bins=%zu, bin_size=%zu, max_size=%zu, mode=%s, adj=%s, "
-            "qmrc_size=%zu, dictionary=",
+            "qmrc_size=%zu, snapshot=%zu, dictionary=",
             algorithm_names[me->algorithm],
             maybe_string(me->mrc_path),
             maybe_string(me->hist_path),
@@ -372,7 +385,8 @@ RunnerArguments__println(struct RunnerArguments const *const me, FILE *const fp)
             me->max_size,
             HISTOGRAM_MODE_STRINGS[me->out_of_bounds_mode],
             bool_to_string(me->shards_adj),
-            me->qmrc_size);
+            me->qmrc_size,
+            me->snapshot_interval);
     Dictionary__write(&me->dictionary, fp, false);
     fprintf(fp, ")\n");
     return true;
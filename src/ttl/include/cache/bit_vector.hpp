@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief  A fixed-size vector of bits packed into 64-bit words.
+/// @note   I use this instead of std::vector<bool> so that we can scan
+///         for set or cleared bits a word at a time.
+class BitVector {
+    std::vector<std::uint64_t> words_;
+
+public:
+    BitVector(std::size_t const num_bits = 0)
+        : words_((num_bits + 63) / 64, 0)
+    {
+    }
+
+    bool
+    get(std::size_t const i) const
+    {
+        return (words_[i / 64] >> (i % 64)) & 1;
+    }
+
+    void
+    set(std::size_t const i)
+    {
+        words_[i / 64] |= (std::uint64_t)1 << (i % 64);
+    }
+
+    void
+    clear(std::size_t const i)
+    {
+        words_[i / 64] &= ~((std::uint64_t)1 << (i % 64));
+    }
+
+    void
+    assign(std::size_t const i, bool const value)
+    {
+        if (value) {
+            set(i);
+        } else {
+            clear(i);
+        }
+    }
+
+    /// @brief  Clear bits in [begin, end) until we reach one that is
+    ///         already clear.
+    /// @return The index of the first bit that was already clear or
+    ///         'end' if there is none.
+    std::size_t
+    clear_run(std::size_t const begin, std::size_t const end)
+    {
+        std::size_t i = begin;
+        while (i < end) {
+            std::size_t const offset = i % 64;
+            std::uint64_t &word = words_[i / 64];
+            std::uint64_t const clear_bits = ~word >> offset;
+            if (clear_bits != 0) {
+                std::size_t const n = __builtin_ctzll(clear_bits);
+                // NOTE Clear the 'n' set bits that we skipped over.
+                word &= ~(((n == 64 ? 0 : (std::uint64_t)1 << n) - 1)
+                          << offset);
+                std::size_t const j = i + n;
+                return j < end ? j : end;
+            }
+            word &= ((std::uint64_t)1 << offset) - 1;
+            i += 64 - offset;
+        }
+        return end;
+    }
+
+    /// @brief  Find the first set bit in [begin, end).
+    /// @return The index of the bit or 'end' if there is none.
+    std::size_t
+    find_first_set(std::size_t const begin, std::size_t const end) const
+    {
+        std::size_t i = begin;
+        while (i < end) {
+            std::uint64_t const word = words_[i / 64] >> (i % 64);
+            if (word != 0) {
+                std::size_t const j = i + __builtin_ctzll(word);
+                return j < end ? j : end;
+            }
+            i = (i / 64 + 1) * 64;
+        }
+        return end;
+    }
+};
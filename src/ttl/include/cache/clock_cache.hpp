@@ -1,78 +1,77 @@
 #pragma once
 
 #include <cassert>
-#include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <deque>
-#include <limits>
-#include <optional>
-#include <unordered_map>
+#include <iostream>
+#include <vector>
 
-#include "cache/base_cache.hpp"
-#include "cache_metadata/cache_metadata.hpp"
+#include "cache/bit_vector.hpp"
+#include "cache/key_index.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
-#include "ttl/ttl.hpp"
-#include "unused/mark_unused.h"
 
-/// @note   I implemented this as FIFO with reinsertion, which is slower
-///         but easier to get right.
-class ClockCache : public BaseCache {
-private:
-    void
-    hit(std::uint64_t const access_time_ms,
-        std::uint64_t const key,
-        std::uint64_t const expiration_time_ms)
-    {
-        map_.at(key).visit(access_time_ms, expiration_time_ms);
-    }
+/// @brief  CLOCK as a circular array of slots with a moving hand.
+/// @note   The hand always points at the oldest slot, so this evicts in
+///         exactly the same order as FIFO with reinsertion. On a hit, we
+///         only set the slot's visited bit; on a miss, the hand clears
+///         the visited bits a word at a time until it finds a victim,
+///         whose slot the new key takes over.
+class ClockCache {
+    KeyIndex<std::uint32_t> map_;
+    // NOTE The slots are filled in order until the cache is full, after
+    //      which the number of slots never changes.
+    std::vector<std::uint64_t> slots_;
+    BitVector visited_;
+    std::size_t const capacity_;
+    std::size_t hand_ = 0;
 
-    void
-    miss(std::uint64_t const access_time_ms,
-         std::uint64_t const key,
-         std::uint64_t const expiration_time_ms)
+    /// @brief  Advance the hand to the first unvisited slot, clearing
+    ///         the visited bits along the way, and evict its key.
+    /// @return The slot that we evicted.
+    std::size_t
+    evict()
     {
-        assert(evictor_.size() <= capacity_);
-        while (evictor_.size() >= capacity_) {
-            std::uint64_t const victim_key = evictor_.back();
-            evictor_.pop_back();
-            if (map_.at(victim_key).visited) {
-                // Re-insert visited node.
-                map_.at(victim_key).unvisit();
-                evictor_.push_front(victim_key);
-                continue;
-            } else {
-                // Permanently remove unvisited node.
-                map_.erase(victim_key);
-                break;
-            }
+        std::size_t victim = visited_.clear_run(hand_, capacity_);
+        if (victim == capacity_) {
+            // NOTE The second pass must end by the original hand, whose
+            //      bit we have just cleared.
+            victim = visited_.clear_run(0, capacity_);
         }
-        evictor_.push_front(key);
-        map_.emplace(key, CacheMetadata(access_time_ms, expiration_time_ms));
+        assert(victim < capacity_);
+        std::size_t i_erased = map_.erase(slots_[victim]);
+        assert(i_erased == 1);
+        hand_ = victim + 1 == capacity_ ? 0 : victim + 1;
+        return victim;
     }
 
 public:
+    static constexpr char name[] = "ClockCache";
+    CacheStatistics statistics_;
+
     ClockCache(std::size_t capacity)
-        : BaseCache(capacity)
+        : visited_(capacity),
+          capacity_(capacity)
     {
+        assert(capacity < UINT32_MAX);
+    }
+
+    std::size_t
+    size() const
+    {
+        return map_.size();
     }
 
     template <class Stream>
     void
     to_stream(Stream &s) const
     {
-        s << name << "(capacity=" << capacity_ << ",size=" << size() << ")"
-          << std::endl;
-        s << "> Key-Metadata Map:" << std::endl;
-        for (auto [k, metadata] : map_) {
-            // This is inefficient, but looks easier on the eyes.
-            std::stringstream ss;
-            metadata.to_stream(ss);
-            s << ">> key: " << k << ", metadata: " << ss.str() << std::endl;
-        }
-        s << "> Evictor" << std::endl;
-        for (auto k : evictor_) {
-            s << ">> key: " << k << std::endl;
+        s << name << "(capacity=" << capacity_ << ",size=" << size()
+          << ",hand=" << hand_ << ")" << std::endl;
+        s << "> Slots" << std::endl;
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            s << ">> slot: " << i << ", key: " << slots_[i]
+              << ", visited: " << visited_.get(i) << std::endl;
         }
     }
 
@@ -83,7 +82,7 @@ public:
             std::cout << "validate(name=" << name << ",verbose=" << verbose
                       << ")" << std::endl;
         }
-        assert(map_.size() == evictor_.size());
+        assert(map_.size() == slots_.size());
         assert(size() <= capacity_);
         if (verbose) {
             std::cout << "> size: " << size() << std::endl;
@@ -92,11 +91,11 @@ public:
             to_stream(std::cout);
         }
 
-        for (auto k : evictor_) {
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
             if (verbose >= 2) {
-                std::cout << "> Validating: key=" << k << std::endl;
+                std::cout << "> Validating: key=" << slots_[i] << std::endl;
             }
-            assert(map_.count(k));
+            assert(map_.count(slots_[i]) && map_.at(slots_[i]) == i);
         }
         return true;
     }
@@ -104,30 +103,42 @@ public:
     int
     access_item(CacheAccess const &access)
     {
-        assert(map_.size() == evictor_.size());
-        assert(map_.size() <= capacity_);
         if (capacity_ == 0) {
             statistics_.miss();
             return 0;
         }
 
-        // TODO Change this to enable TTLs.
-        std::uint64_t expiration_time_ms =
-            get_expiration_time(access.timestamp_ms, FOREVER);
-        if (map_.count(access.key)) {
-            hit(access.timestamp_ms, access.key, expiration_time_ms);
+        auto it = map_.find(access.key);
+        if (it != map_.end()) {
+            visited_.set(it->second);
             statistics_.hit();
+            return 0;
+        }
+        std::size_t slot = 0;
+        if (slots_.size() < capacity_) {
+            // NOTE The hand stays on the oldest slot, which is slot 0.
+            slot = slots_.size();
+            slots_.push_back(access.key);
         } else {
-            miss(access.timestamp_ms, access.key, expiration_time_ms);
-            statistics_.miss();
+            slot = evict();
+            slots_[slot] = access.key;
         }
+        map_.emplace(access.key, static_cast<std::uint32_t>(slot));
+        statistics_.miss();
         assert(map_.size() <= capacity_);
         return 0;
     }
 
-protected:
-    std::deque<std::uint64_t> evictor_;
-
-public:
-    static constexpr char name[] = "ClockCache";
+    /// @brief  Get the keys in the order that the hand will reach them.
+    std::vector<std::uint64_t>
+    get_keys_in_eviction_order() const
+    {
+        std::vector<std::uint64_t> r;
+        r.reserve(slots_.size());
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            std::size_t const j = hand_ + i;
+            r.push_back(slots_[j < slots_.size() ? j : j - slots_.size()]);
+        }
+        return r;
+    }
 };
@@ -9,7 +9,7 @@
 #include <unordered_set>
 #include <vector>
 
-#include "cache/base_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 
 class FIFOCache {
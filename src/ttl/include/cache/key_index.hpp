@@ -0,0 +1,19 @@
+#pragma once
+
+#include <boost/version.hpp>
+// Boost introduced unordered flat maps in version 1.83.0
+#if BOOST_VERSION >= 108300
+#include <boost/unordered/unordered_flat_map.hpp>
+#else
+#include <unordered_map>
+#endif
+#include <cstdint>
+
+/// @brief  The hash table from a key to its slot that the array-based
+///         caches use.
+template <class Slot>
+#if BOOST_VERSION >= 108300
+using KeyIndex = boost::unordered::unordered_flat_map<std::uint64_t, Slot>;
+#else
+using KeyIndex = std::unordered_map<std::uint64_t, Slot>;
+#endif
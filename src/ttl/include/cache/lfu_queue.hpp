@@ -0,0 +1,255 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "cache/key_index.hpp"
+
+/// @brief  The O(1) LFU scheme: a list of frequency nodes in increasing
+///         order of frequency, where each frequency node holds an LRU
+///         list of the keys with that frequency. Ties in frequency are
+///         broken by evicting the key that has been at that frequency
+///         the longest.
+/// @note   Both the keys and the frequency nodes live in slabs and are
+///         linked by 32-bit indices (like LRUQueue), so the steady state
+///         does not allocate. Empty frequency nodes are freed right
+///         away, so there are never more frequency nodes than keys.
+class LFUQueue {
+    static constexpr std::uint32_t NIL = UINT32_MAX;
+
+    struct KeyNode {
+        std::uint64_t key;
+        std::uint32_t prev;
+        std::uint32_t next;
+        std::uint32_t frequency_node;
+    };
+
+    struct FrequencyNode {
+        std::uint64_t frequency;
+        std::uint32_t prev;
+        std::uint32_t next;
+        // NOTE The head is the most recently added and the tail is the
+        //      least recently added key. Free frequency nodes are
+        //      chained through their 'next' links.
+        std::uint32_t head;
+        std::uint32_t tail;
+    };
+
+    KeyIndex<std::uint32_t> index_;
+    std::vector<KeyNode> keys_;
+    std::vector<FrequencyNode> frequencies_;
+    // NOTE The lowest frequency is at the head of the frequency list.
+    std::uint32_t lowest_ = NIL;
+    std::uint32_t free_keys_ = NIL;
+    std::uint32_t free_frequencies_ = NIL;
+
+    /// @brief  Create a frequency node after 'prev', or at the head of
+    ///         the list if 'prev' is NIL.
+    std::uint32_t
+    new_frequency_node(std::uint64_t const frequency, std::uint32_t const prev)
+    {
+        std::uint32_t i = free_frequencies_;
+        if (i != NIL) {
+            free_frequencies_ = frequencies_[i].next;
+        } else {
+            assert(frequencies_.size() < NIL);
+            i = static_cast<std::uint32_t>(frequencies_.size());
+            frequencies_.push_back({});
+        }
+        std::uint32_t const next =
+            prev == NIL ? lowest_ : frequencies_[prev].next;
+        frequencies_[i] = FrequencyNode{frequency, prev, next, NIL, NIL};
+        if (prev == NIL) {
+            lowest_ = i;
+        } else {
+            frequencies_[prev].next = i;
+        }
+        if (next != NIL) {
+            frequencies_[next].prev = i;
+        }
+        return i;
+    }
+
+    void
+    delete_frequency_node(std::uint32_t const i)
+    {
+        FrequencyNode &f = frequencies_[i];
+        assert(f.head == NIL && f.tail == NIL);
+        if (f.prev != NIL) {
+            frequencies_[f.prev].next = f.next;
+        } else {
+            lowest_ = f.next;
+        }
+        if (f.next != NIL) {
+            frequencies_[f.next].prev = f.prev;
+        }
+        f.next = free_frequencies_;
+        free_frequencies_ = i;
+    }
+
+    void
+    unlink_key(std::uint32_t const i)
+    {
+        KeyNode &k = keys_[i];
+        FrequencyNode &f = frequencies_[k.frequency_node];
+        if (k.prev != NIL) {
+            keys_[k.prev].next = k.next;
+        } else {
+            f.head = k.next;
+        }
+        if (k.next != NIL) {
+            keys_[k.next].prev = k.prev;
+        } else {
+            f.tail = k.prev;
+        }
+    }
+
+    void
+    link_key(std::uint32_t const i, std::uint32_t const frequency_node)
+    {
+        KeyNode &k = keys_[i];
+        FrequencyNode &f = frequencies_[frequency_node];
+        k.frequency_node = frequency_node;
+        k.prev = NIL;
+        k.next = f.head;
+        if (f.head != NIL) {
+            keys_[f.head].prev = i;
+        } else {
+            f.tail = i;
+        }
+        f.head = i;
+    }
+
+    /// @brief  Unlink a key and free its frequency node if it is empty.
+    void
+    remove_key(std::uint32_t const i)
+    {
+        std::uint32_t const f = keys_[i].frequency_node;
+        unlink_key(i);
+        if (frequencies_[f].head == NIL) {
+            delete_frequency_node(f);
+        }
+        keys_[i].next = free_keys_;
+        free_keys_ = i;
+    }
+
+public:
+    std::size_t
+    size() const noexcept
+    {
+        return index_.size();
+    }
+
+    bool
+    contains(std::uint64_t const key) const
+    {
+        return index_.find(key) != index_.end();
+    }
+
+    std::optional<std::uint64_t>
+    get_frequency(std::uint64_t const key) const
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return {};
+        }
+        return frequencies_[keys_[it->second].frequency_node].frequency;
+    }
+
+    /// @brief  Increment a key's frequency.
+    /// @return Whether the key was present.
+    bool
+    touch(std::uint64_t const key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        std::uint32_t const i = it->second;
+        std::uint32_t const f = keys_[i].frequency_node;
+        std::uint64_t const new_frequency = frequencies_[f].frequency + 1;
+        std::uint32_t next = frequencies_[f].next;
+        if (next == NIL || frequencies_[next].frequency != new_frequency) {
+            next = new_frequency_node(new_frequency, f);
+        }
+        unlink_key(i);
+        link_key(i, next);
+        // NOTE I delete the old frequency node after linking the key
+        //      into the next one so that the next node's position in
+        //      the list is still valid.
+        if (frequencies_[f].head == NIL) {
+            delete_frequency_node(f);
+        }
+        return true;
+    }
+
+    /// @brief  Insert a key that is not yet present with a frequency of
+    ///         zero.
+    void
+    insert(std::uint64_t const key)
+    {
+        assert(!contains(key));
+        std::uint32_t i = free_keys_;
+        if (i != NIL) {
+            free_keys_ = keys_[i].next;
+        } else {
+            assert(keys_.size() < NIL);
+            i = static_cast<std::uint32_t>(keys_.size());
+            keys_.push_back({});
+        }
+        keys_[i].key = key;
+        std::uint32_t f = lowest_;
+        if (f == NIL || frequencies_[f].frequency != 0) {
+            f = new_frequency_node(0, NIL);
+        }
+        link_key(i, f);
+        index_.emplace(key, i);
+    }
+
+    /// @brief  Remove the least frequently used key.
+    std::optional<std::uint64_t>
+    pop_lfu()
+    {
+        if (lowest_ == NIL) {
+            return {};
+        }
+        std::uint32_t const i = frequencies_[lowest_].tail;
+        assert(i != NIL);
+        std::uint64_t const key = keys_[i].key;
+        remove_key(i);
+        std::size_t i_erased = index_.erase(key);
+        assert(i_erased == 1);
+        return key;
+    }
+
+    bool
+    erase(std::uint64_t const key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        std::uint32_t const i = it->second;
+        index_.erase(it);
+        remove_key(i);
+        return true;
+    }
+
+    /// @brief  Get the keys in the order that they would be evicted.
+    std::vector<std::uint64_t>
+    get_keys_in_eviction_order() const
+    {
+        std::vector<std::uint64_t> keys;
+        keys.reserve(size());
+        for (std::uint32_t f = lowest_; f != NIL; f = frequencies_[f].next) {
+            for (std::uint32_t i = frequencies_[f].tail; i != NIL;
+                 i = keys_[i].prev) {
+                keys.push_back(keys_[i].key);
+            }
+        }
+        return keys;
+    }
+};
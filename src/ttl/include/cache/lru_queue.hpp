@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "cache/key_index.hpp"
+#include "cache/slot_list.hpp"
+
+/// @brief  A queue of keys in recency order, where each key may carry a
+///         value. The entries live in a contiguous slab and are linked
+///         by a SlotList, so touching, inserting, and evicting are all
+///         O(1). Freed slots are recycled, so once the slab has grown to
+///         the working set size, the steady state does not allocate
+///         (besides what the index may do).
+template <class Value = std::monostate>
+class LRUQueue {
+    struct Entry {
+        std::uint64_t key;
+        Value value;
+    };
+
+    KeyIndex<Slot> index_;
+    std::vector<Entry> slab_;
+    // NOTE The front is the least recently used and the back is the most.
+    SlotList list_;
+    std::vector<Slot> free_slots_;
+
+    void
+    release(Slot const i)
+    {
+        list_.unlink(i);
+        slab_[i].value = Value{};
+        free_slots_.push_back(i);
+    }
+
+public:
+    std::size_t
+    size() const noexcept
+    {
+        return index_.size();
+    }
+
+    bool
+    contains(std::uint64_t const key) const
+    {
+        return index_.find(key) != index_.end();
+    }
+
+    /// @brief  Find a key's value without changing its recency.
+    Value *
+    find(std::uint64_t const key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        return &slab_[it->second].value;
+    }
+
+    /// @brief  Move a key to the most recently used position.
+    /// @return A pointer to its value or nullptr if it is not present.
+    Value *
+    touch(std::uint64_t const key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        Slot const i = it->second;
+        list_.move_to_back(i);
+        return &slab_[i].value;
+    }
+
+    /// @brief  Insert a key that is not yet present as the most
+    ///         recently used.
+    Value &
+    insert(std::uint64_t const key, Value value = Value{})
+    {
+        assert(!contains(key));
+        Slot i = 0;
+        if (!free_slots_.empty()) {
+            i = free_slots_.back();
+            free_slots_.pop_back();
+            slab_[i] = Entry{key, std::move(value)};
+        } else {
+            i = static_cast<Slot>(slab_.size());
+            slab_.push_back(Entry{key, std::move(value)});
+            list_.grow(slab_.size());
+        }
+        list_.push_back(i);
+        index_.emplace(key, i);
+        return slab_[i].value;
+    }
+
+    /// @brief  Get the least recently used key without removing it.
+    std::optional<std::uint64_t>
+    peek_lru() const
+    {
+        if (list_.empty()) {
+            return {};
+        }
+        return slab_[list_.front()].key;
+    }
+
+    /// @brief  Remove the least recently used key.
+    std::optional<std::uint64_t>
+    pop_lru()
+    {
+        if (list_.empty()) {
+            return {};
+        }
+        Slot const i = list_.front();
+        std::uint64_t const key = slab_[i].key;
+        release(i);
+        std::size_t i_erased = index_.erase(key);
+        assert(i_erased == 1);
+        return key;
+    }
+
+    bool
+    erase(std::uint64_t const key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return false;
+        }
+        Slot const i = it->second;
+        index_.erase(it);
+        release(i);
+        return true;
+    }
+
+    /// @brief  Get the keys from least to most recently used.
+    std::vector<std::uint64_t>
+    get_keys_in_eviction_order() const
+    {
+        std::vector<std::uint64_t> keys;
+        keys.reserve(size());
+        for (Slot i = list_.front(); i != list_.end(); i = list_.next(i)) {
+            keys.push_back(slab_[i].key);
+        }
+        return keys;
+    }
+};
@@ -1,36 +1,75 @@
 #pragma once
 
 #include <cassert>
-#include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <optional>
-#include <unordered_map>
 #include <vector>
 
-#include "cache/base_cache.hpp"
+#include "cache/bit_vector.hpp"
+#include "cache/key_index.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 
+/// @brief  SIEVE as an array of slots in insertion order with a moving
+///         hand.
+/// @note   Unlike CLOCK, SIEVE evicts from the middle of the queue and
+///         inserts at the tail, so a victim's slot cannot be reused in
+///         place. Instead, I leave a tombstone (i.e. clear its live bit)
+///         and append new keys to the end of the array. When the array
+///         runs out of room, I compact the live slots to the front while
+///         preserving their order. With half of the capacity as slack,
+///         compaction costs O(1) amortized per insertion.
 class SieveCache {
-    struct SieveBucket {
-        bool visited;
-        std::uint64_t idx;
-    };
-
-    std::unordered_map<std::uint64_t, SieveBucket> map_;
-    std::map<std::uint64_t, std::uint64_t> queue_;
+    KeyIndex<std::uint32_t> map_;
+    // NOTE The slots are in order of insertion, oldest first.
+    std::vector<std::uint64_t> slots_;
+    BitVector visited_;
+    BitVector live_;
     std::size_t const capacity_;
-    std::uint64_t hand_ = 0;
-    std::uint64_t logical_time_ = 0;
+    std::size_t const max_slots_;
+    // NOTE The hand may point at a tombstone (i.e. the last slot that
+    //      it evicted).
+    std::size_t hand_ = 0;
+
+    /// @brief  Move the live slots to the front, keeping their order.
+    void
+    compact()
+    {
+        std::size_t n = 0;
+        std::size_t new_hand = 0;
+        for (std::size_t i = live_.find_first_set(0, slots_.size());
+             i < slots_.size();
+             i = live_.find_first_set(i + 1, slots_.size())) {
+            if (i < hand_) {
+                ++new_hand;
+            }
+            std::uint64_t const key = slots_[i];
+            slots_[n] = key;
+            visited_.assign(n, visited_.get(i));
+            live_.set(n);
+            map_[key] = static_cast<std::uint32_t>(n);
+            ++n;
+        }
+        for (std::size_t i = n; i < slots_.size(); ++i) {
+            visited_.clear(i);
+            live_.clear(i);
+        }
+        slots_.resize(n);
+        hand_ = new_hand;
+    }
 
 public:
     static constexpr char name[] = "SieveCache";
     CacheStatistics statistics_;
 
     SieveCache(std::size_t capacity)
-        : capacity_(capacity)
+        : capacity_(capacity),
+          max_slots_(capacity + capacity / 2 + 1)
     {
+        assert(max_slots_ < UINT32_MAX);
+        visited_ = BitVector(max_slots_);
+        live_ = BitVector(max_slots_);
     }
 
     std::size_t
@@ -42,59 +81,64 @@ public:
     std::optional<std::uint64_t>
     delete_sieve()
     {
-        if (queue_.size() == 0) {
+        if (map_.size() == 0) {
             return {};
         }
-        // NOTE This starts on the element greater-than-or-equal-to the
-        //      hand_. This hand_ may be in the cache because hand_ = 0
-        //      is in the cache; it also may not be in the cache since
-        //      it points to the last element that we removed.
-        for (auto victim_it = queue_.lower_bound(hand_);
-             victim_it != queue_.end();
-             ++victim_it) {
-            std::uint64_t victim_key = victim_it->second;
-            assert(map_.count(victim_key));
-            if (map_[victim_key].visited) {
-                map_[victim_key].visited = false;
-            } else {
-                queue_.erase(victim_it);
-                map_.erase(victim_key);
-                hand_ = victim_it->first;
-                return victim_key;
+        std::size_t i = hand_;
+        while (true) {
+            i = live_.find_first_set(i, slots_.size());
+            if (i == slots_.size()) {
+                // NOTE We have completed a full cycle, so let's begin
+                //      again! This terminates because the first pass
+                //      cleared all of the visited bits.
+                i = 0;
+                continue;
             }
+            if (visited_.get(i)) {
+                visited_.clear(i);
+                ++i;
+                continue;
+            }
+            std::uint64_t const victim_key = slots_[i];
+            live_.clear(i);
+            std::size_t i_erased = map_.erase(victim_key);
+            assert(i_erased == 1);
+            // NOTE If we evicted the newest key, then the hand wraps
+            //      around to the oldest rather than moving onto the key
+            //      that we are about to insert (as in Yang et al.).
+            hand_ = live_.find_first_set(i, slots_.size()) == slots_.size()
+                        ? 0
+                        : i;
+            return victim_key;
         }
-        // NOTE We have completed a full cycle, so let's begin again!
-        hand_ = 0;
-        return this->delete_sieve();
     }
 
     int
     access_item(CacheAccess const &access)
     {
-        assert(map_.size() == queue_.size());
         if (capacity_ == 0) {
             statistics_.miss();
             return 0;
         }
-        if (map_.count(access.key)) {
-            map_[access.key].visited = true;
+        auto it = map_.find(access.key);
+        if (it != map_.end()) {
+            visited_.set(it->second);
             statistics_.hit();
-        } else {
-            if (queue_.size() >= capacity_) {
-                this->delete_sieve();
-                assert(map_.size() + 1 == capacity_);
-            }
-            assert(map_.size() + 1 <= capacity_);
-            struct SieveBucket new_bucket = {false, logical_time_};
-            auto [it, inserted] = map_.emplace(access.key, new_bucket);
-            assert(inserted && it->first == access.key &&
-                   it->second.visited == false &&
-                   it->second.idx == logical_time_);
-            queue_.emplace(logical_time_, access.key);
-            assert(map_.size() <= capacity_);
-            statistics_.miss();
+            return 0;
+        }
+        if (map_.size() >= capacity_) {
+            this->delete_sieve();
+            assert(map_.size() + 1 == capacity_);
+        }
+        if (slots_.size() == max_slots_) {
+            compact();
         }
-        ++logical_time_;
+        std::size_t const slot = slots_.size();
+        slots_.push_back(access.key);
+        live_.set(slot);
+        map_.emplace(access.key, static_cast<std::uint32_t>(slot));
+        assert(map_.size() <= capacity_);
+        statistics_.miss();
         return 0;
     }
 
@@ -103,10 +147,11 @@ public:
     get_keys_in_eviction_order()
     {
         std::vector<std::uint64_t> r;
-        // Just a small optimization to avoid resizing.
-        r.reserve(queue_.size());
-        for (auto [expiry_tm, key] : queue_) {
-            r.push_back(key);
+        r.reserve(map_.size());
+        for (std::size_t i = live_.find_first_set(0, slots_.size());
+             i < slots_.size();
+             i = live_.find_first_set(i + 1, slots_.size())) {
+            r.push_back(slots_[i]);
         }
         return r;
     }
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// @brief  A dense index into a cache's slab (e.g. of keys).
+using Slot = std::uint32_t;
+
+/// @brief  A doubly linked list of slots, linked through two arrays of
+///         32-bit indices, so that linking and unlinking are O(1) and
+///         never allocate. The owner keeps whatever each slot holds in
+///         its own slab. LRUQueue and the ComposedCache's eviction
+///         orders are all built on this.
+/// @note   I limit the number of slots to 2^32 - 1 so that the links are
+///         half the size of pointers.
+class SlotList {
+    static constexpr Slot NIL = UINT32_MAX;
+
+    std::vector<Slot> prev_;
+    std::vector<Slot> next_;
+    Slot front_ = NIL;
+    Slot back_ = NIL;
+
+public:
+    SlotList(std::size_t const capacity = 0)
+        : prev_(capacity),
+          next_(capacity)
+    {
+        assert(capacity < NIL);
+    }
+
+    /// @brief  Make room for slots [0, capacity).
+    void
+    grow(std::size_t const capacity)
+    {
+        assert(capacity < NIL);
+        if (capacity > prev_.size()) {
+            prev_.resize(capacity);
+            next_.resize(capacity);
+        }
+    }
+
+    /// @brief  The slot past the back (or before the front).
+    static constexpr Slot
+    end()
+    {
+        return NIL;
+    }
+
+    bool
+    empty() const
+    {
+        return front_ == NIL;
+    }
+
+    Slot
+    front() const
+    {
+        return front_;
+    }
+
+    Slot
+    back() const
+    {
+        return back_;
+    }
+
+    Slot
+    next(Slot const slot) const
+    {
+        return next_[slot];
+    }
+
+    Slot
+    prev(Slot const slot) const
+    {
+        return prev_[slot];
+    }
+
+    void
+    push_back(Slot const slot)
+    {
+        assert(slot < prev_.size());
+        prev_[slot] = back_;
+        next_[slot] = NIL;
+        if (back_ != NIL) {
+            next_[back_] = slot;
+        } else {
+            front_ = slot;
+        }
+        back_ = slot;
+    }
+
+    void
+    unlink(Slot const slot)
+    {
+        if (prev_[slot] != NIL) {
+            next_[prev_[slot]] = next_[slot];
+        } else {
+            front_ = next_[slot];
+        }
+        if (next_[slot] != NIL) {
+            prev_[next_[slot]] = prev_[slot];
+        } else {
+            back_ = prev_[slot];
+        }
+    }
+
+    /// @brief  Move a slot that is in the list to the back.
+    void
+    move_to_back(Slot const slot)
+    {
+        if (slot != back_) {
+            unlink(slot);
+            push_back(slot);
+        }
+    }
+
+    Slot
+    pop_front()
+    {
+        assert(!empty());
+        Slot const slot = front_;
+        unlink(slot);
+        return slot;
+    }
+};
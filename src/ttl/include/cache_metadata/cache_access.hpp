@@ -1,10 +1,18 @@
 /** @brief  Represent a cache access. */
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
 #include <optional>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "io/io.h"
 #include "logger/logger.h"
@@ -30,7 +38,8 @@ struct CacheAccess {
           command((CacheAccessCommand)item->command),
           key(item->key),
           size_bytes(item->size),
-          ttl_ms(item->ttl_s
+          // NOTE A TTL of zero means that the object never expires.
+          ttl_ms(item->ttl_s == 0
                      ? std::nullopt
                      : std::optional(saturation_multiply(1000, item->ttl_s)))
     {
@@ -56,27 +65,176 @@ struct CacheAccess {
           ttl_ms(ttl_ms)
     {
     }
+
+    CacheAccess(std::uint64_t const timestamp_ms,
+                CacheAccessCommand const command,
+                std::uint64_t const key,
+                std::uint64_t size_bytes,
+                std::optional<std::uint64_t> ttl_ms)
+        : timestamp_ms(timestamp_ms),
+          command(command),
+          key(key),
+          size_bytes(size_bytes),
+          ttl_ms(ttl_ms)
+    {
+    }
 };
 
+/// @brief  A trace that I decode once into a structure of arrays.
+/// @details    The trace lives in a single buffer with the layout:
+///
+///             Field       | Type                   | Alignment (bytes)
+///             ------------|------------------------|------------------
+///             Header      | CacheAccessTraceHeader | 64
+///             Timestamps  | u64[length]            | 64
+///             Keys        | u64[length]            | 64
+///             TTLs        | u64[length]            | 64
+///             Sizes       | u32[length]            | 64
+///             Commands    | u8[length]             | 64
+///
+///             I either allocate this buffer and decode the raw trace
+///             into it, or memory map it directly from a file that I
+///             previously saved. In the latter case, there is nothing to
+///             decode at all.
+/// @note   The cache file uses the native byte order.
 class CacheAccessTrace {
 public:
-    CacheAccessTrace(std::string const &fname, enum TraceFormat const format)
-        : bytes_per_obj_(get_bytes_per_trace_item(format)),
-          format_(format)
+    /// @brief  The TTL of an object that never expires.
+    static constexpr std::uint64_t NO_TTL = UINT64_MAX;
+
+    struct CacheAccessTraceHeader {
+        char magic[8];
+        std::uint64_t version;
+        std::uint64_t length;
+    };
+
+    static constexpr char MAGIC[8] = "CATRACE";
+    static constexpr std::uint64_t VERSION = 1;
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    /// @brief  Decode a raw trace into a structure of arrays.
+    /// @param  num_threads: The number of threads to decode with, or 0
+    ///                      to use one per hardware thread.
+    CacheAccessTrace(std::string const &fname,
+                     enum TraceFormat const format,
+                     std::size_t num_threads = 0)
     {
-        if (bytes_per_obj_ == 0) {
+        struct MemoryMap mm = {};
+        std::size_t const bytes_per_obj = get_bytes_per_trace_item(format);
+        if (bytes_per_obj == 0) {
             LOGGER_ERROR("invalid format %s", get_trace_format_string(format));
             exit(1);
         }
         // Memory map the input trace file
+        if (!MemoryMap__init(&mm, fname.c_str(), "rb")) {
+            LOGGER_ERROR("failed to mmap '%s'", fname.c_str());
+            exit(1);
+        }
+        std::size_t const length = mm.num_bytes / bytes_per_obj;
+        allocate(length);
+
+        if (num_threads == 0) {
+            num_threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // NOTE Each thread decodes a disjoint range, so they never write
+        //      to the same cache line (except at the edges).
+        std::atomic<bool> ok = true;
+        std::vector<std::thread> workers;
+        std::size_t const chunk = (length + num_threads - 1) / num_threads;
+        for (std::size_t begin = 0; begin < length; begin += chunk) {
+            std::size_t const end = std::min(length, begin + chunk);
+            workers.emplace_back([this, &mm, &ok, bytes_per_obj, format,
+                                  begin, end]() {
+                if (!decode((uint8_t const *)mm.buffer,
+                            bytes_per_obj,
+                            format,
+                            begin,
+                            end)) {
+                    ok = false;
+                }
+            });
+        }
+        for (auto &t : workers) {
+            t.join();
+        }
+        MemoryMap__destroy(&mm);
+        if (!ok) {
+            LOGGER_ERROR("failed to decode '%s'", fname.c_str());
+            exit(1);
+        }
+    }
+
+    /// @brief  Decode the items [begin, end) of a raw trace that the
+    ///         caller has already memory mapped.
+    /// @note   This lets the caller stream a trace through in blocks
+    ///         rather than decoding all of it up front.
+    CacheAccessTrace(std::uint8_t const *const raw,
+                     enum TraceFormat const format,
+                     std::size_t const begin,
+                     std::size_t const end)
+    {
+        std::size_t const bytes_per_obj = get_bytes_per_trace_item(format);
+        assert(bytes_per_obj != 0 && begin <= end);
+        allocate(end - begin);
+        if (!decode(&raw[begin * bytes_per_obj],
+                    bytes_per_obj,
+                    format,
+                    0,
+                    end - begin)) {
+            LOGGER_ERROR("failed to decode items [%zu, %zu)", begin, end);
+            exit(1);
+        }
+    }
+
+    /// @brief  Memory map a trace that I previously saved.
+    CacheAccessTrace(std::string const &fname)
+    {
         if (!MemoryMap__init(&mm_, fname.c_str(), "rb")) {
             LOGGER_ERROR("failed to mmap '%s'", fname.c_str());
             exit(1);
         }
-        length_ = mm_.num_bytes / bytes_per_obj_;
+        auto const *header = (CacheAccessTraceHeader const *)mm_.buffer;
+        if (mm_.num_bytes < sizeof(*header) ||
+            std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+            header->version != VERSION ||
+            mm_.num_bytes < get_num_bytes(header->length)) {
+            LOGGER_ERROR("'%s' is not a valid cache access trace",
+                         fname.c_str());
+            exit(1);
+        }
+        set_arrays((std::uint8_t *)mm_.buffer, header->length);
+    }
+
+    CacheAccessTrace(CacheAccessTrace const &) = delete;
+    CacheAccessTrace &
+    operator=(CacheAccessTrace const &) = delete;
+
+    ~CacheAccessTrace()
+    {
+        if (buffer_ != nullptr) {
+            ::operator delete(buffer_, std::align_val_t{ALIGNMENT});
+        }
+        if (mm_.buffer != nullptr) {
+            MemoryMap__destroy(&mm_);
+        }
     }
 
-    ~CacheAccessTrace() { MemoryMap__destroy(&mm_); }
+    /// @brief  Save the trace so that I can memory map it later.
+    bool
+    save(std::string const &fname) const
+    {
+        std::ofstream fs(fname, std::ios::binary);
+        if (!fs.is_open()) {
+            LOGGER_ERROR("failed to open '%s'", fname.c_str());
+            return false;
+        }
+        fs.write((char const *)get_buffer(), get_num_bytes(length_));
+        if (!fs.good()) {
+            LOGGER_ERROR("failed to write '%s'", fname.c_str());
+            return false;
+        }
+        return true;
+    }
 
     size_t
     size() const
@@ -84,20 +242,145 @@ public:
         return length_;
     }
 
+    /// @brief  Gather the i-th access from the arrays.
     CacheAccess const
     get(size_t const i) const
     {
-        struct FullTraceItemResult r = construct_full_trace_item(
-            &((uint8_t *)mm_.buffer)[i * bytes_per_obj_],
-            format_);
-        assert(r.valid);
-        return CacheAccess{&r.item};
+        return CacheAccess{timestamps_ms_[i],
+                           (CacheAccessCommand)commands_[i],
+                           keys_[i],
+                           sizes_bytes_[i],
+                           ttls_ms_[i] == NO_TTL
+                               ? std::nullopt
+                               : std::optional<std::uint64_t>(ttls_ms_[i])};
+    }
+
+    std::uint64_t const *
+    get_timestamps_ms() const
+    {
+        return timestamps_ms_;
+    }
+
+    std::uint64_t const *
+    get_keys() const
+    {
+        return keys_;
+    }
+
+    /// @note   Objects without a TTL have a TTL of NO_TTL.
+    std::uint64_t const *
+    get_ttls_ms() const
+    {
+        return ttls_ms_;
+    }
+
+    std::uint32_t const *
+    get_sizes_bytes() const
+    {
+        return sizes_bytes_;
+    }
+
+    std::uint8_t const *
+    get_commands() const
+    {
+        return commands_;
     }
 
 private:
-    size_t const bytes_per_obj_ = 0;
-    enum TraceFormat const format_ = TRACE_FORMAT_INVALID;
+    static std::size_t
+    align(std::size_t const offset)
+    {
+        return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    }
 
+    /// @brief  Get the byte offsets of the header and each array. The
+    ///         final offset is the total number of bytes.
+    static std::array<std::size_t, 7>
+    get_offsets(std::size_t const length)
+    {
+        std::array<std::size_t, 7> offsets = {0};
+        offsets[1] = align(sizeof(CacheAccessTraceHeader));
+        offsets[2] = align(offsets[1] + length * sizeof(std::uint64_t));
+        offsets[3] = align(offsets[2] + length * sizeof(std::uint64_t));
+        offsets[4] = align(offsets[3] + length * sizeof(std::uint64_t));
+        offsets[5] = align(offsets[4] + length * sizeof(std::uint32_t));
+        offsets[6] = align(offsets[5] + length * sizeof(std::uint8_t));
+        return offsets;
+    }
+
+    static std::size_t
+    get_num_bytes(std::size_t const length)
+    {
+        return get_offsets(length)[6];
+    }
+
+    std::uint8_t const *
+    get_buffer() const
+    {
+        return buffer_ != nullptr ? buffer_ : (std::uint8_t *)mm_.buffer;
+    }
+
+    void
+    set_arrays(std::uint8_t *const buffer, std::size_t const length)
+    {
+        std::array<std::size_t, 7> const offsets = get_offsets(length);
+        length_ = length;
+        timestamps_ms_ = (std::uint64_t *)&buffer[offsets[1]];
+        keys_ = (std::uint64_t *)&buffer[offsets[2]];
+        ttls_ms_ = (std::uint64_t *)&buffer[offsets[3]];
+        sizes_bytes_ = (std::uint32_t *)&buffer[offsets[4]];
+        commands_ = (std::uint8_t *)&buffer[offsets[5]];
+    }
+
+    void
+    allocate(std::size_t const length)
+    {
+        std::size_t const num_bytes = get_num_bytes(length);
+        buffer_ = (std::uint8_t *)::operator new(num_bytes,
+                                                 std::align_val_t{ALIGNMENT});
+        // NOTE I zero the padding so that saved files are deterministic.
+        std::memset(buffer_, 0, num_bytes);
+        CacheAccessTraceHeader header = {};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.length = length;
+        std::memcpy(buffer_, &header, sizeof(header));
+        set_arrays(buffer_, length);
+    }
+
+    bool
+    decode(std::uint8_t const *const raw,
+           std::size_t const bytes_per_obj,
+           enum TraceFormat const format,
+           std::size_t const begin,
+           std::size_t const end)
+    {
+        for (std::size_t i = begin; i < end; ++i) {
+            struct FullTraceItemResult r =
+                construct_full_trace_item(&raw[i * bytes_per_obj], format);
+            if (!r.valid) {
+                LOGGER_ERROR("invalid trace item %zu", i);
+                return false;
+            }
+            timestamps_ms_[i] = r.item.timestamp_ms;
+            keys_[i] = r.item.key;
+            ttls_ms_[i] = r.item.ttl_s == 0
+                              ? NO_TTL
+                              : saturation_multiply(1000, r.item.ttl_s);
+            sizes_bytes_[i] = r.item.size;
+            commands_[i] = r.item.command;
+        }
+        return true;
+    }
+
+    // NOTE Exactly one of these owns the arrays.
+    std::uint8_t *buffer_ = nullptr;
     struct MemoryMap mm_ = {};
+
     size_t length_ = 0;
+    std::uint64_t *timestamps_ms_ = nullptr;
+    std::uint64_t *keys_ = nullptr;
+    std::uint64_t *ttls_ms_ = nullptr;
+    std::uint32_t *sizes_bytes_ = nullptr;
+    std::uint8_t *commands_ = nullptr;
 };
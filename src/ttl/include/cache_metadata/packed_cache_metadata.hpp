@@ -0,0 +1,198 @@
+/** @brief  Compact, 16-byte metadata for a cache object.
+ *
+ *  CacheMetadata takes 48 bytes per object, which adds up to ~10 GB for
+ *  a 200M-object cache before we even count the hash table. This packs
+ *  the same information into 16 bytes:
+ *
+ *      Field               | Type  | Encoding
+ *      --------------------|-------|-------------------------------------
+ *      Insertion time      | u32   | Milliseconds since the cache epoch
+ *      Last access time    | u32   | Milliseconds since the cache epoch
+ *      Expiration time     | u32   | Milliseconds since the cache epoch
+ *      Frequency           | u8    | Saturates at 255
+ *      Size class          | u8    | See 'encode_size_class'
+ *      Flags               | u8    | Bit 0 is the visited flag
+ *      (Padding)           | u8    |
+ *
+ *  The cache owns the epoch (e.g. the time of its first access) and
+ *  passes it to every method that deals in absolute times. 32 bits of
+ *  milliseconds covers ~49 days past the epoch, which is longer than
+ *  our traces. Times outside of this range saturate.
+ *
+ *  @note   NewTTLClockCache (via BaseTTLCache), the predictor, and the
+ *          ComposedCache's PackedMetadata store use this. The first two
+ *          work around what this drops: BaseTTLCache keeps its (virtual)
+ *          expiration times only in the timing wheel, and the predictor
+ *          keeps exact sizes for its byte counts.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+
+class PackedCacheMetadata {
+    /// @brief  The encoding of an expiration time of 'never'.
+    static constexpr std::uint32_t NEVER = UINT32_MAX;
+    static constexpr std::uint8_t VISITED_FLAG = 1;
+
+    std::uint32_t insertion_time_ms_ = 0;
+    std::uint32_t last_access_time_ms_ = 0;
+    std::uint32_t expiration_time_ms_ = NEVER;
+    std::uint8_t frequency_ = 0;
+    std::uint8_t size_class_ = 1;
+    std::uint8_t flags_ = 0;
+
+    static std::uint32_t
+    encode_time(std::uint64_t const epoch_ms, std::uint64_t const time_ms)
+    {
+        if (time_ms <= epoch_ms) {
+            return 0;
+        }
+        // NOTE I reserve the maximum value to mean 'never'.
+        std::uint64_t const offset = time_ms - epoch_ms;
+        return offset < NEVER ? static_cast<std::uint32_t>(offset) : NEVER - 1;
+    }
+
+    static std::uint64_t
+    decode_time(std::uint64_t const epoch_ms, std::uint32_t const offset)
+    {
+        return epoch_ms + offset;
+    }
+
+public:
+    /// @brief  Encode a size into 8 bits: sizes below 4 are exact, and
+    ///         larger sizes keep their leading bit plus the next two.
+    /// @note   This rounds down with a relative error below 25%. Every
+    ///         64-bit size fits, since the largest class is 4 * 62 + 3.
+    static std::uint8_t
+    encode_size_class(std::uint64_t const size)
+    {
+        if (size < 4) {
+            return static_cast<std::uint8_t>(size);
+        }
+        unsigned const e = 63 - __builtin_clzll(size);
+        unsigned const m = (size >> (e - 2)) & 3;
+        return static_cast<std::uint8_t>(4 * (e - 1) + m);
+    }
+
+    static std::uint64_t
+    decode_size_class(std::uint8_t const size_class)
+    {
+        if (size_class < 4) {
+            return size_class;
+        }
+        unsigned const e = size_class / 4 + 1;
+        unsigned const m = size_class % 4;
+        return (std::uint64_t)(4 + m) << (e - 2);
+    }
+
+    PackedCacheMetadata() = default;
+
+    /// @param  expiration_time_ms: The absolute expiration time, where
+    ///                             UINT64_MAX means 'never'.
+    PackedCacheMetadata(std::uint64_t const epoch_ms,
+                        std::size_t const value_size,
+                        std::uint64_t const insertion_time_ms,
+                        std::uint64_t const expiration_time_ms)
+        : insertion_time_ms_(encode_time(epoch_ms, insertion_time_ms)),
+          last_access_time_ms_(insertion_time_ms_),
+          expiration_time_ms_(expiration_time_ms == UINT64_MAX
+                                  ? NEVER
+                                  : encode_time(epoch_ms, expiration_time_ms)),
+          size_class_(encode_size_class(value_size))
+    {
+    }
+
+    std::size_t
+    get_size() const
+    {
+        return decode_size_class(size_class_);
+    }
+
+    std::size_t
+    get_frequency() const
+    {
+        return frequency_;
+    }
+
+    std::uint64_t
+    get_insertion_time_ms(std::uint64_t const epoch_ms) const
+    {
+        return decode_time(epoch_ms, insertion_time_ms_);
+    }
+
+    std::uint64_t
+    get_last_access_time_ms(std::uint64_t const epoch_ms) const
+    {
+        return decode_time(epoch_ms, last_access_time_ms_);
+    }
+
+    /// @return The absolute expiration time, or UINT64_MAX for 'never'.
+    std::uint64_t
+    get_expiration_time_ms(std::uint64_t const epoch_ms) const
+    {
+        if (expiration_time_ms_ == NEVER) {
+            return UINT64_MAX;
+        }
+        return decode_time(epoch_ms, expiration_time_ms_);
+    }
+
+    bool
+    is_visited() const
+    {
+        return flags_ & VISITED_FLAG;
+    }
+
+    template <class Stream>
+    void
+    to_stream(Stream &s,
+              std::uint64_t const epoch_ms,
+              bool const newline = false) const
+    {
+        s << "PackedCacheMetadata(frequency=" << get_frequency() << ",";
+        s << "size=" << get_size() << ",";
+        s << "insertion_time[ms]=" << get_insertion_time_ms(epoch_ms) << ",";
+        s << "last_access_time[ms]=" << get_last_access_time_ms(epoch_ms)
+          << ",";
+        s << "expiration_time[ms]=" << get_expiration_time_ms(epoch_ms) << ",";
+        s << "visited=" << is_visited() << ")";
+        if (newline) {
+            s << std::endl;
+        }
+    }
+
+    /// @note   Like CacheMetadata, visiting does not set the visited flag.
+    void
+    visit(std::uint64_t const epoch_ms,
+          std::uint64_t const access_time_ms,
+          std::optional<std::uint64_t> const new_expiration_time_ms)
+    {
+        if (frequency_ != UINT8_MAX) {
+            ++frequency_;
+        }
+        last_access_time_ms_ = encode_time(epoch_ms, access_time_ms);
+        if (new_expiration_time_ms) {
+            expiration_time_ms_ =
+                *new_expiration_time_ms == UINT64_MAX
+                    ? NEVER
+                    : encode_time(epoch_ms, *new_expiration_time_ms);
+        }
+    }
+
+    void
+    set_visited()
+    {
+        flags_ |= VISITED_FLAG;
+    }
+
+    void
+    unvisit()
+    {
+        flags_ &= ~VISITED_FLAG;
+    }
+};
+
+static_assert(sizeof(PackedCacheMetadata) == 16,
+              "PackedCacheMetadata should be 16 bytes");
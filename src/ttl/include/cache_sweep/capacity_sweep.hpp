@@ -0,0 +1,342 @@
+/** @brief  Simulate many caches over a trace in a single pass.
+ *
+ *  Rather than replaying (and re-decoding) the trace once per cache, I
+ *  decode each block of the raw trace once into its own structure-of-
+ *  arrays 'CacheAccessTrace' and fan it out to every cache. Each cache
+ *  consumes the blocks in order, but different caches run concurrently
+ *  on a pool of worker threads with work stealing. A block is freed as
+ *  soon as every cache has consumed it and the decoder never runs more
+ *  than a few blocks ahead of the slowest cache, so memory stays bounded
+ *  and the blocks that the caches are reading stay in the CPU's caches.
+ */
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cache_metadata/cache_access.hpp"
+#include "cache_statistics/cache_statistics.hpp"
+#include "io/io.h"
+#include "logger/logger.h"
+#include "trace/reader.h"
+#include "trace/trace.h"
+
+class CapacitySweep {
+    /// @brief  A cache and how far through the trace it has gotten.
+    struct Consumer {
+        std::string name;
+        std::size_t capacity;
+        std::size_t next_block = 0;
+
+        Consumer(std::string name, std::size_t const capacity)
+            : name(name),
+              capacity(capacity)
+        {
+        }
+        virtual ~Consumer() = default;
+        /// @brief  Process the GET requests in [begin, end).
+        virtual void
+        process(CacheAccessTrace const &trace,
+                std::size_t const begin,
+                std::size_t const end) = 0;
+        virtual CacheStatistics const &
+        get_statistics() const = 0;
+    };
+
+    template <class T>
+    struct CacheConsumer : public Consumer {
+        T cache;
+
+        template <class... Args>
+        CacheConsumer(std::size_t const capacity, Args &&...args)
+            : Consumer(T::name, capacity),
+              cache(capacity, std::forward<Args>(args)...)
+        {
+        }
+
+        void
+        process(CacheAccessTrace const &trace,
+                std::size_t const begin,
+                std::size_t const end) override
+        {
+            std::uint8_t const *const commands = trace.get_commands();
+            for (std::size_t i = begin; i < end; ++i) {
+                // Skip PUT requests.
+                if (commands[i] == (std::uint8_t)CacheAccessCommand::set) {
+                    continue;
+                }
+                cache.access_item(trace.get(i));
+            }
+        }
+
+        CacheStatistics const &
+        get_statistics() const override
+        {
+            return cache.statistics_;
+        }
+    };
+
+    /// @brief  A worker's queue of runnable consumers. The owner takes
+    ///         from the back and thieves take from the front.
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Consumer *> consumers;
+    };
+
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    std::size_t const num_threads_;
+    std::size_t const block_size_;
+    std::size_t const max_live_blocks_;
+
+    // NOTE These are only valid while running.
+    std::size_t num_blocks_ = 0;
+    /// The decoded blocks, which are null until they are published and
+    /// after their last consumer has finished with them.
+    std::vector<std::unique_ptr<CacheAccessTrace const>> blocks_;
+    std::vector<WorkQueue> queues_;
+    std::mutex mutex_;
+    // NOTE The decoder waits on this for blocks to be finished.
+    std::condition_variable publisher_cv_;
+    // NOTE The idle workers wait on this for runnable consumers.
+    std::condition_variable worker_cv_;
+    // NOTE These are guarded by the mutex.
+    /// The number of caches that have yet to consume each block.
+    std::vector<std::size_t> num_remaining_consumers_;
+    std::size_t num_published_blocks_ = 0;
+    std::size_t num_finished_blocks_ = 0;
+    std::size_t num_finished_consumers_ = 0;
+    std::vector<Consumer *> parked_consumers_;
+    std::atomic<std::size_t> num_queued_consumers_ = 0;
+
+    void
+    enqueue(std::size_t const worker, Consumer *const consumer)
+    {
+        WorkQueue &q = queues_[worker % queues_.size()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.consumers.push_back(consumer);
+        }
+        ++num_queued_consumers_;
+        // NOTE Taking the mutex ensures that an idle worker is either
+        //      waiting (and gets notified) or will see the new count.
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        worker_cv_.notify_one();
+    }
+
+    Consumer *
+    dequeue(std::size_t const worker)
+    {
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            WorkQueue &q = queues_[(worker + i) % queues_.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.consumers.empty()) {
+                continue;
+            }
+            Consumer *consumer = nullptr;
+            if (i == 0) {
+                consumer = q.consumers.back();
+                q.consumers.pop_back();
+            } else {
+                consumer = q.consumers.front();
+                q.consumers.pop_front();
+            }
+            --num_queued_consumers_;
+            return consumer;
+        }
+        return nullptr;
+    }
+
+    /// @brief  Process one block and then requeue, park, or retire the
+    ///         consumer.
+    void
+    step(std::size_t const worker, Consumer *const consumer)
+    {
+        std::size_t const b = consumer->next_block;
+        // NOTE The block cannot be freed until I finish with it, so I can
+        //      read it without the lock.
+        CacheAccessTrace const &block = *blocks_[b];
+        consumer->process(block, 0, block.size());
+        ++consumer->next_block;
+
+        std::unique_ptr<CacheAccessTrace const> finished_block;
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (--num_remaining_consumers_[b] == 0) {
+            // NOTE I free the block after I release the lock.
+            finished_block = std::move(blocks_[b]);
+            ++num_finished_blocks_;
+            publisher_cv_.notify_one();
+        }
+        if (consumer->next_block == num_blocks_) {
+            ++num_finished_consumers_;
+            if (num_finished_consumers_ == consumers_.size()) {
+                worker_cv_.notify_all();
+            }
+        } else if (consumer->next_block < num_published_blocks_) {
+            lock.unlock();
+            enqueue(worker, consumer);
+        } else {
+            parked_consumers_.push_back(consumer);
+        }
+    }
+
+    void
+    work(std::size_t const worker)
+    {
+        while (true) {
+            Consumer *const consumer = dequeue(worker);
+            if (consumer != nullptr) {
+                step(worker, consumer);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mutex_);
+            worker_cv_.wait(lock, [this] {
+                return num_queued_consumers_ > 0 ||
+                       num_finished_consumers_ == consumers_.size();
+            });
+            if (num_finished_consumers_ == consumers_.size()) {
+                return;
+            }
+        }
+    }
+
+    /// @brief  Decode the blocks one by one and release them to the
+    ///         consumers that are waiting for them.
+    void
+    publish(std::uint8_t const *const raw,
+            enum TraceFormat const format,
+            std::size_t const length)
+    {
+        for (std::size_t b = 0; b < num_blocks_; ++b) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                publisher_cv_.wait(lock, [this] {
+                    return num_published_blocks_ - num_finished_blocks_ <
+                           max_live_blocks_;
+                });
+            }
+            // NOTE No consumer reads this block until I publish it, so I
+            //      can decode it without the lock.
+            blocks_[b] = std::make_unique<CacheAccessTrace const>(
+                raw,
+                format,
+                b * block_size_,
+                std::min(length, (b + 1) * block_size_));
+            std::vector<Consumer *> ready;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                ++num_published_blocks_;
+                ready.swap(parked_consumers_);
+            }
+            for (std::size_t i = 0; i < ready.size(); ++i) {
+                enqueue(i, ready[i]);
+            }
+        }
+    }
+
+public:
+    /// @param  num_threads: The number of worker threads, or 0 to use
+    ///                      one per hardware thread.
+    /// @param  block_size: The number of trace items per block.
+    CapacitySweep(std::size_t const num_threads = 0,
+                  std::size_t const block_size = 1 << 16)
+        : num_threads_(num_threads != 0
+                           ? num_threads
+                           : std::max(1u, std::thread::hardware_concurrency())),
+          block_size_(block_size),
+          max_live_blocks_(2 * num_threads_ + 2)
+    {
+        assert(block_size_ != 0);
+    }
+
+    /// @brief  Add a cache, which I construct from its capacity and any
+    ///         extra arguments.
+    template <class T, class... Args>
+    void
+    add_cache(std::size_t const capacity, Args &&...args)
+    {
+        consumers_.push_back(
+            std::make_unique<CacheConsumer<T>>(capacity,
+                                               std::forward<Args>(args)...));
+    }
+
+    /// @brief  Run every cache over the raw trace.
+    /// @note   This should only be called once.
+    void
+    run(std::string const &fname, enum TraceFormat const format)
+    {
+        struct MemoryMap mm = {};
+        std::size_t const bytes_per_obj = get_bytes_per_trace_item(format);
+        if (bytes_per_obj == 0) {
+            LOGGER_ERROR("invalid format %s", get_trace_format_string(format));
+            exit(1);
+        }
+        if (!MemoryMap__init(&mm, fname.c_str(), "rb")) {
+            LOGGER_ERROR("failed to mmap '%s'", fname.c_str());
+            exit(1);
+        }
+        std::size_t const length = mm.num_bytes / bytes_per_obj;
+        // NOTE Without any caches, no one would free the blocks, so I
+        //      do not decode any.
+        num_blocks_ = consumers_.empty()
+                          ? 0
+                          : (length + block_size_ - 1) / block_size_;
+        blocks_.resize(num_blocks_);
+        num_remaining_consumers_.assign(num_blocks_, consumers_.size());
+        queues_ = std::vector<WorkQueue>(num_threads_);
+        if (num_blocks_ == 0) {
+            num_finished_consumers_ = consumers_.size();
+        } else {
+            for (auto &c : consumers_) {
+                parked_consumers_.push_back(c.get());
+            }
+        }
+
+        std::vector<std::thread> workers;
+        for (std::size_t i = 0; i < num_threads_; ++i) {
+            workers.emplace_back(&CapacitySweep::work, this, i);
+        }
+        publish((std::uint8_t const *)mm.buffer, format, length);
+        for (auto &t : workers) {
+            t.join();
+        }
+        MemoryMap__destroy(&mm);
+    }
+
+    /// @brief  Get the statistics of the i-th cache that was added.
+    CacheStatistics const &
+    get_statistics(std::size_t const i) const
+    {
+        return consumers_.at(i)->get_statistics();
+    }
+
+    std::size_t
+    get_capacity(std::size_t const i) const
+    {
+        return consumers_.at(i)->capacity;
+    }
+
+    std::string const &
+    get_name(std::size_t const i) const
+    {
+        return consumers_.at(i)->name;
+    }
+
+    std::size_t
+    size() const
+    {
+        return consumers_.size();
+    }
+};
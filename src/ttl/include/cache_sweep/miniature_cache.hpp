@@ -0,0 +1,85 @@
+/** @brief  Approximate any cache with a miniature, spatially sampled one.
+ *
+ *  Olken and SHARDS only give us MRCs for LRU, because they rely on the
+ *  stack property. For every other policy, I follow Waldspurger et al.'s
+ *  miniature simulations (USENIX ATC '17): I hash-sample the keys at a
+ *  rate R and run the policy at capacity C * R on only the sampled keys.
+ *  The miniature cache's miss ratio approximates the full-sized cache's
+ *  miss ratio at capacity C, using roughly R times the memory and time.
+ */
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "cache_metadata/cache_access.hpp"
+#include "cache_statistics/cache_statistics.hpp"
+#include "hash/hash.h"
+#include "math/ratio.h"
+
+/// @brief  Wrap a cache policy (i.e. anything with a constructor from
+///         its capacity and an 'access_item(CacheAccess const &)'
+///         method) in a miniature simulation.
+/// @note   The statistics only count the sampled accesses, so the miss
+///         ratio is the estimate for the full-sized cache; the raw hit
+///         and miss counts are roughly R times the full-sized ones.
+template <class T>
+class MiniatureCache {
+    T cache_;
+    double const sampling_ratio_;
+    std::uint64_t const threshold_;
+
+public:
+    static constexpr char name[] = "MiniatureCache";
+    CacheStatistics statistics_;
+
+    /// @param  capacity: The capacity of the full-sized cache that I
+    ///                   approximate.
+    /// @param  sampling_ratio: The fraction of keys to sample in (0, 1].
+    MiniatureCache(std::size_t const capacity, double const sampling_ratio)
+        : cache_(get_scaled_capacity(capacity, sampling_ratio)),
+          sampling_ratio_(sampling_ratio),
+          threshold_(ratio_uint64(sampling_ratio))
+    {
+        assert(0.0 < sampling_ratio && sampling_ratio <= 1.0);
+    }
+
+    /// @brief  Get the capacity of the miniature cache that stands in for
+    ///         a full-sized cache.
+    static std::size_t
+    get_scaled_capacity(std::size_t const capacity,
+                        double const sampling_ratio)
+    {
+        // NOTE I round to the nearest rather than truncating so that a
+        //      full-sized capacity of C maps to the miniature capacity
+        //      whose unscaled size is closest to C.
+        return static_cast<std::size_t>(
+            std::llround(capacity * sampling_ratio));
+    }
+
+    double
+    get_sampling_ratio() const
+    {
+        return sampling_ratio_;
+    }
+
+    /// @brief  Get the policy that I am simulating in miniature.
+    T const &
+    get_cache() const
+    {
+        return cache_;
+    }
+
+    int
+    access_item(CacheAccess const &access)
+    {
+        if (Hash64Bit(access.key) > threshold_) {
+            return 0;
+        }
+        int const r = cache_.access_item(access);
+        statistics_ = cache_.statistics_;
+        return r;
+    }
+};
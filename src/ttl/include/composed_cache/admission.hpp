@@ -0,0 +1,80 @@
+/** @brief  Admission policies for the ComposedCache.
+ *
+ *  An admission policy decides whether a missed object enters the cache
+ *  at all. Every policy provides:
+ *
+ *      Admission(std::size_t capacity);
+ *      bool admit(CacheAccess const &access);
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cache/bit_vector.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "hash/hash.h"
+
+class AdmitAll {
+public:
+    static constexpr char name[] = "";
+
+    AdmitAll(std::size_t const)
+    {
+    }
+
+    bool
+    admit(CacheAccess const &)
+    {
+        return true;
+    }
+};
+
+/// @brief  Only admit an object on its second miss, as with TinyLFU's
+///         doorkeeper. This keeps one-hit wonders out of the cache.
+/// @note   I remember the missed keys in a one-hash Bloom filter, which I
+///         reset once it has seen about 'capacity' distinct keys so that
+///         it does not fill up.
+class DoorkeeperAdmission {
+    BitVector bits_;
+    std::uint64_t const mask_;
+    std::size_t const max_num_keys_;
+    std::size_t num_keys_ = 0;
+
+    static std::uint64_t
+    get_num_bits(std::size_t const capacity)
+    {
+        // NOTE I use ~8 bits per key for a false positive rate of ~12%.
+        std::uint64_t n = 64;
+        while (n < 8 * (std::uint64_t)capacity) {
+            n *= 2;
+        }
+        return n;
+    }
+
+public:
+    static constexpr char name[] = "Doorkeeper";
+
+    DoorkeeperAdmission(std::size_t const capacity)
+        : bits_(get_num_bits(capacity)),
+          mask_(get_num_bits(capacity) - 1),
+          max_num_keys_(capacity != 0 ? capacity : 1)
+    {
+    }
+
+    bool
+    admit(CacheAccess const &access)
+    {
+        std::uint64_t const i = Hash64Bit(access.key) & mask_;
+        if (bits_.get(i)) {
+            return true;
+        }
+        if (num_keys_ == max_num_keys_) {
+            bits_ = BitVector(mask_ + 1);
+            num_keys_ = 0;
+        }
+        bits_.set(i);
+        ++num_keys_;
+        return false;
+    }
+};
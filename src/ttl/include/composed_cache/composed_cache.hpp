@@ -0,0 +1,216 @@
+/** @brief  A cache composed from orthogonal, compile-time policies.
+ *
+ *  Rather than have each cache reimplement the hit/miss logic, the
+ *  statistics, and the TTL handling with its own containers, I compose
+ *  a cache from six policies:
+ *
+ *      1. Order: which object to evict (see eviction_order.hpp).
+ *      2. Expiry: when objects expire (see expiry.hpp).
+ *      3. Admission: whether a missed object enters (see admission.hpp).
+ *      4. Metadata: what we record per object (see metadata_store.hpp).
+ *      5. Statistics: where hits and misses go (e.g. CacheStatistics).
+ *      6. Index: the hash table from a key to its slot.
+ *
+ *  The policies are template parameters and members (not base classes
+ *  with virtual methods), so every hook is resolved statically and the
+ *  compiler can inline the whole access path. A policy that does
+ *  nothing (e.g. NoExpiry) compiles away entirely. A new variant is
+ *  just a type alias, e.g.
+ *
+ *      using ComposedTTLClockCache = ComposedCache<ClockOrder, TTLExpiry>;
+ */
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "cache/key_index.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_statistics/cache_statistics.hpp"
+#include "composed_cache/admission.hpp"
+#include "composed_cache/eviction_order.hpp"
+#include "composed_cache/expiry.hpp"
+#include "composed_cache/metadata_store.hpp"
+
+/// @brief  A statistics sink that throws everything away.
+struct NoStatistics {
+    void
+    hit(std::size_t const = 1)
+    {
+    }
+
+    void
+    miss(std::size_t const = 1)
+    {
+    }
+};
+
+/// @brief  Concatenate string literals at compile time.
+template <std::size_t... N>
+constexpr std::array<char, (N + ...) - sizeof...(N) + 1>
+concatenate_names(char const (&...names)[N])
+{
+    std::array<char, (N + ...) - sizeof...(N) + 1> r = {};
+    std::size_t i = 0;
+    for (char const *name : {&names[0]...}) {
+        for (; *name != '\0'; ++name) {
+            r[i++] = *name;
+        }
+    }
+    return r;
+}
+
+template <class Order,
+          class Expiry = NoExpiry,
+          class Admission = AdmitAll,
+          class Metadata = NoMetadata,
+          class Statistics = CacheStatistics,
+          class Index = KeyIndex<Slot>>
+class ComposedCache {
+    static constexpr auto name_ = concatenate_names("Composed",
+                                                    Expiry::name,
+                                                    Order::name,
+                                                    Admission::name,
+                                                    Metadata::name,
+                                                    "Cache");
+
+    std::size_t const capacity_;
+    Index index_;
+    // NOTE The key in each slot, so that I can remove a victim's key from
+    //      the index.
+    std::vector<std::uint64_t> keys_;
+    // NOTE Slots that expiry freed up. Until the cache first fills, I
+    //      hand out fresh slots in order.
+    std::vector<Slot> free_slots_;
+    Slot num_used_slots_ = 0;
+
+    Order order_;
+    Expiry expiry_;
+    Admission admission_;
+    Metadata metadata_;
+
+    /// @brief  Remove an expired object.
+    void
+    remove_expired(Slot const slot)
+    {
+        order_.erase(slot);
+        std::size_t i_erased = index_.erase(keys_[slot]);
+        assert(i_erased == 1);
+        free_slots_.push_back(slot);
+    }
+
+    /// @brief  Find a slot for a new object, evicting if necessary.
+    Slot
+    allocate_slot()
+    {
+        if (!free_slots_.empty()) {
+            Slot const slot = free_slots_.back();
+            free_slots_.pop_back();
+            return slot;
+        }
+        if (num_used_slots_ < capacity_) {
+            return num_used_slots_++;
+        }
+        Slot const victim = order_.evict();
+        expiry_.erase(victim);
+        std::size_t i_erased = index_.erase(keys_[victim]);
+        assert(i_erased == 1);
+        return victim;
+    }
+
+public:
+    static constexpr char const *name = name_.data();
+    Statistics statistics_;
+
+    ComposedCache(std::size_t const capacity)
+        : capacity_(capacity),
+          keys_(capacity),
+          order_(capacity),
+          expiry_(capacity),
+          admission_(capacity),
+          metadata_(capacity)
+    {
+        assert(capacity < UINT32_MAX);
+    }
+
+    std::size_t
+    size() const
+    {
+        return index_.size();
+    }
+
+    bool
+    contains(std::uint64_t const key) const
+    {
+        return index_.find(key) != index_.end();
+    }
+
+    /// @brief  Get the slot of a cached key, e.g. to look up its metadata.
+    std::optional<Slot>
+    get_slot(std::uint64_t const key) const
+    {
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    Metadata const &
+    get_metadata_store() const
+    {
+        return metadata_;
+    }
+
+    int
+    access_item(CacheAccess const &access)
+    {
+        expiry_.expire(access.timestamp_ms,
+                       [this](Slot const slot) { remove_expired(slot); });
+        auto it = index_.find(access.key);
+        if (it != index_.end()) {
+            order_.hit(it->second);
+            expiry_.hit(it->second, access);
+            metadata_.hit(it->second, access);
+            statistics_.hit();
+            return 0;
+        }
+        statistics_.miss();
+        if (capacity_ == 0 || !admission_.admit(access)) {
+            return 0;
+        }
+        Slot const slot = allocate_slot();
+        keys_[slot] = access.key;
+        index_.emplace(access.key, slot);
+        order_.insert(slot);
+        expiry_.insert(slot, access);
+        metadata_.insert(slot, access);
+        assert(index_.size() <= capacity_);
+        return 0;
+    }
+};
+
+using ComposedFIFOCache = ComposedCache<FIFOOrder>;
+using ComposedLRUCache = ComposedCache<LRUOrder>;
+using ComposedClockCache = ComposedCache<ClockOrder>;
+using ComposedSieveCache = ComposedCache<SieveOrder>;
+
+using ComposedTTLFIFOCache = ComposedCache<FIFOOrder, TTLExpiry>;
+using ComposedTTLLRUCache = ComposedCache<LRUOrder, TTLExpiry>;
+using ComposedTTLClockCache = ComposedCache<ClockOrder, TTLExpiry>;
+using ComposedTTLSieveCache = ComposedCache<SieveOrder, TTLExpiry>;
+
+// NOTE These also record each object's history in 16 bytes (see
+//      'PackedCacheMetadata').
+using ComposedTTLFIFOPackedMetadataCache =
+    ComposedCache<FIFOOrder, TTLExpiry, AdmitAll, PackedMetadata>;
+using ComposedTTLLRUPackedMetadataCache =
+    ComposedCache<LRUOrder, TTLExpiry, AdmitAll, PackedMetadata>;
+using ComposedTTLClockPackedMetadataCache =
+    ComposedCache<ClockOrder, TTLExpiry, AdmitAll, PackedMetadata>;
+using ComposedTTLSievePackedMetadataCache =
+    ComposedCache<SieveOrder, TTLExpiry, AdmitAll, PackedMetadata>;
@@ -0,0 +1,203 @@
+/** @brief  Eviction orders for the ComposedCache.
+ *
+ *  An eviction order tracks the slots (i.e. dense indices in
+ *  [0, capacity)) that the cache has filled and picks the victim when
+ *  the cache is full. The cache owns the keys; the order only sees
+ *  slots. Every order provides:
+ *
+ *      Order(std::size_t capacity);
+ *      void insert(Slot slot);     // A new object now lives in 'slot'.
+ *      void hit(Slot slot);        // The object in 'slot' was accessed.
+ *      void erase(Slot slot);      // Remove 'slot' (e.g. on expiry).
+ *      Slot evict();               // Remove and return the victim.
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+
+#include "cache/bit_vector.hpp"
+#include "cache/slot_list.hpp"
+
+/// @brief  First-in, first-out.
+class FIFOOrder {
+    SlotList list_;
+
+public:
+    static constexpr char name[] = "FIFO";
+
+    FIFOOrder(std::size_t const capacity)
+        : list_(capacity)
+    {
+    }
+
+    void
+    insert(Slot const slot)
+    {
+        list_.push_back(slot);
+    }
+
+    void
+    hit(Slot const)
+    {
+    }
+
+    void
+    erase(Slot const slot)
+    {
+        list_.unlink(slot);
+    }
+
+    Slot
+    evict()
+    {
+        return list_.pop_front();
+    }
+};
+
+/// @brief  Least recently used.
+class LRUOrder {
+    // NOTE The front is the least recently used.
+    SlotList list_;
+
+public:
+    static constexpr char name[] = "LRU";
+
+    LRUOrder(std::size_t const capacity)
+        : list_(capacity)
+    {
+    }
+
+    void
+    insert(Slot const slot)
+    {
+        list_.push_back(slot);
+    }
+
+    void
+    hit(Slot const slot)
+    {
+        list_.move_to_back(slot);
+    }
+
+    void
+    erase(Slot const slot)
+    {
+        list_.unlink(slot);
+    }
+
+    Slot
+    evict()
+    {
+        return list_.pop_front();
+    }
+};
+
+/// @brief  CLOCK, expressed as FIFO with reinsertion.
+/// @note   This evicts in the same order as the array-based ClockCache,
+///         but the list lets me remove arbitrary slots when they expire.
+class ClockOrder {
+    SlotList list_;
+    BitVector visited_;
+
+public:
+    static constexpr char name[] = "Clock";
+
+    ClockOrder(std::size_t const capacity)
+        : list_(capacity),
+          visited_(capacity)
+    {
+    }
+
+    void
+    insert(Slot const slot)
+    {
+        visited_.clear(slot);
+        list_.push_back(slot);
+    }
+
+    void
+    hit(Slot const slot)
+    {
+        visited_.set(slot);
+    }
+
+    void
+    erase(Slot const slot)
+    {
+        list_.unlink(slot);
+    }
+
+    Slot
+    evict()
+    {
+        while (true) {
+            Slot const slot = list_.pop_front();
+            if (!visited_.get(slot)) {
+                return slot;
+            }
+            visited_.clear(slot);
+            list_.push_back(slot);
+        }
+    }
+};
+
+/// @brief  SIEVE, where the hand moves from the oldest slot towards the
+///         newest and wraps around.
+class SieveOrder {
+    // NOTE The front is the oldest.
+    SlotList list_;
+    BitVector visited_;
+    // NOTE If the hand is at the end, then the next eviction starts from
+    //      the oldest slot.
+    Slot hand_;
+
+public:
+    static constexpr char name[] = "Sieve";
+
+    SieveOrder(std::size_t const capacity)
+        : list_(capacity),
+          visited_(capacity),
+          hand_(list_.end())
+    {
+    }
+
+    void
+    insert(Slot const slot)
+    {
+        visited_.clear(slot);
+        list_.push_back(slot);
+    }
+
+    void
+    hit(Slot const slot)
+    {
+        visited_.set(slot);
+    }
+
+    void
+    erase(Slot const slot)
+    {
+        if (hand_ == slot) {
+            hand_ = list_.next(slot);
+        }
+        list_.unlink(slot);
+    }
+
+    Slot
+    evict()
+    {
+        assert(!list_.empty());
+        Slot slot = hand_ == list_.end() ? list_.front() : hand_;
+        while (visited_.get(slot)) {
+            visited_.clear(slot);
+            slot = list_.next(slot);
+            if (slot == list_.end()) {
+                slot = list_.front();
+            }
+        }
+        hand_ = list_.next(slot);
+        list_.unlink(slot);
+        return slot;
+    }
+};
@@ -0,0 +1,124 @@
+/** @brief  Expiry structures for the ComposedCache.
+ *
+ *  An expiry structure tracks when each slot expires. Every structure
+ *  provides:
+ *
+ *      Expiry(std::size_t capacity);
+ *      template <class F> void expire(std::uint64_t now_ms, F &&erase);
+ *      void insert(Slot slot, CacheAccess const &access);
+ *      void hit(Slot slot, CacheAccess const &access);
+ *      void erase(Slot slot);
+ *
+ *  where 'expire' calls 'erase' on every slot that expires at or before
+ *  'now_ms' (and forgets about them itself).
+ */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cache_metadata/cache_access.hpp"
+#include "composed_cache/eviction_order.hpp"
+#include "math/saturation_arithmetic.h"
+#include "ttl_cache/timing_wheel.hpp"
+
+/// @brief  Objects never expire, so this compiles away entirely.
+class NoExpiry {
+public:
+    static constexpr char name[] = "";
+
+    NoExpiry(std::size_t const)
+    {
+    }
+
+    template <class F>
+    void
+    expire(std::uint64_t const, F &&)
+    {
+    }
+
+    void
+    insert(Slot const, CacheAccess const &)
+    {
+    }
+
+    void
+    hit(Slot const, CacheAccess const &)
+    {
+    }
+
+    void
+    erase(Slot const)
+    {
+    }
+};
+
+/// @brief  Expire objects according to the TTL of their accesses.
+/// @note   An access without a TTL leaves the expiration time alone, so
+///         an object that was inserted without one never expires.
+class TTLExpiry {
+    static constexpr TimingWheel::Handle NIL = UINT32_MAX;
+
+    TimingWheel wheel_;
+    std::vector<TimingWheel::Handle> handles_;
+
+    static std::uint64_t
+    get_expiration_time_ms(CacheAccess const &access)
+    {
+        return saturation_add(access.timestamp_ms, *access.ttl_ms);
+    }
+
+public:
+    static constexpr char name[] = "TTL";
+
+    TTLExpiry(std::size_t const capacity)
+        : handles_(capacity, NIL)
+    {
+    }
+
+    template <class F>
+    void
+    expire(std::uint64_t const now_ms, F &&erase)
+    {
+        wheel_.drain_expired(now_ms, [this, &erase](std::uint64_t const key) {
+            Slot const slot = static_cast<Slot>(key);
+            handles_[slot] = NIL;
+            erase(slot);
+        });
+    }
+
+    void
+    insert(Slot const slot, CacheAccess const &access)
+    {
+        assert(handles_[slot] == NIL);
+        if (access.ttl_ms) {
+            handles_[slot] =
+                wheel_.schedule(slot, get_expiration_time_ms(access));
+        }
+    }
+
+    void
+    hit(Slot const slot, CacheAccess const &access)
+    {
+        if (!access.ttl_ms) {
+            return;
+        }
+        if (handles_[slot] == NIL) {
+            handles_[slot] =
+                wheel_.schedule(slot, get_expiration_time_ms(access));
+        } else {
+            wheel_.reschedule(handles_[slot], get_expiration_time_ms(access));
+        }
+    }
+
+    void
+    erase(Slot const slot)
+    {
+        if (handles_[slot] != NIL) {
+            wheel_.erase(handles_[slot]);
+            handles_[slot] = NIL;
+        }
+    }
+};
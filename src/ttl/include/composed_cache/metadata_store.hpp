@@ -0,0 +1,141 @@
+/** @brief  Per-object metadata stores for the ComposedCache.
+ *
+ *  A metadata store keeps one metadata record per slot. The eviction
+ *  orders keep whatever state they need themselves, so this is only for
+ *  analyses (and future policies) that want the full per-object
+ *  history. Every store provides:
+ *
+ *      Store(std::size_t capacity);
+ *      void insert(Slot slot, CacheAccess const &access);
+ *      void hit(Slot slot, CacheAccess const &access);
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "cache_metadata/cache_access.hpp"
+#include "cache_metadata/cache_metadata.hpp"
+#include "cache_metadata/packed_cache_metadata.hpp"
+#include "composed_cache/eviction_order.hpp"
+#include "math/saturation_arithmetic.h"
+
+/// @brief  Get an access's absolute expiration time (or UINT64_MAX).
+static inline std::uint64_t
+get_access_expiration_time_ms(CacheAccess const &access)
+{
+    if (!access.ttl_ms) {
+        return UINT64_MAX;
+    }
+    return saturation_add(access.timestamp_ms, *access.ttl_ms);
+}
+
+/// @brief  Keep no metadata at all, so this compiles away entirely.
+class NoMetadata {
+public:
+    static constexpr char name[] = "";
+
+    NoMetadata(std::size_t const)
+    {
+    }
+
+    void
+    insert(Slot const, CacheAccess const &)
+    {
+    }
+
+    void
+    hit(Slot const, CacheAccess const &)
+    {
+    }
+};
+
+/// @brief  Keep a full, 48-byte CacheMetadata per object.
+class FullMetadata {
+    std::vector<CacheMetadata> metadata_;
+
+public:
+    static constexpr char name[] = "Metadata";
+
+    FullMetadata(std::size_t const capacity)
+        : metadata_(capacity, CacheMetadata(0, 0))
+    {
+    }
+
+    void
+    insert(Slot const slot, CacheAccess const &access)
+    {
+        metadata_[slot] = CacheMetadata(access.size_bytes,
+                                        access.timestamp_ms,
+                                        get_access_expiration_time_ms(access));
+    }
+
+    void
+    hit(Slot const slot, CacheAccess const &access)
+    {
+        metadata_[slot].visit(
+            access.timestamp_ms,
+            access.ttl_ms ? std::optional<std::uint64_t>(
+                                get_access_expiration_time_ms(access))
+                          : std::nullopt);
+    }
+
+    CacheMetadata const &
+    get(Slot const slot) const
+    {
+        return metadata_[slot];
+    }
+};
+
+/// @brief  Keep a 16-byte PackedCacheMetadata per object, with times
+///         relative to the first access that the cache sees.
+class PackedMetadata {
+    std::vector<PackedCacheMetadata> metadata_;
+    std::optional<std::uint64_t> epoch_ms_;
+
+public:
+    static constexpr char name[] = "PackedMetadata";
+
+    PackedMetadata(std::size_t const capacity)
+        : metadata_(capacity)
+    {
+    }
+
+    void
+    insert(Slot const slot, CacheAccess const &access)
+    {
+        if (!epoch_ms_) {
+            epoch_ms_ = access.timestamp_ms;
+        }
+        metadata_[slot] =
+            PackedCacheMetadata(*epoch_ms_,
+                                access.size_bytes,
+                                access.timestamp_ms,
+                                get_access_expiration_time_ms(access));
+    }
+
+    void
+    hit(Slot const slot, CacheAccess const &access)
+    {
+        metadata_[slot].visit(
+            *epoch_ms_,
+            access.timestamp_ms,
+            access.ttl_ms ? std::optional<std::uint64_t>(
+                                get_access_expiration_time_ms(access))
+                          : std::nullopt);
+    }
+
+    PackedCacheMetadata const &
+    get(Slot const slot) const
+    {
+        return metadata_[slot];
+    }
+
+    std::uint64_t
+    get_epoch_ms() const
+    {
+        return epoch_ms_.value_or(0);
+    }
+};
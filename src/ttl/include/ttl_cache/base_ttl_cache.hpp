@@ -5,17 +5,17 @@
 #include <cstddef>
 #include <cstdint>
 #include <limits>
-#include <map>
 #include <optional>
 #include <sstream>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
-#include "cache/base_cache.hpp"
-#include "cache_metadata/cache_metadata.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_metadata/packed_cache_metadata.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "math/saturation_arithmetic.h"
+#include "ttl_cache/timing_wheel.hpp"
 
 constexpr std::size_t DEFAULT_EPOCH_TIME_MS = (std::size_t)1 << 40;
 
@@ -52,6 +52,17 @@ get_ttl_cache_access_time(std::uint64_t const expiration_time,
     return expiration_time % epoch_time_ms;
 }
 
+/// @brief  The metadata of a cached object and its position in the
+///         expiration queue.
+/// @note   The expiration queue owns the expiration time, which may be
+///         virtual (i.e. offset by DEFAULT_EPOCH_TIME_MS), so the metadata
+///         only records real times relative to the cache's epoch. This
+///         keeps the metadata to 16 bytes rather than CacheMetadata's 48.
+struct TTLCacheEntry {
+    PackedCacheMetadata metadata;
+    TimingWheel::Handle handle;
+};
+
 class BaseTTLCache {
 public:
     BaseTTLCache(std::size_t const capacity)
@@ -72,7 +83,8 @@ public:
     {
         std::vector<std::uint64_t> keys;
         keys.reserve(capacity_);
-        for (auto [exp_tm, key] : expiration_queue_) {
+        for (auto [exp_tm, key] :
+             expiration_queue_.get_entries_in_expiration_order()) {
             keys.push_back(key);
         }
         return keys;
@@ -83,44 +95,74 @@ public:
     std::optional<std::pair<std::uint64_t, std::uint64_t>>
     get_soonest_expiring()
     {
-        auto begin = expiration_queue_.begin();
-        if (begin == expiration_queue_.end()) {
+        auto const handle = expiration_queue_.peek();
+        if (!handle) {
             return {};
         }
-        return {{begin->first, begin->second}};
+        return {{expiration_queue_.get_time(*handle),
+                 expiration_queue_.get_key(*handle)}};
     }
 
     std::optional<std::uint64_t>
     evict_soonest_expiring()
     {
-        auto const it = expiration_queue_.begin();
-        if (it == expiration_queue_.end()) {
+        auto const victim_key = expiration_queue_.pop();
+        if (!victim_key) {
             return std::nullopt;
         }
-        std::uint64_t victim_key = it->second;
-        expiration_queue_.erase(it);
-        std::size_t i = map_.erase(victim_key);
+        std::size_t i = map_.erase(*victim_key);
         assert(i == 1);
         return victim_key;
     }
 
+    /// @brief  Insert an object that is not yet in the cache.
+    /// @note   The first insertion sets the cache's epoch.
+    TTLCacheEntry &
+    insert_item(std::uint64_t const key,
+                std::uint64_t const access_time_ms,
+                std::uint64_t const expiration_time_ms)
+    {
+        if (!epoch_ms_) {
+            epoch_ms_ = access_time_ms;
+        }
+        TimingWheel::Handle const handle =
+            expiration_queue_.schedule(key, expiration_time_ms);
+        auto [it, inserted] = map_.emplace(
+            key,
+            TTLCacheEntry{PackedCacheMetadata(*epoch_ms_,
+                                              1,
+                                              access_time_ms,
+                                              UINT64_MAX),
+                          handle});
+        assert(inserted);
+        return it->second;
+    }
+
+    /// @brief  Record an access to an object that is in the cache.
+    void
+    visit_item(TTLCacheEntry &entry, std::uint64_t const access_time_ms)
+    {
+        entry.metadata.visit(get_epoch_ms(), access_time_ms, std::nullopt);
+    }
+
+    std::uint64_t
+    get_expiration_time(TTLCacheEntry const &entry) const
+    {
+        return expiration_queue_.get_time(entry.handle);
+    }
+
     /// @brief  Change the expiration time of an object.
-    bool
-    update_expiration_time(std::uint64_t const old_expiration_time_ms,
-                           std::uint64_t const key,
+    void
+    update_expiration_time(TTLCacheEntry &entry,
                            std::uint64_t const new_expiration_time_ms)
     {
-        auto [begin, end] =
-            expiration_queue_.equal_range(old_expiration_time_ms);
-        for (auto x = begin; x != end; ++x) {
-            if (x->second == key) {
-                auto nh = expiration_queue_.extract(x);
-                nh.key() = new_expiration_time_ms;
-                expiration_queue_.insert(std::move(nh));
-                return true;
-            }
-        }
-        return true;
+        expiration_queue_.reschedule(entry.handle, new_expiration_time_ms);
+    }
+
+    std::uint64_t
+    get_epoch_ms() const
+    {
+        return epoch_ms_.value_or(0);
     }
 
     template <class Stream>
@@ -130,14 +172,15 @@ public:
         s << name << "(capacity=" << capacity_ << ",size=" << size() << ")"
           << std::endl;
         s << "> Key-Metadata Map:" << std::endl;
-        for (auto [k, metadata] : map_) {
+        for (auto &[k, entry] : map_) {
             // This is inefficient, but looks easier on the eyes.
             std::stringstream ss;
-            metadata.to_stream(ss);
+            entry.metadata.to_stream(ss, get_epoch_ms());
             s << ">> key: " << k << ", metadata: " << ss.str() << std::endl;
         }
         s << "> Expiration Queue:" << std::endl;
-        for (auto [exp_tm, k] : expiration_queue_) {
+        for (auto [exp_tm, k] :
+             expiration_queue_.get_entries_in_expiration_order()) {
             s << ">> expiration time[ms]: " << exp_tm << ", key: " << k
               << std::endl;
         }
@@ -158,18 +201,16 @@ public:
         if (verbose >= 2) {
             to_stream(std::cout);
         }
-        for (auto [k, metadata] : map_) {
+        for (auto &[k, entry] : map_) {
             if (verbose >= 2) {
                 std::stringstream ss;
-                metadata.to_stream(ss);
+                entry.metadata.to_stream(ss, get_epoch_ms());
                 std::cout << "> Validating: key=" << k
-                          << ", metadata=" << ss.str() << std::endl;
+                          << ", metadata=" << ss.str()
+                          << ", expiration_time[ms]="
+                          << get_expiration_time(entry) << std::endl;
             }
-            assert(expiration_queue_.count(metadata.expiration_time_ms_));
-            auto obj = expiration_queue_.find(metadata.expiration_time_ms_);
-            assert(obj != expiration_queue_.end());
-            assert(obj->first == metadata.expiration_time_ms_);
-            assert(obj->second == k);
+            assert(expiration_queue_.get_key(entry.handle) == k);
         }
         return true;
     }
@@ -181,8 +222,10 @@ protected:
     std::size_t const capacity_;
 
     /// @brief  Map the keys to the metadata.
-    std::unordered_map<std::uint64_t, CacheMetadata> map_;
-    std::multimap<std::uint64_t, std::uint64_t> expiration_queue_;
+    std::unordered_map<std::uint64_t, TTLCacheEntry> map_;
+    TimingWheel expiration_queue_;
+    /// The time of the first insertion, from which the metadata counts.
+    std::optional<std::uint64_t> epoch_ms_;
 
 public:
     static constexpr char name[] = "BaseTTLCache";
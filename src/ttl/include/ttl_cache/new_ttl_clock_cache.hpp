@@ -1,8 +1,7 @@
 #include <cstddef>
 #include <iostream>
 
-#include "cache/base_cache.hpp"
-#include "cache_metadata/cache_metadata.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "ttl_cache/base_ttl_cache.hpp"
 #include "unused/mark_unused.h"
 
@@ -28,7 +27,8 @@ class NewTTLClockCache : public BaseTTLCache {
             //      have a TTL in the promoted or non-promoted position.
             insertion_position_ms_ = DEFAULT_EPOCH_TIME_MS + size();
         } else {
-            std::uint64_t min_exp_tm = expiration_queue_.begin()->first;
+            std::uint64_t min_exp_tm =
+                expiration_queue_.get_time(*expiration_queue_.peek());
             insertion_position_ms_ = min_exp_tm + capacity_;
         }
     }
@@ -38,15 +38,12 @@ class NewTTLClockCache : public BaseTTLCache {
     {
         auto obj = map_.find(key);
         assert(obj != map_.end());
-        CacheMetadata &metadata = obj->second;
-        auto old_exp_tm_ms = metadata.expiration_time_ms_;
+        auto old_exp_tm_ms = get_expiration_time(obj->second);
+        visit_item(obj->second, timestamp_ms);
         if (old_exp_tm_ms < insertion_position_ms_) {
             std::uint64_t const new_exp_tm_ms = old_exp_tm_ms + capacity_;
-            metadata.visit(timestamp_ms, new_exp_tm_ms);
-            update_expiration_time(old_exp_tm_ms, key, new_exp_tm_ms);
+            update_expiration_time(obj->second, new_exp_tm_ms);
             update_insertion_position_ms();
-        } else {
-            metadata.visit(timestamp_ms, {});
         }
         statistics_.hit();
     }
@@ -60,8 +57,7 @@ class NewTTLClockCache : public BaseTTLCache {
             assert(map_.size() + 1 == capacity_);
         }
         std::uint64_t exp_tm_ms = insertion_position_ms_;
-        map_.emplace(key, CacheMetadata(timestamp_ms, exp_tm_ms));
-        expiration_queue_.emplace(exp_tm_ms, key);
+        insert_item(key, timestamp_ms, exp_tm_ms);
         statistics_.miss();
         update_insertion_position_ms();
     }
@@ -89,7 +85,8 @@ public:
             std::cout << k << ",";
         }
         std::cout << "} ";
-        for (auto [tm, k] : expiration_queue_) {
+        for (auto [tm, k] :
+             expiration_queue_.get_entries_in_expiration_order()) {
             std::cout << k << "@" << tm << ",";
         }
         std::cout << std::endl;
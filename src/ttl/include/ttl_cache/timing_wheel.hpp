@@ -0,0 +1,403 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/// @brief  A hierarchical timing wheel that orders keys by expiration
+///         time, with an O(1) handle per entry to reschedule or erase
+///         it.
+/// @details    Each level has 64 slots and covers 6 more bits of the time
+///             than the level below it. An entry is placed relative to
+///             the wheel's current time: at the level of the most
+///             significant 6-bit digit in which they differ, in the slot
+///             of its own digit there. Thus, all entries in a level-0
+///             slot expire at the same time, and the soonest expiring
+///             entries are in the first non-empty slot of the lowest
+///             non-empty level. When that is not level 0, I advance the
+///             current time to the slot's earliest expiration time and
+///             cascade the slot's entries down to lower levels.
+/// @note   Entries with equal expiration times are always in the same
+///         slot and are kept in the order that they were (re)scheduled,
+///         so ties expire first-in, first-out (as with std::multimap).
+/// @note   The TTL caches may schedule an entry before the current time
+///         (e.g. a new key whose expiration time is earlier than that of
+///         a key that we just evicted). In that case, I move the current
+///         time back and splice the levels that no longer fit into one
+///         slot, which is O(number of levels * slots).
+class TimingWheel {
+public:
+    using Handle = std::uint32_t;
+
+private:
+    static constexpr unsigned DIGIT_BITS = 6;
+    static constexpr std::size_t NUM_SLOTS = 1 << DIGIT_BITS;
+    static constexpr std::size_t NUM_LEVELS =
+        (64 + DIGIT_BITS - 1) / DIGIT_BITS;
+    static constexpr Handle NIL = UINT32_MAX;
+    // NOTE The first nodes are the sentinels of the circular slot lists.
+    static constexpr Handle NUM_SENTINELS = NUM_LEVELS * NUM_SLOTS;
+
+    struct Node {
+        std::uint64_t time;
+        std::uint64_t key;
+        Handle prev;
+        Handle next;
+    };
+
+    std::vector<Node> nodes_;
+    // NOTE A set bit means that the slot may be non-empty. I only clear
+    //      bits lazily, upon finding the slot empty, so that erasing an
+    //      entry does not need to know which slot it is in.
+    std::uint64_t occupied_[NUM_LEVELS] = {0};
+    // NOTE This is a lower bound on the expiration times in the wheel.
+    std::uint64_t current_time_ = 0;
+    // NOTE This is another lower bound on the expiration times, which
+    //      lets us skip looking for expired entries on most accesses.
+    std::uint64_t no_expiry_before_ = 0;
+    std::size_t size_ = 0;
+    // NOTE Free nodes are chained through their 'next' links.
+    Handle free_ = NIL;
+
+    static constexpr Handle
+    get_sentinel(std::size_t const level, std::size_t const slot)
+    {
+        return static_cast<Handle>(level * NUM_SLOTS + slot);
+    }
+
+    static std::size_t
+    get_digit(std::uint64_t const time, std::size_t const level)
+    {
+        return (time >> (level * DIGIT_BITS)) & (NUM_SLOTS - 1);
+    }
+
+    /// @brief  Get the most significant digit in which two times differ.
+    static std::size_t
+    get_level(std::uint64_t const a, std::uint64_t const b)
+    {
+        std::uint64_t const x = a ^ b;
+        if (x == 0) {
+            return 0;
+        }
+        return (63 - __builtin_clzll(x)) / DIGIT_BITS;
+    }
+
+    bool
+    is_empty_slot(Handle const sentinel) const
+    {
+        return nodes_[sentinel].next == sentinel;
+    }
+
+    void
+    unlink(Handle const i)
+    {
+        Node &n = nodes_[i];
+        nodes_[n.prev].next = n.next;
+        nodes_[n.next].prev = n.prev;
+    }
+
+    void
+    link_at_tail(Handle const sentinel, Handle const i)
+    {
+        Handle const tail = nodes_[sentinel].prev;
+        nodes_[i].prev = tail;
+        nodes_[i].next = sentinel;
+        nodes_[tail].next = i;
+        nodes_[sentinel].prev = i;
+    }
+
+    /// @brief  Move a whole slot list onto the tail of another.
+    void
+    splice(Handle const to, Handle const from)
+    {
+        if (is_empty_slot(from)) {
+            return;
+        }
+        Handle const first = nodes_[from].next;
+        Handle const last = nodes_[from].prev;
+        Handle const tail = nodes_[to].prev;
+        nodes_[tail].next = first;
+        nodes_[first].prev = tail;
+        nodes_[last].next = to;
+        nodes_[to].prev = last;
+        nodes_[from].next = nodes_[from].prev = from;
+    }
+
+    /// @brief  Move the current time back to 'time'.
+    /// @details    Entries at levels below the most significant digit, D,
+    ///             in which the old and new current times differ all share
+    ///             the old current time's digit D, so they all belong in
+    ///             that slot of level D. Entries at higher levels are
+    ///             unaffected.
+    void
+    rewind(std::uint64_t const time)
+    {
+        assert(time < current_time_);
+        std::size_t const top = get_level(time, current_time_);
+        Handle const target = get_sentinel(top, get_digit(current_time_, top));
+        // NOTE If the times only differ in the lowest digit, then the
+        //      target slot holds the entries that expire at the old
+        //      current time, which stay where they are.
+        assert(top == 0 || is_empty_slot(target));
+        for (std::size_t level = 0; level < top; ++level) {
+            for (std::uint64_t bits = occupied_[level]; bits != 0;
+                 bits &= bits - 1) {
+                splice(target, get_sentinel(level, __builtin_ctzll(bits)));
+            }
+            occupied_[level] = 0;
+        }
+        if (!is_empty_slot(target)) {
+            occupied_[top] |= (std::uint64_t)1 << get_digit(current_time_, top);
+        }
+        current_time_ = time;
+    }
+
+    void
+    place(Handle const i)
+    {
+        std::uint64_t const time = nodes_[i].time;
+        no_expiry_before_ = std::min(no_expiry_before_, time);
+        if (time < current_time_) {
+            rewind(time);
+        }
+        std::size_t const level = get_level(time, current_time_);
+        std::size_t const slot = get_digit(time, level);
+        link_at_tail(get_sentinel(level, slot), i);
+        occupied_[level] |= (std::uint64_t)1 << slot;
+    }
+
+    /// @brief  Find the first non-empty slot of the lowest non-empty
+    ///         level, which holds the soonest expiring entries.
+    /// @return The slot's level and sentinel or NIL if the wheel is empty.
+    std::pair<std::size_t, Handle>
+    find_first_occupied_slot()
+    {
+        for (std::size_t level = 0; level < NUM_LEVELS;) {
+            if (occupied_[level] == 0) {
+                ++level;
+                continue;
+            }
+            std::size_t const slot = __builtin_ctzll(occupied_[level]);
+            Handle const sentinel = get_sentinel(level, slot);
+            if (!is_empty_slot(sentinel)) {
+                return {level, sentinel};
+            }
+            occupied_[level] &= ~((std::uint64_t)1 << slot);
+        }
+        return {NUM_LEVELS, NIL};
+    }
+
+    /// @brief  Get the earliest time that could be in a slot.
+    std::uint64_t
+    get_slot_lower_bound(std::size_t const level, Handle const sentinel) const
+    {
+        std::size_t const shift = level * DIGIT_BITS;
+        std::uint64_t const slot = sentinel - get_sentinel(level, 0);
+        // NOTE The shift would overflow for the top level, which has no
+        //      higher digits.
+        std::uint64_t const high =
+            shift + DIGIT_BITS >= 64
+                ? 0
+                : current_time_ >> (shift + DIGIT_BITS) << (shift + DIGIT_BITS);
+        return high | (slot << shift);
+    }
+
+    /// @brief  Find the level-0 slot with the soonest expiring entries,
+    ///         cascading higher levels down as necessary.
+    /// @return The slot's sentinel or NIL if the wheel is empty.
+    Handle
+    find_soonest_slot()
+    {
+        while (true) {
+            auto const [level, sentinel] = find_first_occupied_slot();
+            if (sentinel == NIL || level == 0) {
+                return sentinel;
+            }
+            // NOTE The lower levels are empty, so moving the current time
+            //      up to this slot's earliest entry leaves every other
+            //      entry where it belongs. This slot's entries all move
+            //      to lower levels, preserving their order.
+            std::uint64_t earliest = UINT64_MAX;
+            for (Handle i = nodes_[sentinel].next; i != sentinel;
+                 i = nodes_[i].next) {
+                earliest = std::min(earliest, nodes_[i].time);
+            }
+            current_time_ = earliest;
+            occupied_[level] &=
+                ~((std::uint64_t)1 << (sentinel - get_sentinel(level, 0)));
+            for (Handle i = nodes_[sentinel].next; i != sentinel;) {
+                Handle const next = nodes_[i].next;
+                place(i);
+                i = next;
+            }
+            nodes_[sentinel].next = nodes_[sentinel].prev = sentinel;
+        }
+    }
+
+    void
+    release(Handle const i)
+    {
+        nodes_[i].next = free_;
+        free_ = i;
+        --size_;
+    }
+
+public:
+    TimingWheel()
+        : nodes_(NUM_SENTINELS)
+    {
+        for (Handle i = 0; i < NUM_SENTINELS; ++i) {
+            nodes_[i].prev = nodes_[i].next = i;
+        }
+    }
+
+    std::size_t
+    size() const noexcept
+    {
+        return size_;
+    }
+
+    bool
+    empty() const noexcept
+    {
+        return size_ == 0;
+    }
+
+    std::uint64_t
+    get_time(Handle const handle) const
+    {
+        return nodes_[handle].time;
+    }
+
+    std::uint64_t
+    get_key(Handle const handle) const
+    {
+        return nodes_[handle].key;
+    }
+
+    Handle
+    schedule(std::uint64_t const key, std::uint64_t const time)
+    {
+        Handle i = free_;
+        if (i != NIL) {
+            free_ = nodes_[i].next;
+        } else {
+            assert(nodes_.size() < NIL);
+            i = static_cast<Handle>(nodes_.size());
+            nodes_.push_back({});
+        }
+        nodes_[i].time = time;
+        nodes_[i].key = key;
+        place(i);
+        ++size_;
+        return i;
+    }
+
+    /// @note   A rescheduled entry goes after any others with the same
+    ///         expiration time.
+    void
+    reschedule(Handle const handle, std::uint64_t const time)
+    {
+        assert(handle >= NUM_SENTINELS);
+        unlink(handle);
+        nodes_[handle].time = time;
+        place(handle);
+    }
+
+    void
+    erase(Handle const handle)
+    {
+        assert(handle >= NUM_SENTINELS);
+        unlink(handle);
+        release(handle);
+    }
+
+    /// @brief  Get the soonest expiring entry without removing it.
+    std::optional<Handle>
+    peek()
+    {
+        Handle const sentinel = find_soonest_slot();
+        if (sentinel == NIL) {
+            return {};
+        }
+        return nodes_[sentinel].next;
+    }
+
+    /// @brief  Remove the soonest expiring entry.
+    /// @return Its key.
+    std::optional<std::uint64_t>
+    pop()
+    {
+        std::optional<Handle> const handle = peek();
+        if (!handle) {
+            return {};
+        }
+        std::uint64_t const key = nodes_[*handle].key;
+        erase(*handle);
+        return key;
+    }
+
+    /// @brief  Remove every entry that expires at or before 'now', a
+    ///         whole slot at a time, and call 'f' on each of their keys.
+    /// @return The number of entries that we removed.
+    template <class F>
+    std::size_t
+    drain_expired(std::uint64_t const now, F &&f)
+    {
+        std::size_t n = 0;
+        while (now >= no_expiry_before_) {
+            // NOTE I check the slot's lower bound first so that we do not
+            //      cascade entries that are nowhere near expiring.
+            auto const [level, first] = find_first_occupied_slot();
+            if (first == NIL) {
+                no_expiry_before_ = UINT64_MAX;
+                break;
+            }
+            no_expiry_before_ = get_slot_lower_bound(level, first);
+            if (no_expiry_before_ > now) {
+                break;
+            }
+            Handle const sentinel = find_soonest_slot();
+            no_expiry_before_ = nodes_[nodes_[sentinel].next].time;
+            if (no_expiry_before_ > now) {
+                break;
+            }
+            for (Handle i = nodes_[sentinel].next; i != sentinel;) {
+                Handle const next = nodes_[i].next;
+                f(nodes_[i].key);
+                release(i);
+                ++n;
+                i = next;
+            }
+            nodes_[sentinel].next = nodes_[sentinel].prev = sentinel;
+        }
+        return n;
+    }
+
+    /// @brief  Get the {expiration time, key} pairs from soonest to
+    ///         latest expiring.
+    /// @note   This is O(N log N) and is meant for debugging.
+    std::vector<std::pair<std::uint64_t, std::uint64_t>>
+    get_entries_in_expiration_order() const
+    {
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> entries;
+        entries.reserve(size_);
+        for (Handle sentinel = 0; sentinel < NUM_SENTINELS; ++sentinel) {
+            for (Handle i = nodes_[sentinel].next; i != sentinel;
+                 i = nodes_[i].next) {
+                entries.push_back({nodes_[i].time, nodes_[i].key});
+            }
+        }
+        // NOTE Ties are within a single slot, so the stable sort keeps
+        //      them in first-in, first-out order.
+        std::stable_sort(
+            entries.begin(),
+            entries.end(),
+            [](auto const &a, auto const &b) { return a.first < b.first; });
+        return entries;
+    }
+};
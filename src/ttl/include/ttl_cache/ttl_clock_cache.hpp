@@ -2,20 +2,20 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <optional>
 #include <unordered_map>
 
-#include "cache/base_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "math/saturation_arithmetic.h"
+#include "ttl_cache/timing_wheel.hpp"
 
 class TTLClockCache {
     std::uint64_t const ttl_s_ = 1 << 30;
     std::size_t const capacity_;
 
     std::unordered_map<std::uint64_t, bool> map_;
-    std::multimap<std::uint64_t, std::uint64_t> expiration_queue_;
+    TimingWheel expiration_queue_;
     std::uint64_t logical_time_ = 0;
 
 public:
@@ -37,32 +37,38 @@ public:
     std::optional<std::uint64_t>
     evict_ttl_clock()
     {
-        if (map_.size() == 0) {
-            return {};
-        }
-        for (auto it = expiration_queue_.begin(); it != expiration_queue_.end();
-             ++it) {
-            auto const victim_key = it->second;
-            if (map_[victim_key]) {
-                map_[victim_key] = false;
-                auto nh = expiration_queue_.extract(it);
-                nh.key() =
-                    TTLClockCache::get_expiry_time_ms(logical_time_, ttl_s_);
-                // NOTE We don't seem to access the object we just
-                //      inserted into the multimap data structure...
-                //      how come?
-                expiration_queue_.insert(std::move(nh));
+        // NOTE A visited object is given a new expiration time, which puts
+        //      it behind every other object. Thus, this terminates within
+        //      one revolution of the clock.
+        for (auto handle = expiration_queue_.peek(); handle;
+             handle = expiration_queue_.peek()) {
+            std::uint64_t const victim_key = expiration_queue_.get_key(*handle);
+            bool &visited = map_[victim_key];
+            if (visited) {
+                visited = false;
+                expiration_queue_.reschedule(
+                    *handle,
+                    TTLClockCache::get_expiry_time_ms(logical_time_, ttl_s_));
             } else {
-                expiration_queue_.erase(it);
+                expiration_queue_.erase(*handle);
                 std::size_t i = map_.erase(victim_key);
                 assert(i == 1);
                 return victim_key;
             }
         }
-        // We've traversed the whole clock, so retry! I don't understand
-        // why this is necessary if we've inserted a refreshed object
-        // into the eviction_queue_.
-        return this->evict_ttl_clock();
+        return {};
+    }
+
+    /// @brief  Evict the objects whose expiration time has passed.
+    std::size_t
+    evict_expired()
+    {
+        return expiration_queue_.drain_expired(
+            logical_time_,
+            [this](std::uint64_t const key) {
+                std::size_t i = map_.erase(key);
+                assert(i == 1);
+            });
     }
 
     int
@@ -73,6 +79,7 @@ public:
             statistics_.miss();
             return 0;
         }
+        evict_expired();
         if (map_.count(access.key)) {
             map_[access.key] = true;
             statistics_.hit();
@@ -85,7 +92,7 @@ public:
             map_[access.key] = false;
             uint64_t eviction_time_ms =
                 TTLClockCache::get_expiry_time_ms(logical_time_, ttl_s_);
-            expiration_queue_.emplace(eviction_time_ms, access.key);
+            expiration_queue_.schedule(access.key, eviction_time_ms);
             statistics_.miss();
         }
         ++logical_time_;
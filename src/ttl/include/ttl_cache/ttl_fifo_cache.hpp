@@ -2,20 +2,20 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <optional>
 #include <unordered_map>
 
-#include "cache/base_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "math/saturation_arithmetic.h"
+#include "ttl_cache/timing_wheel.hpp"
 
 class TTLFIFOCache {
     std::uint64_t const ttl_s_ = 1 << 30;
     std::size_t const capacity_;
 
     std::unordered_map<std::uint64_t, bool> map_;
-    std::multimap<std::uint64_t, std::uint64_t> expiration_queue_;
+    TimingWheel expiration_queue_;
     std::uint64_t logical_time_ = 0;
 
 public:
@@ -30,17 +30,27 @@ public:
     std::optional<std::uint64_t>
     evict_ttl_fifo()
     {
-        auto const it = expiration_queue_.begin();
-        if (it == expiration_queue_.end()) {
+        auto const victim_key = expiration_queue_.pop();
+        if (!victim_key) {
             return std::nullopt;
         }
-        std::uint64_t victim_key = it->second;
-        expiration_queue_.erase(it);
-        std::size_t i = map_.erase(victim_key);
+        std::size_t i = map_.erase(*victim_key);
         assert(i == 1);
         return victim_key;
     }
 
+    /// @brief  Evict the objects whose expiration time has passed.
+    std::size_t
+    evict_expired()
+    {
+        return expiration_queue_.drain_expired(
+            logical_time_,
+            [this](std::uint64_t const key) {
+                std::size_t i = map_.erase(key);
+                assert(i == 1);
+            });
+    }
+
     int
     access_item(CacheAccess const &access)
     {
@@ -49,6 +59,7 @@ public:
             statistics_.miss();
             return 0;
         }
+        evict_expired();
         if (map_.count(access.key)) {
             map_[access.key] = true;
             statistics_.hit();
@@ -62,7 +73,7 @@ public:
             uint64_t eviction_time_ms =
                 saturation_add(logical_time_,
                                saturation_multiply(1000, ttl_s_));
-            expiration_queue_.emplace(eviction_time_ms, access.key);
+            expiration_queue_.schedule(access.key, eviction_time_ms);
             statistics_.miss();
         }
         ++logical_time_;
@@ -2,17 +2,18 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <unordered_map>
 
-#include "cache/base_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "math/saturation_arithmetic.h"
+#include "ttl_cache/timing_wheel.hpp"
 
 struct myTTLForLFU {
     std::uint64_t frequency;
     std::uint64_t last_access_time_ms;
     std::uint64_t ttl_s;
+    TimingWheel::Handle handle;
 };
 
 class TTLLFUCache {
@@ -20,7 +21,7 @@ class TTLLFUCache {
     std::size_t const capacity_;
 
     std::unordered_map<std::uint64_t, struct myTTLForLFU> map_;
-    std::multimap<std::uint64_t, std::uint64_t> expiration_queue_;
+    TimingWheel expiration_queue_;
     std::uint64_t logical_time_ = 0;
 
 public:
@@ -46,15 +47,26 @@ public:
     int
     evict_soonest_expiring()
     {
-        auto const x = expiration_queue_.begin();
-        std::uint64_t victim_key = x->second;
-        expiration_queue_.erase(x);
-        std::size_t i = map_.erase(victim_key);
+        auto const victim_key = expiration_queue_.pop();
+        assert(victim_key);
+        std::size_t i = map_.erase(*victim_key);
         assert(i == 1);
         assert(map_.size() + 1 == capacity_);
         return 0;
     }
 
+    /// @brief  Evict the objects whose expiration time has passed.
+    std::size_t
+    evict_expired()
+    {
+        return expiration_queue_.drain_expired(
+            logical_time_,
+            [this](std::uint64_t const key) {
+                std::size_t i = map_.erase(key);
+                assert(i == 1);
+            });
+    }
+
     int
     access_item(CacheAccess const &access)
     {
@@ -63,27 +75,16 @@ public:
             statistics_.miss();
             return 0;
         }
-        if (map_.count(access.key)) {
-            struct myTTLForLFU &s = map_[access.key];
+        evict_expired();
+        auto it = map_.find(access.key);
+        if (it != map_.end()) {
+            struct myTTLForLFU &s = it->second;
 
-            // Use old eviction time
-            std::uint64_t old_evict_time =
-                TTLLFUCache::get_expiry_time_ms(s.last_access_time_ms,
-                                                s.ttl_s,
-                                                s.frequency);
-            auto const [start, end] =
-                expiration_queue_.equal_range(old_evict_time);
-            for (auto i = start; i != end; ++i) {
-                if (i->second == access.key) {
-                    auto node_handle = expiration_queue_.extract(i);
-                    node_handle.key() =
-                        TTLLFUCache::get_expiry_time_ms(logical_time_,
-                                                        ttl_s_,
-                                                        s.frequency + 1);
-                    expiration_queue_.insert(std::move(node_handle));
-                    break;
-                }
-            }
+            expiration_queue_.reschedule(
+                s.handle,
+                TTLLFUCache::get_expiry_time_ms(logical_time_,
+                                                ttl_s_,
+                                                s.frequency + 1));
 
             // Update new eviction time
             s.frequency += 1;
@@ -95,14 +96,14 @@ public:
             if (map_.size() >= capacity_) {
                 this->evict_soonest_expiring();
             }
+            uint64_t eviction_time_ms =
+                TTLLFUCache::get_expiry_time_ms(logical_time_, ttl_s_, 0);
             map_[access.key] = {
                 0,
                 logical_time_,
                 ttl_s_,
+                expiration_queue_.schedule(access.key, eviction_time_ms),
             };
-            uint64_t eviction_time_ms =
-                TTLLFUCache::get_expiry_time_ms(logical_time_, ttl_s_, 0);
-            expiration_queue_.emplace(eviction_time_ms, access.key);
 
             statistics_.miss();
         }
@@ -2,10 +2,9 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <map>
-#include <unordered_map>
 
-#include "cache/base_cache.hpp"
+#include "cache/lru_queue.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "math/saturation_arithmetic.h"
 
@@ -18,8 +17,11 @@ class TTLLRUCache {
     std::uint64_t const ttl_s_ = 1 << 30;
     std::size_t const capacity_;
 
-    std::unordered_map<std::uint64_t, struct myTTLForLRU> map_;
-    std::multimap<std::uint64_t, std::uint64_t> expiration_queue_;
+    // NOTE Every item gets the same TTL upon access, so the order of
+    //      expiration is the order of last access. Thus, the soonest
+    //      expiring item is the least recently used one and I can keep
+    //      the expiration queue as an LRU queue.
+    LRUQueue<struct myTTLForLRU> expiration_queue_;
     std::uint64_t logical_time_ = 0;
 
 public:
@@ -41,57 +43,31 @@ public:
     int
     evict_soonest_expiring()
     {
-        auto const x = expiration_queue_.begin();
-        std::uint64_t victim_key = x->second;
-        expiration_queue_.erase(x);
-        std::size_t i = map_.erase(victim_key);
-        assert(i == 1);
-        assert(map_.size() + 1 == capacity_);
+        auto const victim_key = expiration_queue_.pop_lru();
+        assert(victim_key);
+        assert(expiration_queue_.size() + 1 == capacity_);
         return 0;
     }
 
     int
     access_item(CacheAccess const &access)
     {
-        assert(map_.size() == expiration_queue_.size());
         if (capacity_ == 0) {
             statistics_.miss();
             return 0;
         }
-        if (map_.count(access.key)) {
-            struct myTTLForLRU &s = map_[access.key];
-
-            // Use old eviction time
-            std::uint64_t old_evict_time =
-                TTLLRUCache::get_expiry_time_ms(s.last_access_time_ms, s.ttl_s);
-            auto const [start, end] =
-                expiration_queue_.equal_range(old_evict_time);
-            for (auto i = start; i != end; ++i) {
-                if (i->second == access.key) {
-                    auto node_handle = expiration_queue_.extract(i);
-                    node_handle.key() =
-                        TTLLRUCache::get_expiry_time_ms(logical_time_, ttl_s_);
-                    expiration_queue_.insert(std::move(node_handle));
-                    break;
-                }
-            }
-
+        struct myTTLForLRU *s = expiration_queue_.touch(access.key);
+        if (s != nullptr) {
             // Update new eviction time
-            s.last_access_time_ms = logical_time_;
-            s.ttl_s = ttl_s_;
+            s->last_access_time_ms = logical_time_;
+            s->ttl_s = ttl_s_;
 
             statistics_.hit();
         } else {
-            if (map_.size() >= capacity_) {
+            if (expiration_queue_.size() >= capacity_) {
                 this->evict_soonest_expiring();
             }
-            map_[access.key] = {
-                logical_time_,
-                ttl_s_,
-            };
-            uint64_t eviction_time_ms =
-                TTLLRUCache::get_expiry_time_ms(logical_time_, ttl_s_);
-            expiration_queue_.emplace(eviction_time_ms, access.key);
+            expiration_queue_.insert(access.key, {logical_time_, ttl_s_});
 
             statistics_.miss();
         }
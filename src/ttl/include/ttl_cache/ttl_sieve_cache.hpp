@@ -2,21 +2,23 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <map>
 #include <optional>
 #include <unordered_map>
 #include <vector>
 
-#include "cache/base_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 #include "math/saturation_arithmetic.h"
+#include "ttl_cache/timing_wheel.hpp"
 
 class TTLSieveCache {
     std::uint64_t const ttl_s_ = 1 << 30;
     std::size_t const capacity_;
 
-    std::unordered_map<std::uint64_t, std::uint64_t> map_;
-    std::multimap<std::uint64_t, std::uint64_t> ttl_queue_;
+    // NOTE Map each key to its entry in the TTL queue, which holds its
+    //      expiration time.
+    std::unordered_map<std::uint64_t, TimingWheel::Handle> map_;
+    TimingWheel ttl_queue_;
     std::uint64_t logical_time_ = 0;
     // NOTE The epoch starts at 1 because we multiply it by the TTL
     //      interval.
@@ -42,7 +44,8 @@ public:
     {
         std::vector<std::uint64_t> keys;
         keys.reserve(ttl_queue_.size());
-        for (auto [exp_tm, key] : ttl_queue_) {
+        for (auto [exp_tm, key] :
+             ttl_queue_.get_entries_in_expiration_order()) {
             keys.push_back(key);
         }
         return keys;
@@ -61,17 +64,26 @@ public:
     std::optional<std::uint64_t>
     evict_soonest_expiring()
     {
-        auto const it = ttl_queue_.begin();
-        if (it == ttl_queue_.end()) {
+        auto const victim_key = ttl_queue_.pop();
+        if (!victim_key) {
             return std::nullopt;
         }
-        std::uint64_t victim_key = it->second;
-        ttl_queue_.erase(it);
-        std::size_t i = map_.erase(victim_key);
+        std::size_t i = map_.erase(*victim_key);
         assert(i == 1);
         return victim_key;
     }
 
+    /// @brief  Evict the objects whose expiration time has passed.
+    std::size_t
+    evict_expired()
+    {
+        return ttl_queue_.drain_expired(logical_time_,
+                                        [this](std::uint64_t const key) {
+                                            std::size_t i = map_.erase(key);
+                                            assert(i == 1);
+                                        });
+    }
+
     int
     access_item(CacheAccess const &access)
     {
@@ -80,15 +92,16 @@ public:
             statistics_.miss();
             return 0;
         }
-        if (map_.count(access.key)) {
+        evict_expired();
+        auto it = map_.find(access.key);
+        if (it != map_.end()) {
             // Only increment the eviction time if it hasn't been
             // incremented already in this epoch.
-            if (map_[access.key] <=
+            std::uint64_t const eviction_time_ms =
+                ttl_queue_.get_time(it->second);
+            if (eviction_time_ms <=
                 TTLSieveCache::get_expiry_time_ms(0, epoch_ + 1, ttl_s_)) {
-                auto nh = ttl_queue_.extract(map_[access.key]);
-                nh.key() += ttl_s_;
-                ttl_queue_.insert(std::move(nh));
-                map_[access.key] += ttl_s_;
+                ttl_queue_.reschedule(it->second, eviction_time_ms + ttl_s_);
             }
             statistics_.hit();
         } else {
@@ -101,8 +114,8 @@ public:
                 TTLSieveCache::get_expiry_time_ms(logical_time_,
                                                   epoch_,
                                                   ttl_s_);
-            map_[access.key] = eviction_time_ms;
-            ttl_queue_.emplace(eviction_time_ms, access.key);
+            map_[access.key] =
+                ttl_queue_.schedule(access.key, eviction_time_ms);
             statistics_.miss();
         }
         ++logical_time_;
@@ -4,7 +4,7 @@
 #include <cstdint>
 #include <vector>
 
-#include "cache/base_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
 #include "cache_statistics/cache_statistics.hpp"
 
 class YangSieveCache {
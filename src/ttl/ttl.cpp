@@ -17,6 +17,11 @@
 #include "cache/lfu_cache.hpp"
 #include "cache/lru_cache.hpp"
 #include "cache/sieve_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_statistics/cache_statistics.hpp"
+#include "cache_sweep/capacity_sweep.hpp"
+#include "cache_sweep/miniature_cache.hpp"
+#include "composed_cache/composed_cache.hpp"
 #include "io/io.h"
 #include "logger/logger.h"
 #include "modified_clock_cache.hpp"
@@ -29,49 +34,28 @@
 #include "ttl_cache/ttl_lru_cache.hpp"
 #include "ttl_cache/ttl_sieve_cache.hpp"
 
-template <typename T>
-static double
-run_cache(struct MemoryMap const *const mm,
-          enum TraceFormat format,
-          uint64_t const capacity)
+/// @brief  The fraction of keys that the miniature simulations sample.
+static double const MINIATURE_SAMPLING_RATIO = 0.01;
+
+static std::optional<std::map<std::uint64_t, double>>
+run_sweep(CapacitySweep &sweep,
+          std::string const &name,
+          char const *const trace_path,
+          enum TraceFormat const format)
 {
-    LOGGER_TRACE("running '%s' algorithm for size %zu", T::name, capacity);
-    size_t num_entries = 0;
-    size_t bytes_per_trace_item = 0;
-    T cache(capacity);
-
-    if (mm == NULL) {
-        LOGGER_ERROR("invalid input");
-        return -1.0;
-    }
-    // NOTE I let this helper function handle the format checks for me
-    //      so that all logic dealing with parsing trace formats is
-    //      contained within this library.
-    bytes_per_trace_item = get_bytes_per_trace_item(format);
-    if (bytes_per_trace_item == 0) {
-        LOGGER_ERROR("invalid trace format");
-        return -1.0;
-    }
-    num_entries = mm->num_bytes / bytes_per_trace_item;
-    for (size_t i = 0; i < num_entries; ++i) {
-        if (i % 1000000 == 0) {
-            LOGGER_TRACE("Finished %zu / %zu", i, num_entries);
-        }
-        struct FullTraceItemResult r = construct_full_trace_item(
-            &((uint8_t *)mm->buffer)[i * bytes_per_trace_item],
-            format);
-        assert(r.valid);
-
-        // Skip PUT requests.
-        if (r.item.command == 1) {
-            continue;
-        }
+    std::map<std::size_t, double> mrc = {};
 
-        cache.access_item({&r.item});
+    if (trace_path == NULL) {
+        LOGGER_ERROR("invalid input path", format);
+        return std::nullopt;
+    }
+    sweep.run(trace_path, format);
+    for (std::size_t i = 0; i < sweep.size(); ++i) {
+        CacheStatistics const &statistics = sweep.get_statistics(i);
+        statistics.print(name, sweep.get_capacity(i));
+        mrc[sweep.get_capacity(i)] = statistics.miss_rate();
     }
-    assert(cache.statistics_.total_accesses_ < num_entries);
-    cache.statistics_.print(T::name, capacity);
-    return cache.statistics_.miss_rate();
+    return std::make_optional(mrc);
 }
 
 template <typename T>
@@ -80,34 +64,29 @@ generate_mrc(char const *const trace_path,
              enum TraceFormat const format,
              std::vector<std::size_t> const &capacities)
 {
-    // This initializes everything to the default, i.e. 0.
-    struct MemoryMap mm = {};
-    std::map<std::size_t, double> mrc = {};
-
-    if (trace_path == NULL) {
-        LOGGER_ERROR("invalid input path", format);
-        goto cleanup_error;
+    // NOTE I simulate every capacity in a single pass over the trace.
+    CapacitySweep sweep;
+    for (auto cap : capacities) {
+        sweep.add_cache<T>(cap);
     }
+    return run_sweep(sweep, T::name, trace_path, format);
+}
 
-    // Memory map the input trace file
-    if (!MemoryMap__init(&mm, trace_path, "rb")) {
-        LOGGER_ERROR("failed to mmap '%s'", trace_path);
-        goto cleanup_error;
-    }
+/// @brief  Approximate the MRC of any policy with miniature simulations.
+template <typename T>
+static std::optional<std::map<std::uint64_t, double>>
+generate_miniature_mrc(char const *const trace_path,
+                       enum TraceFormat const format,
+                       std::vector<std::size_t> const &capacities)
+{
+    CapacitySweep sweep;
     for (auto cap : capacities) {
-        double mr = run_cache<T>(&mm, format, cap);
-        if (mr == -1.0) {
-            LOGGER_ERROR("error in '%s' algorithm (N.B. name may be mangled)",
-                         typeid(T).name());
-            return std::nullopt;
-        };
-        mrc[cap] = mr;
+        sweep.add_cache<MiniatureCache<T>>(cap, MINIATURE_SAMPLING_RATIO);
     }
-    MemoryMap__destroy(&mm);
-    return std::make_optional(mrc);
-cleanup_error:
-    MemoryMap__destroy(&mm);
-    return std::nullopt;
+    return run_sweep(sweep,
+                     std::string("Miniature") + T::name,
+                     trace_path,
+                     format);
 }
 
 static int
@@ -165,6 +144,49 @@ main(int argc, char *argv[])
                 {TTLLFUCache::name, generate_mrc<TTLLFUCache>},
                 {TTLFIFOCache::name, generate_mrc<TTLFIFOCache>},
                 {TTLSieveCache::name, generate_mrc<TTLSieveCache>},
+
+                {ComposedFIFOCache::name, generate_mrc<ComposedFIFOCache>},
+                {ComposedLRUCache::name, generate_mrc<ComposedLRUCache>},
+                {ComposedClockCache::name, generate_mrc<ComposedClockCache>},
+                {ComposedSieveCache::name, generate_mrc<ComposedSieveCache>},
+                {ComposedTTLFIFOCache::name,
+                 generate_mrc<ComposedTTLFIFOCache>},
+                {ComposedTTLLRUCache::name, generate_mrc<ComposedTTLLRUCache>},
+                {ComposedTTLClockCache::name,
+                 generate_mrc<ComposedTTLClockCache>},
+                {ComposedTTLSieveCache::name,
+                 generate_mrc<ComposedTTLSieveCache>},
+                {ComposedTTLFIFOPackedMetadataCache::name,
+                 generate_mrc<ComposedTTLFIFOPackedMetadataCache>},
+                {ComposedTTLLRUPackedMetadataCache::name,
+                 generate_mrc<ComposedTTLLRUPackedMetadataCache>},
+                {ComposedTTLClockPackedMetadataCache::name,
+                 generate_mrc<ComposedTTLClockPackedMetadataCache>},
+                {ComposedTTLSievePackedMetadataCache::name,
+                 generate_mrc<ComposedTTLSievePackedMetadataCache>},
+
+                {std::string("Miniature") + ClockCache::name,
+                 generate_miniature_mrc<ClockCache>},
+                {std::string("Miniature") + LRUCache::name,
+                 generate_miniature_mrc<LRUCache>},
+                {std::string("Miniature") + LFUCache::name,
+                 generate_miniature_mrc<LFUCache>},
+                {std::string("Miniature") + FIFOCache::name,
+                 generate_miniature_mrc<FIFOCache>},
+                {std::string("Miniature") + SieveCache::name,
+                 generate_miniature_mrc<SieveCache>},
+                {std::string("Miniature") + NewTTLClockCache::name,
+                 generate_miniature_mrc<NewTTLClockCache>},
+                {std::string("Miniature") + TTLClockCache::name,
+                 generate_miniature_mrc<TTLClockCache>},
+                {std::string("Miniature") + TTLLRUCache::name,
+                 generate_miniature_mrc<TTLLRUCache>},
+                {std::string("Miniature") + TTLLFUCache::name,
+                 generate_miniature_mrc<TTLLFUCache>},
+                {std::string("Miniature") + TTLFIFOCache::name,
+                 generate_miniature_mrc<TTLFIFOCache>},
+                {std::string("Miniature") + TTLSieveCache::name,
+                 generate_miniature_mrc<TTLSieveCache>},
             },
         run_algorithms = {};
 
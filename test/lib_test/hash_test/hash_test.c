@@ -8,7 +8,9 @@
 
 #include "hash/MurmurHash3.h"
 #include "hash/hash.h"
+#include "hash/hash_batch.h"
 #include "hash/miscellaneous_hash.h"
+#include "hash/splitmix64.h"
 #include "hash/types.h"
 #include "logger/logger.h"
 #include "test/mytester.h"
@@ -89,6 +91,52 @@ test_hash(void)
     return true;
 }
 
+/// @brief  Check that every supported batch kernel matches the scalar
+///         hash functions bit-for-bit, including on ragged tails.
+static bool
+test_batch_hash(void)
+{
+    enum { MAX_LENGTH = 100 };
+    uint64_t keys[MAX_LENGTH] = {0};
+    Hash64BitType hashes[MAX_LENGTH + 1] = {0};
+    for (size_t i = 0; i < MAX_LENGTH; ++i) {
+        // NOTE I use a mix of small and large keys.
+        keys[i] = i % 2 ? i : splitmix64_hash(i);
+    }
+    enum HashBatchKernel const kernels[] = {HASH_BATCH_KERNEL_SCALAR,
+                                            HASH_BATCH_KERNEL_AVX2,
+                                            HASH_BATCH_KERNEL_AVX512};
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(*kernels); ++k) {
+        if (!HashBatchKernel__is_supported(kernels[k])) {
+            LOGGER_INFO("skipping unsupported kernel %s",
+                        HashBatchKernel__name(kernels[k]));
+            continue;
+        }
+        for (size_t n = 0; n <= MAX_LENGTH; ++n) {
+            // NOTE The sentinel checks that we do not write past 'n'.
+            hashes[n] = 42;
+            g_assert_true(splitmix64_hash__batch(kernels[k], keys, hashes, n));
+            for (size_t i = 0; i < n; ++i) {
+                g_assert_cmpuint(hashes[i], ==, splitmix64_hash(keys[i]));
+            }
+            g_assert_cmpuint(hashes[n], ==, 42);
+            g_assert_true(
+                MurmurHash3_x64_64__batch(kernels[k], keys, hashes, n));
+            for (size_t i = 0; i < n; ++i) {
+                uint64_t expected[2] = {0, 0};
+                MurmurHash3_x64_128(&keys[i], sizeof(keys[i]), 0, expected);
+                g_assert_cmpuint(hashes[i], ==, expected[0]);
+            }
+            g_assert_cmpuint(hashes[n], ==, 42);
+        }
+    }
+    Hash64Bit__batch(keys, hashes, MAX_LENGTH);
+    for (size_t i = 0; i < MAX_LENGTH; ++i) {
+        g_assert_cmpuint(hashes[i], ==, Hash64Bit(keys[i]));
+    }
+    return true;
+}
+
 int
 main(void)
 {
@@ -96,5 +144,6 @@ main(void)
     ASSERT_FUNCTION_RETURNS_TRUE(test_uint64_hash_to_uint128());
     ASSERT_FUNCTION_RETURNS_TRUE(test_miscellaneous_hash());
     ASSERT_FUNCTION_RETURNS_TRUE(test_hash());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_batch_hash());
     return 0;
 }
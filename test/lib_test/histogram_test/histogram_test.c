@@ -5,9 +5,12 @@
 #include <glib.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "histogram/fractional_histogram.h"
 #include "histogram/histogram.h"
+#include "histogram/log_histogram.h"
+#include "io/binary_container.h"
 
 #include "logger/logger.h"
 #include "test/mytester.h"
@@ -214,6 +217,215 @@ test_histogram_save(void)
     return true;
 }
 
+static void
+assert_histograms_equal(struct Histogram const *const a,
+                        struct Histogram const *const b)
+{
+    g_assert_cmpuint(a->num_bins, ==, b->num_bins);
+    g_assert_cmpuint(a->bin_size, ==, b->bin_size);
+    g_assert_cmpuint(a->false_infinity, ==, b->false_infinity);
+    g_assert_cmpuint(a->infinity, ==, b->infinity);
+    g_assert_cmpuint(a->running_sum, ==, b->running_sum);
+    g_assert_cmpint(a->out_of_bounds_mode, ==, b->out_of_bounds_mode);
+    for (size_t i = 0; i < a->num_bins; ++i) {
+        g_assert_cmpuint(a->histogram[i], ==, b->histogram[i]);
+    }
+}
+
+/// @brief  Flip one byte of a file.
+static void
+corrupt_file(char const *const path, long const offset)
+{
+    FILE *fp = fopen(path, "r+b");
+    g_assert_nonnull(fp);
+    g_assert_cmpint(fseek(fp, offset, SEEK_SET), ==, 0);
+    int const c = fgetc(fp);
+    g_assert_cmpint(fseek(fp, offset, SEEK_SET), ==, 0);
+    g_assert_cmpint(fputc(c ^ 0xFF, fp), !=, EOF);
+    g_assert_cmpint(fclose(fp), ==, 0);
+}
+
+static bool
+test_histogram_save_binary(void)
+{
+    char const *const path = "./histogram_container_test.bin";
+    uint64_t histogram[100] = {0};
+    struct Histogram a = {
+        .histogram = histogram,
+        .num_bins = 100,
+        .bin_size = 10,
+        .false_infinity = 200,
+        .infinity = 300,
+        .running_sum = 400,
+        .out_of_bounds_mode = HistogramOutOfBoundsMode__realloc,
+    };
+    memcpy(histogram, random_values_0_to_11, sizeof(random_values_0_to_11));
+
+    for (int sparse = 0; sparse < 2; ++sparse) {
+        struct Histogram b = {0};
+        struct BinaryContainer container = {0};
+        g_assert_true(Histogram__save_binary(&a, path, sparse));
+        g_assert_true(BinaryContainer__is_container(path));
+        g_assert_true(Histogram__load(&b, path));
+        assert_histograms_equal(&a, &b);
+        Histogram__destroy(&b);
+
+        // Read it in place.
+        g_assert_true(BinaryContainer__open(&container,
+                                            path,
+                                            BINARY_CONTAINER_KIND_HISTOGRAM,
+                                            true));
+        g_assert_true((container.index != NULL) == sparse);
+        for (size_t i = 0; i < a.num_bins; ++i) {
+            g_assert_cmpuint(BinaryContainer__get_u64(&container, i),
+                             ==,
+                             a.histogram[i]);
+        }
+        if (sparse) {
+            g_assert_false(Histogram__init_view(&b, &container));
+        } else {
+            g_assert_true(Histogram__init_view(&b, &container));
+            assert_histograms_equal(&a, &b);
+        }
+        g_assert_true(BinaryContainer__close(&container));
+        // The wrong kind should be rejected.
+        g_assert_false(
+            BinaryContainer__open(&container,
+                                  path,
+                                  BINARY_CONTAINER_KIND_MISS_RATE_CURVE,
+                                  false));
+
+        // Corrupting a value should fail the checksum, but only if we
+        // verify it.
+        corrupt_file(path, 128 + 8 * 3);
+        g_assert_true(BinaryContainer__open(&container,
+                                            path,
+                                            BINARY_CONTAINER_KIND_HISTOGRAM,
+                                            false));
+        g_assert_true(BinaryContainer__close(&container));
+        g_assert_false(BinaryContainer__open(&container,
+                                             path,
+                                             BINARY_CONTAINER_KIND_HISTOGRAM,
+                                             true));
+        g_assert_false(Histogram__load(&b, path));
+        g_assert_cmpint(remove(path), ==, 0);
+    }
+
+    // A truncated file should fail even without verification.
+    g_assert_true(Histogram__save_binary(&a, path, false));
+    g_assert_cmpint(truncate(path, 128 + 8 * 50), ==, 0);
+    struct BinaryContainer container = {0};
+    g_assert_false(BinaryContainer__open(&container,
+                                         path,
+                                         BINARY_CONTAINER_KIND_HISTOGRAM,
+                                         false));
+    g_assert_cmpint(remove(path), ==, 0);
+
+    // An index that aliases the values should fail even without
+    // verification.
+    struct BinaryContainerHeader header = {0};
+    g_assert_true(Histogram__save_binary(&a, path, true));
+    FILE *fp = fopen(path, "r+b");
+    g_assert_nonnull(fp);
+    g_assert_cmpuint(fread(&header, sizeof(header), 1, fp), ==, 1);
+    header.index_offset = header.values_offset;
+    g_assert_cmpint(fseek(fp, 0, SEEK_SET), ==, 0);
+    g_assert_cmpuint(fwrite(&header, sizeof(header), 1, fp), ==, 1);
+    g_assert_cmpint(fclose(fp), ==, 0);
+    g_assert_false(BinaryContainer__open(&container,
+                                         path,
+                                         BINARY_CONTAINER_KIND_HISTOGRAM,
+                                         false));
+    g_assert_cmpint(remove(path), ==, 0);
+    return true;
+}
+
+/// @brief  Compute the fraction of values at least 'value' the slow way.
+static double
+brute_fraction_at_least(struct Histogram const *const me, uint64_t const value)
+{
+    uint64_t at_least = me->false_infinity + me->infinity;
+    for (size_t i = value / me->bin_size; i < me->num_bins; ++i) {
+        at_least += me->histogram[i];
+    }
+    return (double)at_least / me->running_sum;
+}
+
+static bool
+test_histogram_prefix_sums(void)
+{
+    enum HistogramOutOfBoundsMode const modes[] = {
+        HistogramOutOfBoundsMode__allow_overflow,
+        HistogramOutOfBoundsMode__merge_bins,
+        HistogramOutOfBoundsMode__realloc,
+    };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(*modes); ++m) {
+        struct Histogram me = {0};
+        g_assert_true(Histogram__init(&me, 300, 2, modes[m]));
+        g_assert_true(Histogram__enable_prefix_sums(&me));
+        uint64_t x = 1;
+        for (size_t i = 0; i < 10000; ++i) {
+            x = 6364136223846793005 * x + 1442695040888963407;
+            if (x >> 60 == 0) {
+                g_assert_true(Histogram__insert_infinite(&me));
+            } else {
+                // NOTE This sometimes overflows the original 600 values.
+                g_assert_true(Histogram__insert_finite(&me, (x >> 33) % 1000));
+            }
+            if (i % 1000 != 0) {
+                continue;
+            }
+            g_assert_true(Histogram__validate(&me));
+            for (uint64_t v = 0; v < 2 * me.num_bins * me.bin_size; v += 7) {
+                g_assert_cmpfloat(Histogram__get_fraction_at_least(&me, v),
+                                  ==,
+                                  brute_fraction_at_least(&me, v));
+            }
+        }
+        g_assert_true(Histogram__adjust_first_buckets(&me, -3));
+        g_assert_true(Histogram__validate(&me));
+        Histogram__clear(&me);
+        g_assert_true(Histogram__validate(&me));
+        g_assert_cmpfloat(Histogram__get_fraction_at_least(&me, 0), ==, 0.0);
+        Histogram__destroy(&me);
+    }
+    return true;
+}
+
+/// @brief  Check that adding histograms with different bin sizes and
+///         ranges rebins into the coarser bin size and the larger range.
+static bool
+test_histogram_iadd(void)
+{
+    struct Histogram me = {0}, other = {0};
+    enum HistogramOutOfBoundsMode const mode =
+        HistogramOutOfBoundsMode__allow_overflow;
+    g_assert_true(Histogram__init(&me, 8, 1, mode));
+    g_assert_true(Histogram__enable_prefix_sums(&me));
+    g_assert_true(Histogram__init(&other, 6, 2, mode));
+    for (uint64_t v = 0; v < 16; ++v) {
+        g_assert_true(Histogram__insert_finite(&me, v));
+        g_assert_true(Histogram__insert_finite(&other, v));
+    }
+    g_assert_true(Histogram__insert_infinite(&other));
+
+    g_assert_true(Histogram__iadd(&me, &other));
+    g_assert_cmpuint(me.bin_size, ==, 2);
+    g_assert_cmpuint(me.num_bins, ==, 6);
+    uint64_t const expected[] = {4, 4, 4, 4, 2, 2};
+    for (size_t i = 0; i < me.num_bins; ++i) {
+        g_assert_cmpuint(me.histogram[i], ==, expected[i]);
+    }
+    g_assert_cmpuint(me.false_infinity, ==, 8 + 4);
+    g_assert_cmpuint(me.infinity, ==, 1);
+    g_assert_cmpuint(me.running_sum, ==, 16 + 17);
+    g_assert_true(Histogram__validate(&me));
+
+    Histogram__destroy(&me);
+    Histogram__destroy(&other);
+    return true;
+}
+
 static bool
 test_histogram_with_false_infinity_on_outofbounds(void)
 {
@@ -304,6 +516,140 @@ test_histogram_with_realloc_on_outofbounds(void)
     return true;
 }
 
+static bool
+test_log_histogram_bins(void)
+{
+    struct LogHistogram me = {0};
+    g_assert_true(LogHistogram__init(&me, 7, (UINT64_C(1) << 34) - 1));
+    // NOTE Each power of two above 2^7 gets 2^7 sub-bins.
+    g_assert_cmpuint(me.num_bins, ==, (34 - 7 + 1) << 7);
+
+    for (uint64_t v = 0; v < 1 << 7; ++v) {
+        g_assert_cmpuint(LogHistogram__get_bin_index(&me, v), ==, v);
+        g_assert_cmpuint(LogHistogram__get_bin_width(&me, v), ==, 1);
+    }
+    // Every value falls within its bin, whose width bounds the relative
+    // error. I test the values around each power of two and some others.
+    for (unsigned e = 2; e < 34; ++e) {
+        for (uint64_t d = 0; d < 3; ++d) {
+            uint64_t const values[] = {(UINT64_C(1) << e) + d,
+                                       (UINT64_C(1) << e) - d,
+                                       (UINT64_C(3) << e) / 2 + 12345 * d};
+            for (size_t j = 0; j < sizeof(values) / sizeof(*values); ++j) {
+                uint64_t const v = values[j];
+                size_t const i = LogHistogram__get_bin_index(&me, v);
+                uint64_t const lower =
+                    LogHistogram__get_bin_lower_bound(&me, i);
+                uint64_t const width = LogHistogram__get_bin_width(&me, i);
+                g_assert_cmpuint(lower, <=, v);
+                g_assert_cmpuint(v, <, lower + width);
+                g_assert_cmpuint(width << 7, <=, v > 1 << 7 ? v : 1 << 7);
+            }
+        }
+    }
+    // Adjacent bins tile the values without gaps.
+    for (size_t i = 0; i + 1 < me.num_bins; ++i) {
+        g_assert_cmpuint(LogHistogram__get_bin_lower_bound(&me, i) +
+                             LogHistogram__get_bin_width(&me, i),
+                         ==,
+                         LogHistogram__get_bin_lower_bound(&me, i + 1));
+    }
+    LogHistogram__destroy(&me);
+    return true;
+}
+
+static bool
+test_log_histogram(void)
+{
+    struct LogHistogram me = {0}, other = {0}, from_file = {0}, bad = {0};
+    g_assert_true(LogHistogram__init(&me, 2, 1000));
+    g_assert_true(LogHistogram__init(&other, 2, 1 << 20));
+
+    for (size_t i = 0; i < 100; ++i) {
+        g_assert_true(
+            LogHistogram__insert_finite(&me, random_values_0_to_11[i]));
+        g_assert_true(
+            LogHistogram__insert_scaled_finite(&other, 100 * i, 10));
+    }
+    g_assert_true(LogHistogram__insert_scaled_infinite(&me, 3));
+    g_assert_true(LogHistogram__validate(&me));
+    g_assert_true(LogHistogram__validate(&other));
+    g_assert_cmpuint(me.running_sum, ==, 103);
+    g_assert_cmpuint(me.false_infinity, ==, 0);
+    g_assert_cmpuint(other.false_infinity, ==, 0);
+    // NOTE With 2 significant bits, the bins above 8 are 2 wide, so the 11
+    //      values of 10 are spread over [10, 12) and only the 3 infinities
+    //      are at least 12.
+    g_assert_true(LogHistogram__get_fraction_at_least(&me, 11) ==
+                  (3 + 11 * 0.5) / 103);
+    g_assert_true(LogHistogram__get_fraction_at_least(&me, 12) ==
+                  3.0 / 103);
+    g_assert_true(LogHistogram__get_fraction_at_least(&me, 0) == 1.0);
+
+    // Merge a larger histogram, whose extra values become false infinities.
+    uint64_t expected_false_infinity = 0;
+    for (size_t i = me.num_bins; i < other.num_bins; ++i) {
+        expected_false_infinity += other.histogram[i];
+    }
+    g_assert_true(LogHistogram__iadd(&me, &other));
+    g_assert_true(LogHistogram__validate(&me));
+    g_assert_cmpuint(me.running_sum, ==, 103 + 1000);
+    g_assert_cmpuint(me.false_infinity, ==, expected_false_infinity);
+
+    g_assert_true(LogHistogram__save(&me, "./log_histogram_test.bin"));
+    g_assert_true(LogHistogram__load(&from_file, "./log_histogram_test.bin"));
+    g_assert_cmpint(remove("./log_histogram_test.bin"), ==, 0);
+    g_assert_true(LogHistogram__validate(&from_file));
+    g_assert_cmpuint(from_file.num_bins, ==, me.num_bins);
+    g_assert_cmpuint(from_file.significant_bits, ==, me.significant_bits);
+    g_assert_cmpuint(from_file.false_infinity, ==, me.false_infinity);
+    g_assert_cmpuint(from_file.infinity, ==, me.infinity);
+    g_assert_cmpuint(from_file.running_sum, ==, me.running_sum);
+    for (size_t i = 0; i < me.num_bins; ++i) {
+        g_assert_cmpuint(from_file.histogram[i], ==, me.histogram[i]);
+    }
+
+    // I reject a number of bins that the significant bits cannot produce
+    // before I allocate them.
+    uint64_t const zero = 0;
+    uint64_t metadata[BINARY_CONTAINER_METADATA_LENGTH] = {2};
+    g_assert_true(BinaryContainer__save("./log_histogram_test.bin",
+                                        BINARY_CONTAINER_KIND_LOG_HISTOGRAM,
+                                        BINARY_CONTAINER_FILL_ZERO,
+                                        metadata,
+                                        UINT64_C(1) << 40,
+                                        &zero,
+                                        &zero,
+                                        0));
+    g_assert_false(LogHistogram__load(&bad, "./log_histogram_test.bin"));
+    metadata[0] = LOG_HISTOGRAM_MAX_SIGNIFICANT_BITS + 1;
+    g_assert_true(BinaryContainer__save("./log_histogram_test.bin",
+                                        BINARY_CONTAINER_KIND_LOG_HISTOGRAM,
+                                        BINARY_CONTAINER_FILL_ZERO,
+                                        metadata,
+                                        1,
+                                        &zero,
+                                        &zero,
+                                        0));
+    g_assert_false(LogHistogram__load(&bad, "./log_histogram_test.bin"));
+    g_assert_cmpint(remove("./log_histogram_test.bin"), ==, 0);
+
+    LogHistogram__clear(&me);
+    g_assert_true(LogHistogram__validate(&me));
+    g_assert_cmpuint(me.running_sum, ==, 0);
+
+    // Unlike a scaled insert, a weighted insert does not scale the value.
+    g_assert_true(LogHistogram__insert_weighted_finite(&me, 5, 10));
+    g_assert_true(LogHistogram__validate(&me));
+    g_assert_cmpuint(me.histogram[LogHistogram__get_bin_index(&me, 5)], ==, 10);
+    g_assert_cmpuint(me.running_sum, ==, 10);
+
+    LogHistogram__destroy(&me);
+    LogHistogram__destroy(&other);
+    LogHistogram__destroy(&from_file);
+    return true;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -313,9 +659,14 @@ main(int argc, char **argv)
     ASSERT_FUNCTION_RETURNS_TRUE(test_binned_histogram());
     ASSERT_FUNCTION_RETURNS_TRUE(test_fractional_histogram());
     ASSERT_FUNCTION_RETURNS_TRUE(test_histogram_save());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_histogram_save_binary());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_histogram_prefix_sums());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_histogram_iadd());
     ASSERT_FUNCTION_RETURNS_TRUE(
         test_histogram_with_false_infinity_on_outofbounds());
     ASSERT_FUNCTION_RETURNS_TRUE(test_histogram_with_merge_on_outofbounds());
     ASSERT_FUNCTION_RETURNS_TRUE(test_histogram_with_realloc_on_outofbounds());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_log_histogram_bins());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_log_histogram());
     return 0;
 }
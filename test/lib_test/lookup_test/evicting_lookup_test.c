@@ -12,6 +12,10 @@
 #define LENGTH      8
 #define UNIQUE_KEYS 11
 
+#define CONCURRENT_LENGTH      1024
+#define CONCURRENT_NUM_THREADS 4
+#define CONCURRENT_TRACE_LENGTH (1 << 16)
+
 /// @brief   Test that a consistent subset is sampled by the hash table.
 static bool
 sampled_test(void)
@@ -116,10 +120,81 @@ sampled_try_put_test(void)
     return true;
 }
 
+struct ConcurrentWorkerArgs {
+    struct EvictingHashTable *hash_table;
+    size_t id;
+};
+
+/// @brief  Put the whole trace, but only the keys that this thread owns.
+static void *
+concurrent_owner_writer(void *args)
+{
+    struct ConcurrentWorkerArgs *w = args;
+    for (size_t i = 0; i < CONCURRENT_TRACE_LENGTH; ++i) {
+        KeyType key = i % (4 * CONCURRENT_LENGTH);
+        Hash64BitType hash = Hash64Bit(key);
+        if (EvictingHashTable__seqlock_index(w->hash_table, hash) %
+                CONCURRENT_NUM_THREADS !=
+            w->id) {
+            continue;
+        }
+        EvictingHashTable__try_put_hash_concurrent(w->hash_table, hash, i);
+    }
+    return NULL;
+}
+
+/// @brief  Test that threads that own disjoint sequence locks produce
+///         the same table as the serial version.
+static bool
+concurrent_try_put_test(void)
+{
+    struct EvictingHashTable oracle = {0}, me = {0};
+    g_assert_true(EvictingHashTable__init(&oracle, CONCURRENT_LENGTH, 1.0));
+    g_assert_true(EvictingHashTable__init(&me, CONCURRENT_LENGTH, 1.0));
+
+    for (size_t i = 0; i < CONCURRENT_TRACE_LENGTH; ++i) {
+        KeyType key = i % (4 * CONCURRENT_LENGTH);
+        EvictingHashTable__try_put(&oracle, key, i);
+    }
+
+    pthread_t threads[CONCURRENT_NUM_THREADS] = {0};
+    struct ConcurrentWorkerArgs args[CONCURRENT_NUM_THREADS] = {0};
+    for (size_t i = 0; i < CONCURRENT_NUM_THREADS; ++i) {
+        args[i] = (struct ConcurrentWorkerArgs){.hash_table = &me, .id = i};
+        pthread_create(&threads[i], NULL, concurrent_owner_writer, &args[i]);
+    }
+    for (size_t i = 0; i < CONCURRENT_NUM_THREADS; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (size_t i = 0; i < CONCURRENT_LENGTH; ++i) {
+        g_assert_cmpuint(me.hashes[i], ==, oracle.hashes[i]);
+        g_assert_cmpuint(me.values[i], ==, oracle.values[i]);
+    }
+    g_assert_cmpuint(me.num_inserted, ==, oracle.num_inserted);
+    g_assert_cmpuint(me.global_threshold, ==, oracle.global_threshold);
+    g_assert_cmpfloat_with_epsilon(me.running_denominator,
+                                   oracle.running_denominator,
+                                   1e-6);
+    for (size_t i = 0; i < 4 * CONCURRENT_LENGTH; ++i) {
+        KeyType key = i;
+        struct SampledLookupReturn r =
+            EvictingHashTable__lookup_concurrent(&me, key);
+        struct SampledLookupReturn s = EvictingHashTable__lookup(&oracle, key);
+        g_assert_cmpuint(r.status, ==, s.status);
+        g_assert_cmpuint(r.timestamp, ==, s.timestamp);
+    }
+
+    EvictingHashTable__destroy(&oracle);
+    EvictingHashTable__destroy(&me);
+    return true;
+}
+
 int
 main(void)
 {
     ASSERT_FUNCTION_RETURNS_TRUE(sampled_test());
     ASSERT_FUNCTION_RETURNS_TRUE(sampled_try_put_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(concurrent_try_put_test());
     return 0;
 }
@@ -0,0 +1,130 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "lookup/flat_hash_table.h"
+#include "lookup/lookup.h"
+#include "test/mytester.h"
+
+#define MAX_SIZE   (1 << 20)
+#define STREAM     NULL
+#define NUM_KEYS   (1 << 12)
+#define NUM_RANDOM (1 << 22)
+
+static bool
+test_flat_hash_table(void)
+{
+    struct FlatHashTable me = {0};
+    g_assert_true(FlatHashTable__init(&me));
+    FlatHashTable__write(&me, STREAM, true);
+
+    // Test successful inserts
+    for (uint64_t i = 0; i < MAX_SIZE; ++i) {
+        enum PutUniqueStatus r = FlatHashTable__put(&me, i, 2 * i);
+        g_assert_cmpint(r, ==, LOOKUP_PUTUNIQUE_INSERT_KEY_VALUE);
+    }
+    g_assert_cmpuint(FlatHashTable__get_size(&me), ==, MAX_SIZE);
+
+    // Test successful lookups
+    for (uint64_t i = 0; i < MAX_SIZE; ++i) {
+        struct LookupReturn r = FlatHashTable__lookup(&me, i);
+        g_assert_true(r.success);
+        g_assert_cmpuint(r.timestamp, ==, 2 * i);
+    }
+
+    // Test unsuccessful lookups
+    for (uint64_t i = MAX_SIZE; i < MAX_SIZE + 10; ++i) {
+        struct LookupReturn r = FlatHashTable__lookup(&me, i);
+        g_assert_false(r.success);
+    }
+
+    // Test successful replacements
+    for (uint64_t i = 0; i < MAX_SIZE; ++i) {
+        enum PutUniqueStatus r = FlatHashTable__put(&me, i, 3 * i);
+        g_assert_cmpint(r, ==, LOOKUP_PUTUNIQUE_REPLACE_VALUE);
+    }
+
+    // Test successful deletes of every other key
+    for (uint64_t i = 0; i < MAX_SIZE; i += 2) {
+        struct LookupReturn r = FlatHashTable__remove(&me, i);
+        g_assert_true(r.success);
+        g_assert_cmpuint(r.timestamp, ==, 3 * i);
+    }
+    g_assert_cmpuint(FlatHashTable__get_size(&me), ==, MAX_SIZE / 2);
+
+    // Test that the remaining keys survived the backward shifts
+    for (uint64_t i = 0; i < MAX_SIZE; ++i) {
+        struct LookupReturn r = FlatHashTable__lookup(&me, i);
+        g_assert_cmpint(r.success, ==, i % 2 == 1);
+        if (r.success) {
+            g_assert_cmpuint(r.timestamp, ==, 3 * i);
+        }
+    }
+
+    // Test unsuccessful deletes
+    for (uint64_t i = 0; i < MAX_SIZE; i += 2) {
+        struct LookupReturn r = FlatHashTable__remove(&me, i);
+        g_assert_false(r.success);
+    }
+
+    FlatHashTable__write(&me, STREAM, true);
+    FlatHashTable__destroy(&me);
+    return true;
+}
+
+/// @brief  Compare random puts and removes against a plain array, which
+///         exercises deletion in long, wrapped-around runs.
+static bool
+test_random_operations(void)
+{
+    struct FlatHashTable me = {0};
+    bool present[NUM_KEYS] = {0};
+    uint64_t values[NUM_KEYS] = {0};
+    size_t size = 0;
+    g_assert_true(FlatHashTable__init(&me));
+
+    srand(42);
+    for (size_t i = 0; i < NUM_RANDOM; ++i) {
+        uint64_t const key = rand() % NUM_KEYS;
+        if (rand() % 2 == 0) {
+            enum PutUniqueStatus r = FlatHashTable__put(&me, key, i);
+            g_assert_cmpint(r,
+                            ==,
+                            present[key] ? LOOKUP_PUTUNIQUE_REPLACE_VALUE
+                                         : LOOKUP_PUTUNIQUE_INSERT_KEY_VALUE);
+            size += !present[key];
+            present[key] = true;
+            values[key] = i;
+        } else {
+            struct LookupReturn r = FlatHashTable__remove(&me, key);
+            g_assert_cmpint(r.success, ==, present[key]);
+            if (r.success) {
+                g_assert_cmpuint(r.timestamp, ==, values[key]);
+            }
+            size -= present[key];
+            present[key] = false;
+        }
+        g_assert_cmpuint(FlatHashTable__get_size(&me), ==, size);
+    }
+    for (uint64_t key = 0; key < NUM_KEYS; ++key) {
+        struct LookupReturn r = FlatHashTable__lookup(&me, key);
+        g_assert_cmpint(r.success, ==, present[key]);
+        if (r.success) {
+            g_assert_cmpuint(r.timestamp, ==, values[key]);
+        }
+    }
+
+    FlatHashTable__destroy(&me);
+    return true;
+}
+
+int
+main(void)
+{
+    ASSERT_FUNCTION_RETURNS_TRUE(test_flat_hash_table());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_random_operations());
+    return EXIT_SUCCESS;
+}
@@ -153,10 +153,78 @@ multi_thread_test(void)
     return true;
 }
 
+struct ConcurrentArgs {
+    struct ParallelHashTable *hash_table;
+    EntryType start, end;
+    bool *done;
+};
+
+static void *
+concurrent_writer(void *args)
+{
+    struct ConcurrentArgs *w = args;
+    for (EntryType entry = w->start; entry < w->end; ++entry) {
+        g_assert_true(ParallelHashTable__put(w->hash_table, entry, entry));
+    }
+    return NULL;
+}
+
+static void *
+concurrent_reader(void *args)
+{
+    struct ConcurrentArgs *w = args;
+    while (!__atomic_load_n(w->done, __ATOMIC_ACQUIRE)) {
+        for (EntryType entry = w->start; entry < w->end; entry += 7) {
+            struct LookupReturn r =
+                ParallelHashTable__lookup(w->hash_table, entry);
+            g_assert_true(!r.success || r.timestamp == entry);
+        }
+    }
+    return NULL;
+}
+
+/// @brief  Test that readers see consistent values while writers insert
+///         and the stripes grow underneath them.
+static bool
+concurrent_resize_test(void)
+{
+    struct ParallelHashTable me = {0};
+    // NOTE I start small so that every stripe grows many times.
+    g_assert_true(ParallelHashTable__init(&me, 1));
+
+    bool done = false;
+    pthread_t writers[4] = {0}, readers[4] = {0};
+    struct ConcurrentArgs args[4] = {0};
+    for (size_t i = 0; i < 4; ++i) {
+        args[i] = (struct ConcurrentArgs){.hash_table = &me,
+                                          .start = i * 64 * N,
+                                          .end = (i + 1) * 64 * N,
+                                          .done = &done};
+        pthread_create(&readers[i], NULL, concurrent_reader, &args[i]);
+        pthread_create(&writers[i], NULL, concurrent_writer, &args[i]);
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        pthread_join(writers[i], NULL);
+    }
+    __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+    for (size_t i = 0; i < 4; ++i) {
+        pthread_join(readers[i], NULL);
+    }
+
+    g_assert_cmpuint(ParallelHashTable__get_size(&me), ==, 4 * 64 * N);
+    for (EntryType entry = 0; entry < 4 * 64 * N; ++entry) {
+        struct LookupReturn r = ParallelHashTable__lookup(&me, entry);
+        g_assert_true(r.success == true && r.timestamp == entry);
+    }
+    ParallelHashTable__destroy(&me);
+    return true;
+}
+
 int
 main(void)
 {
     ASSERT_FUNCTION_RETURNS_TRUE(single_thread_test());
     ASSERT_FUNCTION_RETURNS_TRUE(multi_thread_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(concurrent_resize_test());
     return 0;
 }
@@ -3,11 +3,18 @@
 #include <stdint.h>
 
 #include <glib.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 
+#include "array/array_kernels.h"
 #include "histogram/histogram.h"
+#include "histogram/log_histogram.h"
+#include "io/binary_container.h"
 #include "logger/logger.h"
 #include "miss_rate_curve/miss_rate_curve.h"
+#include "miss_rate_curve/miss_rate_curve_snapshots.h"
+#include "miss_rate_curve/parallel_merge.h"
 
 #include "math/doubles_are_equal.h"
 #include "test/mytester.h"
@@ -92,6 +99,35 @@ test_miss_rate_curve_from_histogram(struct Histogram *hist)
     g_assert_true(exact_match(&mrc, &mrc_from_file));
     g_assert_cmpint(remove("./mrc.bin"), ==, 0);
 
+    // Test the binary container, both dense and sparse
+    for (int sparse = 0; sparse < 2; ++sparse) {
+        struct MissRateCurve mrc_from_container = {0};
+        struct BinaryContainer container = {0};
+        g_assert_true(MissRateCurve__save_binary(&mrc, "./mrc.bin", sparse));
+        g_assert_true(
+            MissRateCurve__load(&mrc_from_container, "./mrc.bin"));
+        g_assert_true(exact_match(&mrc, &mrc_from_container));
+        MissRateCurve__destroy(&mrc_from_container);
+
+        g_assert_true(
+            BinaryContainer__open(&container,
+                                  "./mrc.bin",
+                                  BINARY_CONTAINER_KIND_MISS_RATE_CURVE,
+                                  true));
+        for (size_t i = 0; i < mrc.num_bins; ++i) {
+            g_assert_true(BinaryContainer__get_f64(&container, i) ==
+                          mrc.miss_rate[i]);
+        }
+        if (!sparse) {
+            // NOTE The view borrows the container's memory.
+            g_assert_true(
+                MissRateCurve__init_view(&mrc_from_container, &container));
+            g_assert_true(exact_match(&mrc, &mrc_from_container));
+        }
+        g_assert_true(BinaryContainer__close(&container));
+        g_assert_cmpint(remove("./mrc.bin"), ==, 0);
+    }
+
     // Test the MSE function
     g_assert_true(MissRateCurve__mean_squared_error(&mrc, &mrc_from_file) ==
                   0.0);
@@ -100,6 +136,439 @@ test_miss_rate_curve_from_histogram(struct Histogram *hist)
     return true;
 }
 
+/// @brief  Compare the MRC from a log histogram against the MRC from an
+///         exact histogram of the same values.
+static bool
+test_miss_rate_curve_from_log_histogram(void)
+{
+    size_t const max_value = 1 << 16;
+    struct Histogram hist = {0};
+    struct LogHistogram log_hist = {0};
+    struct MissRateCurve oracle = {0}, mrc = {0};
+    g_assert_true(Histogram__init(&hist,
+                                  max_value,
+                                  1,
+                                  HistogramOutOfBoundsMode__allow_overflow));
+    g_assert_true(LogHistogram__init(&log_hist, 7, max_value));
+
+    // NOTE I insert small, exact values, followed by a heavy tail from a
+    //      linear congruential generator.
+    for (uint64_t i = 0; i < 1 << 7; ++i) {
+        g_assert_true(Histogram__insert_scaled_finite(&hist, i, 1));
+        g_assert_true(LogHistogram__insert_finite(&log_hist, i));
+    }
+    uint64_t x = 1;
+    for (size_t i = 0; i < 1 << 16; ++i) {
+        x = 6364136223846793005 * x + 1442695040888963407;
+        uint64_t const v = (x >> 33) % max_value >> (x >> 60);
+        g_assert_true(Histogram__insert_scaled_finite(&hist, v, 1));
+        g_assert_true(LogHistogram__insert_finite(&log_hist, v));
+    }
+    g_assert_true(Histogram__insert_scaled_infinite(&hist, 100));
+    g_assert_true(LogHistogram__insert_scaled_infinite(&log_hist, 100));
+
+    g_assert_true(MissRateCurve__init_from_histogram(&oracle, &hist));
+    g_assert_true(MissRateCurve__init_from_log_histogram(&mrc,
+                                                         &log_hist,
+                                                         oracle.num_bins,
+                                                         1));
+    g_assert_true(MissRateCurve__validate(&mrc));
+    // NOTE The MRCs match exactly where the log bins are 1 wide.
+    for (size_t i = 0; i <= 1 << 7; ++i) {
+        g_assert_true(doubles_are_equal(mrc.miss_rate[i], oracle.miss_rate[i]));
+    }
+    double const mae = MissRateCurve__mean_absolute_error(&mrc, &oracle);
+    LOGGER_INFO("log histogram MAE: %g", mae);
+    g_assert_cmpfloat(mae, <, 1e-3);
+
+    Histogram__destroy(&hist);
+    LogHistogram__destroy(&log_hist);
+    MissRateCurve__destroy(&oracle);
+    MissRateCurve__destroy(&mrc);
+    return true;
+}
+
+/// @brief  Compute the MAE or MSE with the original scalar loops.
+static double
+reference_mean_error(struct MissRateCurve const *const lhs,
+                     struct MissRateCurve const *const rhs,
+                     bool const squared)
+{
+    size_t wss[2] = {0, 0};
+    struct MissRateCurve const *const mrcs[2] = {lhs, rhs};
+    for (size_t k = 0; k < 2; ++k) {
+        for (size_t i = 1; i < mrcs[k]->num_bins; ++i) {
+            if (mrcs[k]->miss_rate[i] < mrcs[k]->miss_rate[i - 1]) {
+                wss[k] = i;
+            }
+        }
+    }
+    size_t const min_k = wss[0] < wss[1] ? 0 : 1;
+    size_t const min_wss = wss[min_k], max_wss = wss[1 - min_k];
+    double sum = 0.0;
+    for (size_t i = 0; i <= min_wss; ++i) {
+        double const d = lhs->miss_rate[i] - rhs->miss_rate[i];
+        sum += squared ? d * d : fabs(d);
+    }
+    for (size_t i = min_wss; i <= max_wss; ++i) {
+        double const d = mrcs[min_k]->miss_rate[min_wss] -
+                         mrcs[1 - min_k]->miss_rate[i];
+        sum += squared ? d * d : fabs(d);
+    }
+    return sum / (double)(max_wss == 0 ? 1 : max_wss);
+}
+
+/// @brief  Check the vectorized MRC construction and comparisons against
+///         scalar loops, for MRCs of many lengths and working set sizes.
+static bool
+test_vectorized_kernels(void)
+{
+    size_t const num_mrcs = 8;
+    struct MissRateCurve mrcs[8] = {0};
+    struct MissRateCurve const *mrc_ptrs[8] = {0};
+    uint64_t x = 1;
+    for (size_t k = 0; k < num_mrcs; ++k) {
+        // NOTE The lengths are deliberately not multiples of the vectors.
+        size_t const num_bins = 1000 + 1237 * k;
+        struct Histogram hist = {0};
+        g_assert_true(Histogram__init(
+            &hist,
+            num_bins,
+            1,
+            HistogramOutOfBoundsMode__allow_overflow));
+        for (size_t i = 0; i < 10000; ++i) {
+            x = 6364136223846793005 * x + 1442695040888963407;
+            g_assert_true(Histogram__insert_scaled_finite(
+                &hist,
+                (x >> 33) % (num_bins / (k % 3 + 1) + 10),
+                1));
+        }
+        g_assert_true(Histogram__insert_scaled_infinite(&hist, 7));
+        g_assert_true(MissRateCurve__init_from_histogram(&mrcs[k], &hist));
+        g_assert_true(MissRateCurve__validate(&mrcs[k]));
+        mrc_ptrs[k] = &mrcs[k];
+
+        // Every kernel must build exactly the same MRC.
+        enum ArrayKernel const kernels[] = {ARRAY_KERNEL_SCALAR,
+                                            ARRAY_KERNEL_AVX2,
+                                            ARRAY_KERNEL_AVX512};
+        double *const miss_rate = malloc(num_bins * sizeof(*miss_rate));
+        for (size_t j = 0; j < sizeof(kernels) / sizeof(*kernels); ++j) {
+            uint64_t const remainder =
+                ArrayKernel__normalized_suffix_sums(kernels[j],
+                                                    hist.histogram,
+                                                    num_bins,
+                                                    hist.running_sum,
+                                                    miss_rate);
+            g_assert_cmpuint(remainder,
+                             ==,
+                             hist.false_infinity + hist.infinity);
+            for (size_t i = 0; i < num_bins; ++i) {
+                g_assert_true(miss_rate[i] == mrcs[k].miss_rate[i]);
+            }
+        }
+        free(miss_rate);
+        Histogram__destroy(&hist);
+    }
+
+    // The comparisons only match the MRCs with the same bin size, so I
+    // compare MRCs of different lengths (but the same bin size).
+    double maes[8] = {0}, mses[8] = {0};
+    for (size_t oracle = 0; oracle < num_mrcs; ++oracle) {
+        g_assert_true(MissRateCurve__batch_mean_absolute_error(mrc_ptrs[oracle],
+                                                               mrc_ptrs,
+                                                               num_mrcs,
+                                                               maes));
+        g_assert_true(MissRateCurve__batch_mean_squared_error(mrc_ptrs[oracle],
+                                                              mrc_ptrs,
+                                                              num_mrcs,
+                                                              mses));
+        for (size_t k = 0; k < num_mrcs; ++k) {
+            double const mae =
+                MissRateCurve__mean_absolute_error(&mrcs[oracle], &mrcs[k]);
+            double const mse =
+                MissRateCurve__mean_squared_error(&mrcs[oracle], &mrcs[k]);
+            double const ref_mae =
+                k == oracle ? 0.0
+                            : reference_mean_error(&mrcs[oracle],
+                                                   &mrcs[k],
+                                                   false);
+            double const ref_mse =
+                k == oracle
+                    ? 0.0
+                    : reference_mean_error(&mrcs[oracle], &mrcs[k], true);
+            g_assert_true(doubles_are_close(mae, ref_mae, 1e-12));
+            g_assert_true(doubles_are_close(mse, ref_mse, 1e-12));
+            g_assert_true(doubles_are_close(maes[k], ref_mae, 1e-12));
+            g_assert_true(doubles_are_close(mses[k], ref_mse, 1e-12));
+        }
+    }
+
+    // Scaled addition matches the scalar loop.
+    struct MissRateCurve sum = {0};
+    g_assert_true(MissRateCurve__alloc_empty(&sum,
+                                             mrcs[0].num_bins,
+                                             mrcs[0].bin_size));
+    g_assert_true(MissRateCurve__scaled_iadd(&sum, &mrcs[0], 0.25));
+    g_assert_true(MissRateCurve__scaled_iadd(&sum, &mrcs[0], 0.75));
+    g_assert_true(MissRateCurve__all_close(&sum, &mrcs[0], 1e-15));
+    MissRateCurve__destroy(&sum);
+
+    for (size_t k = 0; k < num_mrcs; ++k) {
+        MissRateCurve__destroy(&mrcs[k]);
+    }
+    return true;
+}
+
+#define NUM_SNAPSHOT_BINS 4096
+#define NUM_SNAPSHOTS     200
+
+/// @brief  Check that a coarse MRC matches the full one at every block.
+static bool
+test_coarse_miss_rate_curve(void)
+{
+    struct Histogram hist = {0};
+    struct MissRateCurve full = {0}, coarse = {0};
+    g_assert_true(Histogram__init(&hist,
+                                  1000,
+                                  3,
+                                  HistogramOutOfBoundsMode__allow_overflow));
+    g_assert_true(Histogram__enable_prefix_sums(&hist));
+    // An empty histogram gives an all-zero MRC.
+    g_assert_true(MissRateCurve__refresh_coarse_from_histogram(&coarse, &hist));
+    g_assert_cmpfloat(coarse.miss_rate[0], ==, 0.0);
+
+    uint64_t x = 1;
+    for (size_t i = 0; i < 100000; ++i) {
+        x = 6364136223846793005 * x + 1442695040888963407;
+        if (x >> 61 == 0) {
+            Histogram__insert_infinite(&hist);
+        } else {
+            Histogram__insert_finite(&hist, (x >> 33) % 3500);
+        }
+    }
+    g_assert_true(MissRateCurve__init_from_histogram(&full, &hist));
+    double *const old_memory = coarse.miss_rate;
+    g_assert_true(MissRateCurve__refresh_coarse_from_histogram(&coarse, &hist));
+    // NOTE The size did not change, so the memory is reused.
+    g_assert_true(coarse.miss_rate == old_memory);
+    g_assert_cmpuint(coarse.bin_size, ==, 3 * HISTOGRAM_BLOCK_SIZE);
+    size_t const num_blocks = coarse.num_bins - 2;
+    for (size_t k = 0; k < num_blocks; ++k) {
+        g_assert_cmpfloat(coarse.miss_rate[k],
+                          ==,
+                          full.miss_rate[k * HISTOGRAM_BLOCK_SIZE]);
+        g_assert_cmpfloat(
+            coarse.miss_rate[k],
+            ==,
+            Histogram__get_fraction_at_least(&hist, k * coarse.bin_size));
+    }
+    g_assert_cmpfloat(coarse.miss_rate[num_blocks],
+                      ==,
+                      full.miss_rate[hist.num_bins]);
+    g_assert_cmpfloat(coarse.miss_rate[num_blocks + 1],
+                      ==,
+                      full.miss_rate[hist.num_bins + 1]);
+
+    Histogram__destroy(&hist);
+    MissRateCurve__destroy(&full);
+    MissRateCurve__destroy(&coarse);
+    return true;
+}
+
+struct SnapshotReader {
+    struct MissRateCurveSnapshots *snapshots;
+    bool ok;
+};
+
+/// @brief  Read snapshots until the last one arrives, checking that each
+///         is a whole, newer MRC.
+static void *
+read_snapshots(void *const arg)
+{
+    struct SnapshotReader *const reader = arg;
+    uint64_t last_version = 0;
+    reader->ok = true;
+    while (last_version != NUM_SNAPSHOTS) {
+        uint64_t version = 0;
+        struct MissRateCurve const *const mrc =
+            MissRateCurveSnapshots__consume(reader->snapshots, &version);
+        if (mrc == NULL) {
+            continue;
+        }
+        if (version < last_version) {
+            reader->ok = false;
+        }
+        // NOTE The writer inserts 'version' finite values per snapshot, so
+        //      a torn MRC would not start at one or would not be monotonic.
+        if (mrc->miss_rate[0] != 1.0) {
+            reader->ok = false;
+        }
+        for (size_t i = 1; i < mrc->num_bins; ++i) {
+            if (mrc->miss_rate[i] > mrc->miss_rate[i - 1]) {
+                reader->ok = false;
+            }
+        }
+        last_version = version;
+    }
+    return NULL;
+}
+
+static bool
+test_miss_rate_curve_snapshots(void)
+{
+    struct Histogram hist = {0};
+    struct MissRateCurveSnapshots snapshots = {0};
+    struct SnapshotReader reader = {.snapshots = &snapshots, .ok = false};
+    pthread_t thread;
+    g_assert_true(Histogram__init(&hist,
+                                  NUM_SNAPSHOT_BINS,
+                                  1,
+                                  HistogramOutOfBoundsMode__allow_overflow));
+    g_assert_true(Histogram__enable_prefix_sums(&hist));
+    g_assert_true(MissRateCurveSnapshots__init(&snapshots));
+    g_assert_null(MissRateCurveSnapshots__consume(&snapshots, NULL));
+
+    g_assert_cmpint(pthread_create(&thread, NULL, read_snapshots, &reader),
+                    ==,
+                    0);
+    uint64_t x = 1;
+    for (size_t s = 1; s <= NUM_SNAPSHOTS; ++s) {
+        for (size_t i = 0; i < s; ++i) {
+            x = 6364136223846793005 * x + 1442695040888963407;
+            Histogram__insert_finite(&hist, (x >> 33) % NUM_SNAPSHOT_BINS);
+        }
+        g_assert_true(MissRateCurveSnapshots__publish(&snapshots, &hist));
+    }
+    g_assert_cmpint(pthread_join(thread, NULL), ==, 0);
+    g_assert_true(reader.ok);
+
+    // The last snapshot matches the final histogram.
+    struct MissRateCurve coarse = {0};
+    uint64_t version = 0;
+    g_assert_true(MissRateCurve__refresh_coarse_from_histogram(&coarse, &hist));
+    struct MissRateCurve const *const last =
+        MissRateCurveSnapshots__consume(&snapshots, &version);
+    g_assert_cmpuint(version, ==, NUM_SNAPSHOTS);
+    struct MissRateCurve last_copy = *last;
+    g_assert_true(exact_match(&coarse, &last_copy));
+
+    MissRateCurve__destroy(&coarse);
+    MissRateCurveSnapshots__destroy(&snapshots);
+    Histogram__destroy(&hist);
+    return true;
+}
+
+#define NUM_MERGE_INPUTS 13
+
+struct MergeInputs {
+    /// Fail to load this input, or NUM_MERGE_INPUTS to never fail
+    size_t fail_at;
+};
+
+/// @brief  Generate a histogram whose bin size (1, 2, or 4) and number of
+///         bins depend on 'i', so that the merge must rebin.
+static bool
+load_merge_histogram(void *const data,
+                     size_t const i,
+                     struct Histogram *const dst)
+{
+    struct MergeInputs const *const inputs = data;
+    if (i == inputs->fail_at) {
+        return false;
+    }
+    if (!Histogram__init(dst,
+                         64 + 16 * i,
+                         1 << (i % 3),
+                         HistogramOutOfBoundsMode__allow_overflow)) {
+        return false;
+    }
+    uint64_t x = i + 1;
+    for (size_t j = 0; j < 1000; ++j) {
+        x = 6364136223846793005 * x + 1442695040888963407;
+        if ((x >> 60) == 0) {
+            Histogram__insert_infinite(dst);
+        } else {
+            Histogram__insert_finite(dst, (x >> 33) % 512);
+        }
+    }
+    return true;
+}
+
+static bool
+load_merge_miss_rate_curve(void *const data,
+                           size_t const i,
+                           struct MissRateCurve *const dst)
+{
+    struct Histogram hist = {0};
+    bool const r = load_merge_histogram(data, i, &hist) &&
+                   MissRateCurve__init_from_histogram(dst, &hist);
+    Histogram__destroy(&hist);
+    return r;
+}
+
+/// @brief  Check that the parallel merge matches a serial fold, for any
+///         number of threads.
+static bool
+test_parallel_merge(void)
+{
+    struct MergeInputs inputs = {.fail_at = NUM_MERGE_INPUTS};
+    struct Histogram oracle_hist = {0}, hist = {0};
+    struct MissRateCurve oracle_mrc = {0}, mrc = {0};
+    g_assert_true(load_merge_histogram(&inputs, 0, &oracle_hist));
+    g_assert_true(load_merge_miss_rate_curve(&inputs, 0, &oracle_mrc));
+    for (size_t i = 1; i < NUM_MERGE_INPUTS; ++i) {
+        g_assert_true(load_merge_histogram(&inputs, i, &hist));
+        g_assert_true(Histogram__iadd(&oracle_hist, &hist));
+        Histogram__destroy(&hist);
+        g_assert_true(load_merge_miss_rate_curve(&inputs, i, &mrc));
+        g_assert_true(MissRateCurve__scaled_iadd(&oracle_mrc, &mrc, 1.0));
+        MissRateCurve__destroy(&mrc);
+    }
+    // The widest input (i = 11) has 240 bins of size 4.
+    g_assert_cmpuint(oracle_hist.bin_size, ==, 4);
+    g_assert_cmpuint(oracle_hist.num_bins, ==, 240);
+    g_assert_cmpuint(oracle_hist.running_sum, ==, NUM_MERGE_INPUTS * 1000);
+    g_assert_true(Histogram__validate(&oracle_hist));
+
+    size_t const num_threads[] = {1, 2, 3, 8, 64};
+    for (size_t t = 0; t < sizeof(num_threads) / sizeof(*num_threads); ++t) {
+        g_assert_true(ParallelMerge__histograms(&hist,
+                                                NUM_MERGE_INPUTS,
+                                                load_merge_histogram,
+                                                &inputs,
+                                                num_threads[t]));
+        g_assert_true(Histogram__exactly_equal(&hist, &oracle_hist));
+        Histogram__destroy(&hist);
+
+        g_assert_true(
+            ParallelMerge__miss_rate_curves(&mrc,
+                                            NUM_MERGE_INPUTS,
+                                            load_merge_miss_rate_curve,
+                                            &inputs,
+                                            num_threads[t]));
+        g_assert_true(MissRateCurve__all_close(&mrc, &oracle_mrc, 1e-12));
+        MissRateCurve__destroy(&mrc);
+    }
+
+    // A failed load fails the merge (without leaking the other inputs).
+    inputs.fail_at = NUM_MERGE_INPUTS / 2;
+    g_assert_false(ParallelMerge__histograms(&hist,
+                                             NUM_MERGE_INPUTS,
+                                             load_merge_histogram,
+                                             &inputs,
+                                             4));
+    g_assert_false(ParallelMerge__miss_rate_curves(&mrc,
+                                                   NUM_MERGE_INPUTS,
+                                                   load_merge_miss_rate_curve,
+                                                   &inputs,
+                                                   4));
+
+    Histogram__destroy(&oracle_hist);
+    MissRateCurve__destroy(&oracle_mrc);
+    return true;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -111,5 +580,10 @@ main(int argc, char **argv)
         test_miss_rate_curve_from_histogram(&SPARSE_HIST));
     ASSERT_FUNCTION_RETURNS_TRUE(
         test_miss_rate_curve_from_histogram(&VERY_SPARSE_HIST));
+    ASSERT_FUNCTION_RETURNS_TRUE(test_miss_rate_curve_from_log_histogram());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_vectorized_kernels());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_coarse_miss_rate_curve());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_miss_rate_curve_snapshots());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_parallel_merge());
     return 0;
 }
@@ -0,0 +1,185 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "arrays/reverse_index.h"
+#include "types/key_type.h"
+#include "types/value_type.h"
+
+#include "priority_queue/indexed_heap.h"
+
+static void
+test_static_max_heap(void)
+{
+    size_t const heap_size = 1 << 12;
+    struct IndexedHeap me = {0};
+    g_assert_true(IndexedHeap__init_max_heap(&me, heap_size));
+
+    for (size_t i = 0; i < heap_size; ++i) {
+        g_assert_false(IndexedHeap__is_full(&me));
+        g_assert_true(IndexedHeap__insert_if_room(&me, i, i));
+    }
+    g_assert_true(IndexedHeap__is_full(&me));
+    g_assert_false(IndexedHeap__insert_if_room(&me, heap_size, heap_size));
+    g_assert_true(IndexedHeap__validate(&me));
+
+    for (size_t i = 0; i < heap_size; ++i) {
+        KeyType key = 0;
+        ValueType value = 0;
+        size_t const max_key = REVERSE_INDEX(i, heap_size);
+        g_assert_cmpuint(IndexedHeap__get_top_key(&me), ==, max_key);
+        g_assert_true(IndexedHeap__pop(&me, &key, &value));
+        g_assert_cmpuint(key, ==, max_key);
+        g_assert_cmpuint(value, ==, max_key);
+    }
+    g_assert_cmpuint(me.length, ==, 0);
+    g_assert_false(IndexedHeap__pop(&me, NULL, NULL));
+    IndexedHeap__destroy(&me);
+}
+
+static void
+test_duplicates(void)
+{
+    struct IndexedHeap me = {0};
+    g_assert_true(IndexedHeap__init_min_heap(&me, 1));
+
+    // Values must be unique, but keys may repeat.
+    g_assert_true(IndexedHeap__insert(&me, 7, 0));
+    g_assert_false(IndexedHeap__insert(&me, 3, 0));
+    g_assert_true(IndexedHeap__insert(&me, 7, 1));
+    g_assert_cmpuint(me.length, ==, 2);
+    g_assert_true(IndexedHeap__validate(&me));
+
+    KeyType key = 0;
+    g_assert_true(IndexedHeap__get_key(&me, 0, &key));
+    g_assert_cmpuint(key, ==, 7);
+    IndexedHeap__destroy(&me);
+}
+
+static void
+test_update_and_remove(void)
+{
+    struct IndexedHeap me = {0};
+    g_assert_true(IndexedHeap__init_min_heap(&me, 0));
+    for (ValueType v = 0; v < 100; ++v) {
+        g_assert_true(IndexedHeap__insert(&me, 1000 + v, v));
+    }
+
+    // Decrease a key to the top.
+    g_assert_true(IndexedHeap__update_key(&me, 50, 1));
+    g_assert_cmpuint(IndexedHeap__get_top_key(&me), ==, 1);
+    // Increase it again past everything else.
+    g_assert_true(IndexedHeap__update_key(&me, 50, 5000));
+    g_assert_cmpuint(IndexedHeap__get_top_key(&me), ==, 1000);
+    g_assert_true(IndexedHeap__validate(&me));
+
+    // Remove from the middle and the top.
+    KeyType key = 0;
+    g_assert_true(IndexedHeap__remove(&me, 50, &key));
+    g_assert_cmpuint(key, ==, 5000);
+    g_assert_false(IndexedHeap__contains(&me, 50));
+    g_assert_false(IndexedHeap__remove(&me, 50, &key));
+    g_assert_false(IndexedHeap__update_key(&me, 50, 0));
+    g_assert_true(IndexedHeap__remove(&me, 0, NULL));
+    g_assert_cmpuint(IndexedHeap__get_top_key(&me), ==, 1001);
+    g_assert_cmpuint(me.length, ==, 98);
+    g_assert_true(IndexedHeap__validate(&me));
+    IndexedHeap__destroy(&me);
+}
+
+/// @brief  Run random operations against a brute-force oracle, where
+///         oracle[v] is value v's key or UINT64_MAX if it is absent.
+static void
+test_random_operations(void)
+{
+    size_t const num_values = 1 << 10;
+    size_t const num_ops = 1 << 16;
+    KeyType *oracle = malloc(num_values * sizeof(*oracle));
+    g_assert_nonnull(oracle);
+    for (size_t v = 0; v < num_values; ++v) {
+        oracle[v] = UINT64_MAX;
+    }
+    struct IndexedHeap me = {0};
+    g_assert_true(IndexedHeap__init_min_heap(&me, 16));
+    size_t oracle_length = 0;
+
+    srand(42);
+    for (size_t i = 0; i < num_ops; ++i) {
+        ValueType const v = rand() % num_values;
+        KeyType const k = rand() % 1000;
+        KeyType key = 0;
+        switch (rand() % 4) {
+        case 0:
+            g_assert_cmpint(IndexedHeap__insert(&me, k, v),
+                            ==,
+                            oracle[v] == UINT64_MAX);
+            if (oracle[v] == UINT64_MAX) {
+                oracle[v] = k;
+                ++oracle_length;
+            }
+            break;
+        case 1:
+            g_assert_cmpint(IndexedHeap__update_key(&me, v, k),
+                            ==,
+                            oracle[v] != UINT64_MAX);
+            if (oracle[v] != UINT64_MAX) {
+                oracle[v] = k;
+            }
+            break;
+        case 2:
+            g_assert_cmpint(IndexedHeap__remove(&me, v, &key),
+                            ==,
+                            oracle[v] != UINT64_MAX);
+            if (oracle[v] != UINT64_MAX) {
+                g_assert_cmpuint(key, ==, oracle[v]);
+                oracle[v] = UINT64_MAX;
+                --oracle_length;
+            }
+            break;
+        case 3: {
+            ValueType value = 0;
+            KeyType min_key = UINT64_MAX;
+            for (size_t j = 0; j < num_values; ++j) {
+                min_key = oracle[j] < min_key ? oracle[j] : min_key;
+            }
+            g_assert_cmpint(IndexedHeap__pop(&me, &key, &value),
+                            ==,
+                            oracle_length != 0);
+            if (oracle_length != 0) {
+                g_assert_cmpuint(key, ==, min_key);
+                g_assert_cmpuint(oracle[value], ==, key);
+                oracle[value] = UINT64_MAX;
+                --oracle_length;
+            }
+            break;
+        }
+        default:
+            g_assert_not_reached();
+        }
+        g_assert_cmpuint(me.length, ==, oracle_length);
+        if (i % 1024 == 0) {
+            g_assert_true(IndexedHeap__validate(&me));
+        }
+    }
+    g_assert_true(IndexedHeap__validate(&me));
+    IndexedHeap__destroy(&me);
+    free(oracle);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/priority_queue_test/indexed_heap__static_max_test",
+                    test_static_max_heap);
+    g_test_add_func("/priority_queue_test/indexed_heap__duplicates_test",
+                    test_duplicates);
+    g_test_add_func("/priority_queue_test/indexed_heap__update_remove_test",
+                    test_update_and_remove);
+    g_test_add_func("/priority_queue_test/indexed_heap__random_test",
+                    test_random_operations);
+    return g_test_run();
+}
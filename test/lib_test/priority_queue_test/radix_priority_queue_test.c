@@ -0,0 +1,123 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <glib.h>
+
+#include "hash/hash.h"
+#include "priority_queue/heap.h"
+#include "types/key_type.h"
+#include "types/value_type.h"
+
+#include "priority_queue/radix_priority_queue.h"
+
+static void
+count_eviction(void *data, ValueType value)
+{
+    (void)value;
+    ++*(size_t *)data;
+}
+
+static void
+test_small_queue(void)
+{
+    struct RadixPriorityQueue me = {0};
+    g_assert_true(RadixPriorityQueue__init(&me, 10));
+
+    for (KeyType k = 0; k < 10; ++k) {
+        g_assert_false(RadixPriorityQueue__is_full(&me));
+        g_assert_true(RadixPriorityQueue__insert_if_room(&me, k, k));
+    }
+    g_assert_true(RadixPriorityQueue__is_full(&me));
+    g_assert_false(RadixPriorityQueue__insert_if_room(&me, 10, 10));
+    g_assert_true(RadixPriorityQueue__validate(&me));
+
+    // Remove the maximum.
+    size_t num_evicted = 0;
+    g_assert_cmpuint(RadixPriorityQueue__get_top_key(&me), ==, 9);
+    g_assert_cmpuint(
+        RadixPriorityQueue__remove_top(&me, count_eviction, &num_evicted),
+        ==,
+        1);
+    g_assert_cmpuint(num_evicted, ==, 1);
+
+    // Insert a duplicate key, which we remove along with the original.
+    g_assert_true(RadixPriorityQueue__insert_if_room(&me, 8, 100));
+    g_assert_cmpuint(RadixPriorityQueue__get_top_key(&me), ==, 8);
+    g_assert_cmpuint(RadixPriorityQueue__remove_top(&me, NULL, NULL), ==, 2);
+    g_assert_cmpuint(RadixPriorityQueue__get_top_key(&me), ==, 7);
+
+    // Insert a key above the maximum, which forces us to rebucket.
+    g_assert_true(RadixPriorityQueue__insert_if_room(&me, 1000, 1000));
+    g_assert_true(RadixPriorityQueue__validate(&me));
+    g_assert_cmpuint(RadixPriorityQueue__get_top_key(&me), ==, 1000);
+    g_assert_cmpuint(RadixPriorityQueue__remove_top(&me, NULL, NULL), ==, 1);
+
+    for (KeyType k = 7; k != UINT64_MAX; --k) {
+        g_assert_cmpuint(RadixPriorityQueue__get_top_key(&me), ==, k);
+        g_assert_cmpuint(RadixPriorityQueue__remove_top(&me, NULL, NULL),
+                         ==,
+                         1);
+    }
+    g_assert_cmpuint(me.length, ==, 0);
+    g_assert_cmpuint(RadixPriorityQueue__remove_top(&me, NULL, NULL), ==, 0);
+    RadixPriorityQueue__destroy(&me);
+}
+
+/// @brief  Run the fixed-size SHARDS eviction loop on a radix queue and a
+///         heap, which must evict the same keys in the same order.
+static void
+test_against_heap(void)
+{
+    size_t const max_size = 1 << 10;
+    struct RadixPriorityQueue me = {0};
+    struct Heap oracle = {0};
+    g_assert_true(RadixPriorityQueue__init(&me, max_size));
+    g_assert_true(Heap__init_max_heap(&oracle, max_size));
+
+    KeyType threshold = UINT64_MAX;
+    for (ValueType v = 0; v < 1 << 20; ++v) {
+        // NOTE I truncate the hashes to create duplicate keys.
+        KeyType const key = Hash64Bit(v) >> 44;
+        if (key > threshold) {
+            continue;
+        }
+        if (RadixPriorityQueue__is_full(&me)) {
+            g_assert_true(Heap__is_full(&oracle));
+            KeyType const max_key = Heap__get_top_key(&oracle);
+            size_t num_oracle_evicted = 0;
+            ValueType value = 0;
+            while (Heap__remove(&oracle, max_key, &value)) {
+                ++num_oracle_evicted;
+            }
+            g_assert_cmpuint(RadixPriorityQueue__get_top_key(&me),
+                             ==,
+                             max_key);
+            g_assert_cmpuint(RadixPriorityQueue__remove_top(&me, NULL, NULL),
+                             ==,
+                             num_oracle_evicted);
+            threshold = RadixPriorityQueue__get_top_key(&me);
+            g_assert_cmpuint(threshold, ==, Heap__get_top_key(&oracle));
+        }
+        g_assert_true(RadixPriorityQueue__insert_if_room(&me, key, v));
+        g_assert_true(Heap__insert_if_room(&oracle, key, v));
+        if (v % 4096 == 0) {
+            g_assert_true(RadixPriorityQueue__validate(&me));
+        }
+    }
+    g_assert_true(RadixPriorityQueue__validate(&me));
+    RadixPriorityQueue__destroy(&me);
+    Heap__destroy(&oracle);
+}
+
+int
+main(int argc, char **argv)
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/priority_queue_test/radix_priority_queue__test",
+                    test_small_queue);
+    g_test_add_func("/priority_queue_test/radix_priority_queue__heap_test",
+                    test_against_heap);
+    return g_test_run();
+}
@@ -80,11 +80,45 @@ test_splay_priority_queue(void)
     SplayPriorityQueue__destroy(&pq);
 }
 
+/// @brief  Check that keys that differ by 2^63 or more are ordered
+///         correctly, since SHARDS inserts full-range 64-bit hashes.
+void
+test_splay_priority_queue_full_range_keys(void)
+{
+    struct SplayPriorityQueue pq;
+    Hash64BitType const keys[] = {
+        1,
+        UINT64_MAX,
+        (Hash64BitType)1 << 63,
+        0,
+        ((Hash64BitType)1 << 63) - 1,
+    };
+    // The keys in descending order, by their index in 'keys'.
+    size_t const descending[] = {1, 2, 4, 0, 3};
+    size_t const nr_keys = sizeof(keys) / sizeof(*keys);
+
+    g_assert_true(SplayPriorityQueue__init(&pq, nr_keys));
+    for (size_t i = 0; i < nr_keys; ++i) {
+        g_assert_true(
+            SplayPriorityQueue__insert_if_room(&pq, keys[i], (EntryType)i));
+    }
+    for (size_t i = 0; i < nr_keys; ++i) {
+        Hash64BitType const expected = keys[descending[i]];
+        EntryType entry = 0;
+        g_assert_cmpuint(SplayPriorityQueue__get_max_hash(&pq), ==, expected);
+        g_assert_true(SplayPriorityQueue__remove(&pq, expected, &entry));
+        g_assert_cmpuint(entry, ==, (EntryType)descending[i]);
+    }
+    SplayPriorityQueue__destroy(&pq);
+}
+
 int
 main(int argc, char **argv)
 {
     g_test_init(&argc, &argv, NULL);
     g_test_add_func("/priority_queue_test/splay_priority_queue__test",
                     test_splay_priority_queue);
+    g_test_add_func("/priority_queue_test/splay_priority_queue__full_range",
+                    test_splay_priority_queue_full_range_keys);
     return g_test_run();
 }
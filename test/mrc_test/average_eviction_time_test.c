@@ -3,6 +3,7 @@
 
 #include "arrays/array_size.h"
 #include "average_eviction_time/average_eviction_time.h"
+#include "average_eviction_time/sampled_average_eviction_time.h"
 #include "histogram/histogram.h"
 #include "logger/logger.h"
 #include "miss_rate_curve/miss_rate_curve.h"
@@ -77,6 +78,70 @@ test_on_step_trace(void)
     return true;
 }
 
+/// @brief  Compare the sampled AET against the exact AET.
+/// @param  max_size: size_t const
+///         The sampled AET's memory budget. If this is at least the
+///         number of unique keys, then the only error comes from the
+///         log-bucketing of the reuse times.
+static bool
+compare_sampled_against_exact(struct Trace const *const trace,
+                              size_t const max_size,
+                              double const max_mae)
+{
+    // NOTE The histogram must cover the longest reuse times, which can
+    //      be as long as the trace, or else the exact AET truncates them.
+    size_t const num_bins = trace->length;
+    struct AverageEvictionTime oracle = {0};
+    struct SampledAverageEvictionTime me = {0};
+    g_assert_true(AverageEvictionTime__init(&oracle, num_bins, 1, false));
+    g_assert_true(
+        SampledAverageEvictionTime__init(&me, 1.0, max_size, num_bins, 1));
+
+    for (size_t i = 0; i < trace->length; ++i) {
+        uint64_t key = trace->trace[i].key;
+        g_assert_true(AverageEvictionTime__access_item(&oracle, key));
+        g_assert_true(SampledAverageEvictionTime__access_item(&me, key));
+    }
+    g_assert_true(SampledAverageEvictionTime__post_process(&me));
+    // NOTE We should never track more than our memory budget.
+    g_assert_cmpuint(KHashTable__get_size(&me.hash_table), <=, max_size);
+
+    struct MissRateCurve oracle_mrc = {0}, mrc = {0};
+    g_assert_true(AverageEvictionTime__to_mrc(&oracle, &oracle_mrc));
+    g_assert_true(SampledAverageEvictionTime__to_mrc(&me, &mrc));
+    double const mae = MissRateCurve__mean_absolute_error(&oracle_mrc, &mrc);
+    LOGGER_INFO("Mean Absolute Error: %lf", mae);
+    g_assert_cmpfloat(mae, <=, max_mae);
+
+    MissRateCurve__destroy(&oracle_mrc);
+    MissRateCurve__destroy(&mrc);
+    AverageEvictionTime__destroy(&oracle);
+    SampledAverageEvictionTime__destroy(&me);
+    return true;
+}
+
+static bool
+test_sampled_against_exact(void)
+{
+    size_t const num_unique = 1 << 12;
+    struct Trace zipfian = generate_zipfian_trace(1 << 18, num_unique, 0.99, 0);
+    struct Trace uniform = generate_uniform_trace(1 << 18, num_unique, 0);
+    if (zipfian.trace == NULL || uniform.trace == NULL) {
+        LOGGER_ERROR("bad trace");
+        return false;
+    }
+    // NOTE Every key is tracked, so the histogram should match closely.
+    g_assert_true(compare_sampled_against_exact(&zipfian, num_unique, 1e-4));
+    g_assert_true(compare_sampled_against_exact(&uniform, num_unique, 1e-4));
+    // NOTE Spatial sampling suffers on skewed traces where a handful of
+    //      hot keys dominate the reuse times, so I only check the
+    //      memory-bounded accuracy on the uniform trace.
+    g_assert_true(compare_sampled_against_exact(&uniform, 256, 0.01));
+    Trace__destroy(&zipfian);
+    Trace__destroy(&uniform);
+    return true;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -84,5 +149,6 @@ main(int argc, char **argv)
     UNUSED(argv);
     ASSERT_FUNCTION_RETURNS_TRUE(access_same_key_five_times());
     ASSERT_FUNCTION_RETURNS_TRUE(test_on_step_trace());
+    ASSERT_FUNCTION_RETURNS_TRUE(test_sampled_against_exact());
     return 0;
 }
@@ -4,6 +4,7 @@
 
 #include "arrays/array_size.h"
 #include "evicting_map/evicting_map.h"
+#include "evicting_map/parallel_evicting_map.h"
 #include "logger/logger.h"
 #include "miss_rate_curve/miss_rate_curve.h"
 #include "olken/olken.h"
@@ -117,6 +118,50 @@ long_accuracy_trace_test(void)
     return true;
 }
 
+static bool
+parallel_accuracy_trace_test(void)
+{
+    struct ZipfianRandom zrng = {0};
+    struct Olken oracle = {0};
+    struct ParallelEvictingMap me = {0};
+
+    g_assert_true(ZipfianRandom__init(&zrng,
+                                      MAX_NUM_UNIQUE_ENTRIES,
+                                      ZIPFIAN_RANDOM_SKEW,
+                                      0));
+    g_assert_true(Olken__init(&oracle, MAX_NUM_UNIQUE_ENTRIES, 1));
+    g_assert_true(ParallelEvictingMap__init(&me,
+                                            4,
+                                            1.0,
+                                            1 << 12,
+                                            MAX_NUM_UNIQUE_ENTRIES,
+                                            1));
+
+    for (uint64_t i = 0; i < TRACE_LENGTH; ++i) {
+        uint64_t entry = ZipfianRandom__next(&zrng);
+        Olken__access_item(&oracle, entry);
+        g_assert_true(ParallelEvictingMap__access_item(&me, entry));
+    }
+    g_assert_true(ParallelEvictingMap__post_process(&me));
+    g_assert_cmpuint(me.map.current_time_stamp, ==, TRACE_LENGTH);
+    struct MissRateCurve oracle_mrc = {0}, mrc = {0};
+    g_assert_true(
+        MissRateCurve__init_from_histogram(&oracle_mrc, &oracle.histogram));
+    g_assert_true(ParallelEvictingMap__to_mrc(&me, &mrc));
+    double mse = MissRateCurve__mean_squared_error(&oracle_mrc, &mrc);
+    LOGGER_INFO("Mean-Squared Error: %lf", mse);
+    // NOTE The parallel version samples exactly the same entries as
+    //      the serial version, so it should be within the same bound.
+    g_assert_cmpfloat(mse, <=, 0.032);
+
+    ZipfianRandom__destroy(&zrng);
+    Olken__destroy(&oracle);
+    ParallelEvictingMap__destroy(&me);
+    MissRateCurve__destroy(&oracle_mrc);
+    MissRateCurve__destroy(&mrc);
+    return true;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -125,5 +170,6 @@ main(int argc, char **argv)
     ASSERT_FUNCTION_RETURNS_TRUE(access_same_key_five_times());
     ASSERT_FUNCTION_RETURNS_TRUE(small_exact_trace_test());
     ASSERT_FUNCTION_RETURNS_TRUE(long_accuracy_trace_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(parallel_accuracy_trace_test());
     return EXIT_SUCCESS;
 }
@@ -4,6 +4,7 @@
 
 #include "arrays/array_size.h"
 #include "evicting_quickmrc/evicting_quickmrc.h"
+#include "evicting_quickmrc/qmrc.h"
 #include "histogram/histogram.h"
 #include "logger/logger.h"
 #include "miss_rate_curve/miss_rate_curve.h"
@@ -136,6 +137,89 @@ long_accuracy_trace_test(void)
     return true;
 }
 
+/// @brief  Run the raw QMRC array with a given kernel and record the
+///         stack distances that it returns.
+static bool
+run_qmrc_kernel(enum qmrc_kernel kernel,
+                size_t const nr_buckets,
+                size_t const num_keys,
+                size_t const trace_length,
+                size_t *const distances)
+{
+    struct ZipfianRandom zrng = {0};
+    struct qmrc qmrc = {0};
+    int *key_epochs = calloc(num_keys, sizeof(*key_epochs));
+    bool *seen = calloc(num_keys, sizeof(*seen));
+    g_assert_nonnull(key_epochs);
+    g_assert_nonnull(seen);
+
+    g_assert_true(ZipfianRandom__init(&zrng, num_keys, ZIPFIAN_RANDOM_SKEW, 0));
+    g_assert_true(qmrc__init(&qmrc, num_keys, nr_buckets, 0));
+    g_assert_true(qmrc__set_kernel(&qmrc, kernel));
+    for (size_t i = 0; i < trace_length; ++i) {
+        uint64_t key = ZipfianRandom__next(&zrng) % num_keys;
+        if (seen[key]) {
+            distances[i] = qmrc__lookup(&qmrc, key_epochs[key]);
+            key_epochs[key] = qmrc.epochs[0];
+        } else {
+            distances[i] = SIZE_MAX;
+            key_epochs[key] = qmrc__insert(&qmrc);
+            seen[key] = true;
+        }
+    }
+
+    ZipfianRandom__destroy(&zrng);
+    // NOTE I do not decrement the counts as the keys leave, so this
+    //      would fail the (optional) emptiness assertions.
+    free(qmrc.counts);
+    free(qmrc.epochs);
+    free(key_epochs);
+    free(seen);
+    return true;
+}
+
+/// @brief  Test that the SIMD kernels return exactly the same stack
+///         distances as the scalar kernel.
+static bool
+kernel_equivalence_test(void)
+{
+    size_t const num_keys = 1 << 12, trace_length = 1 << 16;
+    // NOTE I test sizes that are not multiples of the vector widths too.
+    size_t const nr_buckets[] = {16, 100, 128, 1000, 1024};
+    enum qmrc_kernel const kernels[] = {QMRC_KERNEL_AVX2, QMRC_KERNEL_AVX512};
+    size_t *oracle = calloc(trace_length, sizeof(*oracle));
+    size_t *distances = calloc(trace_length, sizeof(*distances));
+    g_assert_nonnull(oracle);
+    g_assert_nonnull(distances);
+
+    for (size_t i = 0; i < ARRAY_SIZE(nr_buckets); ++i) {
+        run_qmrc_kernel(QMRC_KERNEL_SCALAR,
+                        nr_buckets[i],
+                        num_keys,
+                        trace_length,
+                        oracle);
+        for (size_t j = 0; j < ARRAY_SIZE(kernels); ++j) {
+            if (!qmrc__kernel_is_supported(kernels[j])) {
+                LOGGER_WARN("skipping unsupported kernel '%s'",
+                            qmrc__kernel_name(kernels[j]));
+                continue;
+            }
+            run_qmrc_kernel(kernels[j],
+                            nr_buckets[i],
+                            num_keys,
+                            trace_length,
+                            distances);
+            for (size_t k = 0; k < trace_length; ++k) {
+                g_assert_cmpuint(distances[k], ==, oracle[k]);
+            }
+        }
+    }
+
+    free(oracle);
+    free(distances);
+    return true;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -144,5 +228,6 @@ main(int argc, char **argv)
     ASSERT_FUNCTION_RETURNS_TRUE(access_same_key_five_times());
     ASSERT_FUNCTION_RETURNS_TRUE(small_exact_trace_test());
     ASSERT_FUNCTION_RETURNS_TRUE(long_accuracy_trace_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(kernel_equivalence_test());
     return EXIT_SUCCESS;
 }
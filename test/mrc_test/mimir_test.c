@@ -32,6 +32,7 @@ tester_refresh_buckets(struct MimirBuckets *me)
         {100, 10, 20, 30, 40, 50, 60, 70, 80, 90};
     const struct MimirBuckets reset_target = {
         .buckets = me->buckets,
+        .count_tree = me->count_tree,
         .num_buckets = 10,
         .newest_bucket = 9,
         .oldest_bucket = 0,
@@ -43,6 +44,7 @@ tester_refresh_buckets(struct MimirBuckets *me)
         reset_target.buckets[i] = original_buckets[i];
     }
     *me = reset_target;
+    count_tree_rebuild(me);
 }
 
 static bool
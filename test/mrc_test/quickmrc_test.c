@@ -12,6 +12,7 @@
 #include "histogram/histogram.h"
 #include "miss_rate_curve/miss_rate_curve.h"
 #include "olken/olken.h"
+#include "quickmrc/buckets.h"
 #include "quickmrc/quickmrc.h"
 #include "random/zipfian_random.h"
 #include "test/mytester.h"
@@ -140,6 +141,63 @@ mean_absolute_error_test(void)
     return true;
 }
 
+/// @brief  Find the stack distance by linearly scanning the buckets, which
+///         is how we used to find it before we indexed the buckets.
+static uint64_t
+linear_scan_stack_distance(struct QuickMRCBuckets const *const me,
+                           TimeStampType const old_timestamp)
+{
+    uint64_t stack_dist = 0;
+    for (uint64_t i = 0; i < me->num_buckets; ++i) {
+        stack_dist += me->buckets[i].count;
+        if (me->buckets[i].max_timestamp == 0 ||
+            me->buckets[i].max_timestamp < old_timestamp) {
+            return stack_dist;
+        }
+    }
+    return stack_dist;
+}
+
+/// @brief  Test that the indexed buckets give the same stack distances as a
+///         linear scan, including across many merges.
+static bool
+bucket_index_test(void)
+{
+    uint64_t const num_keys = 1000, trace_length = 1 << 16;
+    struct ZipfianRandom zrng = {0};
+    struct QuickMRCBuckets me = {0};
+    TimeStampType *timestamps = calloc(num_keys, sizeof(*timestamps));
+    bool *seen = calloc(num_keys, sizeof(*seen));
+    g_assert_nonnull(timestamps);
+    g_assert_nonnull(seen);
+
+    g_assert_true(ZipfianRandom__init(&zrng, num_keys, 0.5, 0));
+    // NOTE I use a number of buckets that is not a power of two so that
+    //      the Fenwick tree is not perfectly balanced.
+    g_assert_true(QuickMRCBuckets__init(&me, 37, 4));
+    for (uint64_t i = 0; i < trace_length; ++i) {
+        uint64_t const key = ZipfianRandom__next(&zrng) % num_keys;
+        if (seen[key]) {
+            uint64_t const stack_dist =
+                QuickMRCBuckets__reaccess_old(&me, timestamps[key]);
+            // NOTE The reaccess has already decremented the old bucket.
+            g_assert_cmpuint(stack_dist,
+                             ==,
+                             linear_scan_stack_distance(&me, timestamps[key]));
+        } else {
+            g_assert_true(QuickMRCBuckets__insert_new(&me));
+            seen[key] = true;
+        }
+        timestamps[key] = me.buckets[0].max_timestamp;
+    }
+
+    ZipfianRandom__destroy(&zrng);
+    QuickMRCBuckets__destroy(&me);
+    free(timestamps);
+    free(seen);
+    return true;
+}
+
 struct WorkerData {
     struct QuickMRC *qmrc;
     EntryType *entries;
@@ -220,6 +278,7 @@ main(int argc, char **argv)
     UNUSED(argv);
     ASSERT_FUNCTION_RETURNS_TRUE(access_same_key_five_times());
     ASSERT_FUNCTION_RETURNS_TRUE(small_merge_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(bucket_index_test());
     ASSERT_FUNCTION_RETURNS_TRUE(mean_absolute_error_test());
     ASSERT_FUNCTION_RETURNS_TRUE(long_trace_test());
     ASSERT_FUNCTION_RETURNS_TRUE(parallel_test());
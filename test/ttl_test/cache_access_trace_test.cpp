@@ -0,0 +1,141 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cache_metadata/cache_access.hpp"
+#include "logger/logger.h"
+#include "test/mytester.h"
+#include "trace/reader.h"
+#include "trace/trace.h"
+
+/// @brief  Write a random trace in Kia's format.
+static std::vector<std::uint8_t>
+write_random_trace(std::string const &fname,
+                   std::uint64_t const seed,
+                   std::size_t const length)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint8_t> bytes(length * 25);
+    for (std::size_t i = 0; i < length; ++i) {
+        std::uint8_t *const item = &bytes[i * 25];
+        std::uint64_t const timestamp_ms = i;
+        std::uint8_t const command = rng() % 4 == 0;
+        std::uint64_t const key = rng() % 1000;
+        std::uint32_t const size = 1 + rng() % 1000;
+        // NOTE A TTL of zero means that the object never expires.
+        std::uint32_t const ttl_s = rng() % 2 ? 0 : 1 + rng() % 1000;
+        std::memcpy(&item[0], &timestamp_ms, sizeof(timestamp_ms));
+        std::memcpy(&item[8], &command, sizeof(command));
+        std::memcpy(&item[9], &key, sizeof(key));
+        std::memcpy(&item[17], &size, sizeof(size));
+        std::memcpy(&item[21], &ttl_s, sizeof(ttl_s));
+    }
+    FILE *fp = std::fopen(fname.c_str(), "wb");
+    assert(fp != NULL);
+    std::fwrite(bytes.data(), 1, bytes.size(), fp);
+    std::fclose(fp);
+    return bytes;
+}
+
+static bool
+matches_raw_trace(CacheAccessTrace const &trace,
+                  std::vector<std::uint8_t> const &bytes)
+{
+    if (trace.size() != bytes.size() / 25) {
+        LOGGER_ERROR("wrong size %zu", trace.size());
+        return false;
+    }
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        struct FullTraceItemResult r =
+            construct_full_trace_item(&bytes[i * 25], TRACE_FORMAT_KIA);
+        CacheAccess const expected{&r.item};
+        CacheAccess const actual = trace.get(i);
+        if (actual.timestamp_ms != expected.timestamp_ms ||
+            actual.command != expected.command ||
+            actual.key != expected.key ||
+            actual.size_bytes != expected.size_bytes ||
+            actual.ttl_ms != expected.ttl_ms) {
+            LOGGER_ERROR("mismatch at %zu", i);
+            return false;
+        }
+        if (!expected.ttl_ms.has_value()) {
+            assert(trace.get_ttls_ms()[i] == CacheAccessTrace::NO_TTL);
+        }
+    }
+    // NOTE The arrays should all be aligned for vectorization.
+    assert((std::uintptr_t)trace.get_keys() % CacheAccessTrace::ALIGNMENT ==
+           0);
+    assert((std::uintptr_t)trace.get_sizes_bytes() %
+               CacheAccessTrace::ALIGNMENT ==
+           0);
+    return true;
+}
+
+static bool
+decode_test(std::size_t const length)
+{
+    std::string const raw_fname = "cache_access_trace_test.bin";
+    std::string const saved_fname = "cache_access_trace_test.catrace";
+    std::vector<std::uint8_t> const bytes =
+        write_random_trace(raw_fname, length, length);
+
+    for (std::size_t num_threads : {1, 3, 8}) {
+        CacheAccessTrace const trace(raw_fname, TRACE_FORMAT_KIA, num_threads);
+        if (!matches_raw_trace(trace, bytes)) {
+            return false;
+        }
+        if (!trace.save(saved_fname)) {
+            return false;
+        }
+    }
+    CacheAccessTrace const loaded(saved_fname);
+    bool const ok = matches_raw_trace(loaded, bytes);
+    std::remove(raw_fname.c_str());
+    std::remove(saved_fname.c_str());
+    return ok;
+}
+
+/// @brief  Check that a TTL of zero means that the object never expires
+///         and that any other TTL is converted to milliseconds.
+static bool
+ttl_test()
+{
+    struct FullTraceItem item = {};
+    item.timestamp_ms = 1;
+    item.key = 2;
+    item.size = 3;
+
+    item.ttl_s = 0;
+    if (CacheAccess{&item}.ttl_ms.has_value()) {
+        LOGGER_ERROR("a zero TTL should never expire");
+        return false;
+    }
+    item.ttl_s = 5;
+    std::optional<std::uint64_t> const ttl_ms = CacheAccess{&item}.ttl_ms;
+    if (!ttl_ms.has_value() || *ttl_ms != 5000) {
+        LOGGER_ERROR("a 5 second TTL should be 5000 ms");
+        return false;
+    }
+    item.ttl_s = UINT32_MAX;
+    if (CacheAccess{&item}.ttl_ms != (std::uint64_t)UINT32_MAX * 1000) {
+        LOGGER_ERROR("the largest TTL should be converted exactly");
+        return false;
+    }
+    return true;
+}
+
+int
+main()
+{
+    ASSERT_FUNCTION_RETURNS_TRUE(ttl_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(decode_test(1));
+    ASSERT_FUNCTION_RETURNS_TRUE(decode_test(1000));
+    ASSERT_FUNCTION_RETURNS_TRUE(decode_test(100003));
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "cache/clock_cache.hpp"
+#include "cache/lru_cache.hpp"
+#include "cache/sieve_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_statistics/cache_statistics.hpp"
+#include "cache_sweep/capacity_sweep.hpp"
+#include "cache_sweep/miniature_cache.hpp"
+#include "logger/logger.h"
+#include "random_trace.hpp"
+#include "test/mytester.h"
+#include "trace/trace.h"
+#include "ttl_cache/ttl_fifo_cache.hpp"
+#include "ttl_cache/ttl_lfu_cache.hpp"
+
+static std::vector<std::size_t> const capacities = {0, 1, 10, 100, 1000};
+
+/// @brief  Replay the trace through a single cache, as the sweep should.
+template <class T, class... Args>
+static CacheStatistics
+replay(CacheAccessTrace const &trace,
+       std::size_t const capacity,
+       Args const &...args)
+{
+    T cache(capacity, args...);
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        CacheAccess const access = trace.get(i);
+        if (access.command == CacheAccessCommand::set) {
+            continue;
+        }
+        cache.access_item(access);
+    }
+    return cache.statistics_;
+}
+
+/// @brief  Add a cache of type T for each capacity and append the result
+///         of replaying it sequentially to 'expected'.
+template <class T, class... Args>
+static void
+add_caches(CapacitySweep &sweep,
+           std::vector<CacheStatistics> &expected,
+           CacheAccessTrace const &trace,
+           Args const &...args)
+{
+    for (std::size_t capacity : capacities) {
+        sweep.add_cache<T>(capacity, args...);
+        expected.push_back(replay<T>(trace, capacity, args...));
+    }
+}
+
+static bool
+sweep_test(std::string const &fname,
+           CacheAccessTrace const &trace,
+           std::size_t const num_threads,
+           std::size_t const block_size)
+{
+    CapacitySweep sweep(num_threads, block_size);
+    std::vector<CacheStatistics> expected;
+    add_caches<LRUCache>(sweep, expected, trace);
+    add_caches<ClockCache>(sweep, expected, trace);
+    add_caches<SieveCache>(sweep, expected, trace);
+    add_caches<TTLFIFOCache>(sweep, expected, trace);
+    add_caches<TTLLFUCache>(sweep, expected, trace);
+    add_caches<MiniatureCache<LRUCache>>(sweep, expected, trace, 0.5);
+    sweep.run(fname, TRACE_FORMAT_KIA);
+
+    if (sweep.size() != expected.size()) {
+        LOGGER_ERROR("expected %zu caches, got %zu",
+                     expected.size(),
+                     sweep.size());
+        return false;
+    }
+    for (std::size_t i = 0; i < sweep.size(); ++i) {
+        CacheStatistics const &actual = sweep.get_statistics(i);
+        if (actual.hits_ != expected[i].hits_ ||
+            actual.misses_ != expected[i].misses_ ||
+            actual.total_accesses_ != expected[i].total_accesses_) {
+            LOGGER_ERROR("%s of capacity %zu differs with %zu threads and "
+                         "blocks of %zu: %zu/%zu hits vs %zu/%zu",
+                         sweep.get_name(i).c_str(),
+                         sweep.get_capacity(i),
+                         num_threads,
+                         block_size,
+                         (std::size_t)actual.hits_,
+                         (std::size_t)actual.total_accesses_,
+                         (std::size_t)expected[i].hits_,
+                         (std::size_t)expected[i].total_accesses_);
+            return false;
+        }
+    }
+    return true;
+}
+
+/// @brief  Check that the sweep gives exactly the same statistics as a
+///         sequential replay of each capacity, no matter how the work is
+///         split up.
+static bool
+equivalence_test(std::size_t const length)
+{
+    std::string const fname = "capacity_sweep_test.bin";
+    std::vector<CacheAccess> const gets =
+        generate_trace(0, length, 1e-3, 0.5, 5000);
+    // NOTE The sweep should skip the PUT requests.
+    std::vector<CacheAccess> accesses;
+    for (std::size_t i = 0; i < gets.size(); ++i) {
+        CacheAccess const &a = gets[i];
+        accesses.push_back(CacheAccess{a.timestamp_ms,
+                                       i % 5 == 0 ? CacheAccessCommand::set
+                                                  : CacheAccessCommand::get,
+                                       a.key,
+                                       a.size_bytes,
+                                       a.ttl_ms});
+    }
+    write_kia_trace(fname, accesses);
+    CacheAccessTrace const trace(fname, TRACE_FORMAT_KIA);
+
+    for (std::size_t num_threads : {1, 3, 8}) {
+        // NOTE The last block size is larger than the whole trace.
+        for (std::size_t block_size :
+             std::vector<std::size_t>{1, 1000, 4096, length + 1}) {
+            if (!sweep_test(fname, trace, num_threads, block_size)) {
+                std::remove(fname.c_str());
+                return false;
+            }
+        }
+    }
+    std::remove(fname.c_str());
+    return true;
+}
+
+/// @brief  Check that a sweep without any caches still finishes, even
+///         though the trace has more blocks than the decoder may run
+///         ahead by.
+static bool
+empty_sweep_test()
+{
+    std::string const fname = "capacity_sweep_empty_test.bin";
+    write_kia_trace(fname, generate_trace(0, 1000, 1e-3, 0.5, 5000));
+    CapacitySweep sweep(2, 1);
+    sweep.run(fname, TRACE_FORMAT_KIA);
+    std::remove(fname.c_str());
+    return sweep.size() == 0;
+}
+
+int
+main()
+{
+    ASSERT_FUNCTION_RETURNS_TRUE(equivalence_test(1));
+    ASSERT_FUNCTION_RETURNS_TRUE(equivalence_test(10000));
+    ASSERT_FUNCTION_RETURNS_TRUE(empty_sweep_test());
+    return 0;
+}
@@ -1,9 +1,14 @@
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 
+#include "cache/clock_cache.hpp"
 #include "logger/logger.h"
+#include "random_trace.hpp"
 #include "test/mytester.h"
 #include "trace/reader.h"
 #include "ttl_cache/new_ttl_clock_cache.hpp"
@@ -35,6 +40,52 @@ get_trace(char const *const filename, enum TraceFormat format)
     return trace;
 }
 
+/// @brief  A simple, obviously correct CLOCK cache (i.e. FIFO with
+///         reinsertion) to compare against.
+class ReferenceClockCache {
+    // NOTE The front is the oldest key.
+    std::deque<std::uint64_t> queue_;
+    std::unordered_map<std::uint64_t, bool> visited_;
+    std::size_t const capacity_;
+
+public:
+    std::uint64_t hits_ = 0;
+
+    ReferenceClockCache(std::size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    void
+    access_item(std::uint64_t const key)
+    {
+        auto it = visited_.find(key);
+        if (it != visited_.end()) {
+            it->second = true;
+            ++hits_;
+            return;
+        }
+        while (queue_.size() >= capacity_) {
+            std::uint64_t const victim = queue_.front();
+            queue_.pop_front();
+            if (visited_[victim]) {
+                visited_[victim] = false;
+                queue_.push_back(victim);
+            } else {
+                visited_.erase(victim);
+            }
+        }
+        queue_.push_back(key);
+        visited_[key] = false;
+    }
+
+    std::vector<std::uint64_t>
+    get_keys_in_eviction_order() const
+    {
+        return std::vector<std::uint64_t>(queue_.begin(), queue_.end());
+    }
+};
+
 /*******************************************************************************
  *  VALIDATION TESTING
  *********************************************************************************/
@@ -102,6 +153,49 @@ cache_vs_oracle_test(std::vector<std::uint64_t> const &trace,
     return equal_vectors(keys, final_state);
 }
 
+/// @brief  Check that a hit gives a key a second chance, unlike FIFO.
+static bool
+second_chance_test()
+{
+    ClockCache cache(2);
+    std::uint64_t const trace[] = {'A', 'B', 'A', 'C', 'A'};
+    for (std::size_t i = 0; i < sizeof(trace) / sizeof(*trace); ++i) {
+        cache.access_item({i, trace[i]});
+    }
+    // NOTE When 'C' arrives, the hand skips (and clears) the visited 'A'
+    //      and evicts 'B' instead, so the second access to 'A' hits.
+    //      FIFO would have evicted 'A' and hit only once.
+    assert(cache.statistics_.hits_ == 2);
+    assert(cache.statistics_.misses_ == 3);
+    assert((cache.get_keys_in_eviction_order() ==
+            std::vector<std::uint64_t>{'A', 'C'}));
+    assert(cache.validate());
+    return true;
+}
+
+/// @brief  Compare the CLOCK cache against the reference implementation.
+static bool
+comparison_reference_test(std::size_t capacity,
+                          std::vector<std::uint64_t> const &trace)
+{
+    LOGGER_INFO("Testing CLOCK cache with capacity %zu", capacity);
+    ClockCache cache(capacity);
+    ReferenceClockCache ref_cache(capacity);
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        cache.access_item({i, trace[i]});
+        ref_cache.access_item(trace[i]);
+        // NOTE This should amoritize the cost of comparisons to O(N).
+        if (i % capacity == 0 && cache.get_keys_in_eviction_order() !=
+                                     ref_cache.get_keys_in_eviction_order()) {
+            LOGGER_ERROR("mismatch on iteration %zu", i);
+            return false;
+        }
+    }
+    assert(cache.validate());
+    assert(cache.statistics_.hits_ == ref_cache.hits_);
+    return true;
+}
+
 /*******************************************************************************
  *  CACHE COMPARISON TESTING
  *********************************************************************************/
@@ -183,6 +277,13 @@ main(int argc, char *argv[])
     ASSERT_FUNCTION_RETURNS_TRUE(simple_validation_test(trace, 4));
     ASSERT_FUNCTION_RETURNS_TRUE(simple_validation_test(src2_trace, 2));
 
+    ASSERT_FUNCTION_RETURNS_TRUE(second_chance_test());
+    std::vector<std::uint64_t> synthetic = generate_keys(1 << 16, 1024);
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(1, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(7, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(100, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(1 << 10, synthetic));
+
     // Test filling the trace
     std::vector<std::uint64_t> trace_0 = {1, 2, 3, 4};
     std::vector<std::uint64_t> final_state_0 = {3, 4};
@@ -0,0 +1,236 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "cache/clock_cache.hpp"
+#include "cache/fifo_cache.hpp"
+#include "cache/lru_cache.hpp"
+#include "cache/sieve_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_metadata/cache_metadata.hpp"
+#include "cache_metadata/packed_cache_metadata.hpp"
+#include "composed_cache/composed_cache.hpp"
+#include "logger/logger.h"
+#include "random_trace.hpp"
+#include "test/mytester.h"
+
+/// @brief  Check that a composed cache hits exactly when the equivalent
+///         hand-written cache does.
+template <class Composed, class HandWritten>
+static bool
+equivalence_test(std::vector<CacheAccess> const &trace)
+{
+    for (std::size_t capacity : {0, 1, 2, 10, 100, 1000}) {
+        Composed composed(capacity);
+        HandWritten hand_written(capacity);
+        for (std::size_t i = 0; i < trace.size(); ++i) {
+            composed.access_item(trace[i]);
+            hand_written.access_item(trace[i]);
+            if (composed.statistics_.hits_ != hand_written.statistics_.hits_) {
+                LOGGER_ERROR("%s differs from %s at capacity %zu, access %zu",
+                             Composed::name,
+                             HandWritten::name,
+                             capacity,
+                             i);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/// @brief  A simple TTL cache with either FIFO or LRU eviction.
+class ReferenceTTLCache {
+    struct Entry {
+        std::list<std::uint64_t>::iterator position;
+        std::optional<std::multimap<std::uint64_t, std::uint64_t>::iterator>
+            expiry;
+    };
+
+    std::size_t const capacity_;
+    bool const lru_;
+    std::list<std::uint64_t> order_;
+    std::unordered_map<std::uint64_t, Entry> map_;
+    std::multimap<std::uint64_t, std::uint64_t> expiry_;
+
+    void
+    erase(std::uint64_t const key)
+    {
+        Entry &e = map_.at(key);
+        order_.erase(e.position);
+        if (e.expiry) {
+            expiry_.erase(*e.expiry);
+        }
+        map_.erase(key);
+    }
+
+public:
+    CacheStatistics statistics_;
+
+    ReferenceTTLCache(std::size_t const capacity, bool const lru)
+        : capacity_(capacity),
+          lru_(lru)
+    {
+    }
+
+    void
+    access_item(CacheAccess const &access)
+    {
+        while (!expiry_.empty() &&
+               expiry_.begin()->first <= access.timestamp_ms) {
+            erase(expiry_.begin()->second);
+        }
+        auto it = map_.find(access.key);
+        if (it != map_.end()) {
+            if (lru_) {
+                order_.splice(order_.end(), order_, it->second.position);
+            }
+            if (access.ttl_ms) {
+                if (it->second.expiry) {
+                    expiry_.erase(*it->second.expiry);
+                }
+                it->second.expiry = expiry_.emplace(
+                    access.timestamp_ms + *access.ttl_ms,
+                    access.key);
+            }
+            statistics_.hit();
+            return;
+        }
+        statistics_.miss();
+        if (capacity_ == 0) {
+            return;
+        }
+        if (map_.size() == capacity_) {
+            erase(order_.front());
+        }
+        Entry e = {order_.insert(order_.end(), access.key), std::nullopt};
+        if (access.ttl_ms) {
+            e.expiry = expiry_.emplace(access.timestamp_ms + *access.ttl_ms,
+                                       access.key);
+        }
+        map_.emplace(access.key, e);
+    }
+};
+
+template <class Composed>
+static bool
+ttl_test(std::vector<CacheAccess> const &trace, bool const lru)
+{
+    for (std::size_t capacity : {0, 1, 10, 100, 1000}) {
+        Composed composed(capacity);
+        ReferenceTTLCache reference(capacity, lru);
+        for (std::size_t i = 0; i < trace.size(); ++i) {
+            composed.access_item(trace[i]);
+            reference.access_item(trace[i]);
+            if (composed.statistics_.hits_ != reference.statistics_.hits_) {
+                LOGGER_ERROR("%s differs at capacity %zu, access %zu",
+                             Composed::name,
+                             capacity,
+                             i);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool
+doorkeeper_test()
+{
+    ComposedCache<LRUOrder, NoExpiry, DoorkeeperAdmission> cache(10);
+    assert(std::string(cache.name) == "ComposedLRUDoorkeeperCache");
+    cache.access_item(CacheAccess{0, 1});
+    assert(!cache.contains(1));
+    cache.access_item(CacheAccess{1, 1});
+    assert(cache.contains(1));
+    cache.access_item(CacheAccess{2, 1});
+    assert(cache.statistics_.hits_ == 1 && cache.statistics_.misses_ == 2);
+    return true;
+}
+
+static bool
+packed_metadata_test()
+{
+    // NOTE Small sizes are exact and large ones lose < 25%.
+    for (std::uint64_t size = 0; size < 1 << 20; ++size) {
+        std::uint64_t const decoded = PackedCacheMetadata::decode_size_class(
+            PackedCacheMetadata::encode_size_class(size));
+        assert(decoded <= size && size < decoded + (decoded + 3) / 4 + 1);
+    }
+    assert(PackedCacheMetadata::decode_size_class(
+               PackedCacheMetadata::encode_size_class(UINT64_MAX)) >
+           UINT64_MAX / 2);
+
+    std::uint64_t const epoch = (std::uint64_t)1 << 40;
+    PackedCacheMetadata m(epoch, 100, epoch + 5, UINT64_MAX);
+    assert(m.get_insertion_time_ms(epoch) == epoch + 5);
+    assert(m.get_expiration_time_ms(epoch) == UINT64_MAX);
+    for (std::size_t i = 0; i < 1000; ++i) {
+        m.visit(epoch, epoch + 10, epoch + 20);
+    }
+    assert(m.get_frequency() == UINT8_MAX);
+    assert(m.get_last_access_time_ms(epoch) == epoch + 10);
+    assert(m.get_expiration_time_ms(epoch) == epoch + 20);
+    assert(!m.is_visited());
+    m.set_visited();
+    assert(m.is_visited());
+
+    // NOTE The packed metadata should agree with the full metadata
+    //      whenever the values are in range.
+    using FullCache =
+        ComposedCache<LRUOrder, TTLExpiry, AdmitAll, FullMetadata>;
+    using PackedCache =
+        ComposedCache<LRUOrder, TTLExpiry, AdmitAll, PackedMetadata>;
+    std::vector<CacheAccess> const trace =
+        generate_trace(2, 1 << 14, 1e-3, 0.5, 2000);
+    FullCache full(100);
+    PackedCache packed(100);
+    for (auto const &access : trace) {
+        full.access_item(access);
+        packed.access_item(access);
+        auto const slot = full.get_slot(access.key);
+        assert(slot == packed.get_slot(access.key));
+        if (!slot) {
+            continue;
+        }
+        CacheMetadata const &f = full.get_metadata_store().get(*slot);
+        PackedCacheMetadata const &p = packed.get_metadata_store().get(*slot);
+        std::uint64_t const epoch_ms =
+            packed.get_metadata_store().get_epoch_ms();
+        assert(p.get_insertion_time_ms(epoch_ms) == f.insertion_time_ms_);
+        assert(p.get_last_access_time_ms(epoch_ms) == f.last_access_time_ms_);
+        assert(p.get_expiration_time_ms(epoch_ms) == f.expiration_time_ms_);
+        assert(p.get_frequency() == f.frequency_);
+    }
+    return true;
+}
+
+int
+main()
+{
+    std::vector<CacheAccess> const trace = generate_trace(0, 1 << 16, 1e-3);
+    ASSERT_FUNCTION_RETURNS_TRUE(
+        (equivalence_test<ComposedFIFOCache, FIFOCache>(trace)));
+    ASSERT_FUNCTION_RETURNS_TRUE(
+        (equivalence_test<ComposedLRUCache, LRUCache>(trace)));
+    ASSERT_FUNCTION_RETURNS_TRUE(
+        (equivalence_test<ComposedClockCache, ClockCache>(trace)));
+    ASSERT_FUNCTION_RETURNS_TRUE(
+        (equivalence_test<ComposedSieveCache, SieveCache>(trace)));
+
+    std::vector<CacheAccess> const ttl_trace =
+        generate_trace(1, 1 << 16, 1e-3, 0.5, 2000);
+    ASSERT_FUNCTION_RETURNS_TRUE(
+        ttl_test<ComposedTTLFIFOCache>(ttl_trace, false));
+    ASSERT_FUNCTION_RETURNS_TRUE(
+        ttl_test<ComposedTTLLRUCache>(ttl_trace, true));
+    ASSERT_FUNCTION_RETURNS_TRUE(doorkeeper_test());
+    ASSERT_FUNCTION_RETURNS_TRUE(packed_metadata_test());
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "arrays/array_size.h"
+#include "cache/lfu_cache.hpp"
+#include "logger/logger.h"
+#include "random_trace.hpp"
+#include "test/mytester.h"
+
+/// @brief  A simple, obviously correct (but slow) LFU cache to compare
+///         against. Ties in frequency go to the key that reached its
+///         frequency the earliest.
+class ReferenceLFUCache {
+    // NOTE Map the key to its frequency and when it reached it.
+    std::map<std::uint64_t, std::pair<std::uint64_t, std::uint64_t>> map_;
+    std::size_t const capacity_;
+    std::uint64_t logical_time_ = 0;
+
+public:
+    std::uint64_t hits_ = 0;
+
+    ReferenceLFUCache(std::size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    void
+    access_item(std::uint64_t const key)
+    {
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            it->second = {it->second.first + 1, logical_time_};
+            ++hits_;
+        } else {
+            if (map_.size() >= capacity_) {
+                auto victim = map_.begin();
+                for (auto i = map_.begin(); i != map_.end(); ++i) {
+                    if (i->second < victim->second) {
+                        victim = i;
+                    }
+                }
+                map_.erase(victim);
+            }
+            map_[key] = {0, logical_time_};
+        }
+        ++logical_time_;
+    }
+};
+
+/// @brief  Check a short trace whose hits are easy to count by hand.
+static bool
+lfu_test()
+{
+    LFUCache cache(2);
+    std::uint64_t const trace[] = {'A', 'A', 'B', 'C', 'A', 'B', 'C'};
+    for (std::size_t i = 0; i < ARRAY_SIZE(trace); ++i) {
+        cache.access_item({i, trace[i]});
+    }
+    // NOTE 'A' is never evicted because it is the most frequent; 'B'
+    //      and 'C' evict each other.
+    assert(cache.statistics_.hits_ == 2);
+    assert(cache.statistics_.misses_ == 5);
+    return true;
+}
+
+/// @brief  Compare the LFU cache against the reference implementation.
+static bool
+comparison_lfu_test(std::size_t capacity,
+                    std::vector<std::uint64_t> const &trace)
+{
+    LOGGER_INFO("Testing LFU cache with capacity %zu", capacity);
+    LFUCache my_cache(capacity);
+    ReferenceLFUCache ref_cache(capacity);
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        my_cache.access_item({i, trace[i]});
+        ref_cache.access_item(trace[i]);
+    }
+    assert(my_cache.statistics_.hits_ == ref_cache.hits_);
+    return true;
+}
+
+int
+main()
+{
+    ASSERT_FUNCTION_RETURNS_TRUE(lfu_test());
+
+    std::vector<std::uint64_t> synthetic = generate_keys(1 << 16, 1024);
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lfu_test(1, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lfu_test(7, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lfu_test(100, synthetic));
+    return 0;
+}
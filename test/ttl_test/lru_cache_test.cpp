@@ -0,0 +1,174 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "arrays/array_size.h"
+#include "cache/lru_cache.hpp"
+#include "logger/logger.h"
+#include "random_trace.hpp"
+#include "test/mytester.h"
+#include "trace/reader.h"
+#include "ttl_cache/ttl_lru_cache.hpp"
+
+static std::uint64_t short_trace[] = {'A', 'B', 'C', 'A', 'D', 'B', 'E', 'A'};
+static std::string soln[] = {
+    "||",
+    "|A|",
+    "|A|B|",
+    "|A|B|C|",
+    "|B|C|A|",
+    "|C|A|D|",
+    "|A|D|B|",
+    "|D|B|E|",
+    "|B|E|A|",
+};
+
+/// @brief  Print the keys from least to most recently used.
+static std::string
+lru_print(std::vector<std::uint64_t> keys)
+{
+    std::string s = "|";
+    for (auto key : keys) {
+        // NOTE We know that the key is a character.
+        s += std::string(1, (char)key) + "|";
+    }
+    if (s == "|") {
+        return "||";
+    }
+    return s;
+}
+
+/// @brief  A simple, obviously correct LRU cache to compare against.
+class ReferenceLRUCache {
+    std::list<std::uint64_t> queue_;
+    std::unordered_map<std::uint64_t, std::list<std::uint64_t>::iterator> map_;
+    std::size_t const capacity_;
+
+public:
+    std::uint64_t hits_ = 0;
+
+    ReferenceLRUCache(std::size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    void
+    access_item(std::uint64_t const key)
+    {
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            queue_.erase(it->second);
+            ++hits_;
+        } else if (map_.size() >= capacity_) {
+            map_.erase(queue_.front());
+            queue_.pop_front();
+        }
+        queue_.push_back(key);
+        map_[key] = std::prev(queue_.end());
+    }
+
+    std::vector<std::uint64_t>
+    get_keys_in_eviction_order() const
+    {
+        return std::vector<std::uint64_t>(queue_.begin(), queue_.end());
+    }
+};
+
+static std::vector<std::uint64_t>
+get_trace(char const *const filename, enum TraceFormat format)
+{
+    struct Trace t = {};
+    std::vector<std::uint64_t> trace;
+    t = read_trace_keys(filename, format);
+    trace.reserve(t.length);
+    for (std::size_t i = 0; i < t.length; ++i) {
+        trace.push_back(t.trace[i].key);
+    }
+    return trace;
+}
+
+static bool
+simple_test()
+{
+    std::vector<std::string> my_soln;
+    LRUCache cache(3);
+
+    my_soln.push_back(lru_print(cache.get_keys_in_eviction_order()));
+    for (std::size_t i = 0; i < ARRAY_SIZE(short_trace); ++i) {
+        cache.access_item({i, short_trace[i]});
+        my_soln.push_back(lru_print(cache.get_keys_in_eviction_order()));
+    }
+
+    assert(my_soln.size() == ARRAY_SIZE(soln));
+    for (std::size_t i = 0; i < my_soln.size(); ++i) {
+        if (my_soln[i] != soln[i]) {
+            LOGGER_ERROR("mismatching strings at %zu: got '%s', expecting '%s'",
+                         i,
+                         my_soln[i].c_str(),
+                         soln[i].c_str());
+            return false;
+        }
+    }
+    // NOTE The middle key is now the least recently used.
+    assert(cache.delete_item('E') == 0);
+    assert(cache.delete_item('E') == -1);
+    assert(cache.delete_lru().value() == 'B');
+    assert(cache.delete_lru().value() == 'A');
+    assert(!cache.delete_lru().has_value());
+    return true;
+}
+
+/// @brief  Compare the LRU caches against the reference implementation.
+static bool
+comparison_lru_test(std::size_t capacity,
+                    std::vector<std::uint64_t> const &trace)
+{
+    LOGGER_INFO("Testing LRU cache with capacity %zu", capacity);
+    LRUCache my_cache(capacity);
+    TTLLRUCache ttl_cache(capacity);
+    ReferenceLRUCache ref_cache(capacity);
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        my_cache.access_item({i, trace[i]});
+        ttl_cache.access_item({i, trace[i]});
+        ref_cache.access_item(trace[i]);
+        // NOTE This should amoritize the cost of comparisons to O(N).
+        if (i % capacity == 0 && my_cache.get_keys_in_eviction_order() !=
+                                     ref_cache.get_keys_in_eviction_order()) {
+            LOGGER_ERROR("mismatch on iteration %zu", i);
+            return false;
+        }
+    }
+    assert(my_cache.statistics_.hits_ == ref_cache.hits_);
+    // NOTE Every item has the same TTL, so TTL-LRU is simply LRU.
+    assert(ttl_cache.statistics_.hits_ == ref_cache.hits_);
+    return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+    ASSERT_FUNCTION_RETURNS_TRUE(simple_test());
+
+    std::vector<std::uint64_t> synthetic = generate_keys(1 << 16, 1024);
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(1, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(2, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(100, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(1 << 10, synthetic));
+
+    if (argc == 1) {
+        LOGGER_WARN("skipping real trace test");
+        return 0;
+    }
+    // NOTE I assume the trace we're being passed is MSR src2.bin.
+    std::vector<std::uint64_t> trace = get_trace(argv[1], TRACE_FORMAT_KIA);
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(1 << 10, trace));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(1 << 12, trace));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_lru_test(1 << 14, trace));
+    return 0;
+}
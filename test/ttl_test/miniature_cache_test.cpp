@@ -0,0 +1,83 @@
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "cache/clock_cache.hpp"
+#include "cache/lfu_cache.hpp"
+#include "cache/lru_cache.hpp"
+#include "cache/sieve_cache.hpp"
+#include "cache_metadata/cache_access.hpp"
+#include "cache_sweep/miniature_cache.hpp"
+#include "logger/logger.h"
+#include "random_trace.hpp"
+#include "test/mytester.h"
+#include "ttl_cache/ttl_fifo_cache.hpp"
+
+/// @brief  Check that sampling every key is the same as the full cache.
+template <class T>
+static bool
+exact_test(std::vector<CacheAccess> const &trace)
+{
+    for (std::size_t capacity : {0, 1, 10, 1000}) {
+        T cache(capacity);
+        MiniatureCache<T> mini(capacity, 1.0);
+        for (auto const &access : trace) {
+            cache.access_item(access);
+            mini.access_item(access);
+        }
+        assert(mini.statistics_.hits_ == cache.statistics_.hits_);
+        assert(mini.statistics_.misses_ == cache.statistics_.misses_);
+    }
+    return true;
+}
+
+/// @brief  Check that a miniature simulation is close to the full one.
+template <class T>
+static bool
+accuracy_test(std::vector<CacheAccess> const &trace,
+              double const sampling_ratio,
+              double const max_mean_absolute_error)
+{
+    double total_error = 0.0;
+    std::size_t n = 0;
+    for (std::size_t capacity = 1000; capacity <= 20000; capacity += 2000) {
+        T cache(capacity);
+        MiniatureCache<T> mini(capacity, sampling_ratio);
+        for (auto const &access : trace) {
+            cache.access_item(access);
+            mini.access_item(access);
+        }
+        total_error += std::abs(mini.statistics_.miss_rate() -
+                                cache.statistics_.miss_rate());
+        ++n;
+    }
+    double const mae = total_error / n;
+    LOGGER_INFO("%s: MAE = %f at sampling ratio %f",
+                T::name,
+                mae,
+                sampling_ratio);
+    if (mae > max_mean_absolute_error) {
+        LOGGER_ERROR("MAE %f exceeds %f", mae, max_mean_absolute_error);
+        return false;
+    }
+    return true;
+}
+
+int
+main()
+{
+    std::vector<CacheAccess> const trace =
+        generate_trace(0, 1 << 19, 1e-4, 0.25, 100000);
+    ASSERT_FUNCTION_RETURNS_TRUE(exact_test<LRUCache>(trace));
+    ASSERT_FUNCTION_RETURNS_TRUE(exact_test<SieveCache>(trace));
+    ASSERT_FUNCTION_RETURNS_TRUE(exact_test<TTLFIFOCache>(trace));
+
+    ASSERT_FUNCTION_RETURNS_TRUE(accuracy_test<LRUCache>(trace, 0.1, 0.01));
+    ASSERT_FUNCTION_RETURNS_TRUE(accuracy_test<ClockCache>(trace, 0.1, 0.01));
+    ASSERT_FUNCTION_RETURNS_TRUE(accuracy_test<SieveCache>(trace, 0.1, 0.01));
+    ASSERT_FUNCTION_RETURNS_TRUE(accuracy_test<LFUCache>(trace, 0.1, 0.01));
+    ASSERT_FUNCTION_RETURNS_TRUE(accuracy_test<TTLFIFOCache>(trace, 0.1, 0.01));
+    return 0;
+}
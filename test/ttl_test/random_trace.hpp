@@ -0,0 +1,85 @@
+/** @brief  Random traces for the TTL cache tests. */
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "cache_metadata/cache_access.hpp"
+
+/// @brief  Generate a trace of GET requests with one byte objects.
+/// @param  key_probability: the parameter of the geometric distribution of
+///                          keys. The geometric distribution gives a
+///                          smooth, skewed MRC with about 1/key_probability
+///                          distinct keys.
+/// @param  ttl_probability: the probability that an access has a TTL.
+/// @param  max_ttl_ms: the TTLs are uniform in [1, max_ttl_ms].
+static inline std::vector<CacheAccess>
+generate_trace(std::uint64_t const seed,
+               std::size_t const length,
+               double const key_probability,
+               double const ttl_probability = 0.0,
+               std::uint64_t const max_ttl_ms = 1)
+{
+    std::mt19937_64 rng(seed);
+    std::geometric_distribution<std::uint64_t> key_dist(key_probability);
+    std::bernoulli_distribution ttl_dist(ttl_probability);
+    std::vector<CacheAccess> trace;
+    trace.reserve(length);
+    for (std::size_t i = 0; i < length; ++i) {
+        std::optional<std::uint64_t> ttl_ms = std::nullopt;
+        if (ttl_dist(rng)) {
+            ttl_ms = 1 + rng() % max_ttl_ms;
+        }
+        trace.push_back(CacheAccess{i, key_dist(rng), 1, ttl_ms});
+    }
+    return trace;
+}
+
+/// @brief  Generate a skewed trace of keys in [0, num_unique) so that the
+///         caches get a mix of hits and evictions.
+static inline std::vector<std::uint64_t>
+generate_keys(std::size_t const length, std::size_t const num_unique)
+{
+    std::mt19937_64 rng(0);
+    std::geometric_distribution<std::uint64_t> dist(8.0 / num_unique);
+    std::vector<std::uint64_t> trace;
+    trace.reserve(length);
+    for (std::size_t i = 0; i < length; ++i) {
+        trace.push_back(dist(rng) % num_unique);
+    }
+    return trace;
+}
+
+/// @brief  Write a trace in Kia's format, so that it can be read back with
+///         'CacheAccessTrace'.
+/// @note   Kia's format stores TTLs in seconds, so I round them up.
+static inline void
+write_kia_trace(std::string const &fname,
+                std::vector<CacheAccess> const &trace)
+{
+    std::vector<std::uint8_t> bytes(trace.size() * 25);
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        std::uint8_t *const item = &bytes[i * 25];
+        CacheAccess const &access = trace[i];
+        std::uint8_t const command = (std::uint8_t)access.command;
+        // NOTE A TTL of zero means that the object never expires.
+        std::uint32_t const ttl_s =
+            access.ttl_ms.has_value() ? (*access.ttl_ms + 999) / 1000 : 0;
+        std::memcpy(&item[0], &access.timestamp_ms, 8);
+        std::memcpy(&item[8], &command, 1);
+        std::memcpy(&item[9], &access.key, 8);
+        std::memcpy(&item[17], &access.size_bytes, 4);
+        std::memcpy(&item[21], &ttl_s, 4);
+    }
+    FILE *fp = std::fopen(fname.c_str(), "wb");
+    assert(fp != NULL);
+    std::fwrite(bytes.data(), 1, bytes.size(), fp);
+    std::fclose(fp);
+}
@@ -1,12 +1,17 @@
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "arrays/array_size.h"
 #include "cache/sieve_cache.hpp"
 #include "logger/logger.h"
+#include "random_trace.hpp"
 #include "test/mytester.h"
 #include "trace/reader.h"
 #include "ttl_cache/ttl_sieve_cache.hpp"
@@ -56,6 +61,64 @@ static std::string soln[] = {
     "|J|I|H|G|D|B|A|",
 };
 
+/// @brief  A simple, obviously correct SIEVE cache to compare against.
+class ReferenceSieveCache {
+    struct Entry {
+        std::uint64_t key;
+        bool visited;
+    };
+    // NOTE The front is the oldest key.
+    std::list<Entry> queue_;
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> map_;
+    std::list<Entry>::iterator hand_ = queue_.end();
+    std::size_t const capacity_;
+
+public:
+    std::uint64_t hits_ = 0;
+
+    ReferenceSieveCache(std::size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    void
+    access_item(std::uint64_t const key)
+    {
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            it->second->visited = true;
+            ++hits_;
+            return;
+        }
+        if (map_.size() >= capacity_) {
+            while (true) {
+                if (hand_ == queue_.end()) {
+                    hand_ = queue_.begin();
+                }
+                if (!hand_->visited) {
+                    break;
+                }
+                hand_->visited = false;
+                ++hand_;
+            }
+            map_.erase(hand_->key);
+            hand_ = queue_.erase(hand_);
+        }
+        queue_.push_back({key, false});
+        map_[key] = std::prev(queue_.end());
+    }
+
+    std::vector<std::uint64_t>
+    get_keys_in_eviction_order() const
+    {
+        std::vector<std::uint64_t> keys;
+        for (auto &e : queue_) {
+            keys.push_back(e.key);
+        }
+        return keys;
+    }
+};
+
 static std::string
 sieve_print(std::vector<std::uint64_t> keys)
 {
@@ -218,12 +281,41 @@ comparison_sieve_test(std::size_t capacity, std::vector<std::uint64_t> trace)
     return nerr == 0;
 }
 
+/// @brief  Compare the array-based SIEVE cache against the reference
+///         implementation, including when the hand wraps around.
+static bool
+comparison_reference_test(std::size_t capacity,
+                          std::vector<std::uint64_t> const &trace)
+{
+    LOGGER_INFO("Testing SIEVE cache with capacity %zu", capacity);
+    SieveCache cache(capacity);
+    ReferenceSieveCache ref_cache(capacity);
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        cache.access_item({i, trace[i]});
+        ref_cache.access_item(trace[i]);
+        // NOTE This should amoritize the cost of comparisons to O(N).
+        if (i % capacity == 0 && cache.get_keys_in_eviction_order() !=
+                                     ref_cache.get_keys_in_eviction_order()) {
+            LOGGER_ERROR("mismatch on iteration %zu", i);
+            return false;
+        }
+    }
+    assert(cache.statistics_.hits_ == ref_cache.hits_);
+    return true;
+}
+
 int
 main(int argc, char *argv[])
 {
     ASSERT_FUNCTION_RETURNS_TRUE(my_simple_test());
     ASSERT_FUNCTION_RETURNS_TRUE(yang_simple_test());
 
+    std::vector<std::uint64_t> synthetic = generate_keys(1 << 16, 1024);
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(1, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(7, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(100, synthetic));
+    ASSERT_FUNCTION_RETURNS_TRUE(comparison_reference_test(1 << 10, synthetic));
+
     if (argc == 1) {
         LOGGER_WARN("skipping real trace test");
         return 0;
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "logger/logger.h"
+#include "test/mytester.h"
+#include "ttl_cache/timing_wheel.hpp"
+
+using ReferenceQueue = std::multimap<std::uint64_t, std::uint64_t>;
+
+static ReferenceQueue::iterator
+find_in_reference(ReferenceQueue &ref,
+                  std::uint64_t const key,
+                  std::uint64_t const time)
+{
+    auto [begin, end] = ref.equal_range(time);
+    for (auto x = begin; x != end; ++x) {
+        if (x->second == key) {
+            return x;
+        }
+    }
+    assert(0 && "key not found");
+    return ref.end();
+}
+
+static bool
+simple_test()
+{
+    TimingWheel wheel;
+    assert(!wheel.pop().has_value());
+    // NOTE These span several levels of the wheel.
+    TimingWheel::Handle a = wheel.schedule('A', 1 << 20);
+    wheel.schedule('B', 5);
+    wheel.schedule('C', 5);
+    wheel.schedule('D', 300);
+    assert(wheel.size() == 4);
+
+    // NOTE Ties expire in the order that they were scheduled.
+    assert(wheel.pop().value() == 'B');
+    // NOTE Scheduling before the last expired entry is allowed.
+    wheel.reschedule(a, 1);
+    assert(wheel.get_time(a) == 1);
+    assert(wheel.pop().value() == 'A');
+
+    std::vector<std::uint64_t> expired;
+    std::size_t n = wheel.drain_expired(299, [&expired](std::uint64_t key) {
+        expired.push_back(key);
+    });
+    assert(n == 1 && expired == std::vector<std::uint64_t>{'C'});
+    n = wheel.drain_expired(300, [&expired](std::uint64_t key) {
+        expired.push_back(key);
+    });
+    assert(n == 1 && expired.back() == 'D');
+    assert(wheel.empty());
+    return true;
+}
+
+/// @brief  Compare the timing wheel against a std::multimap under a
+///         random mix of operations.
+static bool
+random_test(std::uint64_t const seed, std::uint64_t const time_range)
+{
+    LOGGER_INFO("Testing timing wheel with time range %" PRIu64, time_range);
+    std::mt19937_64 rng(seed);
+    TimingWheel wheel;
+    ReferenceQueue ref;
+    std::map<std::uint64_t, TimingWheel::Handle> handles;
+    std::uint64_t next_key = 0;
+    auto random_time = [&rng, time_range]() {
+        return time_range == 0 ? rng() : rng() % time_range;
+    };
+    auto random_handle = [&rng, &handles]() {
+        auto it = handles.begin();
+        std::advance(it, rng() % std::min<std::size_t>(handles.size(), 64));
+        return it;
+    };
+
+    for (std::size_t i = 0; i < 1 << 16; ++i) {
+        std::uint64_t const op = rng() % 10;
+        if (op < 4 || handles.empty()) {
+            std::uint64_t const time = random_time();
+            handles[next_key] = wheel.schedule(next_key, time);
+            ref.emplace(time, next_key);
+            ++next_key;
+        } else if (op < 6) {
+            auto it = random_handle();
+            std::uint64_t const time = random_time();
+            auto nh = ref.extract(
+                find_in_reference(ref, it->first, wheel.get_time(it->second)));
+            nh.key() = time;
+            ref.insert(std::move(nh));
+            wheel.reschedule(it->second, time);
+        } else if (op < 7) {
+            auto it = random_handle();
+            ref.erase(
+                find_in_reference(ref, it->first, wheel.get_time(it->second)));
+            wheel.erase(it->second);
+            handles.erase(it);
+        } else if (op < 9) {
+            std::uint64_t const key = wheel.pop().value();
+            if (key != ref.begin()->second) {
+                LOGGER_ERROR("mismatching pop on iteration %zu", i);
+                return false;
+            }
+            ref.erase(ref.begin());
+            handles.erase(key);
+        } else {
+            std::uint64_t const now = ref.begin()->first + random_time() / 4;
+            std::vector<std::uint64_t> expired, ref_expired;
+            wheel.drain_expired(now, [&expired](std::uint64_t const key) {
+                expired.push_back(key);
+            });
+            while (!ref.empty() && ref.begin()->first <= now) {
+                ref_expired.push_back(ref.begin()->second);
+                ref.erase(ref.begin());
+            }
+            if (expired != ref_expired) {
+                LOGGER_ERROR("mismatching drain on iteration %zu", i);
+                return false;
+            }
+            for (auto key : expired) {
+                handles.erase(key);
+            }
+        }
+        assert(wheel.size() == ref.size());
+    }
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> const ref_entries(
+        ref.begin(),
+        ref.end());
+    assert(wheel.get_entries_in_expiration_order() == ref_entries);
+    return true;
+}
+
+int
+main()
+{
+    ASSERT_FUNCTION_RETURNS_TRUE(simple_test());
+    // NOTE A small range gives many ties, while the full range exercises
+    //      every level of the wheel.
+    ASSERT_FUNCTION_RETURNS_TRUE(random_test(0, 16));
+    ASSERT_FUNCTION_RETURNS_TRUE(random_test(1, 1000));
+    ASSERT_FUNCTION_RETURNS_TRUE(random_test(2, (std::uint64_t)1 << 40));
+    ASSERT_FUNCTION_RETURNS_TRUE(random_test(3, 0));
+    return 0;
+}